@@ -536,6 +536,8 @@ extern int copy_ts;
 extern int start_at_zero;
 extern int copy_tb;
 extern int debug_ts;
+extern int filter_pipeline;
+extern int shared_buffer_pools;
 extern int exit_on_error;
 extern int abort_on_flags;
 extern int print_stats;
@@ -986,6 +986,8 @@ int configure_filtergraph(FilterGraph *fg)
     avfilter_graph_free(&fg->graph);
     if (!(fg->graph = avfilter_graph_alloc()))
         return AVERROR(ENOMEM);
+    fg->graph->pipeline     = filter_pipeline;
+    fg->graph->shared_pools = shared_buffer_pools;
 
     if (simple) {
         OutputStream *ost = fg->outputs[0]->ost;
@@ -113,6 +113,8 @@ int copy_ts           = 0;
 int start_at_zero     = 0;
 int copy_tb           = -1;
 int debug_ts          = 0;
+int filter_pipeline   = 0;
+int shared_buffer_pools = 0;
 int exit_on_error     = 0;
 int abort_on_flags    = 0;
 int print_stats       = -1;
@@ -226,6 +228,13 @@ static int opt_abort_on(void *optctx, const char *opt, const char *arg)
     return av_opt_eval_flags(&pclass, &opts[0], arg, &abort_on_flags);
 }
 
+static int opt_buffer_pool_limit(void *optctx, const char *opt, const char *arg)
+{
+    av_buffer_pool_set_shared_limit(parse_number_or_die(opt, arg, OPT_INT64,
+                                                        0, INT64_MAX));
+    return 0;
+}
+
 static int opt_sameq(void *optctx, const char *opt, const char *arg)
 {
     av_log(NULL, AV_LOG_ERROR, "Option '%s' was removed. "
@@ -3216,6 +3225,10 @@ const OptionDef options[] = {
         "add timings for benchmarking" },
     { "benchmark_all",  OPT_BOOL | OPT_EXPERT,                       { &do_benchmark_all },
       "add timings for each task" },
+    { "buffer_pool_limit", HAS_ARG | OPT_EXPERT,                     { .func_arg = opt_buffer_pool_limit },
+      "set the maximum memory held by the shared frame buffer pools", "size" },
+    { "shared_buffer_pools", OPT_BOOL | OPT_EXPERT,                  { &shared_buffer_pools },
+      "allocate decoded and filtered frames from buffer pools shared by the process" },
     { "progress",       HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_progress },
       "write program-readable progress information", "url" },
     { "stdin",          OPT_BOOL | OPT_EXPERT,                       { &stdin_interaction },
@@ -3290,6 +3303,8 @@ const OptionDef options[] = {
         "create a complex filtergraph", "graph_description" },
     { "filter_complex_script", HAS_ARG | OPT_EXPERT,                 { .func_arg = opt_filter_complex_script },
         "read complex filtergraph description from a file", "filename" },
+    { "filter_pipeline", HAS_ARG | OPT_INT | OPT_EXPERT,             { &filter_pipeline },
+        "run filters in a pipeline with up to this many frames queued per filter", "nb_frames" },
     { "stats",          OPT_BOOL,                                    { &print_stats },
         "print progress report during encoding", },
     { "attach",         HAS_ARG | OPT_PERFILE | OPT_EXPERT |
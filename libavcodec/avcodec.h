@@ -918,6 +918,11 @@ typedef struct RcOverride{
  * Discard cropping information from SPS.
  */
 #define AV_CODEC_FLAG2_IGNORE_CROP    (1 << 16)
+/**
+ * Allocate the frames of avcodec_default_get_buffer2() from the buffer
+ * pools shared by the whole process, see av_buffer_pool_init_shared().
+ */
+#define AV_CODEC_FLAG2_SHARED_POOLS   (1 << 17)
 
 /**
  * Show all frames before the first keyframe
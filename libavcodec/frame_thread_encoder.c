@@ -23,6 +23,7 @@
 #include "libavutil/fifo.h"
 #include "libavutil/avassert.h"
 #include "libavutil/imgutils.h"
+#include "libavutil/opt.h"
 #include "libavutil/thread.h"
 #include "avcodec.h"
 #include "internal.h"
@@ -117,7 +118,8 @@ int ff_frame_thread_encoder_init(AVCodecContext *avctx, AVDictionary *options){
 
 
     if(   !(avctx->thread_type & FF_THREAD_FRAME)
-       || !(avctx->codec->capabilities & AV_CODEC_CAP_INTRA_ONLY))
+       || !(avctx->codec->capabilities & (AV_CODEC_CAP_INTRA_ONLY |
+                                          AV_CODEC_CAP_FRAME_THREADS)))
         return 0;
 
     if(   !avctx->thread_count
@@ -208,6 +210,18 @@ int ff_frame_thread_encoder_init(AVCodecContext *avctx, AVDictionary *options){
             goto fail;
         }
         av_dict_free(&tmp);
+        // the encoder clears FF_THREAD_FRAME when its options rule it out
+        if (!i && !(thread_avctx->thread_type & FF_THREAD_FRAME)) {
+            av_log(avctx, AV_LOG_VERBOSE,
+                   "Encoder options do not allow frame threading, "
+                   "using a single thread\n");
+            avcodec_close(thread_avctx);
+            av_freep(&thread_avctx);
+            avctx->thread_count = 0;
+            ff_frame_thread_encoder_free(avctx);
+            avctx->thread_count = 1;
+            return 0;
+        }
         av_assert0(!thread_avctx->internal->frame_thread_encoder);
         thread_avctx->internal->frame_thread_encoder = c;
         if(pthread_create(&c->worker[i], NULL, worker, thread_avctx)) {
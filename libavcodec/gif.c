@@ -29,6 +29,7 @@
  */
 
 #define BITSTREAM_WRITER_LE
+#include "libavutil/intreadwrite.h"
 #include "libavutil/opt.h"
 #include "libavutil/imgutils.h"
 #include "avcodec.h"
@@ -58,6 +59,38 @@ enum {
     GF_TRANSDIFF  = 1<<1,
 };
 
+/**
+ * Locate the first byte differing between a and b.
+ * @return index of the first mismatch, or n if the n bytes are identical
+ */
+static int first_diff(const uint8_t *a, const uint8_t *b, int n)
+{
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8)
+        if (AV_RN64(a + i) != AV_RN64(b + i))
+            break;
+    while (i < n && a[i] == b[i])
+        i++;
+    return i;
+}
+
+/**
+ * Locate the last byte differing between a and b.
+ * @return index of the last mismatch, or -1 if the n bytes are identical
+ */
+static int last_diff(const uint8_t *a, const uint8_t *b, int n)
+{
+    int i = n;
+
+    for (; i >= 8; i -= 8)
+        if (AV_RN64(a + i - 8) != AV_RN64(b + i - 8))
+            break;
+    while (i > 0 && a[i - 1] == b[i - 1])
+        i--;
+    return i - 1;
+}
+
 static int pick_palette_entry(const uint8_t *buf, int linesize, int w, int h)
 {
     int histogram[AVPALETTE_COUNT] = {0};
@@ -106,31 +139,19 @@ static int gif_image_write_image(AVCodecContext *avctx,
         }
         height = y_end + 1 - y_start;
 
-        /* skip common columns */
-        while (x_start < x_end) {
-            int same_column = 1;
-            for (y = y_start; y <= y_end; y++) {
-                if (ref[y*ref_linesize + x_start] != buf[y*linesize + x_start]) {
-                    same_column = 0;
-                    break;
-                }
-            }
-            if (!same_column)
-                break;
-            x_start++;
-        }
-        while (x_end > x_start) {
-            int same_column = 1;
-            for (y = y_start; y <= y_end; y++) {
-                if (ref[y*ref_linesize + x_end] != buf[y*linesize + x_end]) {
-                    same_column = 0;
-                    break;
-                }
-            }
-            if (!same_column)
-                break;
-            x_end--;
+        /* skip common columns; rows are scanned word-wise in memory order
+         * instead of walking each column down the whole image */
+        x_start = x_end;
+        x_end   = 0;
+        for (y = y_start; y <= y_end; y++) {
+            const uint8_t *r = ref + y*ref_linesize;
+            const uint8_t *b = buf + y*linesize;
+
+            x_start = first_diff(r, b, x_start);
+            x_end  += 1 + last_diff(r + x_end + 1, b + x_end + 1,
+                                    avctx->width - x_end - 1);
         }
+        x_end = FFMAX(x_end, x_start);
         width = x_end + 1 - x_start;
 
         av_log(avctx, AV_LOG_DEBUG,"%dx%d image at pos (%d;%d) [area:%dx%d]\n",
@@ -229,6 +250,11 @@ FF_DISABLE_DEPRECATION_WARNINGS
 FF_ENABLE_DEPRECATION_WARNINGS
 #endif
 
+    /* offsetting and transdiff code each frame against the previous one,
+     * which a frame thread does not see */
+    if (s->flags & (GF_OFFSETTING | GF_TRANSDIFF))
+        avctx->thread_type &= ~FF_THREAD_FRAME;
+
     s->transparent_index = -1;
 
     s->lzw = av_mallocz(ff_lzw_encode_state_size);
@@ -287,13 +313,17 @@ static int gif_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
 
         /* The first palette with PAL8 will be used as generic palette by the
          * muxer so we don't need to write it locally in the packet. We store
-         * it as a reference here in case it changes later. */
+         * it as a reference here in case it changes later. With frame
+         * threading this context does not know whether it got the first
+         * frame, so the palette is always written locally. */
         if (!s->palette_loaded) {
             memcpy(s->palette, palette, AVPALETTE_SIZE);
             s->transparent_index = get_palette_transparency_index(palette);
             s->palette_loaded = 1;
-            palette = NULL;
-        } else if (!memcmp(s->palette, palette, AVPALETTE_SIZE)) {
+            if (!avctx->internal->frame_thread_encoder)
+                palette = NULL;
+        } else if (!avctx->internal->frame_thread_encoder &&
+                   !memcmp(s->palette, palette, AVPALETTE_SIZE)) {
             palette = NULL;
         }
     }
@@ -354,6 +384,7 @@ AVCodec ff_gif_encoder = {
     .init           = gif_encode_init,
     .encode2        = gif_encode_frame,
     .close          = gif_encode_close,
+    .capabilities   = AV_CODEC_CAP_FRAME_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]){
         AV_PIX_FMT_RGB8, AV_PIX_FMT_BGR8, AV_PIX_FMT_RGB4_BYTE, AV_PIX_FMT_BGR4_BYTE,
         AV_PIX_FMT_GRAY8, AV_PIX_FMT_PAL8, AV_PIX_FMT_NONE
@@ -134,6 +134,19 @@ void ff_h264_draw_horiz_band(const H264Context *h, H264SliceContext *sl,
     }
 }
 
+static void free_scratch_buffers(H264SliceContext *sl)
+{
+    av_freep(&sl->bipred_scratchpad);
+    av_freep(&sl->edge_emu_buffer);
+    av_freep(&sl->top_borders[0]);
+    av_freep(&sl->top_borders[1]);
+
+    sl->bipred_scratchpad_allocated = 0;
+    sl->edge_emu_buffer_allocated   = 0;
+    sl->top_borders_allocated[0]    = 0;
+    sl->top_borders_allocated[1]    = 0;
+}
+
 void ff_h264_free_tables(H264Context *h)
 {
     int i;
@@ -165,16 +178,10 @@ void ff_h264_free_tables(H264Context *h)
         av_freep(&sl->er.error_status_table);
         av_freep(&sl->er.er_temp_buffer);
 
-        av_freep(&sl->bipred_scratchpad);
-        av_freep(&sl->edge_emu_buffer);
-        av_freep(&sl->top_borders[0]);
-        av_freep(&sl->top_borders[1]);
-
-        sl->bipred_scratchpad_allocated = 0;
-        sl->edge_emu_buffer_allocated   = 0;
-        sl->top_borders_allocated[0]    = 0;
-        sl->top_borders_allocated[1]    = 0;
+        free_scratch_buffers(sl);
     }
+    if (h->lf_slice_ctx)
+        free_scratch_buffers(h->lf_slice_ctx);
 }
 
 int ff_h264_alloc_tables(H264Context *h)
@@ -419,7 +426,7 @@ int ff_h264_decode_extradata(H264Context *h, const uint8_t *buf, int size)
 
 static int h264_init_context(AVCodecContext *avctx, H264Context *h)
 {
-    int i;
+    int i, ret;
 
     h->avctx                 = avctx;
     h->backup_width          = -1;
@@ -455,6 +462,17 @@ static int h264_init_context(AVCodecContext *avctx, H264Context *h)
         return AVERROR(ENOMEM);
     }
 
+    if (avctx->active_thread_type & FF_THREAD_SLICE && avctx->thread_count > 1) {
+        h->lf_slice_ctx = av_mallocz(sizeof(*h->lf_slice_ctx));
+        if (!h->lf_slice_ctx)
+            return AVERROR(ENOMEM);
+        h->lf_slice_ctx->h264 = h;
+
+        ret = ff_alloc_entries(avctx, 2);
+        if (ret < 0)
+            return ret;
+    }
+
     for (i = 0; i < H264_MAX_PICTURE_COUNT; i++) {
         h->DPB[i].f = av_frame_alloc();
         if (!h->DPB[i].f)
@@ -1580,6 +1598,7 @@ av_cold void ff_h264_free_context(H264Context *h)
         av_freep(&h->slice_ctx[i].rbsp_buffer);
     av_freep(&h->slice_ctx);
     h->nb_slice_ctx = 0;
+    av_freep(&h->lf_slice_ctx);
 
     h->a53_caption_size = 0;
     av_freep(&h->a53_caption);
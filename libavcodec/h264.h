@@ -427,6 +427,22 @@ typedef struct H264SliceContext {
     int next_slice_idx;
     int mb_skip_run;
     int is_complex;
+    /**
+     * Set when the rows of this slice are deblocked by a second thread,
+     * two rows behind decoding.
+     */
+    int lf_pipeline;
+    /**
+     * Set once the rows above the current one are left to the deblocking
+     * thread, intra prediction then reads their unfiltered samples from the
+     * frame instead of the saved top borders.
+     */
+    int lf_deferred;
+    /**
+     * MB index (mb_x + mb_y * mb_width) where decoding stopped,
+     * -1 while the slice is still being decoded.
+     */
+    int lf_end;
 
     int mb_field_decoding_flag;
     int mb_mbaff;               ///< mb_aff_frame && mb_field_decoding_flag
@@ -527,6 +543,11 @@ typedef struct H264Context {
 
     H264SliceContext *slice_ctx;
     int            nb_slice_ctx;
+    /**
+     * Context of the thread deblocking the rows of a single slice, set when
+     * slice threads are used.
+     */
+    H264SliceContext *lf_slice_ctx;
 
     H2645Packet pkt;
 
@@ -25,6 +25,7 @@
  * @author Michael Niedermayer <michaelni@gmx.at>
  */
 
+#include "libavutil/atomic.h"
 #include "libavutil/avassert.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/timer.h"
@@ -2275,6 +2276,39 @@ static void decode_finish_row(const H264Context *h, H264SliceContext *sl)
                               h->picture_structure == PICT_BOTTOM_FIELD);
 }
 
+/**
+ * Deblock and finish the MB row that was just decoded, or hand it over to
+ * the deblocking thread when rows are filtered in a pipeline.
+ */
+static void decode_row_done(const H264Context *h, H264SliceContext *sl,
+                            int lf_x_start)
+{
+    if (sl->lf_pipeline) {
+        ff_thread_report_progress2(h->avctx, 0, 0, 1);
+        sl->lf_deferred = 1;
+        return;
+    }
+
+    loop_filter(h, sl, lf_x_start, sl->mb_x);
+    decode_finish_row(h, sl);
+}
+
+/**
+ * Deblock the partial MB row at the end of a slice.
+ */
+static void decode_slice_done(const H264Context *h, H264SliceContext *sl,
+                              int lf_x_start, int lf_x_end)
+{
+    if (sl->lf_pipeline) {
+        avpriv_atomic_int_set(&sl->lf_end, lf_x_end + sl->mb_y * h->mb_width);
+        /* a truncated slice can end on the last column, hand the row over
+         * as complete so that the filter thread does not wait for the next */
+        if (lf_x_end >= h->mb_width)
+            ff_thread_report_progress2(h->avctx, 0, 0, 1);
+    } else if (lf_x_end > lf_x_start)
+        loop_filter(h, sl, lf_x_start, lf_x_end);
+}
+
 static void er_add_slice(H264SliceContext *sl,
                          int startx, int starty,
                          int endx, int endy, int status)
@@ -2367,8 +2401,7 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
                 sl->cabac.bytestream > sl->cabac.bytestream_end + 2) {
                 er_add_slice(sl, sl->resync_mb_x, sl->resync_mb_y, sl->mb_x - 1,
                              sl->mb_y, ER_MB_END);
-                if (sl->mb_x >= lf_x_start)
-                    loop_filter(h, sl, lf_x_start, sl->mb_x + 1);
+                decode_slice_done(h, sl, lf_x_start, sl->mb_x + 1);
                 return 0;
             }
             if (sl->cabac.bytestream > sl->cabac.bytestream_end + 2 )
@@ -2384,9 +2417,8 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
             }
 
             if (++sl->mb_x >= h->mb_width) {
-                loop_filter(h, sl, lf_x_start, sl->mb_x);
+                decode_row_done(h, sl, lf_x_start);
                 sl->mb_x = lf_x_start = 0;
-                decode_finish_row(h, sl);
                 ++sl->mb_y;
                 if (FIELD_OR_MBAFF_PICTURE(h)) {
                     ++sl->mb_y;
@@ -2400,8 +2432,7 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
                         get_bits_count(&sl->gb), sl->gb.size_in_bits);
                 er_add_slice(sl, sl->resync_mb_x, sl->resync_mb_y, sl->mb_x - 1,
                              sl->mb_y, ER_MB_END);
-                if (sl->mb_x > lf_x_start)
-                    loop_filter(h, sl, lf_x_start, sl->mb_x);
+                decode_slice_done(h, sl, lf_x_start, sl->mb_x);
                 return 0;
             }
         }
@@ -2441,9 +2472,8 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
             }
 
             if (++sl->mb_x >= h->mb_width) {
-                loop_filter(h, sl, lf_x_start, sl->mb_x);
+                decode_row_done(h, sl, lf_x_start);
                 sl->mb_x = lf_x_start = 0;
-                decode_finish_row(h, sl);
                 ++sl->mb_y;
                 if (FIELD_OR_MBAFF_PICTURE(h)) {
                     ++sl->mb_y;
@@ -2476,8 +2506,7 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
                 if (get_bits_left(&sl->gb) == 0) {
                     er_add_slice(sl, sl->resync_mb_x, sl->resync_mb_y,
                                  sl->mb_x - 1, sl->mb_y, ER_MB_END);
-                    if (sl->mb_x > lf_x_start)
-                        loop_filter(h, sl, lf_x_start, sl->mb_x);
+                    decode_slice_done(h, sl, lf_x_start, sl->mb_x);
 
                     return 0;
                 } else {
@@ -2491,6 +2520,121 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg)
     }
 }
 
+/**
+ * Deblock the rows of a slice as the decoding thread completes them. A row is
+ * filtered once the row below it is decoded as well, so that neither intra
+ * prediction nor the filter of the next row see partially filtered samples.
+ */
+static int loop_filter_rows(const H264Context *h, H264SliceContext *sl,
+                            H264SliceContext *lf_sl)
+{
+    int mb_y;
+
+    for (mb_y = lf_sl->mb_y; mb_y < h->mb_height; mb_y++) {
+        int end;
+
+        ff_thread_await_progress2(h->avctx, 1, 1, 2);
+        end = avpriv_atomic_int_get(&sl->lf_end);
+
+        lf_sl->mb_y = mb_y;
+        if (end >= 0 && end < (mb_y + 1) * h->mb_width) {
+            if (end > mb_y * h->mb_width)
+                loop_filter(h, lf_sl, 0, end - mb_y * h->mb_width);
+            break;
+        }
+        loop_filter(h, lf_sl, 0, h->mb_width);
+        decode_finish_row(h, lf_sl);
+        ff_thread_report_progress2(h->avctx, 1, 1, 1);
+    }
+
+    return 0;
+}
+
+static int decode_slice_pipeline(struct AVCodecContext *avctx, void *arg,
+                                 int jobnr, int threadnr)
+{
+    H264SliceContext **ctx = arg;
+    H264SliceContext *sl   = ctx[0];
+    const H264Context *h   = sl->h264;
+    int ret;
+
+    if (jobnr)
+        return loop_filter_rows(h, sl, ctx[1]);
+
+    ret = decode_slice(avctx, sl);
+
+    // the partial row is not deblocked if decoding stopped on an error
+    if (avpriv_atomic_int_get(&sl->lf_end) < 0)
+        avpriv_atomic_int_set(&sl->lf_end, sl->mb_y * h->mb_width);
+    ff_thread_report_progress2(avctx, 0, 0, 2);
+
+    return ret;
+}
+
+/**
+ * Decode a single slice while deblocking its rows on a second thread.
+ * Used when slice threads are available but the slices of the picture
+ * cannot be decoded in parallel.
+ *
+ * @return the return value of decode_slice() or a negative error code if
+ *         the pipeline could not be set up
+ */
+static int decode_slice_lf_pipeline(H264Context *h, H264SliceContext *sl)
+{
+    H264SliceContext *lf_sl  = h->lf_slice_ctx;
+    H264SliceContext *ctx[2] = { sl, lf_sl };
+    uint8_t *bipred_scratchpad = lf_sl->bipred_scratchpad;
+    uint8_t *edge_emu_buffer   = lf_sl->edge_emu_buffer;
+    uint8_t (*top_borders[2])[(16 * 3) * 2] = { lf_sl->top_borders[0],
+                                                lf_sl->top_borders[1] };
+    int bipred_scratchpad_allocated = lf_sl->bipred_scratchpad_allocated;
+    int edge_emu_buffer_allocated   = lf_sl->edge_emu_buffer_allocated;
+    int top_borders_allocated[2]    = { lf_sl->top_borders_allocated[0],
+                                        lf_sl->top_borders_allocated[1] };
+    int ret[2] = { 0 };
+    int i, err;
+
+    sl->linesize   = h->cur_pic_ptr->f->linesize[0];
+    sl->uvlinesize = h->cur_pic_ptr->f->linesize[1];
+
+    err = alloc_scratch_buffers(sl, sl->linesize);
+    if (err < 0)
+        return err;
+
+    /* The deblocking thread works on a copy of the slice context with
+     * scratch buffers of its own. The top borders it backs up are copied
+     * back for the intra prediction of the next slice. */
+    memcpy(lf_sl, sl, sizeof(*sl));
+    lf_sl->bipred_scratchpad           = bipred_scratchpad;
+    lf_sl->edge_emu_buffer             = edge_emu_buffer;
+    lf_sl->bipred_scratchpad_allocated = bipred_scratchpad_allocated;
+    lf_sl->edge_emu_buffer_allocated   = edge_emu_buffer_allocated;
+    for (i = 0; i < 2; i++) {
+        lf_sl->top_borders[i]           = top_borders[i];
+        lf_sl->top_borders_allocated[i] = top_borders_allocated[i];
+    }
+
+    err = alloc_scratch_buffers(lf_sl, sl->linesize);
+    if (err < 0)
+        return err;
+    for (i = 0; i < 2; i++)
+        memcpy(lf_sl->top_borders[i], sl->top_borders[i],
+               h->mb_width * sizeof(*sl->top_borders[i]));
+
+    ff_reset_entries(h->avctx);
+    sl->lf_end      = -1;
+    sl->lf_pipeline = 1;
+    h->avctx->execute2(h->avctx, decode_slice_pipeline, ctx, ret, 2);
+    sl->lf_pipeline = 0;
+    sl->lf_deferred = 0;
+
+    for (i = 0; i < 2; i++)
+        memcpy(sl->top_borders[i], lf_sl->top_borders[i],
+               h->mb_width * sizeof(*sl->top_borders[i]));
+
+    return ret[0];
+}
+
 /**
  * Call decode_slice() for each context.
  *
@@ -2516,9 +2660,14 @@ int ff_h264_execute_decode_slices(H264Context *h, unsigned context_count)
     if (context_count == 1) {
         int ret;
 
-        h->slice_ctx[0].next_slice_idx = h->mb_width * h->mb_height;
+        sl = &h->slice_ctx[0];
+        sl->next_slice_idx = h->mb_width * h->mb_height;
 
-        ret = decode_slice(avctx, &h->slice_ctx[0]);
+        if (h->lf_slice_ctx && sl->deblocking_filter &&
+            !sl->mb_x && !FIELD_OR_MBAFF_PICTURE(h))
+            ret = decode_slice_lf_pipeline(h, sl);
+        else
+            ret = decode_slice(avctx, sl);
         h->mb_y = h->slice_ctx[0].mb_y;
         return ret;
     } else {
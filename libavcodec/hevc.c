@@ -2344,22 +2344,105 @@ static int hls_decode_entry(AVCodecContext *avctxt, void *isFilterThread)
         more_data = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
         if (more_data < 0) {
             s->tab_slice_address[ctb_addr_rs] = -1;
+            if (s->pipeline_filters)
+                avpriv_atomic_int_set(&s->filter_ctb_end, ctb_addr_ts);
             return more_data;
         }
 
 
         ctb_addr_ts++;
         ff_hevc_save_states(s, ctb_addr_ts);
-        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+        if (s->pipeline_filters)
+            ff_thread_report_progress2(s->avctx, 0, 0, 1);
+        else
+            ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
     }
 
-    if (x_ctb + ctb_size >= s->ps.sps->width &&
+    if (!s->pipeline_filters &&
+        x_ctb + ctb_size >= s->ps.sps->width &&
         y_ctb + ctb_size >= s->ps.sps->height)
         ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
 
     return ctb_addr_ts;
 }
 
+static int hevc_alloc_thread_contexts(HEVCContext *s)
+{
+    int i;
+
+    for (i = 1; i < s->threads_number; i++) {
+        if (s->sList[i])
+            continue;
+        s->sList[i]      = av_malloc(sizeof(HEVCContext));
+        s->HEVClcList[i] = av_mallocz(sizeof(HEVCLocalContext));
+        if (!s->sList[i] || !s->HEVClcList[i]) {
+            av_freep(&s->sList[i]);
+            av_freep(&s->HEVClcList[i]);
+            return AVERROR(ENOMEM);
+        }
+        memcpy(s->sList[i], s, sizeof(HEVCContext));
+        s->sList[i]->HEVClc = s->HEVClcList[i];
+    }
+
+    return 0;
+}
+
+/**
+ * Run the deblocking and SAO filters on the CTBs decoded by
+ * hls_decode_entry(), in the same order and with the same lag as the
+ * single-threaded path, as soon as the decoding thread reports them.
+ */
+static int hls_filter_entry(HEVCContext *s1)
+{
+    HEVCContext *s  = s1->sList[1];
+    int ctb_size    = 1 << s->ps.sps->log2_ctb_size;
+    int ctb_addr_ts = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+
+    for (;; ctb_addr_ts++) {
+        int ctb_end, ctb_addr_rs, x_ctb, y_ctb;
+
+        ff_thread_await_progress2(s->avctx, 1, 1, 1);
+        ctb_end = avpriv_atomic_int_get(&s1->filter_ctb_end);
+        if (ctb_end >= 0 && ctb_addr_ts >= ctb_end)
+            break;
+
+        ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+        x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+
+        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+        if (x_ctb + ctb_size >= s->ps.sps->width &&
+            y_ctb + ctb_size >= s->ps.sps->height)
+            ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
+
+        ff_thread_report_progress2(s->avctx, 1, 1, 1);
+    }
+
+    return 0;
+}
+
+static int hls_decode_entry_pipeline(AVCodecContext *avctxt, void *arg, int job, int self_id)
+{
+    HEVCContext *s = avctxt->priv_data;
+    int ctb_addr_ts, ctb_start;
+
+    if (job)
+        return hls_filter_entry(s);
+
+    ctb_start   = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+    ctb_addr_ts = hls_decode_entry(avctxt, arg);
+
+    // a CTB that failed to decode already set the end, as it is not filtered
+    if (ctb_addr_ts >= 0)
+        avpriv_atomic_int_set(&s->filter_ctb_end, ctb_addr_ts);
+    else if (avpriv_atomic_int_get(&s->filter_ctb_end) < 0)
+        avpriv_atomic_int_set(&s->filter_ctb_end, ctb_start);
+    // wake up the filter thread so that it sees the end of the slice
+    ff_thread_report_progress2(avctxt, 0, 0, 1);
+
+    return ctb_addr_ts;
+}
+
 static int hls_slice_data(HEVCContext *s)
 {
     int arg[2];
@@ -2368,6 +2451,23 @@ static int hls_slice_data(HEVCContext *s)
     arg[0] = 0;
     arg[1] = 1;
 
+    /* With slice threads but no entry points to spread CABAC decoding over,
+     * overlap the in-loop filters with the decoding of the following CTBs. */
+    if (s->threads_number > 1) {
+        if (ff_alloc_entries(s->avctx, 2) >= 0 &&
+            hevc_alloc_thread_contexts(s) >= 0) {
+            memcpy(s->sList[1], s, sizeof(HEVCContext));
+            s->sList[1]->HEVClc = s->HEVClcList[1];
+
+            ff_reset_entries(s->avctx);
+            avpriv_atomic_int_set(&s->filter_ctb_end, -1);
+            s->pipeline_filters = 1;
+            s->avctx->execute2(s->avctx, hls_decode_entry_pipeline, arg, ret, 2);
+            s->pipeline_filters = 0;
+            return ret[0];
+        }
+    }
+
     s->avctx->execute(s->avctx, hls_decode_entry, arg, ret , 1, sizeof(int));
     return ret[0];
 }
@@ -2476,14 +2576,9 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
 
     ff_alloc_entries(s->avctx, s->sh.num_entry_point_offsets + 1);
 
-    if (!s->sList[1]) {
-        for (i = 1; i < s->threads_number; i++) {
-            s->sList[i] = av_malloc(sizeof(HEVCContext));
-            memcpy(s->sList[i], s, sizeof(HEVCContext));
-            s->HEVClcList[i] = av_mallocz(sizeof(HEVCLocalContext));
-            s->sList[i]->HEVClc = s->HEVClcList[i];
-        }
-    }
+    res = hevc_alloc_thread_contexts(s);
+    if (res < 0)
+        goto error;
 
     offset = (lc->gb.index >> 3);
 
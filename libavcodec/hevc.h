@@ -877,6 +877,16 @@ typedef struct HEVCContext {
 
     int enable_parallel_tiles;
     int wpp_err;
+    /**
+     * Set when the in-loop filters of a slice run on a separate thread,
+     * behind CABAC decoding and reconstruction.
+     */
+    int pipeline_filters;
+    /**
+     * ctb_addr_ts one past the last CTB handed to the filter thread,
+     * -1 while the slice is still being decoded.
+     */
+    int filter_ctb_end;
 
     const uint8_t *data;
 
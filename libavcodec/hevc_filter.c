@@ -651,6 +651,16 @@ static void deblocking_filter_CTB(HEVCContext *s, int x0, int y0)
 static int boundary_strength(HEVCContext *s, MvField *curr, MvField *neigh,
                              RefPicList *neigh_refPicList)
 {
+    // identical motion against the same reference lists, the common case
+    // inside a prediction unit and between merged neighbours
+    if (neigh_refPicList == s->ref->refPicList &&
+        curr->pred_flag  == neigh->pred_flag  &&
+        curr->ref_idx[0] == neigh->ref_idx[0] &&
+        curr->ref_idx[1] == neigh->ref_idx[1] &&
+        curr->mv[0].x    == neigh->mv[0].x    && curr->mv[0].y == neigh->mv[0].y &&
+        curr->mv[1].x    == neigh->mv[1].x    && curr->mv[1].y == neigh->mv[1].y)
+        return 0;
+
     if (curr->pred_flag == PF_BI &&  neigh->pred_flag == PF_BI) {
         // same L0 and L1
         if (s->ref->refPicList[0].list[curr->ref_idx[0]] == neigh_refPicList[0].list[neigh->ref_idx[0]]  &&
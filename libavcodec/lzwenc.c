@@ -36,14 +36,16 @@
 #define LZW_HASH_SHIFT 6
 
 #define LZW_PREFIX_EMPTY -1
-#define LZW_PREFIX_FREE -2
+
+/** Pack prefix code and suffix character into a single comparable key */
+#define LZW_KEY(prefix, c) (((prefix) + 1) << 8 | (c))
+#define LZW_KEY_FREE -1
 
 /** One code in hash table */
 typedef struct Code{
-    /// Hash code of prefix, LZW_PREFIX_EMPTY if empty prefix, or LZW_PREFIX_FREE if no code
-    int hash_prefix;
+    /// LZW_KEY() of prefix code and last character, LZW_KEY_FREE if no code
+    int key;
     int code;               ///< LZW code
-    uint8_t suffix;         ///< Last character in code block
 }Code;
 
 /** LZW encode state */
@@ -126,12 +128,12 @@ static inline void writeCode(LZWEncodeState * s, int c)
  */
 static inline int findCode(LZWEncodeState * s, uint8_t c, int hash_prefix)
 {
+    const int key = LZW_KEY(hash_prefix, c);
     int h = hash(FFMAX(hash_prefix, 0), c);
     int hash_offset = hashOffset(h);
 
-    while (s->tab[h].hash_prefix != LZW_PREFIX_FREE) {
-        if ((s->tab[h].suffix == c)
-            && (s->tab[h].hash_prefix == hash_prefix))
+    while (s->tab[h].key != LZW_KEY_FREE) {
+        if (s->tab[h].key == key)
             return h;
         h = hashNext(h, hash_offset);
     }
@@ -149,8 +151,7 @@ static inline int findCode(LZWEncodeState * s, uint8_t c, int hash_prefix)
 static inline void addCode(LZWEncodeState * s, uint8_t c, int hash_prefix, int hash_code)
 {
     s->tab[hash_code].code = s->tabsize;
-    s->tab[hash_code].suffix = c;
-    s->tab[hash_code].hash_prefix = hash_prefix;
+    s->tab[hash_code].key  = LZW_KEY(hash_prefix, c);
 
     s->tabsize++;
 
@@ -169,13 +170,12 @@ static void clearTable(LZWEncodeState * s)
     writeCode(s, s->clear_code);
     s->bits = 9;
     for (i = 0; i < LZW_HASH_SIZE; i++) {
-        s->tab[i].hash_prefix = LZW_PREFIX_FREE;
+        s->tab[i].key = LZW_KEY_FREE;
     }
     for (i = 0; i < 256; i++) {
         h = hash(0, i);
         s->tab[h].code = i;
-        s->tab[h].suffix = i;
-        s->tab[h].hash_prefix = LZW_PREFIX_EMPTY;
+        s->tab[h].key  = LZW_KEY(LZW_PREFIX_EMPTY, i);
     }
     s->tabsize = 258;
 }
@@ -238,7 +238,7 @@ int ff_lzw_encode(LZWEncodeState * s, const uint8_t * inbuf, int insize)
     for (i = 0; i < insize; i++) {
         uint8_t c = *inbuf++;
         int code = findCode(s, c, s->last_code);
-        if (s->tab[code].hash_prefix == LZW_PREFIX_FREE) {
+        if (s->tab[code].key == LZW_KEY_FREE) {
             writeCode(s, s->last_code);
             addCode(s, c, s->last_code, code);
             code= hash(0, c);
@@ -45,6 +45,17 @@ typedef struct APNGFctlChunk {
     uint8_t dispose_op, blend_op;
 } APNGFctlChunk;
 
+/** Row band deflated independently when encoding with several slices */
+typedef struct PNGBand {
+    int y_start, y_end;          ///< rows [y_start, y_end) of the image
+    uint8_t *buf;                ///< raw deflate output, ends byte aligned
+    unsigned int buf_size;
+    int len;                     ///< bytes of deflated data in buf
+    uLong adler;                 ///< adler32 of the filtered band rows
+    uLong in_len;                ///< number of filtered bytes in the band
+    int ret;
+} PNGBand;
+
 typedef struct PNGEncContext {
     AVClass *class;
     HuffYUVEncDSPContext hdsp;
@@ -74,6 +85,12 @@ typedef struct PNGEncContext {
     APNGFctlChunk last_frame_fctl;
     uint8_t *last_frame_packet;
     size_t last_frame_packet_size;
+
+    // row band compression
+    int compression_level;
+    const AVFrame *band_pict;    ///< frame being compressed by the band jobs
+    PNGBand *bands;
+    int nb_bands;
 } PNGEncContext;
 
 static void png_get_interlaced_row(uint8_t *dst, int row_size,
@@ -188,6 +205,22 @@ static void png_filter_row(PNGEncContext *c, uint8_t *dst, int filter_type,
     }
 }
 
+/**
+ * Sum of absolute values of the filtered bytes taken as signed, the usual
+ * heuristic for the compressibility of a row.
+ * Kept branch free so that the compiler can vectorize it.
+ */
+static int png_filter_cost(const uint8_t *buf, int size)
+{
+    int i, cost = 0;
+
+    for (i = 0; i < size; i++) {
+        int v = (int8_t)buf[i];
+        cost += FFABS(v);
+    }
+    return cost;
+}
+
 static uint8_t *png_choose_filter(PNGEncContext *s, uint8_t *dst,
                                   uint8_t *src, uint8_t *top, int size, int bpp)
 {
@@ -196,15 +229,12 @@ static uint8_t *png_choose_filter(PNGEncContext *s, uint8_t *dst,
     if (!top && pred)
         pred = PNG_FILTER_VALUE_SUB;
     if (pred == PNG_FILTER_VALUE_MIXED) {
-        int i;
         int cost, bcost = INT_MAX;
         uint8_t *buf1 = dst, *buf2 = dst + size + 16;
         for (pred = 0; pred < 5; pred++) {
             png_filter_row(s, buf1 + 1, pred, src, top, size, bpp);
             buf1[0] = pred;
-            cost = 0;
-            for (i = 0; i <= size; i++)
-                cost += abs((int8_t) buf1[i]);
+            cost = png_filter_cost(buf1, size + 1);
             if (cost < bcost) {
                 bcost = cost;
                 FFSWAP(uint8_t *, buf1, buf2);
@@ -425,6 +455,197 @@ static int encode_headers(AVCodecContext *avctx, const AVFrame *pict)
     return 0;
 }
 
+static int png_deflate_band(z_stream *zs, PNGBand *band, int flush)
+{
+    int ret;
+
+    do {
+        if (!zs->avail_out) {
+            uint8_t *buf = av_fast_realloc(band->buf, &band->buf_size,
+                                           band->buf_size + IOBUF_SIZE);
+            if (!buf)
+                return AVERROR(ENOMEM);
+            band->buf     = buf;
+            zs->next_out  = buf + band->len;
+            zs->avail_out = band->buf_size - band->len;
+        }
+        ret = deflate(zs, flush);
+        band->len = zs->next_out - band->buf;
+        if (ret == Z_STREAM_END)
+            return 0;
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+            return AVERROR_EXTERNAL;
+    } while (zs->avail_in || !zs->avail_out || flush == Z_FINISH);
+    return 0;
+}
+
+/**
+ * Filter and deflate one row band into a raw deflate stream.
+ * Bands other than the last one end with a sync flush so that their output
+ * can simply be concatenated. The window is primed with the filtered rows
+ * preceding the band, which keeps the compression ratio close to the one
+ * of a single stream.
+ */
+static int png_encode_band(AVCodecContext *avctx, void *arg)
+{
+    PNGEncContext *s    = avctx->priv_data;
+    PNGBand *band       = arg;
+    const AVFrame *pict = s->band_pict;
+    const int row_size  = (pict->width * s->bits_per_pixel + 7) >> 3;
+    const int bpp       = s->bits_per_pixel >> 3;
+    const int dict_rows = FFMIN(band->y_start, (32768 + row_size) / (row_size + 1));
+    const int dict_len  = dict_rows * (row_size + 1);
+    uint8_t *crow_base, *crow_buf, *crow, *top = NULL, *dict = NULL;
+    z_stream zs = { 0 };
+    int y, ret;
+
+    band->len    = 0;
+    band->in_len = 0;
+    band->adler  = adler32(0, NULL, 0);
+
+    crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
+    if (dict_rows)
+        dict = av_malloc(dict_len);
+    if (!crow_base || (dict_rows && !dict)) {
+        ret = AVERROR(ENOMEM);
+        goto the_end;
+    }
+    crow_buf = crow_base + 15;
+
+    zs.zalloc = ff_png_zalloc;
+    zs.zfree  = ff_png_zfree;
+    zs.opaque = NULL;
+    if (deflateInit2(&zs, s->compression_level, Z_DEFLATED, -15, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        ret = AVERROR_EXTERNAL;
+        goto the_end;
+    }
+    crow = av_fast_realloc(band->buf, &band->buf_size,
+                           deflateBound(&zs, (band->y_end - band->y_start) * (row_size + 1)) + 64);
+    if (!crow) {
+        ret = AVERROR(ENOMEM);
+        goto the_end;
+    }
+    band->buf = crow;
+
+    if (dict_rows) {
+        uint8_t *dst = dict;
+
+        y = band->y_start - dict_rows;
+        if (y > 0)
+            top = pict->data[0] + (y - 1) * pict->linesize[0];
+        for (; y < band->y_start; y++) {
+            uint8_t *ptr = pict->data[0] + y * pict->linesize[0];
+            crow = png_choose_filter(s, crow_buf, ptr, top, row_size, bpp);
+            memcpy(dst, crow, row_size + 1);
+            dst += row_size + 1;
+            top  = ptr;
+        }
+        deflateSetDictionary(&zs, dict + FFMAX(dict_len - 32768, 0),
+                             FFMIN(dict_len, 32768));
+    }
+
+    zs.next_out  = band->buf;
+    zs.avail_out = band->buf_size;
+    for (y = band->y_start; y < band->y_end; y++) {
+        uint8_t *ptr = pict->data[0] + y * pict->linesize[0];
+        crow = png_choose_filter(s, crow_buf, ptr, top, row_size, bpp);
+        band->adler   = adler32(band->adler, crow, row_size + 1);
+        band->in_len += row_size + 1;
+        zs.next_in    = crow;
+        zs.avail_in   = row_size + 1;
+        ret = png_deflate_band(&zs, band, Z_NO_FLUSH);
+        if (ret < 0)
+            goto the_end;
+        top = ptr;
+    }
+    ret = png_deflate_band(&zs, band, band->y_end == pict->height ? Z_FINISH
+                                                                   : Z_SYNC_FLUSH);
+
+the_end:
+    deflateEnd(&zs);
+    av_free(crow_base);
+    av_free(dict);
+    band->ret = ret;
+    return ret;
+}
+
+static void png_write_band_data(AVCodecContext *avctx, int *pos,
+                                const uint8_t *data, int size)
+{
+    PNGEncContext *s = avctx->priv_data;
+
+    while (size > 0) {
+        int len = FFMIN(size, IOBUF_SIZE - *pos);
+        memcpy(s->buf + *pos, data, len);
+        *pos += len;
+        data += len;
+        size -= len;
+        if (*pos == IOBUF_SIZE) {
+            if (s->bytestream_end - s->bytestream > IOBUF_SIZE + 100)
+                png_write_image_data(avctx, s->buf, IOBUF_SIZE);
+            *pos = 0;
+        }
+    }
+}
+
+/**
+ * Write the image as a single zlib stream made of independently deflated
+ * row bands, compressed in parallel when slice threading is active.
+ */
+static int encode_frame_bands(AVCodecContext *avctx, const AVFrame *pict)
+{
+    PNGEncContext *s = avctx->priv_data;
+    int nb_bands     = FFMIN(avctx->slices, pict->height);
+    int level        = s->compression_level == Z_DEFAULT_COMPRESSION ? 6
+                                                                     : s->compression_level;
+    uLong adler      = adler32(0, NULL, 0);
+    uint8_t buf[4];
+    int i, pos = 0;
+
+    if (nb_bands > s->nb_bands) {
+        int ret = av_reallocp_array(&s->bands, nb_bands, sizeof(*s->bands));
+        if (ret < 0) {
+            s->nb_bands = 0;
+            return ret;
+        }
+        memset(s->bands + s->nb_bands, 0,
+               (nb_bands - s->nb_bands) * sizeof(*s->bands));
+        s->nb_bands = nb_bands;
+    }
+    for (i = 0; i < nb_bands; i++) {
+        s->bands[i].y_start = pict->height *  i      / nb_bands;
+        s->bands[i].y_end   = pict->height * (i + 1) / nb_bands;
+    }
+
+    s->band_pict = pict;
+    avctx->execute(avctx, png_encode_band, s->bands, NULL, nb_bands,
+                   sizeof(*s->bands));
+    s->band_pict = NULL;
+
+    /* zlib header, 32K window, compression level hint, see RFC 1950 */
+    buf[0]  = 0x78;
+    buf[1]  = (level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6;
+    buf[1] += 31 - (buf[0] << 8 | buf[1]) % 31;
+    png_write_band_data(avctx, &pos, buf, 2);
+
+    for (i = 0; i < nb_bands; i++) {
+        PNGBand *band = &s->bands[i];
+
+        if (band->ret < 0)
+            return band->ret;
+        png_write_band_data(avctx, &pos, band->buf, band->len);
+        adler = adler32_combine(adler, band->adler, band->in_len);
+    }
+
+    AV_WB32(buf, adler);
+    png_write_band_data(avctx, &pos, buf, 4);
+    if (pos > 0 && s->bytestream_end - s->bytestream > pos + 100)
+        png_write_image_data(avctx, s->buf, pos);
+
+    return 0;
+}
+
 static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 {
     PNGEncContext *s       = avctx->priv_data;
@@ -436,6 +657,9 @@ static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
     uint8_t *progressive_buf = NULL;
     uint8_t *top_buf         = NULL;
 
+    if (avctx->slices > 1 && !s->is_progressive)
+        return encode_frame_bands(avctx, pict);
+
     row_size = (pict->width * s->bits_per_pixel + 7) >> 3;
 
     crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
@@ -1079,6 +1303,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
     compression_level = avctx->compression_level == FF_COMPRESSION_DEFAULT
                       ? Z_DEFAULT_COMPRESSION
                       : av_clip(avctx->compression_level, 0, 9);
+    s->compression_level = compression_level;
     if (deflateInit2(&s->zstream, compression_level, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
         return -1;
 
@@ -1088,11 +1313,16 @@ FF_ENABLE_DEPRECATION_WARNINGS
 static av_cold int png_enc_close(AVCodecContext *avctx)
 {
     PNGEncContext *s = avctx->priv_data;
+    int i;
 
     deflateEnd(&s->zstream);
     av_frame_free(&s->last_frame);
     av_frame_free(&s->prev_frame);
     av_freep(&s->last_frame_packet);
+    for (i = 0; i < s->nb_bands; i++)
+        av_freep(&s->bands[i].buf);
+    av_freep(&s->bands);
+    s->nb_bands = 0;
     return 0;
 }
 
@@ -1134,7 +1364,8 @@ AVCodec ff_png_encoder = {
     .init           = png_enc_init,
     .close          = png_enc_close,
     .encode2        = encode_png,
-    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_INTRA_ONLY,
+    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS |
+                      AV_CODEC_CAP_INTRA_ONLY,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA,
         AV_PIX_FMT_RGB48BE, AV_PIX_FMT_RGBA64BE,
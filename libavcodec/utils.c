@@ -506,8 +506,12 @@ int avcodec_fill_audio_frame(AVFrame *frame, int nb_channels,
 static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
 {
     FramePool *pool = avctx->internal->pool;
+    AVBufferPool *(*pool_init)(int size, AVBufferRef *(*alloc)(int size));
     int i, ret;
 
+    pool_init = avctx->flags2 & AV_CODEC_FLAG2_SHARED_POOLS ?
+                av_buffer_pool_init_shared : av_buffer_pool_init;
+
     switch (avctx->codec_type) {
     case AVMEDIA_TYPE_VIDEO: {
         uint8_t *data[4];
@@ -550,10 +554,10 @@ static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
             av_buffer_pool_uninit(&pool->pools[i]);
             pool->linesize[i] = linesize[i];
             if (size[i]) {
-                pool->pools[i] = av_buffer_pool_init(size[i] + 16 + STRIDE_ALIGN - 1,
-                                                     CONFIG_MEMORY_POISONING ?
-                                                        NULL :
-                                                        av_buffer_allocz);
+                pool->pools[i] = pool_init(size[i] + 16 + STRIDE_ALIGN - 1,
+                                           CONFIG_MEMORY_POISONING ?
+                                              NULL :
+                                              av_buffer_allocz);
                 if (!pool->pools[i]) {
                     ret = AVERROR(ENOMEM);
                     goto fail;
@@ -581,7 +585,7 @@ static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
         if (ret < 0)
             goto fail;
 
-        pool->pools[0] = av_buffer_pool_init(pool->linesize[0], NULL);
+        pool->pools[0] = pool_init(pool->linesize[0], NULL);
         if (!pool->pools[0]) {
             ret = AVERROR(ENOMEM);
             goto fail;
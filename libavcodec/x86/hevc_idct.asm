@@ -21,6 +21,11 @@
 ; */
 %include "libavutil/x86/x86util.asm"
 
+SECTION_RODATA
+
+; size in bytes of the 4x4 to 32x32 coefficient blocks
+transform_skip_size: dd 32, 128, 512, 2048
+
 SECTION .text
 
 ; void ff_hevc_idctHxW_dc_{8,10}_<opt>(int16_t *coeffs)
@@ -120,3 +125,40 @@ INIT_YMM avx2
 IDCT_DC    16,  2, 12
 IDCT_DC    32,  8, 12
 %endif ;HAVE_AVX2_EXTERNAL
+
+; void ff_hevc_transform_skip_{8,10}_<opt>(int16_t *coeffs, int16_t log2_size)
+; Computes (coeff + (1 << (shift - 1))) >> shift with shift = 15 - bitdepth - log2_size
+; as pmulhrsw by 1 << (bitdepth + log2_size), which keeps the 17-bit intermediate
+; of the C version.
+; %1 = bitdepth
+%macro TRANSFORM_SKIP 1
+cglobal hevc_transform_skip_%1, 2, 4, 2, coeffs, log2, cnt, tmp
+    movsx            log2d, log2w
+    cmp              log2d, 15 - %1
+    jge .end                        ; shift can only be 0 here, nothing to do
+    lea               tmpq, [transform_skip_size]
+    mov               cntd, [tmpq + log2q*4 - 8]
+    mov               tmpd, 1 << %1
+    movd               xm1, tmpd
+    movd               xm0, log2d
+    psllw              xm1, xm0
+    SPLATW              m1, xm1
+.loop:
+    pmulhrsw            m0, m1, [coeffsq]
+    mova         [coeffsq], m0
+    add            coeffsq, mmsize
+    sub               cntd, mmsize
+    jg .loop
+.end:
+    RET
+%endmacro
+
+INIT_XMM ssse3
+TRANSFORM_SKIP  8
+TRANSFORM_SKIP 10
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+TRANSFORM_SKIP  8
+TRANSFORM_SKIP 10
+%endif ;HAVE_AVX2_EXTERNAL
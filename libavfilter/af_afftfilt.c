@@ -34,7 +34,8 @@ typedef struct AFFTFiltContext {
     char *img_str;
     int fft_bits;
 
-    FFTContext *fft, *ifft;
+    FFTContext **fft, **ifft;   ///< one pair per channel job
+    int nb_jobs;
     FFTComplex **fft_data;
     int nb_exprs;
     int window_size;
@@ -98,11 +99,19 @@ static int config_input(AVFilterLink *inlink)
     char *args;
     const char *last_expr = "1";
 
-    s->fft  = av_fft_init(s->fft_bits, 0);
-    s->ifft = av_fft_init(s->fft_bits, 1);
+    s->nb_jobs = ff_filter_channel_jobs(ctx, inlink->channels);
+    s->fft  = av_calloc(s->nb_jobs, sizeof(*s->fft));
+    s->ifft = av_calloc(s->nb_jobs, sizeof(*s->ifft));
     if (!s->fft || !s->ifft)
         return AVERROR(ENOMEM);
 
+    for (i = 0; i < s->nb_jobs; i++) {
+        s->fft[i]  = av_fft_init(s->fft_bits, 0);
+        s->ifft[i] = av_fft_init(s->fft_bits, 1);
+        if (!s->fft[i] || !s->ifft[i])
+            return AVERROR(ENOMEM);
+    }
+
     s->window_size = 1 << s->fft_bits;
 
     s->fft_data = av_calloc(inlink->channels, sizeof(*s->fft_data));
@@ -185,17 +194,87 @@ static int config_input(AVFilterLink *inlink)
     return ret;
 }
 
+typedef struct ThreadData {
+    AVFrame *in;
+    const double *values;
+} ThreadData;
+
+static int filter_channels(AVFilterContext *ctx, void *arg, int jobnr,
+                           int ch_start, int ch_end)
+{
+    AFFTFiltContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int window_size = s->window_size;
+    const float f = 1. / s->win_scale;
+    double values[VAR_VARS_NB];
+    int ch, n, i, j;
+
+    memcpy(values, td->values, sizeof(values));
+
+    for (ch = ch_start; ch < ch_end; ch++) {
+        const float *src = (float *)td->in->extended_data[ch];
+        FFTComplex *fft_data = s->fft_data[ch];
+        float *buf = (float *)s->buffer->extended_data[ch];
+        int x;
+
+        for (n = 0; n < td->in->nb_samples; n++) {
+            fft_data[n].re = src[n] * s->window_func_lut[n];
+            fft_data[n].im = 0;
+        }
+
+        for (; n < window_size; n++) {
+            fft_data[n].re = 0;
+            fft_data[n].im = 0;
+        }
+
+        values[VAR_CHANNEL] = ch;
+
+        av_fft_permute(s->fft[jobnr], fft_data);
+        av_fft_calc(s->fft[jobnr], fft_data);
+
+        for (n = 0; n < window_size / 2; n++) {
+            float fr, fi;
+
+            values[VAR_BIN] = n;
+
+            fr = av_expr_eval(s->real[ch], values, s);
+            fi = av_expr_eval(s->imag[ch], values, s);
+
+            fft_data[n].re *= fr;
+            fft_data[n].im *= fi;
+        }
+
+        for (n = window_size / 2 + 1, x = window_size / 2 - 1; n < window_size; n++, x--) {
+            fft_data[n].re =  fft_data[x].re;
+            fft_data[n].im = -fft_data[x].im;
+        }
+
+        av_fft_permute(s->ifft[jobnr], fft_data);
+        av_fft_calc(s->ifft[jobnr], fft_data);
+
+        for (i = 0, j = s->start; j < s->end && i < window_size; i++, j++) {
+            buf[j] += fft_data[i].re * f;
+        }
+
+        for (; i < window_size; i++, j++) {
+            buf[j] = fft_data[i].re * f;
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 {
     AVFilterContext *ctx = inlink->dst;
     AVFilterLink *outlink = ctx->outputs[0];
     AFFTFiltContext *s = ctx->priv;
     const int window_size = s->window_size;
-    const float f = 1. / s->win_scale;
     double values[VAR_VARS_NB];
     AVFrame *out, *in = NULL;
-    int ch, n, ret, i, j, k;
-    int start = s->start, end = s->end;
+    ThreadData td;
+    int ch, n, ret;
+    int start, end;
 
     av_audio_fifo_write(s->fifo, (void **)frame->extended_data, frame->nb_samples);
     av_frame_free(&frame);
@@ -211,70 +290,17 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
         if (ret < 0)
             break;
 
-        for (ch = 0; ch < inlink->channels; ch++) {
-            const float *src = (float *)in->extended_data[ch];
-            FFTComplex *fft_data = s->fft_data[ch];
-
-            for (n = 0; n < in->nb_samples; n++) {
-                fft_data[n].re = src[n] * s->window_func_lut[n];
-                fft_data[n].im = 0;
-            }
-
-            for (; n < window_size; n++) {
-                fft_data[n].re = 0;
-                fft_data[n].im = 0;
-            }
-        }
-
         values[VAR_PTS]         = s->pts;
         values[VAR_SAMPLE_RATE] = inlink->sample_rate;
         values[VAR_NBBINS]      = window_size / 2;
         values[VAR_CHANNELS]    = inlink->channels;
 
-        for (ch = 0; ch < inlink->channels; ch++) {
-            FFTComplex *fft_data = s->fft_data[ch];
-            float *buf = (float *)s->buffer->extended_data[ch];
-            int x;
-
-            values[VAR_CHANNEL] = ch;
-
-            av_fft_permute(s->fft, fft_data);
-            av_fft_calc(s->fft, fft_data);
+        td.in     = in;
+        td.values = values;
+        ff_filter_execute_channels(ctx, filter_channels, &td, inlink->channels);
 
-            for (n = 0; n < window_size / 2; n++) {
-                float fr, fi;
-
-                values[VAR_BIN] = n;
-
-                fr = av_expr_eval(s->real[ch], values, s);
-                fi = av_expr_eval(s->imag[ch], values, s);
-
-                fft_data[n].re *= fr;
-                fft_data[n].im *= fi;
-            }
-
-            for (n = window_size / 2 + 1, x = window_size / 2 - 1; n < window_size; n++, x--) {
-                fft_data[n].re =  fft_data[x].re;
-                fft_data[n].im = -fft_data[x].im;
-            }
-
-            av_fft_permute(s->ifft, fft_data);
-            av_fft_calc(s->ifft, fft_data);
-
-            start = s->start;
-            end = s->end;
-            k = end;
-            for (i = 0, j = start; j < k && i < window_size; i++, j++) {
-                buf[j] += s->fft_data[ch][i].re * f;
-            }
-
-            for (; i < window_size; i++, j++) {
-                buf[j] = s->fft_data[ch][i].re * f;
-            }
-
-            start += s->hop_size;
-            end = j;
-        }
+        start = s->start + s->hop_size;
+        end   = s->start + window_size;
 
         s->start = start;
         s->end = end;
@@ -354,8 +380,14 @@ static av_cold void uninit(AVFilterContext *ctx)
     AFFTFiltContext *s = ctx->priv;
     int i;
 
-    av_fft_end(s->fft);
-    av_fft_end(s->ifft);
+    for (i = 0; i < s->nb_jobs; i++) {
+        if (s->fft)
+            av_fft_end(s->fft[i]);
+        if (s->ifft)
+            av_fft_end(s->ifft[i]);
+    }
+    av_freep(&s->fft);
+    av_freep(&s->ifft);
 
     for (i = 0; i < s->nb_exprs; i++) {
         if (s->fft_data)
@@ -400,4 +432,5 @@ AVFilter ff_af_afftfilt = {
     .outputs         = outputs,
     .query_formats   = query_formats,
     .uninit          = uninit,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
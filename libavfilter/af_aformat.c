@@ -130,6 +130,7 @@ static const AVFilterPad avfilter_af_aformat_inputs[] = {
     {
         .name = "default",
         .type = AVMEDIA_TYPE_AUDIO,
+        .pipeline = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -29,17 +29,17 @@
  */
 
 #include "libavutil/attributes.h"
-#include "libavutil/audio_fifo.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/common.h"
-#include "libavutil/float_dsp.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/samplefmt.h"
 
+#include "af_amix.h"
 #include "audio.h"
+#include "audioqueue.h"
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
@@ -154,19 +154,24 @@ static int frame_list_add_frame(FrameList *frame_list, int nb_samples, int64_t p
 
 typedef struct MixContext {
     const AVClass *class;       /**< class for AVOptions */
-    AVFloatDSPContext *fdsp;
+    AMixDSPContext dsp;
 
     int nb_inputs;              /**< number of inputs */
     int active_inputs;          /**< number of input currently active */
     int duration_mode;          /**< mode for determining duration */
     float dropout_transition;   /**< transition time when an input drops out */
+    char *weights_str;          /**< string of the input weights */
 
     int nb_channels;            /**< number of channels */
     int sample_rate;            /**< sample rate */
     int planar;
-    AVAudioFifo **fifos;        /**< audio fifo for each input */
+    FFAudioQueue *queues;       /**< audio queue for each input */
     uint8_t *input_state;       /**< current state of each input */
+    float *weights;             /**< weight of each input */
     float *input_scale;         /**< mixing scale factor for each input */
+    AVFrame **mix_bufs;         /**< frames of the inputs mixed in a frame */
+    const float **mix_src;      /**< plane of each input being mixed */
+    float *mix_scale;           /**< scale factor of each input being mixed */
     float scale_norm;           /**< normalization factor for all inputs */
     int64_t next_pts;           /**< calculated pts for next output frame */
     FrameList *frame_list;      /**< list of frame info for the first input */
@@ -177,7 +182,7 @@ typedef struct MixContext {
 #define F AV_OPT_FLAG_FILTERING_PARAM
 static const AVOption amix_options[] = {
     { "inputs", "Number of inputs.",
-            OFFSET(nb_inputs), AV_OPT_TYPE_INT, { .i64 = 2 }, 1, 32, A|F },
+            OFFSET(nb_inputs), AV_OPT_TYPE_INT, { .i64 = 2 }, 1, INT16_MAX, A|F },
     { "duration", "How to determine the end-of-stream.",
             OFFSET(duration_mode), AV_OPT_TYPE_INT, { .i64 = DURATION_LONGEST }, 0,  2, A|F, "duration" },
         { "longest",  "Duration of longest input.",  0, AV_OPT_TYPE_CONST, { .i64 = DURATION_LONGEST  }, INT_MIN, INT_MAX, A|F, "duration" },
@@ -186,6 +191,8 @@ static const AVOption amix_options[] = {
     { "dropout_transition", "Transition time, in seconds, for volume "
                             "renormalization when an input stream ends.",
             OFFSET(dropout_transition), AV_OPT_TYPE_FLOAT, { .dbl = 2.0 }, 0, INT_MAX, A|F },
+    { "weights", "Set the weight of each input.",
+            OFFSET(weights_str), AV_OPT_TYPE_STRING, { .str = "1 1" }, 0, 0, A|F },
     { NULL }
 };
 
@@ -209,7 +216,7 @@ static void calculate_scales(MixContext *s, int nb_samples)
 
     for (i = 0; i < s->nb_inputs; i++) {
         if (s->input_state[i] & INPUT_ON)
-            s->input_scale[i] = 1.0f / s->scale_norm;
+            s->input_scale[i] = s->weights[i] / s->scale_norm;
         else
             s->input_scale[i] = 0.0f;
     }
@@ -231,15 +238,15 @@ static int config_output(AVFilterLink *outlink)
     if (!s->frame_list)
         return AVERROR(ENOMEM);
 
-    s->fifos = av_mallocz_array(s->nb_inputs, sizeof(*s->fifos));
-    if (!s->fifos)
+    s->queues = av_mallocz_array(s->nb_inputs, sizeof(*s->queues));
+    if (!s->queues)
         return AVERROR(ENOMEM);
 
     s->nb_channels = av_get_channel_layout_nb_channels(outlink->channel_layout);
     for (i = 0; i < s->nb_inputs; i++) {
-        s->fifos[i] = av_audio_fifo_alloc(outlink->format, s->nb_channels, 1024);
-        if (!s->fifos[i])
-            return AVERROR(ENOMEM);
+        int ret = ff_audio_queue_init(&s->queues[i], outlink->format, s->nb_channels);
+        if (ret < 0)
+            return ret;
     }
 
     s->input_state = av_malloc(s->nb_inputs);
@@ -249,7 +256,10 @@ static int config_output(AVFilterLink *outlink)
     s->active_inputs = s->nb_inputs;
 
     s->input_scale = av_mallocz_array(s->nb_inputs, sizeof(*s->input_scale));
-    if (!s->input_scale)
+    s->mix_bufs    = av_mallocz_array(s->nb_inputs, sizeof(*s->mix_bufs));
+    s->mix_src     = av_mallocz_array(s->nb_inputs, sizeof(*s->mix_src));
+    s->mix_scale   = av_mallocz_array(s->nb_inputs, sizeof(*s->mix_scale));
+    if (!s->input_scale || !s->mix_bufs || !s->mix_src || !s->mix_scale)
         return AVERROR(ENOMEM);
     s->scale_norm = s->active_inputs;
     calculate_scales(s, 0);
@@ -265,15 +275,66 @@ static int config_output(AVFilterLink *outlink)
 
 static int calc_active_inputs(MixContext *s);
 
+static void mix_c(float *dst, const float *const *src, const float *scale,
+                  int nb_src, int len)
+{
+    int i, k;
+
+    for (i = 0; i < nb_src; i++) {
+        const float *in = src[i];
+        const float mul = scale[i];
+
+        for (k = 0; k < len; k++)
+            dst[k] += in[k] * mul;
+    }
+}
+
+av_cold void ff_amix_init(AMixDSPContext *dsp)
+{
+    dsp->mix           = mix_c;
+    dsp->samples_align = 1;
+
+    if (ARCH_X86)
+        ff_amix_init_x86(dsp);
+}
+
 /**
- * Read samples from the input FIFOs, mix, and write to the output link.
+ * Add plane p of the nb_src frames in mix_bufs to dst, a few inputs at a
+ * time.
+ */
+static void mix_plane(MixContext *s, float *dst, int p, int nb_src, int len)
+{
+    /* the inputs may be views into frames, which are neither padded nor
+     * always aligned; the output may come from another filter */
+    const int simd_len = (uintptr_t)dst & 31 ? 0 : len & ~(s->dsp.samples_align - 1);
+    int i;
+
+    for (i = 0; i < nb_src; i++)
+        s->mix_src[i] = (const float *)s->mix_bufs[i]->extended_data[p];
+
+    for (i = 0; i < nb_src; i += AMIX_MAX_PASS_INPUTS) {
+        const int n = FFMIN(nb_src - i, AMIX_MAX_PASS_INPUTS);
+        int j;
+
+        if (simd_len)
+            s->dsp.mix(dst, s->mix_src + i, s->mix_scale + i, n, simd_len);
+        if (simd_len < len) {
+            for (j = i; j < i + n; j++)
+                s->mix_src[j] += simd_len;
+            mix_c(dst + simd_len, s->mix_src + i, s->mix_scale + i, n, len - simd_len);
+        }
+    }
+}
+
+/**
+ * Read samples from the input queues, mix, and write to the output link.
  */
 static int output_frame(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
     MixContext      *s = ctx->priv;
-    AVFrame *out_buf, *in_buf;
-    int nb_samples, ns, ret, i;
+    AVFrame *out_buf;
+    int nb_samples, ns, ret, i, p, planes, plane_size, nb_src = 0;
 
     ret = calc_active_inputs(s);
     if (ret < 0)
@@ -284,7 +345,7 @@ static int output_frame(AVFilterLink *outlink)
         nb_samples = frame_list_next_frame_size(s->frame_list);
         for (i = 1; i < s->nb_inputs; i++) {
             if (s->input_state[i] & INPUT_ON) {
-                ns = av_audio_fifo_size(s->fifos[i]);
+                ns = FFMIN(ff_audio_queue_size(&s->queues[i]), INT_MAX);
                 if (ns < nb_samples) {
                     if (!(s->input_state[i] & INPUT_EOF))
                         /* unclosed input with not enough samples */
@@ -299,7 +360,7 @@ static int output_frame(AVFilterLink *outlink)
         nb_samples = INT_MAX;
         for (i = 1; i < s->nb_inputs; i++) {
             if (s->input_state[i] & INPUT_ON) {
-                ns = av_audio_fifo_size(s->fifos[i]);
+                ns = FFMIN(ff_audio_queue_size(&s->queues[i]), INT_MAX);
                 nb_samples = FFMIN(nb_samples, ns);
             }
         }
@@ -319,37 +380,35 @@ static int output_frame(AVFilterLink *outlink)
     if (!out_buf)
         return AVERROR(ENOMEM);
 
-    in_buf = ff_get_audio_buffer(outlink, nb_samples);
-    if (!in_buf) {
-        av_frame_free(&out_buf);
-        return AVERROR(ENOMEM);
-    }
-
     for (i = 0; i < s->nb_inputs; i++) {
         if (s->input_state[i] & INPUT_ON) {
-            int planes, plane_size, p;
-
-            av_audio_fifo_read(s->fifos[i], (void **)in_buf->extended_data,
-                               nb_samples);
-
-            planes     = s->planar ? s->nb_channels : 1;
-            plane_size = nb_samples * (s->planar ? 1 : s->nb_channels);
-            plane_size = FFALIGN(plane_size, 16);
-
-            for (p = 0; p < planes; p++) {
-                s->fdsp->vector_fmac_scalar((float *)out_buf->extended_data[p],
-                                           (float *) in_buf->extended_data[p],
-                                           s->input_scale[i], plane_size);
-            }
+            ret = ff_audio_queue_get(&s->queues[i], outlink, &s->mix_bufs[nb_src],
+                                     nb_samples);
+            if (ret < 0)
+                goto fail;
+            s->mix_scale[nb_src++] = s->input_scale[i];
         }
     }
-    av_frame_free(&in_buf);
+
+    planes     = s->planar ? s->nb_channels : 1;
+    plane_size = nb_samples * (s->planar ? 1 : s->nb_channels);
+    for (p = 0; p < planes; p++)
+        mix_plane(s, (float *)out_buf->extended_data[p], p, nb_src, plane_size);
+
+    for (i = 0; i < nb_src; i++)
+        av_frame_free(&s->mix_bufs[i]);
 
     out_buf->pts = s->next_pts;
     if (s->next_pts != AV_NOPTS_VALUE)
         s->next_pts += nb_samples;
 
     return ff_filter_frame(outlink, out_buf);
+
+fail:
+    for (i = 0; i < nb_src; i++)
+        av_frame_free(&s->mix_bufs[i]);
+    av_frame_free(&out_buf);
+    return ret;
 }
 
 /**
@@ -366,12 +425,12 @@ static int request_samples(AVFilterContext *ctx, int min_samples)
         ret = 0;
         if (!(s->input_state[i] & INPUT_ON))
             continue;
-        if (av_audio_fifo_size(s->fifos[i]) >= min_samples)
+        if (ff_audio_queue_size(&s->queues[i]) >= min_samples)
             continue;
         ret = ff_request_frame(ctx->inputs[i]);
         if (ret == AVERROR_EOF) {
             s->input_state[i] |= INPUT_EOF;
-            if (av_audio_fifo_size(s->fifos[i]) == 0) {
+            if (!ff_audio_queue_size(&s->queues[i])) {
                 s->input_state[i] = 0;
                 continue;
             }
@@ -457,10 +516,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
             goto fail;
     }
 
-    ret = av_audio_fifo_write(s->fifos[i], (void **)buf->extended_data,
-                              buf->nb_samples);
+    ret = ff_audio_queue_add(&s->queues[i], buf);
+    if (ret < 0)
+        return ret;
 
-    av_frame_free(&buf);
     return output_frame(outlink);
 
 fail:
@@ -472,7 +531,9 @@ fail:
 static av_cold int init(AVFilterContext *ctx)
 {
     MixContext *s = ctx->priv;
-    int i;
+    char *weights, *p, *arg, *saveptr = NULL;
+    float last_weight = 1.0f;
+    int i, ret = 0;
 
     for (i = 0; i < s->nb_inputs; i++) {
         char name[32];
@@ -488,9 +549,33 @@ static av_cold int init(AVFilterContext *ctx)
         ff_insert_inpad(ctx, i, &pad);
     }
 
-    s->fdsp = avpriv_float_dsp_alloc(0);
-    if (!s->fdsp)
+    s->weights = av_mallocz_array(s->nb_inputs, sizeof(*s->weights));
+    weights    = av_strdup(s->weights_str);
+    if (!s->weights || !weights) {
+        av_free(weights);
         return AVERROR(ENOMEM);
+    }
+
+    /* inputs without a weight get the last one given */
+    p = weights;
+    for (i = 0; i < s->nb_inputs; i++) {
+        if (!(arg = av_strtok(p, " |", &saveptr)))
+            break;
+        p = NULL;
+        if (sscanf(arg, "%f", &last_weight) != 1) {
+            av_log(ctx, AV_LOG_ERROR, "Invalid weight '%s'.\n", arg);
+            ret = AVERROR(EINVAL);
+            break;
+        }
+        s->weights[i] = last_weight;
+    }
+    for (; i < s->nb_inputs; i++)
+        s->weights[i] = last_weight;
+    av_free(weights);
+    if (ret < 0)
+        return ret;
+
+    ff_amix_init(&s->dsp);
 
     return 0;
 }
@@ -500,16 +585,19 @@ static av_cold void uninit(AVFilterContext *ctx)
     int i;
     MixContext *s = ctx->priv;
 
-    if (s->fifos) {
+    if (s->queues) {
         for (i = 0; i < s->nb_inputs; i++)
-            av_audio_fifo_free(s->fifos[i]);
-        av_freep(&s->fifos);
+            ff_audio_queue_uninit(&s->queues[i]);
+        av_freep(&s->queues);
     }
     frame_list_clear(s->frame_list);
     av_freep(&s->frame_list);
     av_freep(&s->input_state);
+    av_freep(&s->weights);
     av_freep(&s->input_scale);
-    av_freep(&s->fdsp);
+    av_freep(&s->mix_bufs);
+    av_freep(&s->mix_src);
+    av_freep(&s->mix_scale);
 
     for (i = 0; i < ctx->nb_inputs; i++)
         av_freep(&ctx->input_pads[i].name);
@@ -0,0 +1,54 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * audio mix filter
+ */
+
+#ifndef AVFILTER_AMIX_H
+#define AVFILTER_AMIX_H
+
+/**
+ * Number of inputs added to the output in a single pass. Larger mixes are
+ * done in several passes, so the number of input streams read at once
+ * stays small.
+ */
+#define AMIX_MAX_PASS_INPUTS 16
+
+typedef struct AMixDSPContext {
+    /**
+     * Add several scaled inputs to dst, i.e.
+     * dst[k] += src[0][k] * scale[0] + ... + src[nb_src - 1][k] * scale[nb_src - 1]
+     * with the sum done in that order.
+     *
+     * @param dst    output, 32-byte aligned
+     * @param src    inputs, not necessarily aligned
+     * @param scale  scale factor of each input
+     * @param nb_src number of inputs, at least 1
+     * @param len    number of samples, a multiple of samples_align
+     */
+    void (*mix)(float *dst, const float *const *src, const float *scale,
+                int nb_src, int len);
+    int samples_align;
+} AMixDSPContext;
+
+void ff_amix_init(AMixDSPContext *dsp);
+void ff_amix_init_x86(AMixDSPContext *dsp);
+
+#endif /* AVFILTER_AMIX_H */
@@ -31,6 +31,7 @@ static const AVFilterPad avfilter_af_anull_inputs[] = {
     {
         .name = "default",
         .type = AVMEDIA_TYPE_AUDIO,
+        .pipeline = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -0,0 +1,461 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * audio peaks extraction filter
+ *
+ * The minimum, maximum and optionally the RMS of every block of samples
+ * are written to a file in the binary waveform data format of
+ * audiowaveform, version 2. Coarser levels, each with blocks twice as long
+ * as the level before, are computed from the finer ones and written after
+ * the first as complete waveform data files of their own.
+ */
+
+#include <float.h>
+#include <stdio.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "af_apeaks.h"
+#include "audio.h"
+#include "avfilter.h"
+#include "formats.h"
+#include "internal.h"
+
+#define DAT_VERSION     2
+#define DAT_HEADER_SIZE 24
+#define DAT_FLAG_8BIT   1
+#define DAT_FLAG_RMS    2   ///< not part of the audiowaveform format
+
+typedef struct PeaksLevel {
+    float *stats;               ///< APEAKS_STATS values of each channel
+    int64_t nb_samples;         ///< samples in the current block
+    int nb_children;            ///< blocks of the level below in the current block
+    uint8_t *data;              ///< values of the blocks done
+    unsigned int size;          ///< bytes of data used
+    unsigned int allocated;     ///< bytes of data allocated
+    uint32_t length;            ///< number of blocks done
+} PeaksLevel;
+
+typedef struct APeaksContext {
+    const AVClass *class;
+    char *filename;
+    int spp;
+    int nb_levels;
+    int bits;
+    int rms;
+
+    FILE *file;
+    int nb_channels;
+    int sample_rate;
+    PeaksLevel *levels;
+    int finished;
+    APeaksDSPContext dsp;
+} APeaksContext;
+
+#define OFFSET(x) offsetof(APeaksContext, x)
+#define A AV_OPT_FLAG_AUDIO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
+
+static const AVOption apeaks_options[] = {
+    { "file",   "set the file to write the peaks to", OFFSET(filename), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, A },
+    { "f",      "set the file to write the peaks to", OFFSET(filename), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, A },
+    { "spp",    "set the number of samples per block", OFFSET(spp), AV_OPT_TYPE_INT, { .i64 = 256 }, 1, 1 << 16, A },
+    { "levels", "set the number of resolutions", OFFSET(nb_levels), AV_OPT_TYPE_INT, { .i64 = 1 }, 1, 15, A },
+    { "bits",   "set the bits per value", OFFSET(bits), AV_OPT_TYPE_INT, { .i64 = 16 }, 8, 16, A, "bits" },
+        { "8",  NULL, 0, AV_OPT_TYPE_CONST, { .i64 = 8  }, 0, 0, A, "bits" },
+        { "16", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = 16 }, 0, 0, A, "bits" },
+    { "rms",    "write the RMS of each block", OFFSET(rms), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, A },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(apeaks);
+
+static void peaks_c(float *stats, const float *src, int len)
+{
+    float min = stats[0], max = stats[1];
+    float *sum = stats + 2;
+    int i, j;
+
+    for (i = 0; i < len; i += APEAKS_ALIGN) {
+        for (j = 0; j < APEAKS_ALIGN; j++) {
+            min = FFMIN(min, src[i + j]);
+            max = FFMAX(max, src[i + j]);
+            sum[j] += src[i + j] * src[i + j];
+        }
+    }
+
+    stats[0] = min;
+    stats[1] = max;
+}
+
+av_cold void ff_apeaks_init(APeaksDSPContext *dsp)
+{
+    dsp->peaks = peaks_c;
+
+    if (ARCH_X86)
+        ff_apeaks_init_x86(dsp);
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    APeaksContext *s = ctx->priv;
+
+    if (s->bits != 8 && s->bits != 16) {
+        av_log(ctx, AV_LOG_ERROR, "Only 8 and 16 bits per value are supported.\n");
+        return AVERROR(EINVAL);
+    }
+
+    if (!s->filename) {
+        av_log(ctx, AV_LOG_ERROR, "No output file set.\n");
+        return AVERROR(EINVAL);
+    }
+    if (!strcmp(s->filename, "-")) {
+        s->file = stdout;
+    } else {
+        s->file = fopen(s->filename, "wb");
+        if (!s->file) {
+            int err = AVERROR(errno);
+            char buf[128];
+            av_strerror(err, buf, sizeof(buf));
+            av_log(ctx, AV_LOG_ERROR, "Could not open peaks file %s: %s\n",
+                   s->filename, buf);
+            return err;
+        }
+    }
+
+    ff_apeaks_init(&s->dsp);
+
+    return 0;
+}
+
+static int query_formats(AVFilterContext *ctx)
+{
+    AVFilterFormats *formats;
+    AVFilterChannelLayouts *layouts;
+    static const enum AVSampleFormat sample_fmts[] = {
+        AV_SAMPLE_FMT_FLTP,
+        AV_SAMPLE_FMT_NONE
+    };
+    int ret;
+
+    layouts = ff_all_channel_counts();
+    if (!layouts)
+        return AVERROR(ENOMEM);
+    ret = ff_set_common_channel_layouts(ctx, layouts);
+    if (ret < 0)
+        return ret;
+
+    formats = ff_make_format_list(sample_fmts);
+    if (!formats)
+        return AVERROR(ENOMEM);
+    ret = ff_set_common_formats(ctx, formats);
+    if (ret < 0)
+        return ret;
+
+    formats = ff_all_samplerates();
+    if (!formats)
+        return AVERROR(ENOMEM);
+    return ff_set_common_samplerates(ctx, formats);
+}
+
+static void reset_level(APeaksContext *s, PeaksLevel *l)
+{
+    int ch;
+
+    for (ch = 0; ch < s->nb_channels; ch++) {
+        float *stats = &l->stats[APEAKS_STATS * ch];
+
+        stats[0] =  FLT_MAX;
+        stats[1] = -FLT_MAX;
+        memset(stats + 2, 0, APEAKS_ALIGN * sizeof(*stats));
+    }
+    l->nb_samples  = 0;
+    l->nb_children = 0;
+}
+
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    APeaksContext *s = ctx->priv;
+    int i;
+
+    s->nb_channels = inlink->channels;
+    s->sample_rate = inlink->sample_rate;
+
+    s->levels = av_calloc(s->nb_levels, sizeof(*s->levels));
+    if (!s->levels)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < s->nb_levels; i++) {
+        s->levels[i].stats = av_malloc_array(s->nb_channels, APEAKS_STATS * sizeof(*s->levels[i].stats));
+        if (!s->levels[i].stats)
+            return AVERROR(ENOMEM);
+        reset_level(s, &s->levels[i]);
+    }
+
+    return 0;
+}
+
+static uint8_t *put_value(uint8_t *p, int bits, float v)
+{
+    v = av_clipf(v, -1, 1);
+    if (bits == 8) {
+        *p = lrintf(v * INT8_MAX);
+        return p + 1;
+    }
+    AV_WL16(p, lrintf(v * INT16_MAX));
+    return p + 2;
+}
+
+/* sum of squares of a block, from its partial sums */
+static float sum_squares(const float *stats)
+{
+    float sum[APEAKS_ALIGN];
+    int j;
+
+    memcpy(sum, stats + 2, sizeof(sum));
+    for (j = 0; j < 8; j++)
+        sum[j] += sum[j + 8];
+    for (j = 0; j < 4; j++)
+        sum[j] += sum[j + 4];
+
+    return (sum[0] + sum[2]) + (sum[1] + sum[3]);
+}
+
+/* store the current block of level k and add it to the level above */
+static int end_block(APeaksContext *s, int k)
+{
+    PeaksLevel *l = &s->levels[k];
+    const int values = s->rms ? 3 : 2;
+    const unsigned int size = s->nb_channels * values * (s->bits / 8);
+    uint8_t *p;
+    int ch;
+
+    if (l->size > UINT_MAX - size)
+        return AVERROR(ENOMEM);
+    p = av_fast_realloc(l->data, &l->allocated, l->size + size);
+    if (!p)
+        return AVERROR(ENOMEM);
+    l->data = p;
+
+    p += l->size;
+    for (ch = 0; ch < s->nb_channels; ch++) {
+        const float *stats = &l->stats[APEAKS_STATS * ch];
+
+        p = put_value(p, s->bits, stats[0]);
+        p = put_value(p, s->bits, stats[1]);
+        if (s->rms)
+            p = put_value(p, s->bits, sqrtf(sum_squares(stats) / l->nb_samples));
+    }
+    l->size += size;
+    l->length++;
+
+    if (k + 1 < s->nb_levels) {
+        PeaksLevel *parent = &s->levels[k + 1];
+
+        for (ch = 0; ch < s->nb_channels; ch++) {
+            float *dst = &parent->stats[APEAKS_STATS * ch];
+            const float *src = &l->stats[APEAKS_STATS * ch];
+
+            dst[0]  = FFMIN(dst[0], src[0]);
+            dst[1]  = FFMAX(dst[1], src[1]);
+            dst[2] += sum_squares(src);
+        }
+        parent->nb_samples += l->nb_samples;
+        if (++parent->nb_children == 2) {
+            int ret = end_block(s, k + 1);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    reset_level(s, l);
+
+    return 0;
+}
+
+static void add_sample(float *stats, float v, int lane)
+{
+    stats[0] = FFMIN(stats[0], v);
+    stats[1] = FFMAX(stats[1], v);
+    stats[2 + lane] += v * v;
+}
+
+/* add samples to the current block of the first level; the sample of index
+ * i in the block always goes to the partial sum i modulo APEAKS_ALIGN */
+static void add_samples(APeaksContext *s, AVFrame *frame, int offset, int nb_samples)
+{
+    PeaksLevel *l = &s->levels[0];
+    const int lane = l->nb_samples & (APEAKS_ALIGN - 1);
+    const int head = FFMIN((APEAKS_ALIGN - lane) & (APEAKS_ALIGN - 1), nb_samples);
+    const int aligned = (nb_samples - head) & ~(APEAKS_ALIGN - 1);
+    int ch, i;
+
+    for (ch = 0; ch < s->nb_channels; ch++) {
+        const float *src = (const float *)frame->extended_data[ch] + offset;
+        float *stats = &l->stats[APEAKS_STATS * ch];
+
+        for (i = 0; i < head; i++)
+            add_sample(stats, src[i], lane + i);
+        if (aligned)
+            s->dsp.peaks(stats, src + head, aligned);
+        for (i = head + aligned; i < nb_samples; i++)
+            add_sample(stats, src[i], i - head - aligned);
+    }
+    l->nb_samples += nb_samples;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx = inlink->dst;
+    APeaksContext *s = ctx->priv;
+    PeaksLevel *l = &s->levels[0];
+    int ret, offset = 0;
+
+    while (offset < frame->nb_samples) {
+        int n = FFMIN(s->spp - l->nb_samples, frame->nb_samples - offset);
+
+        add_samples(s, frame, offset, n);
+        offset += n;
+
+        if (l->nb_samples == s->spp && (ret = end_block(s, 0)) < 0) {
+            av_frame_free(&frame);
+            return ret;
+        }
+    }
+
+    return ff_filter_frame(ctx->outputs[0], frame);
+}
+
+static int write_level(APeaksContext *s, int k)
+{
+    PeaksLevel *l = &s->levels[k];
+    uint8_t header[DAT_HEADER_SIZE];
+    int flags = 0;
+
+    if (s->bits == 8)
+        flags |= DAT_FLAG_8BIT;
+    if (s->rms)
+        flags |= DAT_FLAG_RMS;
+
+    AV_WL32(header,      DAT_VERSION);
+    AV_WL32(header +  4, flags);
+    AV_WL32(header +  8, s->sample_rate);
+    AV_WL32(header + 12, s->spp << k);
+    AV_WL32(header + 16, l->length);
+    AV_WL32(header + 20, s->nb_channels);
+
+    if (fwrite(header, DAT_HEADER_SIZE, 1, s->file) != 1 ||
+        (l->size && fwrite(l->data, l->size, 1, s->file) != 1))
+        return AVERROR(EIO);
+
+    return 0;
+}
+
+/* end the incomplete blocks and write all levels */
+static int finish(AVFilterContext *ctx)
+{
+    APeaksContext *s = ctx->priv;
+    int k, ret;
+
+    if (s->finished || !s->levels)
+        return 0;
+    s->finished = 1;
+
+    for (k = 0; k < s->nb_levels; k++) {
+        if (s->levels[k].nb_samples && (ret = end_block(s, k)) < 0)
+            return ret;
+    }
+
+    for (k = 0; k < s->nb_levels; k++) {
+        if ((ret = write_level(s, k)) < 0) {
+            av_log(ctx, AV_LOG_ERROR, "Error writing peaks file %s.\n", s->filename);
+            return ret;
+        }
+    }
+    fflush(s->file);
+
+    return 0;
+}
+
+static int request_frame(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    int ret;
+
+    ret = ff_request_frame(ctx->inputs[0]);
+    if (ret == AVERROR_EOF) {
+        int err = finish(ctx);
+        if (err < 0)
+            return err;
+    }
+
+    return ret;
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    APeaksContext *s = ctx->priv;
+    int i;
+
+    finish(ctx);
+
+    if (s->file && s->file != stdout)
+        fclose(s->file);
+    if (s->levels) {
+        for (i = 0; i < s->nb_levels; i++) {
+            av_freep(&s->levels[i].stats);
+            av_freep(&s->levels[i].data);
+        }
+    }
+    av_freep(&s->levels);
+}
+
+static const AVFilterPad apeaks_inputs[] = {
+    {
+        .name         = "default",
+        .type         = AVMEDIA_TYPE_AUDIO,
+        .filter_frame = filter_frame,
+        .config_props = config_input,
+    },
+    { NULL }
+};
+
+static const AVFilterPad apeaks_outputs[] = {
+    {
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_AUDIO,
+        .request_frame = request_frame,
+    },
+    { NULL }
+};
+
+AVFilter ff_af_apeaks = {
+    .name          = "apeaks",
+    .description   = NULL_IF_CONFIG_SMALL("Write the audio peaks to a waveform data file."),
+    .priv_size     = sizeof(APeaksContext),
+    .priv_class    = &apeaks_class,
+    .init          = init,
+    .uninit        = uninit,
+    .query_formats = query_formats,
+    .inputs        = apeaks_inputs,
+    .outputs       = apeaks_outputs,
+};
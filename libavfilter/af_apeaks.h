@@ -0,0 +1,59 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * audio peaks extraction filter
+ */
+
+#ifndef AVFILTER_APEAKS_H
+#define AVFILTER_APEAKS_H
+
+/**
+ * Number of samples the length given to APeaksDSPContext.peaks must be a
+ * multiple of.
+ */
+#define APEAKS_ALIGN 16
+
+/**
+ * Number of floats of the peaks of a channel: the minimum, the maximum and
+ * APEAKS_ALIGN partial sums of squares.
+ */
+#define APEAKS_STATS (2 + APEAKS_ALIGN)
+
+typedef struct APeaksDSPContext {
+    /**
+     * Update the peaks of a channel with len samples:
+     * stats[0] = min(stats[0], src[0], ..., src[len - 1])
+     * stats[1] = max(stats[1], src[0], ..., src[len - 1])
+     * stats[2 + j] += src[j] * src[j] + src[j + 16] * src[j + 16] + ...
+     *
+     * Each partial sum is updated in the order of the samples, so the
+     * result does not depend on how the samples are split between calls.
+     *
+     * @param stats APEAKS_STATS values, not necessarily aligned
+     * @param src   samples, not necessarily aligned
+     * @param len   number of samples, a positive multiple of APEAKS_ALIGN
+     */
+    void (*peaks)(float *stats, const float *src, int len);
+} APeaksDSPContext;
+
+void ff_apeaks_init(APeaksDSPContext *dsp);
+void ff_apeaks_init_x86(APeaksDSPContext *dsp);
+
+#endif /* AVFILTER_APEAKS_H */
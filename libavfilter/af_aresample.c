@@ -324,6 +324,7 @@ static const AVFilterPad aresample_inputs[] = {
         .name         = "default",
         .type         = AVMEDIA_TYPE_AUDIO,
         .filter_frame = filter_frame,
+        .pipeline     = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -24,19 +24,19 @@
  * Filter that changes number of samples on single output operation
  */
 
-#include "libavutil/audio_fifo.h"
 #include "libavutil/avassert.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/opt.h"
 #include "avfilter.h"
 #include "audio.h"
+#include "audioqueue.h"
 #include "internal.h"
 #include "formats.h"
 
 typedef struct {
     const AVClass *class;
     int nb_out_samples;  ///< how many samples to output
-    AVAudioFifo *fifo;   ///< samples are queued here
+    FFAudioQueue queue;  ///< frames are queued here
     int64_t next_out_pts;
     int pad;
 } ASNSContext;
@@ -67,48 +67,51 @@ static av_cold int init(AVFilterContext *ctx)
 static av_cold void uninit(AVFilterContext *ctx)
 {
     ASNSContext *asns = ctx->priv;
-    av_audio_fifo_free(asns->fifo);
+    ff_audio_queue_uninit(&asns->queue);
 }
 
 static int config_props_output(AVFilterLink *outlink)
 {
     ASNSContext *asns = outlink->src->priv;
 
-    asns->fifo = av_audio_fifo_alloc(outlink->format, outlink->channels, asns->nb_out_samples);
-    if (!asns->fifo)
-        return AVERROR(ENOMEM);
-
-    return 0;
+    ff_audio_queue_uninit(&asns->queue);
+    return ff_audio_queue_init(&asns->queue, outlink->format, outlink->channels);
 }
 
 static int push_samples(AVFilterLink *outlink)
 {
     ASNSContext *asns = outlink->src->priv;
     AVFrame *outsamples = NULL;
+    int64_t queued = ff_audio_queue_size(&asns->queue);
     int ret, nb_out_samples, nb_pad_samples;
 
     if (asns->pad) {
-        nb_out_samples = av_audio_fifo_size(asns->fifo) ? asns->nb_out_samples : 0;
-        nb_pad_samples = nb_out_samples - FFMIN(nb_out_samples, av_audio_fifo_size(asns->fifo));
+        nb_out_samples = queued ? asns->nb_out_samples : 0;
+        nb_pad_samples = nb_out_samples - FFMIN(nb_out_samples, queued);
     } else {
-        nb_out_samples = FFMIN(asns->nb_out_samples, av_audio_fifo_size(asns->fifo));
+        nb_out_samples = FFMIN(asns->nb_out_samples, queued);
         nb_pad_samples = 0;
     }
 
     if (!nb_out_samples)
         return 0;
 
-    outsamples = ff_get_audio_buffer(outlink, nb_out_samples);
-    if (!outsamples)
-        return AVERROR(ENOMEM);
-
-    av_audio_fifo_read(asns->fifo,
-                       (void **)outsamples->extended_data, nb_out_samples);
+    if (nb_pad_samples) {
+        outsamples = ff_get_audio_buffer(outlink, nb_out_samples);
+        if (!outsamples)
+            return AVERROR(ENOMEM);
 
-    if (nb_pad_samples)
+        ff_audio_queue_read(&asns->queue, outsamples->extended_data,
+                            nb_out_samples - nb_pad_samples);
         av_samples_set_silence(outsamples->extended_data, nb_out_samples - nb_pad_samples,
                                nb_pad_samples, outlink->channels,
                                outlink->format);
+    } else {
+        /* a reference to the input frames when they can be cut without copying */
+        ret = ff_audio_queue_get(&asns->queue, outlink, &outsamples, nb_out_samples);
+        if (ret < 0)
+            return ret;
+    }
     outsamples->nb_samples     = nb_out_samples;
     outsamples->channel_layout = outlink->channel_layout;
     outsamples->sample_rate    = outlink->sample_rate;
@@ -129,24 +132,18 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
     ASNSContext *asns = ctx->priv;
     AVFilterLink *outlink = ctx->outputs[0];
     int ret;
-    int nb_samples = insamples->nb_samples;
-
-    if (av_audio_fifo_space(asns->fifo) < nb_samples) {
-        av_log(ctx, AV_LOG_DEBUG, "No space for %d samples, stretching audio fifo\n", nb_samples);
-        ret = av_audio_fifo_realloc(asns->fifo, av_audio_fifo_size(asns->fifo) + nb_samples);
-        if (ret < 0) {
-            av_log(ctx, AV_LOG_ERROR,
-                   "Stretching audio fifo failed, discarded %d samples\n", nb_samples);
-            return -1;
-        }
-    }
-    av_audio_fifo_write(asns->fifo, (void **)insamples->extended_data, nb_samples);
+
     if (asns->next_out_pts == AV_NOPTS_VALUE)
         asns->next_out_pts = insamples->pts;
-    av_frame_free(&insamples);
+    ret = ff_audio_queue_add(&asns->queue, insamples);
+    if (ret < 0)
+        return ret;
 
-    while (av_audio_fifo_size(asns->fifo) >= asns->nb_out_samples)
-        push_samples(outlink);
+    while (ff_audio_queue_size(&asns->queue) >= asns->nb_out_samples) {
+        ret = push_samples(outlink);
+        if (ret < 0)
+            return ret;
+    }
     return 0;
 }
 
@@ -39,7 +39,6 @@
  */
 
 #include <float.h>
-#include "libavcodec/avfft.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
@@ -47,9 +46,19 @@
 #include "libavutil/opt.h"
 #include "libavutil/samplefmt.h"
 #include "avfilter.h"
+#include "af_atempo.h"
 #include "audio.h"
 #include "internal.h"
 
+#define YAE_ATEMPO_MIN 0.25
+#define YAE_ATEMPO_MAX 100.0
+
+// number of samples of the decimated fragments used for the coarse search:
+#define YAE_COARSE_SIZE 256
+
+// fragments are padded with zeros up to a multiple of this many samples:
+#define YAE_PAD ATEMPO_DOT_ALIGN
+
 /**
  * A fragment of audio waveform
  */
@@ -65,9 +74,13 @@ typedef struct {
     // number of samples in this fragment:
     int nsamples;
 
-    // rDFT transform of the down-mixed mono fragment, used for
-    // fast waveform alignment via correlation in frequency domain:
-    FFTSample *xdat;
+    // down-mixed mono fragment, zero padded to window + YAE_PAD samples,
+    // used for waveform alignment via cross-correlation:
+    float *xdat;
+
+    // the down-mixed fragment decimated by summing every decim samples,
+    // used for the coarse alignment search:
+    float *xdec;
 } AudioFragment;
 
 /**
@@ -116,6 +129,9 @@ typedef struct {
     // fragment window size, power-of-two integer:
     int window;
 
+    // decimation factor of the coarse alignment search, power-of-two:
+    int decim;
+
     // Hann window coefficients, for feathering
     // (blending) the overlapping fragment region:
     float *hann;
@@ -136,10 +152,7 @@ typedef struct {
     // current state:
     FilterState state;
 
-    // for fast correlation calculation in frequency domain:
-    RDFTContext *real_to_complex;
-    RDFTContext *complex_to_real;
-    FFTSample *correlation;
+    ATempoDSPContext dsp;
 
     // for managing AVFilterPad.request_frame and AVFilterPad.filter_frame
     AVFrame *dst_buffer;
@@ -153,7 +166,8 @@ typedef struct {
 
 static const AVOption atempo_options[] = {
     { "tempo", "set tempo scale factor",
-      OFFSET(tempo), AV_OPT_TYPE_DOUBLE, { .dbl = 1.0 }, 0.5, 2.0,
+      OFFSET(tempo), AV_OPT_TYPE_DOUBLE, { .dbl = 1.0 },
+      YAE_ATEMPO_MIN, YAE_ATEMPO_MAX,
       AV_OPT_FLAG_AUDIO_PARAM | AV_OPT_FLAG_FILTERING_PARAM },
     { NULL }
 };
@@ -221,16 +235,11 @@ static void yae_release_buffers(ATempoContext *atempo)
     av_freep(&atempo->frag[1].data);
     av_freep(&atempo->frag[0].xdat);
     av_freep(&atempo->frag[1].xdat);
+    av_freep(&atempo->frag[0].xdec);
+    av_freep(&atempo->frag[1].xdec);
 
     av_freep(&atempo->buffer);
     av_freep(&atempo->hann);
-    av_freep(&atempo->correlation);
-
-    av_rdft_end(atempo->real_to_complex);
-    atempo->real_to_complex = NULL;
-
-    av_rdft_end(atempo->complex_to_real);
-    atempo->complex_to_real = NULL;
 }
 
 /* av_realloc is not aligned enough; fortunately, the data does not need to
@@ -257,7 +266,7 @@ static int yae_reset(ATempoContext *atempo,
     const int sample_size = av_get_bytes_per_sample(format);
     uint32_t nlevels  = 0;
     uint32_t pot;
-    int i;
+    int i, ndec;
 
     atempo->format   = format;
     atempo->channels = channels;
@@ -276,32 +285,17 @@ static int yae_reset(ATempoContext *atempo,
         nlevels++;
     }
 
+    // pick a decimation factor leaving YAE_COARSE_SIZE samples per fragment:
+    atempo->decim = FFMAX(atempo->window / YAE_COARSE_SIZE, 1);
+    ndec = atempo->window / atempo->decim;
+
     // initialize audio fragment buffers:
     RE_MALLOC_OR_FAIL(atempo->frag[0].data, atempo->window * atempo->stride);
     RE_MALLOC_OR_FAIL(atempo->frag[1].data, atempo->window * atempo->stride);
-    RE_MALLOC_OR_FAIL(atempo->frag[0].xdat, atempo->window * sizeof(FFTComplex));
-    RE_MALLOC_OR_FAIL(atempo->frag[1].xdat, atempo->window * sizeof(FFTComplex));
-
-    // initialize rDFT contexts:
-    av_rdft_end(atempo->real_to_complex);
-    atempo->real_to_complex = NULL;
-
-    av_rdft_end(atempo->complex_to_real);
-    atempo->complex_to_real = NULL;
-
-    atempo->real_to_complex = av_rdft_init(nlevels + 1, DFT_R2C);
-    if (!atempo->real_to_complex) {
-        yae_release_buffers(atempo);
-        return AVERROR(ENOMEM);
-    }
-
-    atempo->complex_to_real = av_rdft_init(nlevels + 1, IDFT_C2R);
-    if (!atempo->complex_to_real) {
-        yae_release_buffers(atempo);
-        return AVERROR(ENOMEM);
-    }
-
-    RE_MALLOC_OR_FAIL(atempo->correlation, atempo->window * sizeof(FFTComplex));
+    RE_MALLOC_OR_FAIL(atempo->frag[0].xdat, (atempo->window + YAE_PAD) * sizeof(float));
+    RE_MALLOC_OR_FAIL(atempo->frag[1].xdat, (atempo->window + YAE_PAD) * sizeof(float));
+    RE_MALLOC_OR_FAIL(atempo->frag[0].xdec, (ndec + YAE_PAD) * sizeof(float));
+    RE_MALLOC_OR_FAIL(atempo->frag[1].xdec, (ndec + YAE_PAD) * sizeof(float));
 
     atempo->ring = atempo->window * 3;
     RE_MALLOC_OR_FAIL(atempo->buffer, atempo->ring * atempo->stride);
@@ -331,9 +325,9 @@ static int yae_set_tempo(AVFilterContext *ctx, const char *arg_tempo)
         return AVERROR(EINVAL);
     }
 
-    if (tempo < 0.5 || tempo > 2.0) {
-        av_log(ctx, AV_LOG_ERROR, "Tempo value %f exceeds [0.5, 2.0] range\n",
-               tempo);
+    if (tempo < YAE_ATEMPO_MIN || tempo > YAE_ATEMPO_MAX) {
+        av_log(ctx, AV_LOG_ERROR, "Tempo value %f exceeds [%.2f, %.1f] range\n",
+               tempo, YAE_ATEMPO_MIN, YAE_ATEMPO_MAX);
         return AVERROR(EINVAL);
     }
 
@@ -345,15 +339,15 @@ static int yae_set_tempo(AVFilterContext *ctx, const char *arg_tempo)
 }
 
 /**
- * A helper macro for initializing complex data buffer with scalar data
- * of a given type.
+ * A helper macro for initializing the down-mixed data buffer with scalar
+ * data of a given type.
  */
 #define yae_init_xdat(scalar_type, scalar_max)                          \
     do {                                                                \
         const uint8_t *src_end = src +                                  \
             frag->nsamples * atempo->channels * sizeof(scalar_type);    \
                                                                         \
-        FFTSample *xdat = frag->xdat;                                   \
+        float *xdat = frag->xdat;                                       \
         scalar_type tmp;                                                \
                                                                         \
         if (atempo->channels == 1) {                                    \
@@ -361,27 +355,25 @@ static int yae_set_tempo(AVFilterContext *ctx, const char *arg_tempo)
                 tmp = *(const scalar_type *)src;                        \
                 src += sizeof(scalar_type);                             \
                                                                         \
-                *xdat = (FFTSample)tmp;                                 \
+                *xdat = (float)tmp;                                     \
             }                                                           \
         } else {                                                        \
-            FFTSample s, max, ti, si;                                   \
+            float s, max, ti, si;                                       \
             int i;                                                      \
                                                                         \
             for (; src < src_end; xdat++) {                             \
                 tmp = *(const scalar_type *)src;                        \
                 src += sizeof(scalar_type);                             \
                                                                         \
-                max = (FFTSample)tmp;                                   \
-                s = FFMIN((FFTSample)scalar_max,                        \
-                          (FFTSample)fabsf(max));                       \
+                max = (float)tmp;                                       \
+                s = FFMIN((float)scalar_max, fabsf(max));               \
                                                                         \
                 for (i = 1; i < atempo->channels; i++) {                \
                     tmp = *(const scalar_type *)src;                    \
                     src += sizeof(scalar_type);                         \
                                                                         \
-                    ti = (FFTSample)tmp;                                \
-                    si = FFMIN((FFTSample)scalar_max,                   \
-                               (FFTSample)fabsf(ti));                   \
+                    ti = (float)tmp;                                    \
+                    si = FFMIN((float)scalar_max, fabsf(ti));           \
                                                                         \
                     if (s < si) {                                       \
                         s   = si;                                       \
@@ -395,16 +387,18 @@ static int yae_set_tempo(AVFilterContext *ctx, const char *arg_tempo)
     } while (0)
 
 /**
- * Initialize complex data buffer of a given audio fragment
- * with down-mixed mono data of appropriate scalar type.
+ * Initialize the data buffers of a given audio fragment with down-mixed
+ * mono data of appropriate scalar type and its decimated version.
  */
 static void yae_downmix(ATempoContext *atempo, AudioFragment *frag)
 {
     // shortcuts:
     const uint8_t *src = frag->data;
+    const int ndec = atempo->window / atempo->decim;
+    int i, j;
 
-    // init complex data buffer used for FFT and Correlation:
-    memset(frag->xdat, 0, sizeof(FFTComplex) * atempo->window);
+    // the samples past the end of the fragment must read as zeros:
+    memset(frag->xdat, 0, sizeof(float) * (atempo->window + YAE_PAD));
 
     if (atempo->format == AV_SAMPLE_FMT_U8) {
         yae_init_xdat(uint8_t, 127);
@@ -417,6 +411,17 @@ static void yae_downmix(ATempoContext *atempo, AudioFragment *frag)
     } else if (atempo->format == AV_SAMPLE_FMT_DBL) {
         yae_init_xdat(double, 1);
     }
+
+    // decimate, the sum acts as a crude low-pass filter:
+    for (i = 0; i < ndec; i++) {
+        const float *x = frag->xdat + i * atempo->decim;
+        float sum = 0;
+
+        for (j = 0; j < atempo->decim; j++)
+            sum += x[j];
+        frag->xdec[i] = sum;
+    }
+    memset(frag->xdec + ndec, 0, sizeof(float) * YAE_PAD);
 }
 
 /**
@@ -433,20 +438,19 @@ static int yae_load_data(ATempoContext *atempo,
 {
     // shortcut:
     const uint8_t *src = *src_ref;
-    const int read_size = stop_here - atempo->position[0];
 
     if (stop_here <= atempo->position[0]) {
         return 0;
     }
 
-    // samples are not expected to be skipped:
-    av_assert0(read_size <= atempo->ring);
-
+    // samples are skipped when the tempo is greater than 2, only the last
+    // ring-buffer worth of them is kept:
     while (atempo->position[0] < stop_here && src < src_end) {
+        int64_t read_size = stop_here - atempo->position[0];
         int src_samples = (src_end - src) / atempo->stride;
 
         // load data piece-wise, in order to avoid complicating the logic:
-        int nsamples = FFMIN(read_size, src_samples);
+        int nsamples = FFMIN(read_size, (int64_t)src_samples);
         int na;
         int nb;
 
@@ -535,9 +539,9 @@ static int yae_load_frag(ATempoContext *atempo,
     zeros = 0;
 
     if (frag->position[0] < start) {
-        // what we don't have we substitute with zeros:
+        // what we don't have we substitute with zeros, which may be the
+        // whole fragment after a large change of tempo:
         zeros = FFMIN(start - frag->position[0], (int64_t)nsamples);
-        av_assert0(zeros != nsamples);
 
         memset(dst, 0, zeros * atempo->stride);
         dst += zeros * atempo->stride;
@@ -598,67 +602,57 @@ static void yae_advance_to_next_frag(ATempoContext *atempo)
 }
 
 /**
- * Calculate cross-correlation via rDFT.
- *
- * Multiply two vectors of complex numbers (result of real_to_complex rDFT)
- * and transform back via complex_to_real rDFT.
+ * Calculate the normalized cross-correlation metric of two fragments
+ * at a given lag, in samples of the given data buffers.
  */
-static void yae_xcorr_via_rdft(FFTSample *xcorr,
-                               RDFTContext *complex_to_real,
-                               const FFTComplex *xa,
-                               const FFTComplex *xb,
-                               const int window)
+static float yae_xcorr(ATempoContext *atempo,
+                       const float *prev,
+                       const float *frag,
+                       int size,
+                       int lag,
+                       int i,
+                       int i0,
+                       int i1,
+                       int drift)
 {
-    FFTComplex *xc = (FFTComplex *)xcorr;
-    int i;
-
-    // NOTE: first element requires special care -- Given Y = rDFT(X),
-    // Im(Y[0]) and Im(Y[N/2]) are always zero, therefore av_rdft_calc
-    // stores Re(Y[N/2]) in place of Im(Y[0]).
+    // the fragments are zero padded, so the length may be rounded up:
+    const int len = FFALIGN(size - lag, YAE_PAD);
+    float metric = atempo->dsp.dot(prev + lag, frag, len);
 
-    xc->re = xa->re * xb->re;
-    xc->im = xa->im * xb->im;
-    xa++;
-    xb++;
-    xc++;
+    // normalize:
+    float drifti = (float)(drift + i);
+    metric *= drifti * (float)(i - i0) * (float)(i1 - i);
 
-    for (i = 1; i < window; i++, xa++, xb++, xc++) {
-        xc->re = (xa->re * xb->re + xa->im * xb->im);
-        xc->im = (xa->im * xb->re - xa->re * xb->im);
-    }
-
-    // apply inverse rDFT:
-    av_rdft_calc(complex_to_real, xcorr);
+    return metric;
 }
 
 /**
  * Calculate alignment offset for given fragment
  * relative to the previous fragment.
  *
+ * The cross-correlation of the decimated fragments is searched first, and
+ * then that of the full fragments, around the best lag found.
+ *
  * @return alignment offset of current fragment relative to previous.
  */
-static int yae_align(AudioFragment *frag,
+static int yae_align(ATempoContext *atempo,
+                     const AudioFragment *frag,
                      const AudioFragment *prev,
-                     const int window,
                      const int delta_max,
-                     const int drift,
-                     FFTSample *correlation,
-                     RDFTContext *complex_to_real)
+                     const int drift)
 {
+    const int window = atempo->window;
+    const int decim  = atempo->decim;
     int       best_offset = -drift;
-    FFTSample best_metric = -FLT_MAX;
-    FFTSample *xcorr;
+    float     best_metric = -FLT_MAX;
+    int       best_coarse = -1;
 
     int i0;
     int i1;
+    int lo;
+    int hi;
     int i;
 
-    yae_xcorr_via_rdft(correlation,
-                       complex_to_real,
-                       (const FFTComplex *)prev->xdat,
-                       (const FFTComplex *)frag->xdat,
-                       window);
-
     // identify search window boundaries:
     i0 = FFMAX(window / 2 - delta_max - drift, 0);
     i0 = FFMIN(i0, window);
@@ -666,15 +660,33 @@ static int yae_align(AudioFragment *frag,
     i1 = FFMIN(window / 2 + delta_max - drift, window - window / 16);
     i1 = FFMAX(i1, 0);
 
-    // identify cross-correlation peaks within search window:
-    xcorr = correlation + i0;
+    // coarse search, every decim samples:
+    if (decim > 1) {
+        for (i = FFALIGN(i0, decim); i < i1; i += decim) {
+            float metric = yae_xcorr(atempo, prev->xdec, frag->xdec,
+                                     window / decim, i / decim,
+                                     i, i0, i1, drift);
+
+            if (metric > best_metric) {
+                best_metric = metric;
+                best_coarse = i;
+            }
+        }
+    }
 
-    for (i = i0; i < i1; i++, xcorr++) {
-        FFTSample metric = *xcorr;
+    // fine search, around the coarse peak:
+    lo = i0;
+    hi = i1;
+    if (best_coarse >= 0) {
+        lo = FFMAX(i0, best_coarse - decim + 1);
+        hi = FFMIN(i1, best_coarse + decim);
+        best_metric = -FLT_MAX;
+    }
 
-        // normalize:
-        FFTSample drifti = (FFTSample)(drift + i);
-        metric *= drifti * (FFTSample)(i - i0) * (FFTSample)(i1 - i);
+    // identify cross-correlation peaks within search window:
+    for (i = lo; i < hi; i++) {
+        float metric = yae_xcorr(atempo, prev->xdat, frag->xdat,
+                                 window, i, i, i0, i1, drift);
 
         if (metric > best_metric) {
             best_metric = metric;
@@ -703,16 +715,17 @@ static int yae_adjust_position(ATempoContext *atempo)
         (double)(prev->position[0] - atempo->origin[0] + atempo->window / 2) /
         atempo->tempo;
 
-    const int drift = (int)(prev_output_position - ideal_output_position);
+    // the drift is compensated by moving the fragment along the input,
+    // it is scaled down below a tempo of 0.5 so as not to overshoot:
+    const int drift = (int)((prev_output_position - ideal_output_position) *
+                            FFMIN(2.0 * atempo->tempo, 1.0));
 
     const int delta_max  = atempo->window / 2;
-    const int correction = yae_align(frag,
+    const int correction = yae_align(atempo,
+                                     frag,
                                      prev,
-                                     atempo->window,
                                      delta_max,
-                                     drift,
-                                     atempo->correlation,
-                                     atempo->complex_to_real);
+                                     drift);
 
     if (correction) {
         // adjust fragment position:
@@ -837,9 +850,6 @@ yae_apply(ATempoContext *atempo,
             // down-mix to mono:
             yae_downmix(atempo, yae_curr_frag(atempo));
 
-            // apply rDFT:
-            av_rdft_calc(atempo->real_to_complex, yae_curr_frag(atempo)->xdat);
-
             // must load the second fragment before alignment can start:
             if (!atempo->nfrag) {
                 yae_advance_to_next_frag(atempo);
@@ -869,9 +879,6 @@ yae_apply(ATempoContext *atempo,
             // down-mix to mono:
             yae_downmix(atempo, yae_curr_frag(atempo));
 
-            // apply rDFT:
-            av_rdft_calc(atempo->real_to_complex, yae_curr_frag(atempo)->xdat);
-
             atempo->state = YAE_OUTPUT_OVERLAP_ADD;
         }
 
@@ -928,9 +935,6 @@ static int yae_flush(ATempoContext *atempo,
             // down-mix to mono:
             yae_downmix(atempo, frag);
 
-            // apply rDFT:
-            av_rdft_calc(atempo->real_to_complex, frag->xdat);
-
             // align current fragment to previous fragment:
             if (yae_adjust_position(atempo)) {
                 // reload the current fragment due to adjusted position:
@@ -979,11 +983,39 @@ static int yae_flush(ATempoContext *atempo,
     return atempo->position[1] == stop_here ? 0 : AVERROR(EAGAIN);
 }
 
+static float dot_c(const float *a, const float *b, int len)
+{
+    float sum[ATEMPO_DOT_ALIGN] = { 0 };
+    int i, j;
+
+    // the partial sums are kept and added up in the same order as in
+    // the SIMD versions, so that they give the same alignment:
+    for (i = 0; i < len; i += ATEMPO_DOT_ALIGN)
+        for (j = 0; j < ATEMPO_DOT_ALIGN; j++)
+            sum[j] += a[i + j] * b[i + j];
+
+    for (j = 0; j < 8; j++)
+        sum[j] += sum[j + 8];
+    for (j = 0; j < 4; j++)
+        sum[j] += sum[j + 4];
+
+    return (sum[0] + sum[2]) + (sum[1] + sum[3]);
+}
+
+av_cold void ff_atempo_init(ATempoDSPContext *dsp)
+{
+    dsp->dot = dot_c;
+
+    if (ARCH_X86)
+        ff_atempo_init_x86(dsp);
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     ATempoContext *atempo = ctx->priv;
     atempo->format = AV_SAMPLE_FMT_NONE;
     atempo->state  = YAE_LOAD_FRAGMENT;
+    ff_atempo_init(&atempo->dsp);
     return 0;
 }
 
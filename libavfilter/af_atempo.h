@@ -0,0 +1,48 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * tempo scaling audio filter
+ */
+
+#ifndef AVFILTER_ATEMPO_H
+#define AVFILTER_ATEMPO_H
+
+#define ATEMPO_DOT_ALIGN 16
+
+typedef struct ATempoDSPContext {
+    /**
+     * Calculate the scalar product of two vectors.
+     *
+     * The products are summed in ATEMPO_DOT_ALIGN partial sums, the one
+     * of index j taking the products of index j modulo ATEMPO_DOT_ALIGN,
+     * which are then added up pairwise: sum[j] += sum[j + 8], then
+     * sum[j] += sum[j + 4] and finally (sum[0] + sum[2]) + (sum[1] + sum[3]).
+     *
+     * @param a   first vector, not necessarily aligned
+     * @param b   second vector, not necessarily aligned
+     * @param len length of the vectors, a multiple of ATEMPO_DOT_ALIGN
+     */
+    float (*dot)(const float *a, const float *b, int len);
+} ATempoDSPContext;
+
+void ff_atempo_init(ATempoDSPContext *dsp);
+void ff_atempo_init_x86(ATempoDSPContext *dsp);
+
+#endif /* AVFILTER_ATEMPO_H */
@@ -25,6 +25,7 @@
 #include "avfilter.h"
 #include "internal.h"
 #include "audio.h"
+#include "partconv.h"
 
 #define RDFT_BITS_MIN 4
 #define RDFT_BITS_MAX 16
@@ -49,27 +50,17 @@ typedef struct {
     double  gain;
 } GainEntry;
 
-typedef struct {
-    int buf_idx;
-    int overlap_idx;
-} OverlapIndex;
-
 typedef struct {
     const AVClass *class;
 
     RDFTContext   *analysis_irdft;
-    RDFTContext   *rdft;
-    RDFTContext   *irdft;
     int           analysis_rdft_len;
-    int           rdft_len;
 
     float         *analysis_buf;
     float         *kernel_tmp_buf;
-    float         *kernel_buf;
-    float         *conv_buf;
-    OverlapIndex  *conv_idx;
+    PartConvContext *conv;          ///< one per channel
+    int           nb_channels;
     int           fir_len;
-    int           nsamples_max;
     int64_t       next_pts;
     int           frame_nsamples_max;
     int           remaining;
@@ -118,16 +109,17 @@ AVFILTER_DEFINE_CLASS(firequalizer);
 
 static void common_uninit(FIREqualizerContext *s)
 {
+    int i;
+
     av_rdft_end(s->analysis_irdft);
-    av_rdft_end(s->rdft);
-    av_rdft_end(s->irdft);
-    s->analysis_irdft = s->rdft = s->irdft = NULL;
+    s->analysis_irdft = NULL;
+    for (i = 0; i < s->nb_channels; i++)
+        ff_partconv_uninit(&s->conv[i]);
+    av_freep(&s->conv);
+    s->nb_channels = 0;
 
     av_freep(&s->analysis_buf);
     av_freep(&s->kernel_tmp_buf);
-    av_freep(&s->kernel_buf);
-    av_freep(&s->conv_buf);
-    av_freep(&s->conv_idx);
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -169,45 +161,6 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_samplerates(ctx, formats);
 }
 
-static void fast_convolute(FIREqualizerContext *s, const float *kernel_buf, float *conv_buf,
-                           OverlapIndex *idx, float *data, int nsamples)
-{
-    if (nsamples <= s->nsamples_max) {
-        float *buf = conv_buf + idx->buf_idx * s->rdft_len;
-        float *obuf = conv_buf + !idx->buf_idx * s->rdft_len + idx->overlap_idx;
-        int k;
-
-        memcpy(buf, data, nsamples * sizeof(*data));
-        memset(buf + nsamples, 0, (s->rdft_len - nsamples) * sizeof(*data));
-        av_rdft_calc(s->rdft, buf);
-
-        buf[0] *= kernel_buf[0];
-        buf[1] *= kernel_buf[1];
-        for (k = 2; k < s->rdft_len; k += 2) {
-            float re, im;
-            re = buf[k] * kernel_buf[k] - buf[k+1] * kernel_buf[k+1];
-            im = buf[k] * kernel_buf[k+1] + buf[k+1] * kernel_buf[k];
-            buf[k] = re;
-            buf[k+1] = im;
-        }
-
-        av_rdft_calc(s->irdft, buf);
-        for (k = 0; k < s->rdft_len - idx->overlap_idx; k++)
-            buf[k] += obuf[k];
-        memcpy(data, buf, nsamples * sizeof(*data));
-        idx->buf_idx = !idx->buf_idx;
-        idx->overlap_idx = nsamples;
-    } else {
-        while (nsamples > s->nsamples_max * 2) {
-            fast_convolute(s, kernel_buf, conv_buf, idx, data, s->nsamples_max);
-            data += s->nsamples_max;
-            nsamples -= s->nsamples_max;
-        }
-        fast_convolute(s, kernel_buf, conv_buf, idx, data, nsamples/2);
-        fast_convolute(s, kernel_buf, conv_buf, idx, data + nsamples/2, nsamples - nsamples/2);
-    }
-}
-
 static double entry_func(void *p, double freq, double gain)
 {
     AVFilterContext *ctx = p;
@@ -389,7 +342,7 @@ static int generate_kernel(AVFilterContext *ctx, const char *gain, const char *g
             default:
                 av_assert0(0);
             }
-            s->analysis_buf[k] *= (2.0/s->analysis_rdft_len) * (2.0/s->rdft_len) * win;
+            s->analysis_buf[k] *= (2.0/s->analysis_rdft_len) * win;
         }
 
         for (k = 0; k < center - k; k++) {
@@ -401,10 +354,7 @@ static int generate_kernel(AVFilterContext *ctx, const char *gain, const char *g
         for (k = 1; k <= center; k++)
             s->analysis_buf[center + k] = s->analysis_buf[center - k];
 
-        memset(s->analysis_buf + s->fir_len, 0, (s->rdft_len - s->fir_len) * sizeof(*s->analysis_buf));
-        av_rdft_calc(s->rdft, s->analysis_buf);
-
-        for (k = 0; k < s->rdft_len; k++) {
+        for (k = 0; k < s->fir_len; k++) {
             if (isnan(s->analysis_buf[k]) || isinf(s->analysis_buf[k])) {
                 av_log(ctx, AV_LOG_ERROR, "filter kernel contains nan or infinity.\n");
                 av_expr_free(gain_expr);
@@ -412,12 +362,13 @@ static int generate_kernel(AVFilterContext *ctx, const char *gain, const char *g
             }
         }
 
-        memcpy(s->kernel_tmp_buf + ch * s->rdft_len, s->analysis_buf, s->rdft_len * sizeof(*s->analysis_buf));
+        memcpy(s->kernel_tmp_buf + ch * s->fir_len, s->analysis_buf, s->fir_len * sizeof(*s->analysis_buf));
         if (!s->multi)
             break;
     }
 
-    memcpy(s->kernel_buf, s->kernel_tmp_buf, (s->multi ? inlink->channels : 1) * s->rdft_len * sizeof(*s->kernel_buf));
+    for (ch = 0; ch < inlink->channels; ch++)
+        ff_partconv_set_ir(&s->conv[ch], 0, s->kernel_tmp_buf + (s->multi ? ch * s->fir_len : 0), s->fir_len);
     av_expr_free(gain_expr);
     return 0;
 }
@@ -426,7 +377,7 @@ static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     FIREqualizerContext *s = ctx->priv;
-    int rdft_bits;
+    int rdft_bits, part_size, ch, ret;
 
     common_uninit(s);
 
@@ -436,10 +387,10 @@ static int config_input(AVFilterLink *inlink)
     s->fir_len = FFMAX(2 * (int)(inlink->sample_rate * s->delay) + 1, 3);
     s->remaining = s->fir_len - 1;
 
+    /* the analysis length is at least 1.5 times the kernel length */
     for (rdft_bits = RDFT_BITS_MIN; rdft_bits <= RDFT_BITS_MAX; rdft_bits++) {
-        s->rdft_len = 1 << rdft_bits;
-        s->nsamples_max = s->rdft_len - s->fir_len + 1;
-        if (s->nsamples_max * 2 >= s->fir_len)
+        int len = 1 << rdft_bits;
+        if ((len - s->fir_len + 1) * 2 >= s->fir_len)
             break;
     }
 
@@ -448,8 +399,16 @@ static int config_input(AVFilterLink *inlink)
         return AVERROR(EINVAL);
     }
 
-    if (!(s->rdft = av_rdft_init(rdft_bits, DFT_R2C)) || !(s->irdft = av_rdft_init(rdft_bits, IDFT_C2R)))
+    part_size = ff_partconv_part_size(s->fir_len);
+
+    s->conv = av_calloc(inlink->channels, sizeof(*s->conv));
+    if (!s->conv)
         return AVERROR(ENOMEM);
+    s->nb_channels = inlink->channels;
+
+    for (ch = 0; ch < inlink->channels; ch++)
+        if ((ret = ff_partconv_init(&s->conv[ch], part_size, s->fir_len, 1)) < 0)
+            return ret;
 
     for ( ; rdft_bits <= RDFT_BITS_MAX; rdft_bits++) {
         s->analysis_rdft_len = 1 << rdft_bits;
@@ -466,35 +425,43 @@ static int config_input(AVFilterLink *inlink)
         return AVERROR(ENOMEM);
 
     s->analysis_buf = av_malloc_array(s->analysis_rdft_len, sizeof(*s->analysis_buf));
-    s->kernel_tmp_buf = av_malloc_array(s->rdft_len * (s->multi ? inlink->channels : 1), sizeof(*s->kernel_tmp_buf));
-    s->kernel_buf = av_malloc_array(s->rdft_len * (s->multi ? inlink->channels : 1), sizeof(*s->kernel_buf));
-    s->conv_buf   = av_calloc(2 * s->rdft_len * inlink->channels, sizeof(*s->conv_buf));
-    s->conv_idx   = av_calloc(inlink->channels, sizeof(*s->conv_idx));
-    if (!s->analysis_buf || !s->kernel_tmp_buf || !s->kernel_buf || !s->conv_buf || !s->conv_idx)
+    s->kernel_tmp_buf = av_malloc_array(s->fir_len * (s->multi ? inlink->channels : 1), sizeof(*s->kernel_tmp_buf));
+    if (!s->analysis_buf || !s->kernel_tmp_buf)
         return AVERROR(ENOMEM);
 
-    av_log(ctx, AV_LOG_DEBUG, "sample_rate = %d, channels = %d, analysis_rdft_len = %d, rdft_len = %d, fir_len = %d, nsamples_max = %d.\n",
-           inlink->sample_rate, inlink->channels, s->analysis_rdft_len, s->rdft_len, s->fir_len, s->nsamples_max);
+    av_log(ctx, AV_LOG_DEBUG, "sample_rate = %d, channels = %d, analysis_rdft_len = %d, fir_len = %d, part_size = %d, nb_parts = %d.\n",
+           inlink->sample_rate, inlink->channels, s->analysis_rdft_len, s->fir_len, part_size, s->conv[0].nb_parts);
 
     if (s->fixed)
-        inlink->min_samples = inlink->max_samples = inlink->partial_buf_size = s->nsamples_max;
+        inlink->min_samples = inlink->max_samples = inlink->partial_buf_size = part_size;
 
     return generate_kernel(ctx, s->gain_cmd ? s->gain_cmd : s->gain,
                            s->gain_entry_cmd ? s->gain_entry_cmd : s->gain_entry);
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+static int convolute_channels(AVFilterContext *ctx, void *arg, int jobnr,
+                              int ch_start, int ch_end)
 {
-    AVFilterContext *ctx = inlink->dst;
     FIREqualizerContext *s = ctx->priv;
+    AVFrame *frame = arg;
     int ch;
 
-    for (ch = 0; ch < inlink->channels; ch++) {
-        fast_convolute(s, s->kernel_buf + (s->multi ? ch * s->rdft_len : 0),
-                       s->conv_buf + 2 * ch * s->rdft_len, s->conv_idx + ch,
-                       (float *) frame->extended_data[ch], frame->nb_samples);
+    for (ch = ch_start; ch < ch_end; ch++) {
+        float *data = (float *) frame->extended_data[ch];
+
+        ff_partconv_process(&s->conv[ch], data, 1, (const float **) &data, 1, frame->nb_samples);
     }
 
+    return 0;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx = inlink->dst;
+    FIREqualizerContext *s = ctx->priv;
+
+    ff_filter_execute_channels(ctx, convolute_channels, frame, inlink->channels);
+
     s->next_pts = AV_NOPTS_VALUE;
     if (frame->pts != AV_NOPTS_VALUE) {
         s->next_pts = frame->pts + av_rescale_q(frame->nb_samples, av_make_q(1, inlink->sample_rate), inlink->time_base);
@@ -596,4 +563,5 @@ AVFilter ff_af_firequalizer = {
     .inputs             = firequalizer_inputs,
     .outputs            = firequalizer_outputs,
     .priv_class         = &firequalizer_class,
+    .flags              = AVFILTER_FLAG_SLICE_THREADS,
 };
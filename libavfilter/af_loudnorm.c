@@ -24,7 +24,7 @@
 #include "avfilter.h"
 #include "internal.h"
 #include "audio.h"
-#include <ebur128.h>
+#include "ebur128.h"
 
 enum FrameType {
     FIRST_FRAME,
@@ -62,6 +62,7 @@ typedef struct LoudNormContext {
     int linear;
     int dual_mono;
     enum PrintFormat print_format;
+    int measure;
 
     double *buf;
     int buf_size;
@@ -91,8 +92,8 @@ typedef struct LoudNormContext {
     int prev_nb_samples;
     int channels;
 
-    ebur128_state *r128_in;
-    ebur128_state *r128_out;
+    FFEBUR128Context r128_in;
+    FFEBUR128Context r128_out;
 } LoudNormContext;
 
 #define OFFSET(x) offsetof(LoudNormContext, x)
@@ -119,6 +120,7 @@ static const AVOption loudnorm_options[] = {
     {     "none",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  NONE},     0,         0,  FLAGS, "print_format" },
     {     "json",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  JSON},     0,         0,  FLAGS, "print_format" },
     {     "summary",      0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  SUMMARY},  0,         0,  FLAGS, "print_format" },
+    { "measure",          "only measure the input",            OFFSET(measure),          AV_OPT_TYPE_BOOL,    {.i64 =  0},        0,         1,  FLAGS },
     { NULL }
 };
 
@@ -420,6 +422,11 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     double gain, gain_next, env_global, env_shortterm,
     global, shortterm, lra, relative_threshold;
 
+    if (s->measure) {
+        ff_ebur128_add_frames(&s->r128_in, (const double *)in->data[0], in->nb_samples);
+        return ff_filter_frame(outlink, in);
+    }
+
     if (av_frame_is_writable(in)) {
         out = in;
     } else {
@@ -437,15 +444,14 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     buf = s->buf;
     limiter_buf = s->limiter_buf;
 
-    ebur128_add_frames_double(s->r128_in, src, in->nb_samples);
+    ff_ebur128_add_frames(&s->r128_in, src, in->nb_samples);
 
     if (s->frame_type == FIRST_FRAME && in->nb_samples < frame_size(inlink->sample_rate, 3000)) {
         double offset, offset_tp, true_peak;
 
-        ebur128_loudness_global(s->r128_in, &global);
+        global = ff_ebur128_loudness_global(&s->r128_in);
         for (c = 0; c < inlink->channels; c++) {
-            double tmp;
-            ebur128_sample_peak(s->r128_in, c, &tmp);
+            double tmp = s->r128_in.sample_peaks[c];
             if (c == 0 || tmp > true_peak)
                 true_peak = tmp;
         }
@@ -467,7 +473,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             s->buf_index += inlink->channels;
         }
 
-        ebur128_loudness_shortterm(s->r128_in, &shortterm);
+        shortterm = s->r128_in.shortterm;
 
         if (shortterm < s->measured_thresh) {
             s->above_threshold = 0;
@@ -497,7 +503,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
         subframe_length = frame_size(inlink->sample_rate, 100);
         true_peak_limiter(s, dst, subframe_length, inlink->channels);
-        ebur128_add_frames_double(s->r128_out, dst, subframe_length);
+        ff_ebur128_add_frames(&s->r128_out, dst, subframe_length);
 
         s->pts +=
         out->nb_samples =
@@ -536,12 +542,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         s->limiter_buf_index = s->limiter_buf_index + subframe_length < s->limiter_buf_size ? s->limiter_buf_index + subframe_length : s->limiter_buf_index + subframe_length - s->limiter_buf_size;
 
         true_peak_limiter(s, dst, in->nb_samples, inlink->channels);
-        ebur128_add_frames_double(s->r128_out, dst, in->nb_samples);
+        ff_ebur128_add_frames(&s->r128_out, dst, in->nb_samples);
 
-        ebur128_loudness_range(s->r128_in, &lra);
-        ebur128_loudness_global(s->r128_in, &global);
-        ebur128_loudness_shortterm(s->r128_in, &shortterm);
-        ebur128_relative_threshold(s->r128_in, &relative_threshold);
+        ff_ebur128_loudness_range(&s->r128_in, &lra, NULL, NULL);
+        global             = ff_ebur128_loudness_global(&s->r128_in);
+        shortterm          = s->r128_in.shortterm;
+        relative_threshold = ff_ebur128_relative_threshold(&s->r128_in);
 
         if (s->above_threshold == 0) {
             double shortterm_out;
@@ -549,7 +555,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             if (shortterm > s->measured_thresh)
                 s->prev_delta *= 1.0058;
 
-            ebur128_loudness_shortterm(s->r128_out, &shortterm_out);
+            shortterm_out = s->r128_out.shortterm;
             if (shortterm_out >= s->target_i)
                 s->above_threshold = 1;
         }
@@ -611,7 +617,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         }
 
         dst = (double *)out->data[0];
-        ebur128_add_frames_double(s->r128_out, dst, in->nb_samples);
+        ff_ebur128_add_frames(&s->r128_out, dst, in->nb_samples);
         break;
 
     case LINEAR_MODE:
@@ -624,7 +630,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         }
 
         dst = (double *)out->data[0];
-        ebur128_add_frames_double(s->r128_out, dst, in->nb_samples);
+        ff_ebur128_add_frames(&s->r128_out, dst, in->nb_samples);
         s->pts += in->nb_samples;
         break;
     }
@@ -682,6 +688,7 @@ static int request_frame(AVFilterLink *outlink)
 
 static int query_formats(AVFilterContext *ctx)
 {
+    LoudNormContext *s = ctx->priv;
     AVFilterFormats *formats;
     AVFilterChannelLayouts *layouts;
     AVFilterLink *inlink = ctx->inputs[0];
@@ -707,6 +714,10 @@ static int query_formats(AVFilterContext *ctx)
     if (ret < 0)
         return ret;
 
+    /* measuring alone does not need the oversampled input of the limiter */
+    if (s->measure)
+        return ff_set_common_samplerates(ctx, ff_all_samplerates());
+
     formats = ff_make_format_list(input_srate);
     if (!formats)
         return AVERROR(ENOMEM);
@@ -724,19 +735,24 @@ static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     LoudNormContext *s = ctx->priv;
+    const int flags = s->dual_mono ? FF_EBUR128_DUAL_MONO : 0;
+    int ret;
 
-    s->r128_in = ebur128_init(inlink->channels, inlink->sample_rate, EBUR128_MODE_I | EBUR128_MODE_S | EBUR128_MODE_LRA | EBUR128_MODE_SAMPLE_PEAK);
-    if (!s->r128_in)
-        return AVERROR(ENOMEM);
+    s->channels = inlink->channels;
 
-    s->r128_out = ebur128_init(inlink->channels, inlink->sample_rate, EBUR128_MODE_I | EBUR128_MODE_S | EBUR128_MODE_LRA | EBUR128_MODE_SAMPLE_PEAK);
-    if (!s->r128_out)
-        return AVERROR(ENOMEM);
+    if (s->measure)
+        return ff_ebur128_init(&s->r128_in, ctx, inlink->channel_layout, inlink->channels,
+                               inlink->sample_rate, flags | FF_EBUR128_TRUE_PEAK);
 
-    if (inlink->channels == 1 && s->dual_mono) {
-        ebur128_set_channel(s->r128_in,  0, EBUR128_DUAL_MONO);
-        ebur128_set_channel(s->r128_out, 0, EBUR128_DUAL_MONO);
-    }
+    ret = ff_ebur128_init(&s->r128_in, ctx, inlink->channel_layout, inlink->channels,
+                          inlink->sample_rate, flags | FF_EBUR128_SAMPLE_PEAK);
+    if (ret < 0)
+        return ret;
+
+    ret = ff_ebur128_init(&s->r128_out, ctx, inlink->channel_layout, inlink->channels,
+                          inlink->sample_rate, flags | FF_EBUR128_SAMPLE_PEAK);
+    if (ret < 0)
+        return ret;
 
     s->buf_size = frame_size(inlink->sample_rate, 3000) * inlink->channels;
     s->buf = av_malloc_array(s->buf_size, sizeof(*s->buf));
@@ -779,7 +795,6 @@ static int config_input(AVFilterLink *inlink)
     s->buf_index =
     s->prev_buf_index =
     s->limiter_buf_index = 0;
-    s->channels = inlink->channels;
     s->index = 1;
     s->limiter_state = OUT;
     s->offset = pow(10., s->offset / 20.);
@@ -796,27 +811,33 @@ static av_cold void uninit(AVFilterContext *ctx)
     double i_in, i_out, lra_in, lra_out, thresh_in, thresh_out, tp_in, tp_out;
     int c;
 
-    if (!s->r128_in || !s->r128_out)
+    if (!s->r128_in.nb_channels || (!s->measure && !s->r128_out.nb_channels))
         goto end;
 
-    ebur128_loudness_range(s->r128_in, &lra_in);
-    ebur128_loudness_global(s->r128_in, &i_in);
-    ebur128_relative_threshold(s->r128_in, &thresh_in);
+    ff_ebur128_loudness_range(&s->r128_in, &lra_in, NULL, NULL);
+    i_in      = ff_ebur128_loudness_global(&s->r128_in);
+    thresh_in = ff_ebur128_relative_threshold(&s->r128_in);
     for (c = 0; c < s->channels; c++) {
-        double tmp;
-        ebur128_sample_peak(s->r128_in, c, &tmp);
+        double tmp = s->measure ? s->r128_in.true_peaks[c] : s->r128_in.sample_peaks[c];
         if ((c == 0) || (tmp > tp_in))
             tp_in = tmp;
     }
 
-    ebur128_loudness_range(s->r128_out, &lra_out);
-    ebur128_loudness_global(s->r128_out, &i_out);
-    ebur128_relative_threshold(s->r128_out, &thresh_out);
-    for (c = 0; c < s->channels; c++) {
-        double tmp;
-        ebur128_sample_peak(s->r128_out, c, &tmp);
-        if ((c == 0) || (tmp > tp_out))
-            tp_out = tmp;
+    if (s->measure) {
+        /* the audio is passed through unchanged */
+        i_out      = i_in;
+        lra_out    = lra_in;
+        thresh_out = thresh_in;
+        tp_out     = tp_in;
+    } else {
+        ff_ebur128_loudness_range(&s->r128_out, &lra_out, NULL, NULL);
+        i_out      = ff_ebur128_loudness_global(&s->r128_out);
+        thresh_out = ff_ebur128_relative_threshold(&s->r128_out);
+        for (c = 0; c < s->channels; c++) {
+            double tmp = s->r128_out.sample_peaks[c];
+            if ((c == 0) || (tmp > tp_out))
+                tp_out = tmp;
+        }
     }
 
     switch(s->print_format) {
@@ -845,7 +866,7 @@ static av_cold void uninit(AVFilterContext *ctx)
             20. * log10(tp_out),
             lra_out,
             thresh_out,
-            s->frame_type == LINEAR_MODE ? "linear" : "dynamic",
+            s->measure ? "none" : s->frame_type == LINEAR_MODE ? "linear" : "dynamic",
             s->target_i - i_out
         );
         break;
@@ -873,17 +894,15 @@ static av_cold void uninit(AVFilterContext *ctx)
             20. * log10(tp_out),
             lra_out,
             thresh_out,
-            s->frame_type == LINEAR_MODE ? "Linear" : "Dynamic",
+            s->measure ? "None" : s->frame_type == LINEAR_MODE ? "Linear" : "Dynamic",
             s->target_i - i_out
         );
         break;
     }
 
 end:
-    if (s->r128_in)
-        ebur128_destroy(&s->r128_in);
-    if (s->r128_out)
-        ebur128_destroy(&s->r128_out);
+    ff_ebur128_uninit(&s->r128_in);
+    ff_ebur128_uninit(&s->r128_out);
     av_freep(&s->limiter_buf);
     av_freep(&s->prev_smp);
     av_freep(&s->buf);
@@ -917,4 +936,5 @@ AVFilter ff_af_loudnorm = {
     .uninit        = uninit,
     .inputs        = avfilter_af_loudnorm_inputs,
     .outputs       = avfilter_af_loudnorm_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -28,7 +28,6 @@
 #include <math.h>
 #include <netcdf.h>
 
-#include "libavcodec/avfft.h"
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/float_dsp.h"
@@ -37,6 +36,7 @@
 #include "avfilter.h"
 #include "internal.h"
 #include "audio.h"
+#include "partconv.h"
 
 #define TIME_DOMAIN      0
 #define FREQUENCY_DOMAIN 1
@@ -81,7 +81,7 @@ typedef struct SOFAlizerContext {
     int write[2];               /* current write position to ringbuffer */
     int buffer_length;          /* is: longest IR plus max. delay in all SOFA files */
                                 /* then choose next power of 2 */
-    int n_fft;                  /* number of samples in one FFT block */
+    int ir_len;                 /* longest IR plus max. delay */
 
                                 /* netCDF variables */
     int *delay[2];              /* broadband delay for each channel/IR to be convolved */
@@ -89,7 +89,6 @@ typedef struct SOFAlizerContext {
     float *data_ir[2];          /* IRs for all channels to be convolved */
                                 /* (this excludes the LFE) */
     float *temp_src[2];
-    FFTComplex *temp_fft[2];
 
                          /* control variables */
     float gain;          /* filter gain (in dB) */
@@ -100,8 +99,7 @@ typedef struct SOFAlizerContext {
 
     VirtualSpeaker vspkrpos[64];
 
-    FFTContext *fft[2], *ifft[2];
-    FFTComplex *data_hrtf[2];
+    PartConvContext conv[2];    /* partitioned convolution for L and R */
 
     AVFloatDSPContext *fdsp;
 } SOFAlizerContext;
@@ -589,7 +587,6 @@ typedef struct ThreadData {
     int *n_clippings;
     float **ringbuffer;
     float **temp_src;
-    FFTComplex **temp_fft;
 } ThreadData;
 
 static int sofalizer_convolute(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
@@ -683,112 +680,36 @@ static int sofalizer_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr,
     SOFAlizerContext *s = ctx->priv;
     ThreadData *td = arg;
     AVFrame *in = td->in, *out = td->out;
-    int offset = jobnr;
-    int *write = &td->write[jobnr];
-    FFTComplex *hrtf = s->data_hrtf[jobnr]; /* get pointers to current HRTF data */
     int *n_clippings = &td->n_clippings[jobnr];
-    float *ringbuffer = td->ringbuffer[jobnr];
-    const int n_samples = s->sofa.n_samples; /* length of one IR */
     const float *src = (const float *)in->data[0]; /* get pointer to audio input buffer */
-    float *dst = (float *)out->data[0]; /* get pointer to audio output buffer */
+    float *dst = (float *)out->data[0] + jobnr; /* get pointer to audio output buffer */
     const int in_channels = s->n_conv; /* number of input channels */
-    /* ring buffer length is: longest IR plus max. delay -> next power of 2 */
-    const int buffer_length = s->buffer_length;
-    /* -1 for AND instead of MODULO (applied to powers of 2): */
-    const uint32_t modulo = (uint32_t)buffer_length - 1;
-    FFTComplex *fft_in = s->temp_fft[jobnr]; /* temporary array for FFT input/output data */
-    FFTContext *ifft = s->ifft[jobnr];
-    FFTContext *fft = s->fft[jobnr];
-    const int n_conv = s->n_conv;
-    const int n_fft = s->n_fft;
-    int wr = *write;
-    int n_read;
+    const float *conv_src[16]; /* inputs to be convolved (all but the LFE) */
     int i, j;
 
-    dst += offset;
-
-    /* find minimum between number of samples and output buffer length:
-     * (important, if one IR is longer than the output buffer) */
-    n_read = FFMIN(s->sofa.n_samples, in->nb_samples);
-    for (j = 0; j < n_read; j++) {
-        /* initialize output buf with saved signal from overflow buf */
-        dst[2 * j]     = ringbuffer[wr];
-        ringbuffer[wr] = 0.0; /* re-set read samples to zero */
-        /* update ringbuffer read/write position */
-        wr  = (wr + 1) & modulo;
-    }
-
-    /* initialize rest of output buffer with 0 */
-    for (j = n_read; j < in->nb_samples; j++) {
-        dst[2 * j] = 0;
+    for (i = 0, j = 0; i < in_channels; i++) {
+        if (i != s->lfe_channel)
+            conv_src[j++] = src + i;
     }
 
-    for (i = 0; i < n_conv; i++) {
-        if (i == s->lfe_channel) { /* LFE */
-            for (j = 0; j < in->nb_samples; j++) {
-                /* apply gain to LFE signal and add to output buffer */
-                dst[2 * j] += src[i + j * in_channels] * s->gain_lfe;
-            }
-            continue;
-        }
-
-        /* outer loop: go through all input channels to be convolved */
-        offset = i * n_fft; /* no. samples already processed */
-
-        /* fill FFT input with 0 (we want to zero-pad) */
-        memset(fft_in, 0, sizeof(FFTComplex) * n_fft);
-
-        for (j = 0; j < in->nb_samples; j++) {
-            /* prepare input for FFT */
-            /* write all samples of current input channel to FFT input array */
-            fft_in[j].re = src[j * in_channels + i];
-        }
-
-        /* transform input signal of current channel to frequency domain */
-        av_fft_permute(fft, fft_in);
-        av_fft_calc(fft, fft_in);
-        for (j = 0; j < n_fft; j++) {
-            const float re = fft_in[j].re;
-            const float im = fft_in[j].im;
-
-            /* complex multiplication of input signal and HRTFs */
-            /* output channel (real): */
-            fft_in[j].re = re * (hrtf + offset + j)->re - im * (hrtf + offset + j)->im;
-            /* output channel (imag): */
-            fft_in[j].im = re * (hrtf + offset + j)->im + im * (hrtf + offset + j)->re;
-        }
-
-        /* transform output signal of current channel back to time domain */
-        av_fft_permute(ifft, fft_in);
-        av_fft_calc(ifft, fft_in);
+    /* convolve all input channels with the HRIRs of this ear and sum them up */
+    ff_partconv_process(&s->conv[jobnr], dst, 2, conv_src, in_channels, in->nb_samples);
 
+    if (s->lfe_channel >= 0) {
         for (j = 0; j < in->nb_samples; j++) {
-            /* write output signal of current channel to output buffer */
-            dst[2 * j] += fft_in[j].re / (float)n_fft;
-        }
-
-        for (j = 0; j < n_samples - 1; j++) { /* overflow length is IR length - 1 */
-            /* write the rest of output signal to overflow buffer */
-            int write_pos = (wr + j) & modulo;
-
-            *(ringbuffer + write_pos) += fft_in[in->nb_samples + j].re / (float)n_fft;
+            /* apply gain to LFE signal and add to output buffer */
+            dst[2 * j] += src[s->lfe_channel + j * in_channels] * s->gain_lfe;
         }
     }
 
     /* go through all samples of current output buffer: count clippings */
-    for (i = 0; i < out->nb_samples; i++) {
+    for (j = 0; j < out->nb_samples; j++) {
         /* clippings counter */
-        if (fabs(*dst) > 1) { /* if current output sample > 1 */
+        if (fabs(dst[2 * j]) > 1) { /* if current output sample > 1 */
             *n_clippings = *n_clippings + 1;
         }
-
-        /* move output buffer pointer by +2 to get to next sample of processed channel: */
-        dst += 2;
     }
 
-    /* remember read/write position in ringbuffer for next call */
-    *write = wr;
-
     return 0;
 }
 
@@ -811,7 +732,6 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     td.in = in; td.out = out; td.write = s->write;
     td.delay = s->delay; td.ir = s->data_ir; td.n_clippings = n_clippings;
     td.ringbuffer = s->ringbuffer; td.temp_src = s->temp_src;
-    td.temp_fft = s->temp_fft;
 
     if (s->type == TIME_DOMAIN) {
         ctx->internal->execute(ctx, sofalizer_convolute, &td, NULL, 2);
@@ -873,20 +793,17 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius)
     struct SOFAlizerContext *s = ctx->priv;
     const int n_samples = s->sofa.n_samples;
     int n_conv = s->n_conv; /* no. channels to convolve */
-    int n_fft = s->n_fft;
     int delay_l[16]; /* broadband delay for each IR */
     int delay_r[16];
     int nb_input_channels = ctx->inputs[0]->channels; /* no. input channels */
     float gain_lin = expf((s->gain - 3 * nb_input_channels) / 20 * M_LN10); /* gain - 3dB/channel */
-    FFTComplex *data_hrtf_l = NULL;
-    FFTComplex *data_hrtf_r = NULL;
-    FFTComplex *fft_in_l = NULL;
-    FFTComplex *fft_in_r = NULL;
+    float *ir_l = NULL;
+    float *ir_r = NULL;
     float *data_ir_l = NULL;
     float *data_ir_r = NULL;
     int offset = 0; /* used for faster pointer arithmetics in for-loop */
     int m[16]; /* measurement index m of IR closest to required source positions */
-    int i, j, azim_orig = azim, elev_orig = elev;
+    int i, j, k = 0, azim_orig = azim, elev_orig = elev;
 
     if (!s->sofa.ncid) { /* if an invalid SOFA file has been selected */
         av_log(ctx, AV_LOG_ERROR, "Selected SOFA file is invalid. Please select valid SOFA file.\n");
@@ -906,12 +823,12 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius)
             return AVERROR(ENOMEM);
         }
     } else {
-        /* get temporary HRTF memory for L and R channel */
-        data_hrtf_l = av_malloc_array(n_fft, sizeof(*data_hrtf_l) * n_conv);
-        data_hrtf_r = av_malloc_array(n_fft, sizeof(*data_hrtf_r) * n_conv);
-        if (!data_hrtf_r || !data_hrtf_l) {
-            av_free(data_hrtf_l);
-            av_free(data_hrtf_r);
+        /* get temporary IR memory for L and R channel */
+        ir_l = av_malloc_array(s->ir_len, sizeof(*ir_l));
+        ir_r = av_malloc_array(s->ir_len, sizeof(*ir_r));
+        if (!ir_l || !ir_r) {
+            av_free(ir_l);
+            av_free(ir_r);
             return AVERROR(ENOMEM);
         }
     }
@@ -937,36 +854,23 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius)
                 *(data_ir_r + offset + j) = /* right channel */
                 *(s->sofa.data_ir + 2 * m[i] * n_samples + n_samples - 1 - j  + n_samples) * gain_lin;
             }
-        } else {
-            fft_in_l = av_calloc(n_fft, sizeof(*fft_in_l));
-            fft_in_r = av_calloc(n_fft, sizeof(*fft_in_r));
-            if (!fft_in_l || !fft_in_r) {
-                av_free(data_hrtf_l);
-                av_free(data_hrtf_r);
-                av_free(fft_in_l);
-                av_free(fft_in_r);
-                return AVERROR(ENOMEM);
-            }
-
-            offset = i * n_fft; /* no. samples already written */
+        } else if (i != s->lfe_channel) {
+            memset(ir_l, 0, s->ir_len * sizeof(*ir_l));
+            memset(ir_r, 0, s->ir_len * sizeof(*ir_r));
             for (j = 0; j < n_samples; j++) {
                 /* load non-reversed IRs of the specified source position
                  * sample-by-sample and apply gain,
-                 * L channel is loaded to real part, R channel to imag part,
-                 * IRs ared shifted by L and R delay */
-                fft_in_l[delay_l[i] + j].re = /* left channel */
+                 * IRs are shifted by L and R delay */
+                ir_l[delay_l[i] + j] = /* left channel */
                 *(s->sofa.data_ir + 2 * m[i] * n_samples + j) * gain_lin;
-                fft_in_r[delay_r[i] + j].re = /* right channel */
+                ir_r[delay_r[i] + j] = /* right channel */
                 *(s->sofa.data_ir + (2 * m[i] + 1) * n_samples + j) * gain_lin;
             }
 
             /* actually transform to frequency domain (IRs -> HRTFs) */
-            av_fft_permute(s->fft[0], fft_in_l);
-            av_fft_calc(s->fft[0], fft_in_l);
-            memcpy(data_hrtf_l + offset, fft_in_l, n_fft * sizeof(*fft_in_l));
-            av_fft_permute(s->fft[0], fft_in_r);
-            av_fft_calc(s->fft[0], fft_in_r);
-            memcpy(data_hrtf_r + offset, fft_in_r, n_fft * sizeof(*fft_in_r));
+            ff_partconv_set_ir(&s->conv[0], k, ir_l, s->ir_len);
+            ff_partconv_set_ir(&s->conv[1], k, ir_r, s->ir_len);
+            k++;
         }
 
         av_log(ctx, AV_LOG_DEBUG, "Index: %d, Azimuth: %f, Elevation: %f, Radius: %f of SOFA file.\n",
@@ -981,26 +885,8 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius)
         av_freep(&data_ir_l); /* free temporary IR memory */
         av_freep(&data_ir_r);
     } else {
-        s->data_hrtf[0] = av_malloc_array(n_fft * s->n_conv, sizeof(FFTComplex));
-        s->data_hrtf[1] = av_malloc_array(n_fft * s->n_conv, sizeof(FFTComplex));
-        if (!s->data_hrtf[0] || !s->data_hrtf[1]) {
-            av_freep(&data_hrtf_l);
-            av_freep(&data_hrtf_r);
-            av_freep(&fft_in_l);
-            av_freep(&fft_in_r);
-            return AVERROR(ENOMEM); /* memory allocation failed */
-        }
-
-        memcpy(s->data_hrtf[0], data_hrtf_l, /* copy HRTF data to */
-            sizeof(FFTComplex) * n_conv * n_fft); /* filter struct */
-        memcpy(s->data_hrtf[1], data_hrtf_r,
-            sizeof(FFTComplex) * n_conv * n_fft);
-
-        av_freep(&data_hrtf_l); /* free temporary HRTF memory */
-        av_freep(&data_hrtf_r);
-
-        av_freep(&fft_in_l); /* free temporary FFT memory */
-        av_freep(&fft_in_r);
+        av_freep(&ir_l); /* free temporary IR memory */
+        av_freep(&ir_r);
     }
 
     memcpy(s->delay[0], &delay_l[0], sizeof(int) * s->n_conv);
@@ -1052,13 +938,7 @@ static int config_input(AVFilterLink *inlink)
     int n_max_ir = 0;
     int n_current;
     int n_max = 0;
-    int ret;
-
-    if (s->type == FREQUENCY_DOMAIN) {
-        inlink->partial_buf_size =
-        inlink->min_samples =
-        inlink->max_samples = inlink->sample_rate;
-    }
+    int i, ret;
 
     /* gain -3 dB per channel, -6 dB to get LFE on a similar level */
     s->gain_lfe = expf((s->gain - 3 * inlink->channels - 6) / 20 * M_LN10);
@@ -1077,23 +957,7 @@ static int config_input(AVFilterLink *inlink)
     /* buffer length is longest IR plus max. delay -> next power of 2
        (32 - count leading zeros gives required exponent)  */
     s->buffer_length = 1 << (32 - ff_clz(n_max));
-    s->n_fft         = 1 << (32 - ff_clz(n_max + inlink->sample_rate));
-
-    if (s->type == FREQUENCY_DOMAIN) {
-        av_fft_end(s->fft[0]);
-        av_fft_end(s->fft[1]);
-        s->fft[0] = av_fft_init(log2(s->n_fft), 0);
-        s->fft[1] = av_fft_init(log2(s->n_fft), 0);
-        av_fft_end(s->ifft[0]);
-        av_fft_end(s->ifft[1]);
-        s->ifft[0] = av_fft_init(log2(s->n_fft), 1);
-        s->ifft[1] = av_fft_init(log2(s->n_fft), 1);
-
-        if (!s->fft[0] || !s->fft[1] || !s->ifft[0] || !s->ifft[1]) {
-            av_log(ctx, AV_LOG_ERROR, "Unable to create FFT contexts of size %d.\n", s->n_fft);
-            return AVERROR(ENOMEM);
-        }
-    }
+    s->ir_len        = n_max;
 
     /* Allocate memory for the impulse responses, delays and the ringbuffers */
     /* size: (longest IR) * (number of channels to convolute) */
@@ -1103,18 +967,12 @@ static int config_input(AVFilterLink *inlink)
     s->delay[0] = av_malloc_array(s->n_conv, sizeof(float));
     s->delay[1] = av_malloc_array(s->n_conv, sizeof(float));
     /* length: (buffer length) * (number of input channels),
-     * OR: buffer length (if frequency domain processing)
      * calloc zero-initializes the buffer */
 
     if (s->type == TIME_DOMAIN) {
         s->ringbuffer[0] = av_calloc(s->buffer_length, sizeof(float) * nb_input_channels);
         s->ringbuffer[1] = av_calloc(s->buffer_length, sizeof(float) * nb_input_channels);
-    } else {
-        s->ringbuffer[0] = av_calloc(s->buffer_length, sizeof(float));
-        s->ringbuffer[1] = av_calloc(s->buffer_length, sizeof(float));
-        s->temp_fft[0] = av_malloc_array(s->n_fft, sizeof(FFTComplex));
-        s->temp_fft[1] = av_malloc_array(s->n_fft, sizeof(FFTComplex));
-        if (!s->temp_fft[0] || !s->temp_fft[1])
+        if (!s->ringbuffer[0] || !s->ringbuffer[1])
             return AVERROR(ENOMEM);
     }
 
@@ -1124,8 +982,7 @@ static int config_input(AVFilterLink *inlink)
 
     /* memory allocation failed: */
     if (!s->data_ir[0] || !s->data_ir[1] || !s->delay[1] ||
-        !s->delay[0] || !s->ringbuffer[0] || !s->ringbuffer[1] ||
-        !s->speaker_azim || !s->speaker_elev)
+        !s->delay[0] || !s->speaker_azim || !s->speaker_elev)
         return AVERROR(ENOMEM);
 
     compensate_volume(ctx);
@@ -1136,6 +993,17 @@ static int config_input(AVFilterLink *inlink)
         return ret;
     }
 
+    if (s->type == FREQUENCY_DOMAIN) {
+        /* the LFE is not convolved */
+        int n_inputs = s->n_conv - (s->lfe_channel >= 0);
+        int part_size = ff_partconv_part_size(s->ir_len);
+
+        for (i = 0; i < 2; i++) {
+            if ((ret = ff_partconv_init(&s->conv[i], part_size, s->ir_len, n_inputs)) < 0)
+                return ret;
+        }
+    }
+
     /* load IRs to data_ir[0] and data_ir[1] for required directions */
     if ((ret = load_data(ctx, s->rotation, s->elevation, s->radius)) < 0)
         return ret;
@@ -1157,10 +1025,8 @@ static av_cold void uninit(AVFilterContext *ctx)
         av_freep(&s->sofa.data_delay);
         av_freep(&s->sofa.data_ir);
     }
-    av_fft_end(s->ifft[0]);
-    av_fft_end(s->ifft[1]);
-    av_fft_end(s->fft[0]);
-    av_fft_end(s->fft[1]);
+    ff_partconv_uninit(&s->conv[0]);
+    ff_partconv_uninit(&s->conv[1]);
     av_freep(&s->delay[0]);
     av_freep(&s->delay[1]);
     av_freep(&s->data_ir[0]);
@@ -1171,10 +1037,6 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->speaker_elev);
     av_freep(&s->temp_src[0]);
     av_freep(&s->temp_src[1]);
-    av_freep(&s->temp_fft[0]);
-    av_freep(&s->temp_fft[1]);
-    av_freep(&s->data_hrtf[0]);
-    av_freep(&s->data_hrtf[1]);
     av_freep(&s->fdsp);
 }
 
@@ -88,6 +88,10 @@ typedef struct VolumeContext {
     int samples_align;
 } VolumeContext;
 
+/**
+ * Set scale_samples and samples_align for the sample_fmt and volume_i of vol.
+ */
+void ff_volume_init(VolumeContext *vol);
 void ff_volume_init_x86(VolumeContext *vol);
 
 #endif /* AVFILTER_VOLUME_H */
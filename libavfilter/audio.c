@@ -74,3 +74,45 @@ AVFrame *ff_get_audio_buffer(AVFilterLink *link, int nb_samples)
 
     return ret;
 }
+
+#define MAX_CHANNEL_JOBS 64
+
+typedef struct ChannelJobs {
+    ff_channel_func *func;
+    void *arg;
+    int nb_channels;
+} ChannelJobs;
+
+int ff_filter_channel_jobs(AVFilterContext *ctx, int nb_channels)
+{
+    if (!(ctx->thread_type & AVFILTER_THREAD_SLICE))
+        return 1;
+    return av_clip(FFMIN(nb_channels, ctx->graph->nb_threads), 1, MAX_CHANNEL_JOBS);
+}
+
+static int channel_job(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ChannelJobs *jobs = arg;
+    const int start = (jobs->nb_channels *  jobnr     ) / nb_jobs;
+    const int end   = (jobs->nb_channels * (jobnr + 1)) / nb_jobs;
+
+    return jobs->func(ctx, jobs->arg, jobnr, start, end);
+}
+
+int ff_filter_execute_channels(AVFilterContext *ctx, ff_channel_func *func,
+                               void *arg, int nb_channels)
+{
+    ChannelJobs jobs = { func, arg, nb_channels };
+    int nb_jobs = ff_filter_channel_jobs(ctx, nb_channels);
+    int ret[MAX_CHANNEL_JOBS];
+    int i;
+
+    if (nb_jobs == 1)
+        return func(ctx, arg, 0, 0, nb_channels);
+
+    ctx->internal->execute(ctx, channel_job, &jobs, ret, nb_jobs);
+    for (i = 0; i < nb_jobs; i++)
+        if (ret[i] < 0)
+            return ret[i];
+    return 0;
+}
@@ -60,4 +60,31 @@ AVFrame *ff_null_get_audio_buffer(AVFilterLink *link, int nb_samples);
  */
 AVFrame *ff_get_audio_buffer(AVFilterLink *link, int nb_samples);
 
+/**
+ * Process a range of channels of an audio filter.
+ *
+ * @param jobnr    index of the job, smaller than the value returned by
+ *                 ff_filter_channel_jobs()
+ * @param ch_start first channel to process
+ * @param ch_end   one past the last channel to process
+ */
+typedef int (ff_channel_func)(AVFilterContext *ctx, void *arg, int jobnr,
+                              int ch_start, int ch_end);
+
+/**
+ * Get the number of jobs ff_filter_execute_channels() splits nb_channels
+ * channels into, for filters which need some state per job.
+ */
+int ff_filter_channel_jobs(AVFilterContext *ctx, int nb_channels);
+
+/**
+ * Run func over nb_channels channels, split into contiguous ranges which
+ * are processed in parallel if the filter has AVFILTER_FLAG_SLICE_THREADS
+ * set and slice threading is enabled in the graph.
+ *
+ * @return the first negative value returned by func, 0 otherwise
+ */
+int ff_filter_execute_channels(AVFilterContext *ctx, ff_channel_func *func,
+                               void *arg, int nb_channels);
+
 #endif /* AVFILTER_AUDIO_H */
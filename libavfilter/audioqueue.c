@@ -0,0 +1,200 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/avassert.h"
+#include "libavutil/common.h"
+#include "audio.h"
+#include "audioqueue.h"
+
+/* alignment of the buffers allocated by lavfi, which filters may rely on */
+#define VIEW_ALIGN 32
+
+#define FRAME_SIZE sizeof(AVFrame *)
+
+int ff_audio_queue_init(FFAudioQueue *q, enum AVSampleFormat format, int nb_channels)
+{
+    q->frames = av_fifo_alloc_array(8, FRAME_SIZE);
+    if (!q->frames)
+        return AVERROR(ENOMEM);
+
+    q->nb_samples  = 0;
+    q->skip        = 0;
+    q->format      = format;
+    q->nb_channels = nb_channels;
+    q->sample_size = av_get_bytes_per_sample(format);
+    if (!av_sample_fmt_is_planar(format))
+        q->sample_size *= nb_channels;
+
+    return 0;
+}
+
+void ff_audio_queue_uninit(FFAudioQueue *q)
+{
+    AVFrame *frame;
+
+    if (!q->frames)
+        return;
+    while (av_fifo_size(q->frames) >= FRAME_SIZE) {
+        av_fifo_generic_read(q->frames, &frame, FRAME_SIZE, NULL);
+        av_frame_free(&frame);
+    }
+    av_fifo_freep(&q->frames);
+    q->nb_samples = 0;
+}
+
+int ff_audio_queue_add(FFAudioQueue *q, AVFrame *frame)
+{
+    int ret;
+
+    av_assert1(frame->format == q->format);
+
+    if (!frame->nb_samples) {
+        av_frame_free(&frame);
+        return 0;
+    }
+
+    if (av_fifo_space(q->frames) < FRAME_SIZE &&
+        (ret = av_fifo_grow(q->frames, av_fifo_size(q->frames))) < 0) {
+        av_frame_free(&frame);
+        return ret;
+    }
+
+    av_fifo_generic_write(q->frames, &frame, FRAME_SIZE, NULL);
+    q->nb_samples += frame->nb_samples;
+
+    return 0;
+}
+
+static AVFrame *peek_first(FFAudioQueue *q)
+{
+    return *(AVFrame **)av_fifo_peek2(q->frames, 0);
+}
+
+static AVFrame *remove_first(FFAudioQueue *q)
+{
+    AVFrame *frame;
+
+    av_fifo_generic_read(q->frames, &frame, FRAME_SIZE, NULL);
+    q->nb_samples -= frame->nb_samples - q->skip;
+    q->skip = 0;
+
+    return frame;
+}
+
+void ff_audio_queue_drain(FFAudioQueue *q, int64_t nb_samples)
+{
+    nb_samples = FFMIN(nb_samples, q->nb_samples);
+
+    while (nb_samples > 0) {
+        AVFrame *frame = peek_first(q);
+        int left = frame->nb_samples - q->skip;
+
+        if (nb_samples >= left) {
+            frame = remove_first(q);
+            av_frame_free(&frame);
+            nb_samples -= left;
+        } else {
+            q->skip       += nb_samples;
+            q->nb_samples -= nb_samples;
+            break;
+        }
+    }
+}
+
+int ff_audio_queue_read(FFAudioQueue *q, uint8_t **dst, int nb_samples)
+{
+    int done = 0;
+
+    nb_samples = FFMIN(nb_samples, q->nb_samples);
+
+    while (done < nb_samples) {
+        AVFrame *frame = peek_first(q);
+        int n = FFMIN(nb_samples - done, frame->nb_samples - q->skip);
+
+        av_samples_copy(dst, frame->extended_data, done, q->skip, n,
+                        q->nb_channels, q->format);
+        ff_audio_queue_drain(q, n);
+        done += n;
+    }
+
+    return nb_samples;
+}
+
+static int view_is_aligned(FFAudioQueue *q, const AVFrame *frame, int offset)
+{
+    const int planes = av_sample_fmt_is_planar(q->format) ? q->nb_channels : 1;
+    int p;
+
+    for (p = 0; p < planes; p++)
+        if ((uintptr_t)(frame->extended_data[p] + offset) & (VIEW_ALIGN - 1))
+            return 0;
+    return 1;
+}
+
+/* make frame a view of nb_samples samples, starting offset bytes into it */
+static void set_view(FFAudioQueue *q, AVFrame *frame, int offset, int nb_samples)
+{
+    const int planes = av_sample_fmt_is_planar(q->format) ? q->nb_channels : 1;
+    int p;
+
+    for (p = 0; p < planes; p++)
+        frame->extended_data[p] += offset;
+    for (p = 0; p < FFMIN(planes, AV_NUM_DATA_POINTERS); p++)
+        frame->data[p] = frame->extended_data[p];
+    frame->linesize[0] -= offset;
+    frame->nb_samples   = nb_samples;
+}
+
+int ff_audio_queue_get(FFAudioQueue *q, AVFilterLink *link, AVFrame **frame,
+                       int nb_samples)
+{
+    AVFrame *first, *out;
+
+    av_assert0(nb_samples > 0 && nb_samples <= q->nb_samples);
+
+    first = peek_first(q);
+    if (!q->skip && first->nb_samples == nb_samples) {
+        *frame = remove_first(q);
+        return 0;
+    }
+
+    if (first->nb_samples - q->skip >= nb_samples) {
+        const int offset = q->skip * q->sample_size;
+
+        if (view_is_aligned(q, first, offset)) {
+            if (first->nb_samples - q->skip == nb_samples) {
+                out = remove_first(q);
+            } else {
+                if (!(out = av_frame_clone(first)))
+                    return AVERROR(ENOMEM);
+                q->skip       += nb_samples;
+                q->nb_samples -= nb_samples;
+            }
+            set_view(q, out, offset, nb_samples);
+            *frame = out;
+            return 0;
+        }
+    }
+
+    if (!(out = ff_get_audio_buffer(link, nb_samples)))
+        return AVERROR(ENOMEM);
+    ff_audio_queue_read(q, out->extended_data, nb_samples);
+    *frame = out;
+
+    return 0;
+}
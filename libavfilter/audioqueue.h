@@ -0,0 +1,106 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Audio queue holding frame references
+ *
+ * Unlike AVAudioFifo, the queue keeps the frames it is given instead of
+ * copying their samples. Frames are taken out of it as references: a part
+ * of a single queued frame is returned as a view of that frame whose data
+ * pointers are moved past the consumed samples, as long as they stay
+ * aligned. Samples are only copied when the requested span crosses the end
+ * of a frame or would be misaligned.
+ *
+ * The frames returned may share their buffers with the queue and are then
+ * not writable.
+ */
+
+#ifndef AVFILTER_AUDIOQUEUE_H
+#define AVFILTER_AUDIOQUEUE_H
+
+#include <stdint.h>
+
+#include "libavutil/fifo.h"
+#include "libavutil/frame.h"
+#include "libavutil/samplefmt.h"
+#include "avfilter.h"
+
+typedef struct FFAudioQueue {
+    AVFifoBuffer *frames;           ///< queued frame references
+    int64_t nb_samples;             ///< number of queued samples
+    int skip;                       ///< samples of the first frame already consumed
+    enum AVSampleFormat format;
+    int nb_channels;
+    int sample_size;                ///< bytes per sample in each plane
+} FFAudioQueue;
+
+/**
+ * Set up a queue for frames of the given format and channel count.
+ *
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int ff_audio_queue_init(FFAudioQueue *q, enum AVSampleFormat format, int nb_channels);
+
+/**
+ * Free all queued frames and the queue itself.
+ */
+void ff_audio_queue_uninit(FFAudioQueue *q);
+
+/**
+ * Return the number of queued samples.
+ */
+static inline int64_t ff_audio_queue_size(const FFAudioQueue *q)
+{
+    return q->nb_samples;
+}
+
+/**
+ * Queue a frame. The queue takes ownership of the frame, even on failure.
+ *
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int ff_audio_queue_add(FFAudioQueue *q, AVFrame *frame);
+
+/**
+ * Take the next nb_samples samples out of the queue.
+ *
+ * The frame returned is a queued frame or a view of one when the samples
+ * lie in a single frame, otherwise a buffer is allocated on link and the
+ * samples are copied into it. Only the data and the number of samples of
+ * the frame are meaningful; the caller is expected to set its timestamp.
+ *
+ * @param nb_samples number of samples, at least 1 and at most the queue size
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int ff_audio_queue_get(FFAudioQueue *q, AVFilterLink *link, AVFrame **frame,
+                       int nb_samples);
+
+/**
+ * Copy up to nb_samples samples out of the queue into dst and remove them.
+ *
+ * @return the number of samples copied
+ */
+int ff_audio_queue_read(FFAudioQueue *q, uint8_t **dst, int nb_samples);
+
+/**
+ * Remove up to nb_samples samples from the queue.
+ */
+void ff_audio_queue_drain(FFAudioQueue *q, int64_t nb_samples);
+
+#endif /* AVFILTER_AUDIOQUEUE_H */
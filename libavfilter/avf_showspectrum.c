@@ -33,6 +33,7 @@
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
+#include "libavutil/intfloat.h"
 #include "libavutil/opt.h"
 #include "libavutil/xga_font_data.h"
 #include "audio.h"
@@ -48,6 +49,22 @@ enum ColorMode    { CHANNEL, INTENSITY, RAINBOW, MORELAND, NEBULAE, FIRE, FIERY,
 enum SlideMode    { REPLACE, SCROLL, FULLFRAME, RSCROLL, NB_SLIDES };
 enum Orientation  { VERTICAL, HORIZONTAL, NB_ORIENTATIONS };
 
+/* number of color levels a scaled value is quantized to */
+#define COLOR_LUT_SIZE 1024
+
+/* the scales which need transcendental functions are looked up by the
+ * exponent and the SCALE_LUT_BITS top bits of the mantissa of the value */
+#define SCALE_LUT_BITS  8
+#define SCALE_LUT_SHIFT (23 - SCALE_LUT_BITS)
+
+typedef struct ShowSpectrumJob {
+    FFTContext *fft;            ///< Fast Fourier Transform context
+    FFTComplex *fft_data;       ///< bins holder
+    float *magnitudes;          ///< magnitudes or phases of each (displayed) channel
+    float *combine_buffer;      ///< color combining buffer (3 * h items), for showspectrumpic
+    AVFrame *fin;               ///< input samples, for showspectrumpic
+} ShowSpectrumJob;
+
 typedef struct {
     const AVClass *class;
     int w, h;
@@ -63,12 +80,15 @@ typedef struct {
     float saturation;           ///< color saturation multiplier
     int data;
     int xpos;                   ///< x position (current column)
-    FFTContext *fft;            ///< Fast Fourier Transform context
     int fft_bits;               ///< number of bits (FFT window size = 1<<fft_bits)
-    FFTComplex **fft_data;      ///< bins holder for each (displayed) channels
+    ShowSpectrumJob *jobs;      ///< FFT contexts and buffers of each thread job
+    int nb_jobs;
+    float **color_buffer;       ///< color of each (displayed) channel (3 * h items)
     float *window_func_lut;     ///< Window function LUT
-    float **magnitudes;
-    float **phases;
+    float color_lut[COLOR_LUT_SIZE][3]; ///< color of each level
+    uint16_t *scale_lut;        ///< color level of each value, for the scales without a fast path
+    int scale_lut_start;        ///< bits of the lowest value in scale_lut
+    int scale_lut_size;
     int win_func;
     int win_size;
     double win_scale;
@@ -217,31 +237,38 @@ static const struct ColorTable {
     {    1,                  1,                -.5,                  .5 }},
 };
 
-static av_cold void uninit(AVFilterContext *ctx)
+static void free_jobs(ShowSpectrumContext *s)
 {
-    ShowSpectrumContext *s = ctx->priv;
     int i;
 
-    av_freep(&s->combine_buffer);
-    av_fft_end(s->fft);
-    if (s->fft_data) {
-        for (i = 0; i < s->nb_display_channels; i++)
-            av_freep(&s->fft_data[i]);
+    if (s->jobs) {
+        for (i = 0; i < s->nb_jobs; i++) {
+            av_fft_end(s->jobs[i].fft);
+            av_freep(&s->jobs[i].fft_data);
+            av_freep(&s->jobs[i].magnitudes);
+            av_freep(&s->jobs[i].combine_buffer);
+            av_frame_free(&s->jobs[i].fin);
+        }
     }
-    av_freep(&s->fft_data);
-    av_freep(&s->window_func_lut);
-    if (s->magnitudes) {
+    av_freep(&s->jobs);
+    s->nb_jobs = 0;
+    if (s->color_buffer) {
         for (i = 0; i < s->nb_display_channels; i++)
-            av_freep(&s->magnitudes[i]);
+            av_freep(&s->color_buffer[i]);
     }
-    av_freep(&s->magnitudes);
+    av_freep(&s->color_buffer);
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    ShowSpectrumContext *s = ctx->priv;
+
+    free_jobs(s);
+    av_freep(&s->combine_buffer);
+    av_freep(&s->window_func_lut);
+    av_freep(&s->scale_lut);
     av_frame_free(&s->outpicref);
     av_audio_fifo_free(s->fifo);
-    if (s->phases) {
-        for (i = 0; i < s->nb_display_channels; i++)
-            av_freep(&s->phases[i]);
-    }
-    av_freep(&s->phases);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -275,12 +302,136 @@ static int query_formats(AVFilterContext *ctx)
     return 0;
 }
 
+static void pick_color(ShowSpectrumContext *s,
+                       float yf, float uf, float vf,
+                       float a, float *out)
+{
+    if (s->color_mode > CHANNEL) {
+        const int cm = s->color_mode;
+        float y, u, v;
+        int i;
+
+        for (i = 1; i < FF_ARRAY_ELEMS(color_table[cm]) - 1; i++)
+            if (color_table[cm][i].a >= a)
+                break;
+        // i now is the first item >= the color
+        // now we know to interpolate between item i - 1 and i
+        if (a <= color_table[cm][i - 1].a) {
+            y = color_table[cm][i - 1].y;
+            u = color_table[cm][i - 1].u;
+            v = color_table[cm][i - 1].v;
+        } else if (a >= color_table[cm][i].a) {
+            y = color_table[cm][i].y;
+            u = color_table[cm][i].u;
+            v = color_table[cm][i].v;
+        } else {
+            float start = color_table[cm][i - 1].a;
+            float end = color_table[cm][i].a;
+            float lerpfrac = (a - start) / (end - start);
+            y = color_table[cm][i - 1].y * (1.0f - lerpfrac)
+              + color_table[cm][i].y * lerpfrac;
+            u = color_table[cm][i - 1].u * (1.0f - lerpfrac)
+              + color_table[cm][i].u * lerpfrac;
+            v = color_table[cm][i - 1].v * (1.0f - lerpfrac)
+              + color_table[cm][i].v * lerpfrac;
+        }
+
+        out[0] += y * yf;
+        out[1] += u * uf;
+        out[2] += v * vf;
+    } else {
+        out[0] += a * yf;
+        out[1] += a * uf;
+        out[2] += a * vf;
+    }
+}
+
+static double scale_value(const ShowSpectrumContext *s, double a)
+{
+    switch (s->scale) {
+    case CBRT:
+        a = av_clipd(cbrt(a), 0, 1);
+        break;
+    case FIFTHRT:
+        a = av_clipd(pow(a, 0.20), 0, 1);
+        break;
+    case LOG:
+        a = 1 + log10(av_clipd(a, 1e-6, 1)) / 6; // zero = -120dBFS
+        break;
+    default:
+        av_assert0(0);
+    }
+    return a;
+}
+
+static int scale_level(const ShowSpectrumContext *s, double a)
+{
+    return lrint(scale_value(s, a) * (COLOR_LUT_SIZE - 1));
+}
+
+static int init_luts(ShowSpectrumContext *s)
+{
+    int i, octaves;
+
+    for (i = 0; i < COLOR_LUT_SIZE; i++) {
+        memset(s->color_lut[i], 0, sizeof(s->color_lut[i]));
+        pick_color(s, 1, 1, 1, i / (float)(COLOR_LUT_SIZE - 1), s->color_lut[i]);
+    }
+
+    av_freep(&s->scale_lut);
+    if (s->scale != CBRT && s->scale != FIFTHRT && s->scale != LOG)
+        return 0;
+
+    /* the values below 2^-octaves all map to the lowest level */
+    for (octaves = 1; octaves < 126; octaves++)
+        if (!scale_level(s, ldexp(1, -octaves)))
+            break;
+    s->scale_lut_start = av_float2int(ldexp(1, -octaves));
+    s->scale_lut_size  = (av_float2int(1.0f) - s->scale_lut_start) >> SCALE_LUT_SHIFT;
+    s->scale_lut = av_malloc_array(s->scale_lut_size, sizeof(*s->scale_lut));
+    if (!s->scale_lut)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < s->scale_lut_size; i++) {
+        int bits = s->scale_lut_start + (i << SCALE_LUT_SHIFT) + (1 << (SCALE_LUT_SHIFT - 1));
+        s->scale_lut[i] = scale_level(s, av_int2float(bits));
+    }
+
+    return 0;
+}
+
+/* map a magnitude or phase to a color level with the display scale */
+static int color_level(const ShowSpectrumContext *s, float a)
+{
+    int bits;
+
+    switch (s->scale) {
+    case LINEAR:
+        a = av_clipf(a, 0, 1);
+        break;
+    case SQRT:
+        a = av_clipf(sqrtf(a), 0, 1);
+        break;
+    case FOURTHRT:
+        a = av_clipf(sqrtf(sqrtf(a)), 0, 1);
+        break;
+    default:
+        /* negative values have the sign bit set and are below the start */
+        bits = av_float2int(a);
+        if (bits < s->scale_lut_start)
+            return 0;
+        if (bits >= av_float2int(1.0f))
+            return COLOR_LUT_SIZE - 1;
+        return s->scale_lut[(bits - s->scale_lut_start) >> SCALE_LUT_SHIFT];
+    }
+    return lrintf(a * (COLOR_LUT_SIZE - 1));
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
     AVFilterLink *inlink = ctx->inputs[0];
     ShowSpectrumContext *s = ctx->priv;
-    int i, fft_bits, h, w;
+    int i, ret, fft_bits, h, w, h_max;
     float overlap;
 
     if (!strcmp(ctx->filter->name, "showspectrumpic"))
@@ -300,6 +451,7 @@ static int config_output(AVFilterLink *outlink)
     w = (s->mode == COMBINED || s->orientation == VERTICAL)   ? s->w : s->w / inlink->channels;
     s->channel_height = h;
     s->channel_width  = w;
+    h_max = s->orientation == VERTICAL ? s->h : s->w;
 
     if (s->orientation == VERTICAL) {
         /* FFT window size (precision) according to the requested output frame height */
@@ -314,47 +466,48 @@ static int config_output(AVFilterLink *outlink)
     if (fft_bits != s->fft_bits) {
         AVFrame *outpicref;
 
-        av_fft_end(s->fft);
-        s->fft = av_fft_init(fft_bits, 0);
-        if (!s->fft) {
-            av_log(ctx, AV_LOG_ERROR, "Unable to create FFT context. "
-                   "The window size might be too high.\n");
-            return AVERROR(EINVAL);
-        }
+        free_jobs(s);
         s->fft_bits = fft_bits;
-
-        /* FFT buffers: x2 for each (display) channel buffer.
-         * Note: we use free and malloc instead of a realloc-like function to
-         * make sure the buffer is aligned in memory for the FFT functions. */
-        for (i = 0; i < s->nb_display_channels; i++)
-            av_freep(&s->fft_data[i]);
-        av_freep(&s->fft_data);
         s->nb_display_channels = inlink->channels;
 
-        s->magnitudes = av_calloc(s->nb_display_channels, sizeof(*s->magnitudes));
-        if (!s->magnitudes)
-            return AVERROR(ENOMEM);
-        for (i = 0; i < s->nb_display_channels; i++) {
-            s->magnitudes[i] = av_calloc(s->orientation == VERTICAL ? s->h : s->w, sizeof(**s->magnitudes));
-            if (!s->magnitudes[i])
-                return AVERROR(ENOMEM);
-        }
+        /* the columns of showspectrumpic are computed in parallel, the
+         * channels of showspectrum */
+        if (s->single_pic)
+            s->nb_jobs = ctx->thread_type & AVFILTER_THREAD_SLICE ?
+                         av_clip(ctx->graph->nb_threads, 1, s->orientation == VERTICAL ? s->w : s->h) : 1;
+        else
+            s->nb_jobs = ff_filter_channel_jobs(ctx, s->nb_display_channels);
 
-        s->phases = av_calloc(s->nb_display_channels, sizeof(*s->magnitudes));
-        if (!s->phases)
+        s->jobs = av_calloc(s->nb_jobs, sizeof(*s->jobs));
+        if (!s->jobs)
             return AVERROR(ENOMEM);
-        for (i = 0; i < s->nb_display_channels; i++) {
-            s->phases[i] = av_calloc(s->orientation == VERTICAL ? s->h : s->w, sizeof(**s->phases));
-            if (!s->phases[i])
+        for (i = 0; i < s->nb_jobs; i++) {
+            ShowSpectrumJob *job = &s->jobs[i];
+
+            job->fft = av_fft_init(fft_bits, 0);
+            if (!job->fft) {
+                av_log(ctx, AV_LOG_ERROR, "Unable to create FFT context. "
+                       "The window size might be too high.\n");
+                return AVERROR(EINVAL);
+            }
+            job->fft_data   = av_calloc(s->win_size, sizeof(*job->fft_data));
+            job->magnitudes = av_calloc(s->nb_display_channels * h_max, sizeof(*job->magnitudes));
+            if (!job->fft_data || !job->magnitudes)
                 return AVERROR(ENOMEM);
+            if (s->single_pic) {
+                job->combine_buffer = av_calloc(h_max * 3, sizeof(*job->combine_buffer));
+                job->fin = ff_get_audio_buffer(inlink, s->win_size);
+                if (!job->combine_buffer || !job->fin)
+                    return AVERROR(ENOMEM);
+            }
         }
 
-        s->fft_data = av_calloc(s->nb_display_channels, sizeof(*s->fft_data));
-        if (!s->fft_data)
+        s->color_buffer = av_calloc(s->nb_display_channels, sizeof(*s->color_buffer));
+        if (!s->color_buffer)
             return AVERROR(ENOMEM);
         for (i = 0; i < s->nb_display_channels; i++) {
-            s->fft_data[i] = av_calloc(s->win_size, sizeof(**s->fft_data));
-            if (!s->fft_data[i])
+            s->color_buffer[i] = av_calloc(h_max * 3, sizeof(**s->color_buffer));
+            if (!s->color_buffer[i])
                 return AVERROR(ENOMEM);
         }
 
@@ -413,6 +566,9 @@ static int config_output(AVFilterLink *outlink)
                          sizeof(*s->combine_buffer));
     }
 
+    if ((ret = init_luts(s)) < 0)
+        return ret;
+
     av_log(ctx, AV_LOG_VERBOSE, "s:%dx%d FFT window size:%d\n",
            s->w, s->h, s->win_size);
 
@@ -423,82 +579,63 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
-static void run_fft(ShowSpectrumContext *s, AVFrame *fin)
+static void run_fft(ShowSpectrumContext *s, ShowSpectrumJob *job, const float *p, int nb_samples)
 {
-    int ch, n;
+    int n;
 
     /* fill FFT input with the number of samples available */
-    for (ch = 0; ch < s->nb_display_channels; ch++) {
-        const float *p = (float *)fin->extended_data[ch];
-
-        for (n = 0; n < s->win_size; n++) {
-            s->fft_data[ch][n].re = p[n] * s->window_func_lut[n];
-            s->fft_data[ch][n].im = 0;
-        }
+    for (n = 0; n < nb_samples; n++) {
+        job->fft_data[n].re = p[n] * s->window_func_lut[n];
+        job->fft_data[n].im = 0;
     }
-
-    /* run FFT on each samples set */
-    for (ch = 0; ch < s->nb_display_channels; ch++) {
-        av_fft_permute(s->fft, s->fft_data[ch]);
-        av_fft_calc(s->fft, s->fft_data[ch]);
+    for (; n < s->win_size; n++) {
+        job->fft_data[n].re = 0;
+        job->fft_data[n].im = 0;
     }
+
+    av_fft_permute(job->fft, job->fft_data);
+    av_fft_calc(job->fft, job->fft_data);
 }
 
-#define RE(y, ch) s->fft_data[ch][y].re
-#define IM(y, ch) s->fft_data[ch][y].im
-#define MAGNITUDE(y, ch) hypot(RE(y, ch), IM(y, ch))
-#define PHASE(y, ch) atan2(IM(y, ch), RE(y, ch))
+#define RE(y) job->fft_data[y].re
+#define IM(y) job->fft_data[y].im
+#define MAGNITUDE(y) sqrtf(RE(y) * RE(y) + IM(y) * IM(y))
+#define PHASE(y) atan2(IM(y), RE(y))
 
-static void calc_magnitudes(ShowSpectrumContext *s)
+static void calc_magnitudes(ShowSpectrumContext *s, ShowSpectrumJob *job, float *magnitudes)
 {
     const double w = s->win_scale * (s->scale == LOG ? s->win_scale : 1);
-    int ch, y, h = s->orientation == VERTICAL ? s->h : s->w;
+    int y, h = s->orientation == VERTICAL ? s->channel_height : s->channel_width;
     const float f = s->gain * w;
 
-    for (ch = 0; ch < s->nb_display_channels; ch++) {
-        float *magnitudes = s->magnitudes[ch];
-
-        for (y = 0; y < h; y++)
-            magnitudes[y] = MAGNITUDE(y, ch) * f;
-    }
+    for (y = 0; y < h; y++)
+        magnitudes[y] = MAGNITUDE(y) * f;
 }
 
-static void calc_phases(ShowSpectrumContext *s)
+static void calc_phases(ShowSpectrumContext *s, ShowSpectrumJob *job, float *phases)
 {
-    int ch, y, h = s->orientation == VERTICAL ? s->h : s->w;
-
-    for (ch = 0; ch < s->nb_display_channels; ch++) {
-        float *phases = s->phases[ch];
+    int y, h = s->orientation == VERTICAL ? s->channel_height : s->channel_width;
 
-        for (y = 0; y < h; y++)
-            phases[y] = (PHASE(y, ch) / M_PI + 1) / 2;
-    }
+    for (y = 0; y < h; y++)
+        phases[y] = (PHASE(y) / M_PI + 1) / 2;
 }
 
-static void acalc_magnitudes(ShowSpectrumContext *s)
+static void acalc_magnitudes(ShowSpectrumContext *s, ShowSpectrumJob *job, float *magnitudes)
 {
     const double w = s->win_scale * (s->scale == LOG ? s->win_scale : 1);
-    int ch, y, h = s->orientation == VERTICAL ? s->h : s->w;
+    int y, h = s->orientation == VERTICAL ? s->channel_height : s->channel_width;
     const float f = s->gain * w;
 
-    for (ch = 0; ch < s->nb_display_channels; ch++) {
-        float *magnitudes = s->magnitudes[ch];
-
-        for (y = 0; y < h; y++)
-            magnitudes[y] += MAGNITUDE(y, ch) * f;
-    }
+    for (y = 0; y < h; y++)
+        magnitudes[y] += MAGNITUDE(y) * f;
 }
 
-static void scale_magnitudes(ShowSpectrumContext *s, float scale)
+static void scale_magnitudes(ShowSpectrumContext *s, float *magnitudes, float scale)
 {
-    int ch, y, h = s->orientation == VERTICAL ? s->h : s->w;
-
-    for (ch = 0; ch < s->nb_display_channels; ch++) {
-        float *magnitudes = s->magnitudes[ch];
+    int y, h = s->orientation == VERTICAL ? s->channel_height : s->channel_width;
 
-        for (y = 0; y < h; y++)
-            magnitudes[y] *= scale;
-    }
+    for (y = 0; y < h; y++)
+        magnitudes[y] *= scale;
 }
 
 static void color_range(ShowSpectrumContext *s, int ch,
@@ -553,59 +690,95 @@ static void color_range(ShowSpectrumContext *s, int ch,
     *vf *= s->saturation;
 }
 
-static void pick_color(ShowSpectrumContext *s,
-                       float yf, float uf, float vf,
-                       float a, float *out)
+static void clear_combine_buffer(float *combine_buffer, int size)
 {
-    if (s->color_mode > CHANNEL) {
-        const int cm = s->color_mode;
-        float y, u, v;
-        int i;
+    int y;
 
-        for (i = 1; i < FF_ARRAY_ELEMS(color_table[cm]) - 1; i++)
-            if (color_table[cm][i].a >= a)
-                break;
-        // i now is the first item >= the color
-        // now we know to interpolate between item i - 1 and i
-        if (a <= color_table[cm][i - 1].a) {
-            y = color_table[cm][i - 1].y;
-            u = color_table[cm][i - 1].u;
-            v = color_table[cm][i - 1].v;
-        } else if (a >= color_table[cm][i].a) {
-            y = color_table[cm][i].y;
-            u = color_table[cm][i].u;
-            v = color_table[cm][i].v;
-        } else {
-            float start = color_table[cm][i - 1].a;
-            float end = color_table[cm][i].a;
-            float lerpfrac = (a - start) / (end - start);
-            y = color_table[cm][i - 1].y * (1.0f - lerpfrac)
-              + color_table[cm][i].y * lerpfrac;
-            u = color_table[cm][i - 1].u * (1.0f - lerpfrac)
-              + color_table[cm][i].u * lerpfrac;
-            v = color_table[cm][i - 1].v * (1.0f - lerpfrac)
-              + color_table[cm][i].v * lerpfrac;
-        }
+    for (y = 0; y < size; y++) {
+        combine_buffer[3 * y    ] = 0;
+        combine_buffer[3 * y + 1] = 127.5;
+        combine_buffer[3 * y + 2] = 127.5;
+    }
+}
 
-        out[0] += y * yf;
-        out[1] += u * uf;
-        out[2] += v * vf;
+/* add the colors of the magnitudes or phases of a channel to out */
+static void plot_channel(ShowSpectrumContext *s, int ch, const float *values, float *out)
+{
+    int y, h = s->orientation == VERTICAL ? s->channel_height : s->channel_width;
+    float yf, uf, vf;
+
+    /* decide color range */
+    color_range(s, ch, &yf, &uf, &vf);
+
+    for (y = 0; y < h; y++) {
+        const float *color = s->color_lut[color_level(s, values[y])];
+
+        out[3 * y    ] += color[0] * yf;
+        out[3 * y + 1] += color[1] * uf;
+        out[3 * y + 2] += color[2] * vf;
+    }
+}
+
+static float *channel_colors(ShowSpectrumContext *s, int ch, float *combine_buffer)
+{
+    int h = s->orientation == VERTICAL ? s->channel_height : s->channel_width;
+
+    return s->mode == COMBINED ? combine_buffer : combine_buffer + 3 * ch * h;
+}
+
+/* write a combined spectrum column at position xpos of the picture */
+static void draw_column(ShowSpectrumContext *s, AVFrame *outpicref, int outh,
+                        int xpos, const float *combine_buffer)
+{
+    int plane, x, y;
+
+    if (s->orientation == VERTICAL) {
+        for (plane = 0; plane < 3; plane++) {
+            uint8_t *p = outpicref->data[plane] + s->start_x +
+                         (outh - 1 - s->start_y) * outpicref->linesize[plane] +
+                         xpos;
+            for (y = 0; y < s->h; y++) {
+                *p = lrintf(av_clipf(combine_buffer[3 * y + plane], 0, 255));
+                p -= outpicref->linesize[plane];
+            }
+        }
     } else {
-        out[0] += a * yf;
-        out[1] += a * uf;
-        out[2] += a * vf;
+        for (plane = 0; plane < 3; plane++) {
+            uint8_t *p = outpicref->data[plane] + s->start_x +
+                         (xpos + s->start_y) * outpicref->linesize[plane];
+            for (x = 0; x < s->w; x++) {
+                *p = lrintf(av_clipf(combine_buffer[3 * x + plane], 0, 255));
+                p++;
+            }
+        }
     }
 }
 
-static void clear_combine_buffer(ShowSpectrumContext *s, int size)
+#if CONFIG_SHOWSPECTRUM_FILTER
+
+static int plot_channels(AVFilterContext *ctx, void *arg, int jobnr,
+                         int ch_start, int ch_end)
 {
-    int y;
+    ShowSpectrumContext *s = ctx->priv;
+    ShowSpectrumJob *job = &s->jobs[jobnr];
+    AVFrame *fin = arg;
+    int h = s->orientation == VERTICAL ? s->h : s->w;
+    int ch;
 
-    for (y = 0; y < size; y++) {
-        s->combine_buffer[3 * y    ] = 0;
-        s->combine_buffer[3 * y + 1] = 127.5;
-        s->combine_buffer[3 * y + 2] = 127.5;
+    for (ch = ch_start; ch < ch_end; ch++) {
+        float *color_buffer = s->color_buffer[ch];
+
+        run_fft(s, job, (const float *)fin->extended_data[ch], s->win_size);
+        if (s->data == D_MAGNITUDE)
+            calc_magnitudes(s, job, job->magnitudes);
+        if (s->data == D_PHASE)
+            calc_phases(s, job, job->magnitudes);
+
+        memset(color_buffer, 0, 3 * h * sizeof(*color_buffer));
+        plot_channel(s, ch, job->magnitudes, channel_colors(s, ch, color_buffer));
     }
+
+    return 0;
 }
 
 static int plot_spectrum_column(AVFilterLink *inlink, AVFrame *insamples)
@@ -615,67 +788,22 @@ static int plot_spectrum_column(AVFilterLink *inlink, AVFrame *insamples)
     AVFilterLink *outlink = ctx->outputs[0];
     ShowSpectrumContext *s = ctx->priv;
     AVFrame *outpicref = s->outpicref;
-    int h = s->orientation == VERTICAL ? s->channel_height : s->channel_width;
+    int size = s->orientation == VERTICAL ? s->h : s->w;
+
+    int ch, plane, y, i;
 
-    int ch, plane, x, y;
+    /* fill a new spectrum column: the channels are colored in parallel,
+     * then combined in their order */
+    ff_filter_execute_channels(ctx, plot_channels, insamples, s->nb_display_channels);
 
-    /* fill a new spectrum column */
     /* initialize buffer for combining to black */
-    clear_combine_buffer(s, s->orientation == VERTICAL ? s->h : s->w);
+    clear_combine_buffer(s->combine_buffer, size);
 
     for (ch = 0; ch < s->nb_display_channels; ch++) {
-        float *magnitudes = s->magnitudes[ch];
-        float *phases = s->phases[ch];
-        float yf, uf, vf;
-
-        /* decide color range */
-        color_range(s, ch, &yf, &uf, &vf);
-
-        /* draw the channel */
-        for (y = 0; y < h; y++) {
-            int row = (s->mode == COMBINED) ? y : ch * h + y;
-            float *out = &s->combine_buffer[3 * row];
-            float a;
-
-            switch (s->data) {
-            case D_MAGNITUDE:
-                /* get magnitude */
-                a = magnitudes[y];
-                break;
-            case D_PHASE:
-                /* get phase */
-                a = phases[y];
-                break;
-            default:
-                av_assert0(0);
-            }
-
-            /* apply scale */
-            switch (s->scale) {
-            case LINEAR:
-                a = av_clipf(a, 0, 1);
-                break;
-            case SQRT:
-                a = av_clipf(sqrt(a), 0, 1);
-                break;
-            case CBRT:
-                a = av_clipf(cbrt(a), 0, 1);
-                break;
-            case FOURTHRT:
-                a = av_clipf(sqrt(sqrt(a)), 0, 1);
-                break;
-            case FIFTHRT:
-                a = av_clipf(pow(a, 0.20), 0, 1);
-                break;
-            case LOG:
-                a = 1 + log10(av_clipd(a, 1e-6, 1)) / 6; // zero = -120dBFS
-                break;
-            default:
-                av_assert0(0);
-            }
+        const float *color_buffer = s->color_buffer[ch];
 
-            pick_color(s, yf, uf, vf, a, out);
-        }
+        for (i = 0; i < 3 * size; i++)
+            s->combine_buffer[i] += color_buffer[i];
     }
 
     av_frame_make_writable(s->outpicref);
@@ -700,15 +828,6 @@ static int plot_spectrum_column(AVFilterLink *inlink, AVFrame *insamples)
             }
             s->xpos = 0;
         }
-        for (plane = 0; plane < 3; plane++) {
-            uint8_t *p = outpicref->data[plane] + s->start_x +
-                         (outlink->h - 1 - s->start_y) * outpicref->linesize[plane] +
-                         s->xpos;
-            for (y = 0; y < s->h; y++) {
-                *p = lrintf(av_clipf(s->combine_buffer[3 * y + plane], 0, 255));
-                p -= outpicref->linesize[plane];
-            }
-        }
     } else {
         if (s->sliding == SCROLL) {
             for (plane = 0; plane < 3; plane++) {
@@ -729,15 +848,8 @@ static int plot_spectrum_column(AVFilterLink *inlink, AVFrame *insamples)
             }
             s->xpos = 0;
         }
-        for (plane = 0; plane < 3; plane++) {
-            uint8_t *p = outpicref->data[plane] + s->start_x +
-                         (s->xpos + s->start_y) * outpicref->linesize[plane];
-            for (x = 0; x < s->w; x++) {
-                *p = lrintf(av_clipf(s->combine_buffer[3 * x + plane], 0, 255));
-                p++;
-            }
-        }
     }
+    draw_column(s, outpicref, outlink->h, s->xpos, s->combine_buffer);
 
     if (s->sliding != FULLFRAME || s->xpos == 0)
         outpicref->pts = insamples->pts;
@@ -756,8 +868,6 @@ static int plot_spectrum_column(AVFilterLink *inlink, AVFrame *insamples)
     return s->win_size;
 }
 
-#if CONFIG_SHOWSPECTRUM_FILTER
-
 static int request_frame(AVFilterLink *outlink)
 {
     ShowSpectrumContext *s = outlink->src->priv;
@@ -815,12 +925,6 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
 
         av_assert0(fin->nb_samples == s->win_size);
 
-        run_fft(s, fin);
-        if (s->data == D_MAGNITUDE)
-            calc_magnitudes(s);
-        if (s->data == D_PHASE)
-            calc_phases(s);
-
         ret = plot_spectrum_column(inlink, fin);
         av_frame_free(&fin);
         av_audio_fifo_drain(s->fifo, s->hop_size);
@@ -862,6 +966,7 @@ AVFilter ff_avf_showspectrum = {
     .inputs        = showspectrum_inputs,
     .outputs       = showspectrum_outputs,
     .priv_class    = &showspectrum_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
 #endif // CONFIG_SHOWSPECTRUM_FILTER
 
@@ -952,6 +1057,57 @@ static void drawtext(AVFrame *pic, int x, int y, const char *txt, int o)
     }
 }
 
+typedef struct PlotColumnsData {
+    int samples;    ///< number of samples in the fifo
+    int spf;        ///< samples between the FFT windows
+    int n;          ///< FFT windows averaged in each column
+} PlotColumnsData;
+
+static int plot_columns(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ShowSpectrumContext *s = ctx->priv;
+    ShowSpectrumJob *job = &s->jobs[jobnr];
+    PlotColumnsData *td = arg;
+    AVFrame *fin = job->fin;
+    int h = s->orientation == VERTICAL ? s->channel_height : s->channel_width;
+    int sz = s->orientation == VERTICAL ? s->w : s->h;
+    int start = (sz *  jobnr     ) / nb_jobs;
+    int end   = (sz * (jobnr + 1)) / nb_jobs;
+    int x, k, ch;
+
+    for (x = start; x < end; x++) {
+        memset(job->magnitudes, 0, s->nb_display_channels * h * sizeof(*job->magnitudes));
+
+        for (k = 0; k < td->n; k++) {
+            int offset = (x * td->n + k) * td->spf;
+            int ret = 0;
+
+            if (offset < td->samples) {
+                ret = av_audio_fifo_peek_at(s->fifo, (void **)fin->extended_data,
+                                            FFMIN(s->win_size, td->samples - offset), offset);
+                if (ret < 0)
+                    return ret;
+            }
+
+            for (ch = 0; ch < s->nb_display_channels; ch++) {
+                run_fft(s, job, (const float *)fin->extended_data[ch], ret);
+                acalc_magnitudes(s, job, job->magnitudes + ch * h);
+            }
+        }
+
+        clear_combine_buffer(job->combine_buffer, s->orientation == VERTICAL ? s->h : s->w);
+        for (ch = 0; ch < s->nb_display_channels; ch++) {
+            float *magnitudes = job->magnitudes + ch * h;
+
+            scale_magnitudes(s, magnitudes, 1. / td->n);
+            plot_channel(s, ch, magnitudes, channel_colors(s, ch, job->combine_buffer));
+        }
+        draw_column(s, s->outpicref, ctx->outputs[0]->h, x, job->combine_buffer);
+    }
+
+    return 0;
+}
+
 static int showspectrumpic_request_frame(AVFilterLink *outlink)
 {
     ShowSpectrumContext *s = outlink->src->priv;
@@ -961,51 +1117,26 @@ static int showspectrumpic_request_frame(AVFilterLink *outlink)
     ret = ff_request_frame(inlink);
     if (ret == AVERROR_EOF && s->outpicref) {
         int samples = av_audio_fifo_size(s->fifo);
-        int consumed = 0;
-        int y, x = 0, sz = s->orientation == VERTICAL ? s->w : s->h;
+        int y, x, sz = s->orientation == VERTICAL ? s->w : s->h;
         int ch, spf, spb;
-        AVFrame *fin;
+        PlotColumnsData td;
 
         spf = s->win_size * (samples / ((s->win_size * sz) * ceil(samples / (float)(s->win_size * sz))));
+        spf = FFMAX(spf, 1);
         spb = (samples / (spf * sz)) * spf;
 
-        fin = ff_get_audio_buffer(inlink, s->win_size);
-        if (!fin)
-            return AVERROR(ENOMEM);
-
-        while (x < sz) {
-            ret = av_audio_fifo_peek(s->fifo, (void **)fin->extended_data, s->win_size);
-            if (ret < 0) {
-                av_frame_free(&fin);
-                return ret;
-            }
-
-            av_audio_fifo_drain(s->fifo, spf);
-
-            if (ret < s->win_size) {
-                for (ch = 0; ch < s->nb_display_channels; ch++) {
-                    memset(fin->extended_data[ch] + ret * sizeof(float), 0,
-                           (s->win_size - ret) * sizeof(float));
-                }
-            }
-
-            run_fft(s, fin);
-            acalc_magnitudes(s);
-
-            consumed += spf;
-            if (consumed >= spb) {
-                int h = s->orientation == VERTICAL ? s->h : s->w;
+        ret = av_frame_make_writable(s->outpicref);
+        if (ret < 0)
+            return ret;
 
-                scale_magnitudes(s, 1. / (consumed / spf));
-                plot_spectrum_column(inlink, fin);
-                consumed = 0;
-                x++;
-                for (ch = 0; ch < s->nb_display_channels; ch++)
-                    memset(s->magnitudes[ch], 0, h * sizeof(float));
-            }
-        }
+        /* each column averages the spectra of spb / spf windows, spf
+         * samples apart; the columns are independent and computed in
+         * parallel straight from the fifo */
+        td.samples = samples;
+        td.spf     = spf;
+        td.n       = FFMAX(spb / spf, 1);
+        outlink->src->internal->execute(outlink->src, plot_columns, &td, NULL, s->nb_jobs);
 
-        av_frame_free(&fin);
         s->outpicref->pts = 0;
 
         if (s->legend) {
@@ -1223,6 +1354,7 @@ AVFilter ff_avf_showspectrumpic = {
     .inputs        = showspectrumpic_inputs,
     .outputs       = showspectrumpic_outputs,
     .priv_class    = &showspectrumpic_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
 
 #endif // CONFIG_SHOWSPECTRUMPIC_FILTER
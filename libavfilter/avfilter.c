@@ -38,6 +38,7 @@
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "pipeline.h"
 
 #include "libavutil/ffversion.h"
 const char av_filter_ffversion[] = "FFmpeg version " FFMPEG_VERSION;
@@ -188,7 +189,9 @@ void ff_avfilter_link_set_in_status(AVFilterLink *link, int status, int64_t pts)
 void ff_avfilter_link_set_out_status(AVFilterLink *link, int status, int64_t pts)
 {
     link->status = status;
+    ff_filter_pipeline_lock_link(link);
     link->frame_wanted_in = link->frame_wanted_out = 0;
+    ff_filter_pipeline_unlock_link(link);
     ff_update_link_current_pts(link, pts);
 }
 
@@ -372,33 +375,52 @@ int ff_request_frame(AVFilterLink *link)
 
     if (link->status)
         return link->status;
+    ff_filter_pipeline_lock_link(link);
     link->frame_wanted_in = 1;
     link->frame_wanted_out = 1;
+    ff_filter_pipeline_unlock_link(link);
     return 0;
 }
 
 int ff_request_frame_to_filter(AVFilterLink *link)
 {
-    int ret = -1;
+    int ret = -1, dst_held = 0;
 
     FF_TPRINTF_START(NULL, request_frame_to_filter); ff_tlog_link(NULL, link, 1);
+    ff_filter_pipeline_lock_link(link);
     link->frame_wanted_in = 0;
+    ff_filter_pipeline_unlock_link(link);
+    if (link->src->internal->pipeline) {
+        ret = ff_filter_pipeline_request(link);
+        if (ret)
+            return FFMIN(ret, 0);
+        ret = -1;
+    }
     if (link->srcpad->request_frame)
         ret = link->srcpad->request_frame(link);
     else if (link->src->inputs[0])
         ret = ff_request_frame(link->src->inputs[0]);
+    if (ret < 0 && ret != AVERROR(EAGAIN) && link->dst->internal->pipeline) {
+        /* the status must not overtake the frames queued on the link */
+        ff_filter_pipeline_hold(link->dst);
+        dst_held = 1;
+    }
     if (ret == AVERROR_EOF && link->partial_buf) {
         AVFrame *pbuf = link->partial_buf;
         link->partial_buf = NULL;
         ret = ff_filter_frame_framed(link, pbuf);
         ff_avfilter_link_set_in_status(link, AVERROR_EOF, AV_NOPTS_VALUE);
+        ff_filter_pipeline_lock_link(link);
         link->frame_wanted_out = 0;
-        return ret;
-    }
-    if (ret < 0) {
+        ff_filter_pipeline_unlock_link(link);
+    } else if (ret < 0) {
         if (ret != AVERROR(EAGAIN) && ret != link->status)
             ff_avfilter_link_set_in_status(link, ret, AV_NOPTS_VALUE);
     }
+    if (dst_held)
+        ff_filter_pipeline_release(link->dst);
+    if (link->src->internal->pipeline)
+        ff_filter_pipeline_release(link->src);
     return ret;
 }
 
@@ -746,8 +768,10 @@ void avfilter_free(AVFilterContext *filter)
     if (!filter)
         return;
 
-    if (filter->graph)
+    if (filter->graph) {
+        ff_filter_pipeline_detach(filter);
         ff_filter_graph_remove_filter(filter->graph, filter);
+    }
 
     if (filter->filter->uninit)
         filter->filter->uninit(filter);
@@ -1168,8 +1192,10 @@ static int ff_filter_frame_needs_framing(AVFilterLink *link, AVFrame *frame)
             ret = ff_filter_frame_framed(link, pbuf);
             pbuf = NULL;
         } else {
+            ff_filter_pipeline_lock_link(link);
             if (link->frame_wanted_out)
                 link->frame_wanted_in = 1;
+            ff_filter_pipeline_unlock_link(link);
         }
     }
     av_frame_free(&frame);
@@ -1211,7 +1237,24 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
         }
     }
 
+    link->frame_count_in++;
+    if (link->src->internal->pipeline || link->dst->internal->pipeline) {
+        int ret = ff_filter_pipeline_frame(link, frame);
+        if (ret)
+            return FFMIN(ret, 0);
+    }
+
+    ff_filter_pipeline_lock_link(link);
     link->frame_wanted_out = 0;
+    ff_filter_pipeline_unlock_link(link);
+    return ff_filter_frame_to_filter(link, frame);
+error:
+    av_frame_free(&frame);
+    return AVERROR_PATCHWELCOME;
+}
+
+int ff_filter_frame_to_filter(AVFilterLink *link, AVFrame *frame)
+{
     /* Go directly to actual filtering if possible */
     if (link->type == AVMEDIA_TYPE_AUDIO &&
         link->min_samples &&
@@ -1222,9 +1265,6 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
     } else {
         return ff_filter_frame_framed(link, frame);
     }
-error:
-    av_frame_free(&frame);
-    return AVERROR_PATCHWELCOME;
 }
 
 const AVClass *avfilter_get_class(void)
@@ -532,6 +532,13 @@ struct AVFilterLink {
      */
     int64_t frame_count;
 
+    /**
+     * Number of past frames sent on the link by its source. Unlike
+     * frame_count, it does not lag behind while frames wait in a pipeline
+     * queue, so it is the count to use on output links.
+     */
+    int64_t frame_count_in;
+
     /**
      * A pointer to a FFVideoFramePool struct.
      */
@@ -842,6 +849,24 @@ typedef struct AVFilterGraph {
     int sink_links_count;
 
     unsigned disable_auto_convert;
+
+    /**
+     * Maximum number of frames queued in front of each filter when running
+     * filter chains in a pipeline, one thread per filter. 0 disables
+     * pipelining. The output of the graph does not depend on this setting.
+     *
+     * May be set by the caller before avfilter_graph_config().
+     */
+    int pipeline;
+
+    /**
+     * Allocate the video frames of the graph from the buffer pools shared
+     * by the whole process (see av_buffer_pool_init_shared()) instead of
+     * pools private to each link.
+     *
+     * May be set by the caller before avfilter_graph_config().
+     */
+    int shared_pools;
 } AVFilterGraph;
 
 /**
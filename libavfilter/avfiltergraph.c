@@ -35,6 +35,7 @@
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "pipeline.h"
 #include "thread.h"
 
 #define OFFSET(x) offsetof(AVFilterGraph, x)
@@ -45,6 +46,10 @@ static const AVOption filtergraph_options[] = {
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = FLAGS, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads),
         AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX, FLAGS },
+    { "pipeline",    "Maximum number of frames queued per pipelined filter", OFFSET(pipeline),
+        AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, 1024, FLAGS },
+    { "shared_pools", "Allocate frames from the buffer pools shared by the process", OFFSET(shared_pools),
+        AV_OPT_TYPE_BOOL,  { .i64 = 0 }, 0, 1, FLAGS },
     {"scale_sws_opts"       , "default scale filter options"        , OFFSET(scale_sws_opts)        ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, FLAGS },
     {"aresample_swr_opts"   , "default aresample filter options"    , OFFSET(aresample_swr_opts)    ,
@@ -71,6 +76,61 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     graph->nb_threads  = 1;
     return 0;
 }
+
+int ff_filter_graph_pipeline_init(AVFilterGraph *graph)
+{
+    graph->pipeline = 0;
+    return 0;
+}
+
+void ff_filter_graph_pipeline_uninit(AVFilterGraph *graph)
+{
+}
+
+void ff_filter_pipeline_detach(AVFilterContext *ctx)
+{
+}
+
+int ff_filter_pipeline_frame(AVFilterLink *link, AVFrame *frame)
+{
+    return 0;
+}
+
+int ff_filter_pipeline_request(AVFilterLink *link)
+{
+    return 0;
+}
+
+void ff_filter_pipeline_hold(AVFilterContext *ctx)
+{
+}
+
+void ff_filter_pipeline_release(AVFilterContext *ctx)
+{
+}
+
+void ff_filter_pipeline_lock_link(AVFilterLink *link)
+{
+}
+
+void ff_filter_pipeline_unlock_link(AVFilterLink *link)
+{
+}
+
+int ff_filter_pipeline_get_stats(AVFilterContext *ctx, FFPipelineStats *stats)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_filter_graph_pipeline_deliver(AVFilterGraph *graph)
+{
+    return 0;
+}
+
+int ff_filter_graph_pipeline_wait(AVFilterGraph *graph)
+{
+    return 0;
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -114,6 +174,8 @@ void avfilter_graph_free(AVFilterGraph **graph)
     if (!*graph)
         return;
 
+    ff_filter_graph_pipeline_uninit(*graph);
+
     while ((*graph)->nb_filters)
         avfilter_free((*graph)->filters[0]);
 
@@ -299,6 +361,29 @@ static void sanitize_channel_layouts(void *log, AVFilterChannelLayouts *l)
     }
 }
 
+static int formats_declared(AVFilterContext *f)
+{
+    int i;
+
+    for (i = 0; i < f->nb_inputs; i++) {
+        if (!f->inputs[i]->out_formats)
+            return 0;
+        if (f->inputs[i]->type == AVMEDIA_TYPE_AUDIO &&
+            !(f->inputs[i]->out_samplerates &&
+              f->inputs[i]->out_channel_layouts))
+            return 0;
+    }
+    for (i = 0; i < f->nb_outputs; i++) {
+        if (!f->outputs[i]->in_formats)
+            return 0;
+        if (f->outputs[i]->type == AVMEDIA_TYPE_AUDIO &&
+            !(f->outputs[i]->in_samplerates &&
+              f->outputs[i]->in_channel_layouts))
+            return 0;
+    }
+    return 1;
+}
+
 static int filter_query_formats(AVFilterContext *ctx)
 {
     int ret, i;
@@ -321,6 +406,11 @@ static int filter_query_formats(AVFilterContext *ctx)
     for (i = 0; i < ctx->nb_outputs; i++)
         sanitize_channel_layouts(ctx, ctx->outputs[i]->in_channel_layouts);
 
+    /* the filter usually sets all its lists itself, do not build the
+       default ones for nothing */
+    if (formats_declared(ctx))
+        return 0;
+
     formats = ff_all_formats(type);
     if ((ret = ff_set_common_formats(ctx, formats)) < 0)
         return ret;
@@ -335,84 +425,6 @@ static int filter_query_formats(AVFilterContext *ctx)
     return 0;
 }
 
-static int formats_declared(AVFilterContext *f)
-{
-    int i;
-
-    for (i = 0; i < f->nb_inputs; i++) {
-        if (!f->inputs[i]->out_formats)
-            return 0;
-        if (f->inputs[i]->type == AVMEDIA_TYPE_AUDIO &&
-            !(f->inputs[i]->out_samplerates &&
-              f->inputs[i]->out_channel_layouts))
-            return 0;
-    }
-    for (i = 0; i < f->nb_outputs; i++) {
-        if (!f->outputs[i]->in_formats)
-            return 0;
-        if (f->outputs[i]->type == AVMEDIA_TYPE_AUDIO &&
-            !(f->outputs[i]->in_samplerates &&
-              f->outputs[i]->in_channel_layouts))
-            return 0;
-    }
-    return 1;
-}
-
-static AVFilterFormats *clone_filter_formats(AVFilterFormats *arg)
-{
-    AVFilterFormats *a = av_memdup(arg, sizeof(*arg));
-    if (a) {
-        a->refcount = 0;
-        a->refs     = NULL;
-        a->formats  = av_memdup(a->formats, sizeof(*a->formats) * a->nb_formats);
-        if (!a->formats && arg->formats)
-            av_freep(&a);
-    }
-    return a;
-}
-
-static int can_merge_formats(AVFilterFormats *a_arg,
-                             AVFilterFormats *b_arg,
-                             enum AVMediaType type,
-                             int is_sample_rate)
-{
-    AVFilterFormats *a, *b, *ret;
-    if (a_arg == b_arg)
-        return 1;
-    a = clone_filter_formats(a_arg);
-    b = clone_filter_formats(b_arg);
-
-    if (!a || !b) {
-        if (a)
-            av_freep(&a->formats);
-        if (b)
-            av_freep(&b->formats);
-
-        av_freep(&a);
-        av_freep(&b);
-
-        return 0;
-    }
-
-    if (is_sample_rate) {
-        ret = ff_merge_samplerates(a, b);
-    } else {
-        ret = ff_merge_formats(a, b, type);
-    }
-    if (ret) {
-        av_freep(&ret->formats);
-        av_freep(&ret->refs);
-        av_freep(&ret);
-        return 1;
-    } else {
-        av_freep(&a->formats);
-        av_freep(&b->formats);
-        av_freep(&a);
-        av_freep(&b);
-        return 0;
-    }
-}
-
 /**
  * Perform one round of query_formats() and merging formats lists on the
  * filter graph.
@@ -459,15 +471,14 @@ static int query_formats(AVFilterGraph *graph, AVClass *log_ctx)
 
             if (link->in_formats != link->out_formats
                 && link->in_formats && link->out_formats)
-                if (!can_merge_formats(link->in_formats, link->out_formats,
-                                      link->type, 0))
+                if (!ff_can_merge_formats(link->in_formats, link->out_formats,
+                                          link->type))
                     convert_needed = 1;
             if (link->type == AVMEDIA_TYPE_AUDIO) {
                 if (link->in_samplerates != link->out_samplerates
                     && link->in_samplerates && link->out_samplerates)
-                    if (!can_merge_formats(link->in_samplerates,
-                                           link->out_samplerates,
-                                           0, 1))
+                    if (!ff_can_merge_samplerates(link->in_samplerates,
+                                                  link->out_samplerates))
                         convert_needed = 1;
             }
 
@@ -1258,6 +1269,8 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
         return ret;
     if ((ret = graph_config_pointers(graphctx, log_ctx)))
         return ret;
+    if ((ret = ff_filter_graph_pipeline_init(graphctx)) < 0)
+        return ret;
 
     return 0;
 }
@@ -1281,7 +1294,11 @@ int avfilter_graph_send_command(AVFilterGraph *graph, const char *target, const
     for (i = 0; i < graph->nb_filters; i++) {
         AVFilterContext *filter = graph->filters[i];
         if (!strcmp(target, "all") || (filter->name && !strcmp(target, filter->name)) || !strcmp(target, filter->filter->name)) {
+            if (filter->internal->pipeline)
+                ff_filter_pipeline_hold(filter);
             r = avfilter_process_command(filter, cmd, arg, res, res_len, flags);
+            if (filter->internal->pipeline)
+                ff_filter_pipeline_release(filter);
             if (r != AVERROR(ENOSYS)) {
                 if ((flags & AVFILTER_CMD_FLAG_ONE) || r < 0)
                     return r;
@@ -1303,6 +1320,8 @@ int avfilter_graph_queue_command(AVFilterGraph *graph, const char *target, const
         AVFilterContext *filter = graph->filters[i];
         if(filter && (!strcmp(target, "all") || !strcmp(target, filter->name) || !strcmp(target, filter->filter->name))){
             AVFilterCommand **queue = &filter->command_queue, *next;
+            if (filter->internal->pipeline)
+                ff_filter_pipeline_hold(filter);
             while (*queue && (*queue)->time <= ts)
                 queue = &(*queue)->next;
             next = *queue;
@@ -1312,6 +1331,8 @@ int avfilter_graph_queue_command(AVFilterGraph *graph, const char *target, const
             (*queue)->time    = ts;
             (*queue)->flags   = flags;
             (*queue)->next    = next;
+            if (filter->internal->pipeline)
+                ff_filter_pipeline_release(filter);
             if(flags & AVFILTER_CMD_FLAG_ONE)
                 return 0;
         }
@@ -1400,6 +1421,16 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
     return 0;
 }
 
+static int link_frame_wanted(AVFilterLink *link, int in)
+{
+    int wanted;
+
+    ff_filter_pipeline_lock_link(link);
+    wanted = in ? link->frame_wanted_in : link->frame_wanted_out;
+    ff_filter_pipeline_unlock_link(link);
+    return wanted;
+}
+
 static AVFilterLink *graph_run_once_find_filter(AVFilterGraph *graph)
 {
     unsigned i, j;
@@ -1409,13 +1440,13 @@ static AVFilterLink *graph_run_once_find_filter(AVFilterGraph *graph)
     for (i = 0; i < graph->nb_filters; i++) {
         f = graph->filters[i];
         for (j = 0; j < f->nb_outputs; j++)
-            if (f->outputs[j]->frame_wanted_in)
+            if (link_frame_wanted(f->outputs[j], 1))
                 return f->outputs[j];
     }
     for (i = 0; i < graph->nb_filters; i++) {
         f = graph->filters[i];
         for (j = 0; j < f->nb_outputs; j++)
-            if (f->outputs[j]->frame_wanted_out)
+            if (link_frame_wanted(f->outputs[j], 0))
                 return f->outputs[j];
     }
     return NULL;
@@ -1426,8 +1457,16 @@ int ff_filter_graph_run_once(AVFilterGraph *graph)
     AVFilterLink *link;
     int ret;
 
+    if (graph->internal->pipeline) {
+        ret = ff_filter_graph_pipeline_deliver(graph);
+        if (ret)
+            return ret;
+    }
     link = graph_run_once_find_filter(graph);
     if (!link) {
+        /* the frames being filtered may still answer the requests */
+        if ((ret = ff_filter_graph_pipeline_wait(graph)))
+            return ret;
         av_log(NULL, AV_LOG_WARNING, "Useless run of a filter graph\n");
         return AVERROR(EAGAIN);
     }
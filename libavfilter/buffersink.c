@@ -23,7 +23,6 @@
  * buffer sink
  */
 
-#include "libavutil/audio_fifo.h"
 #include "libavutil/avassert.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/common.h"
@@ -32,9 +31,11 @@
 #include "libavutil/opt.h"
 
 #include "audio.h"
+#include "audioqueue.h"
 #include "avfilter.h"
 #include "buffersink.h"
 #include "internal.h"
+#include "pipeline.h"
 
 typedef struct BufferSinkContext {
     const AVClass *class;
@@ -57,7 +58,7 @@ typedef struct BufferSinkContext {
     int sample_rates_size;
 
     /* only used for compat API */
-    AVAudioFifo *audio_fifo;     ///< FIFO for audio samples
+    FFAudioQueue audio_queue;    ///< queue of audio frames to rechunk
     int64_t next_pts;            ///< interpolating audio pts
 } BufferSinkContext;
 
@@ -70,8 +71,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     BufferSinkContext *sink = ctx->priv;
     AVFrame *frame;
 
-    if (sink->audio_fifo)
-        av_audio_fifo_free(sink->audio_fifo);
+    ff_audio_queue_uninit(&sink->audio_queue);
 
     if (sink->fifo) {
         while (av_fifo_size(sink->fifo) >= FIFO_INIT_ELEMENT_SIZE) {
@@ -132,6 +132,9 @@ int attribute_align_arg av_buffersink_get_frame_flags(AVFilterContext *ctx, AVFr
     int ret;
     AVFrame *cur_frame;
 
+    if ((ret = ff_filter_graph_pipeline_deliver(ctx->graph)) < 0)
+        return ret;
+
     /* no picref available, fetch it from the filterchain */
     while (!av_fifo_size(buf->fifo)) {
         if (inlink->status)
@@ -160,16 +163,16 @@ int attribute_align_arg av_buffersink_get_frame_flags(AVFilterContext *ctx, AVFr
     return 0;
 }
 
-static int read_from_fifo(AVFilterContext *ctx, AVFrame *frame,
-                          int nb_samples)
+static int read_from_queue(AVFilterContext *ctx, AVFrame *frame,
+                           int nb_samples)
 {
     BufferSinkContext *s = ctx->priv;
     AVFilterLink   *link = ctx->inputs[0];
     AVFrame *tmp;
+    int ret;
 
-    if (!(tmp = ff_get_audio_buffer(link, nb_samples)))
-        return AVERROR(ENOMEM);
-    av_audio_fifo_read(s->audio_fifo, (void**)tmp->extended_data, nb_samples);
+    if ((ret = ff_audio_queue_get(&s->audio_queue, link, &tmp, nb_samples)) < 0)
+        return ret;
 
     tmp->pts = s->next_pts;
     if (s->next_pts != AV_NOPTS_VALUE)
@@ -190,22 +193,20 @@ int attribute_align_arg av_buffersink_get_samples(AVFilterContext *ctx,
     AVFrame *cur_frame;
     int ret = 0;
 
-    if (!s->audio_fifo) {
-        int nb_channels = link->channels;
-        if (!(s->audio_fifo = av_audio_fifo_alloc(link->format, nb_channels, nb_samples)))
-            return AVERROR(ENOMEM);
-    }
+    if (!s->audio_queue.frames &&
+        (ret = ff_audio_queue_init(&s->audio_queue, link->format, link->channels)) < 0)
+        return ret;
 
     while (ret >= 0) {
-        if (av_audio_fifo_size(s->audio_fifo) >= nb_samples)
-            return read_from_fifo(ctx, frame, nb_samples);
+        if (ff_audio_queue_size(&s->audio_queue) >= nb_samples)
+            return read_from_queue(ctx, frame, nb_samples);
 
         if (!(cur_frame = av_frame_alloc()))
             return AVERROR(ENOMEM);
         ret = av_buffersink_get_frame_flags(ctx, cur_frame, 0);
-        if (ret == AVERROR_EOF && av_audio_fifo_size(s->audio_fifo)) {
+        if (ret == AVERROR_EOF && ff_audio_queue_size(&s->audio_queue)) {
             av_frame_free(&cur_frame);
-            return read_from_fifo(ctx, frame, av_audio_fifo_size(s->audio_fifo));
+            return read_from_queue(ctx, frame, ff_audio_queue_size(&s->audio_queue));
         } else if (ret < 0) {
             av_frame_free(&cur_frame);
             return ret;
@@ -213,14 +214,12 @@ int attribute_align_arg av_buffersink_get_samples(AVFilterContext *ctx,
 
         if (cur_frame->pts != AV_NOPTS_VALUE) {
             s->next_pts = cur_frame->pts -
-                          av_rescale_q(av_audio_fifo_size(s->audio_fifo),
+                          av_rescale_q(ff_audio_queue_size(&s->audio_queue),
                                        (AVRational){ 1, link->sample_rate },
                                        link->time_base);
         }
 
-        ret = av_audio_fifo_write(s->audio_fifo, (void**)cur_frame->extended_data,
-                                  cur_frame->nb_samples);
-        av_frame_free(&cur_frame);
+        ret = ff_audio_queue_add(&s->audio_queue, cur_frame);
     }
 
     return ret;
@@ -98,6 +98,41 @@ static void multiply3x3_c(int16_t *buf[3], ptrdiff_t stride,
     }
 }
 
+static void gamut_map_c(int16_t *buf[3], ptrdiff_t stride,
+                        int w, int h, const int16_t luma[3][8])
+{
+    int y, x;
+    int16_t *buf0 = buf[0], *buf1 = buf[1], *buf2 = buf[2];
+
+    for (y = 0; y < h; y++) {
+        for (x = 0; x < w; x++) {
+            int v0 = buf0[x], v1 = buf1[x], v2 = buf2[x];
+            int l = (luma[0][0] * v0 + luma[1][0] * v1 + luma[2][0] * v2 + 8192) >> 14;
+            int lo = FFMIN3(v0, v1, v2), hi = FFMAX3(v0, v1, v2);
+            int k = 1 << 14;
+
+            if (l <= 0 || l >= 28672) {
+                buf0[x] = buf1[x] = buf2[x] = av_clip(l, 0, 28672);
+                continue;
+            }
+            // scale the distance to the luminance so that [0,1] is reached
+            if (lo < 0)
+                k = (l << 14) / (l - lo);
+            if (hi > 28672)
+                k = FFMIN(k, ((28672 - l) << 14) / (hi - l));
+            if (k < 1 << 14) {
+                buf0[x] = l + (((v0 - l) * k + 8192) >> 14);
+                buf1[x] = l + (((v1 - l) * k + 8192) >> 14);
+                buf2[x] = l + (((v2 - l) * k + 8192) >> 14);
+            }
+        }
+
+        buf0 += stride;
+        buf1 += stride;
+        buf2 += stride;
+    }
+}
+
 void ff_colorspacedsp_init(ColorSpaceDSPContext *dsp)
 {
 #define init_yuv2rgb_fn(bit) \
@@ -141,6 +176,7 @@ void ff_colorspacedsp_init(ColorSpaceDSPContext *dsp)
     init_yuv2yuv_fns(12);
 
     dsp->multiply3x3 = multiply3x3_c;
+    dsp->gamut_map   = gamut_map_c;
 
     if (ARCH_X86)
         ff_colorspacedsp_x86_init(dsp);
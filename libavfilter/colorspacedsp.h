@@ -73,6 +73,12 @@ typedef struct ColorSpaceDSPContext {
      * (our internal data format) */
     void (*multiply3x3)(int16_t *data[3], ptrdiff_t stride,
                         int w, int h, const int16_t m[3][3][8]);
+
+    /* In-place mapping of out-of-gamut linear RGB (15bpp, internal format)
+     * into the gamut by desaturating towards the luminance, which is computed
+     * with the 14bit coefficients in luma[]. */
+    void (*gamut_map)(int16_t *data[3], ptrdiff_t stride,
+                      int w, int h, const int16_t luma[3][8]);
 } ColorSpaceDSPContext;
 
 void ff_colorspacedsp_init(ColorSpaceDSPContext *dsp);
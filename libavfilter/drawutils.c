@@ -579,6 +579,49 @@ static void blend_line_hv16(uint8_t *dst, int dst_delta,
                       right, hband, hsub + vsub, xm);
 }
 
+/**
+ * Same as blend_pixel() on a line of w pixels, for an 8-bit mask with
+ * no subsampling. Written so that the packed case can be vectorized.
+ */
+static void blend_line_mask8(uint8_t *dst, int dst_delta,
+                             unsigned src, unsigned alpha,
+                             const uint8_t *mask, int w)
+{
+    int x;
+
+    if (dst_delta == 1) {
+        for (x = 0; x < w; x++) {
+            unsigned a = mask[x] * alpha;
+            dst[x] = ((0x1010101 - a) * dst[x] + a * src) >> 24;
+        }
+    } else {
+        for (x = 0; x < w; x++) {
+            unsigned a = mask[x] * alpha;
+            *dst = ((0x1010101 - a) * *dst + a * src) >> 24;
+            dst += dst_delta;
+        }
+    }
+}
+
+/**
+ * Same as blend_pixel() on a line of w pixels, for an 8-bit mask with
+ * 2x2 subsampling.
+ */
+static void blend_line_mask8_sub2(uint8_t *dst, int dst_delta,
+                                  unsigned src, unsigned alpha,
+                                  const uint8_t *mask, int mask_linesize, int w)
+{
+    const uint8_t *mask2 = mask + mask_linesize;
+    int x;
+
+    for (x = 0; x < w; x++) {
+        unsigned a = ((mask[2 * x] + mask[2 * x + 1] +
+                       mask2[2 * x] + mask2[2 * x + 1]) >> 2) * alpha;
+        *dst = ((0x1010101 - a) * *dst + a * src) >> 24;
+        dst += dst_delta;
+    }
+}
+
 static void blend_line_hv(uint8_t *dst, int dst_delta,
                           unsigned src, unsigned alpha,
                           const uint8_t *mask, int mask_linesize, int l2depth, int w,
@@ -593,11 +636,21 @@ static void blend_line_hv(uint8_t *dst, int dst_delta,
         dst += dst_delta;
         xm += left;
     }
-    for (x = 0; x < w; x++) {
-        blend_pixel(dst, src, alpha, mask, mask_linesize, l2depth,
-                    1 << hsub, hband, hsub + vsub, xm);
-        dst += dst_delta;
-        xm += 1 << hsub;
+    if (l2depth == 3 && hsub == vsub && hsub <= 1 && hband == 1 << vsub) {
+        if (hsub)
+            blend_line_mask8_sub2(dst, dst_delta, src, alpha,
+                                  mask + xm, mask_linesize, w);
+        else
+            blend_line_mask8(dst, dst_delta, src, alpha, mask + xm, w);
+        dst += w * dst_delta;
+        xm  += w << hsub;
+    } else {
+        for (x = 0; x < w; x++) {
+            blend_pixel(dst, src, alpha, mask, mask_linesize, l2depth,
+                        1 << hsub, hband, hsub + vsub, xm);
+            dst += dst_delta;
+            xm += 1 << hsub;
+        }
     }
     if (right)
         blend_pixel(dst, src, alpha, mask, mask_linesize, l2depth,
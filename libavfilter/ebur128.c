@@ -0,0 +1,487 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/channel_layout.h"
+#include "libavutil/common.h"
+#include "libavutil/ffmath.h"
+#include "audio.h"
+#include "ebur128.h"
+
+#define ABS_THRES  FF_EBUR128_ABS_THRES
+#define HIST_GRAIN FF_EBUR128_HIST_GRAIN
+#define HIST_SIZE  FF_EBUR128_HIST_SIZE
+#define TP_TAPS    FF_EBUR128_TP_TAPS
+
+#define I_GATE_THRES   -10
+#define LRA_GATE_THRES -20
+#define LRA_LOWER_PRC   10
+#define LRA_HIGHER_PRC  95
+
+/* Kaiser window parameter of the true peak filter */
+#define TP_BETA 4.0
+
+#define ENERGY(loudness) (ff_exp10(((loudness) + 0.691) / 10.))
+#define LOUDNESS(energy) (-0.691 + 10 * log10(energy))
+#define HIST_POS(power) (int)(((power) - ABS_THRES) * HIST_GRAIN)
+
+#define BACK_MASK (AV_CH_BACK_LEFT    |AV_CH_BACK_CENTER    |AV_CH_BACK_RIGHT| \
+                   AV_CH_TOP_BACK_LEFT|AV_CH_TOP_BACK_CENTER|AV_CH_TOP_BACK_RIGHT| \
+                   AV_CH_SIDE_LEFT                          |AV_CH_SIDE_RIGHT| \
+                   AV_CH_SURROUND_DIRECT_LEFT               |AV_CH_SURROUND_DIRECT_RIGHT)
+
+static av_always_inline void kweight_channel(double *sum, double *state, ptrdiff_t state_stride,
+                                             const double *c, const double *src,
+                                             ptrdiff_t src_stride, int len)
+{
+    double x1 = state[0], x2 = state[    state_stride];
+    double y1 = state[2 * state_stride], y2 = state[3 * state_stride];
+    double z1 = state[4 * state_stride], z2 = state[5 * state_stride];
+    double energy = *sum;
+    int i;
+
+    for (i = 0; i < len; i++) {
+        const double x0 = src[i * src_stride];
+        const double y0 = x0 * c[0] + x1 * c[2] + x2 * c[4] - y1 * c[6] - y2 * c[8];
+        const double z0 = y0 - (y1 + y1) + y2 - z1 * c[10] - z2 * c[12];
+
+        energy += z0 * z0;
+        x2 = x1; x1 = x0;
+        y2 = y1; y1 = y0;
+        z2 = z1; z1 = z0;
+    }
+
+    *sum = energy;
+    state[0]                = x1;
+    state[    state_stride] = x2;
+    state[2 * state_stride] = y1;
+    state[3 * state_stride] = y2;
+    state[4 * state_stride] = z1;
+    state[5 * state_stride] = z2;
+}
+
+static void kweight_c(double *sum, double *state, ptrdiff_t state_stride,
+                      const double *coeffs, const double *src,
+                      ptrdiff_t src_stride, int len)
+{
+    kweight_channel(sum,     state,     state_stride, coeffs, src,     src_stride, len);
+    kweight_channel(sum + 1, state + 1, state_stride, coeffs, src + 1, src_stride, len);
+}
+
+av_cold void ff_ebur128_dsp_init(FFEBUR128DSPContext *dsp)
+{
+    dsp->kweight = kweight_c;
+
+    if (ARCH_X86)
+        ff_ebur128_dsp_init_x86(dsp);
+}
+
+/* K-weighting filter for any sample rate, from the analog prototypes of the
+ * BS.1770 filters; at 48 kHz this gives the coefficients of the standard */
+static av_cold void init_kweighting(FFEBUR128Context *s)
+{
+    double f0, g, q, k, vh, vb, a0;
+    double c[7];
+    int i;
+
+    f0 = 1681.974450955533;
+    g  = 3.999843853973347;
+    q  = 0.7071752369554196;
+    k  = tan(M_PI * f0 / s->sample_rate);
+    vh = pow(10., g / 20.);
+    vb = pow(vh, 0.4996667741545416);
+    a0 = 1. + k / q + k * k;
+    c[0] = (vh + vb * k / q + k * k) / a0;
+    c[1] = 2. * (k * k - vh) / a0;
+    c[2] = (vh - vb * k / q + k * k) / a0;
+    c[3] = 2. * (k * k - 1.) / a0;
+    c[4] = (1. - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q  = 0.5003270373238773;
+    k  = tan(M_PI * f0 / s->sample_rate);
+    a0 = 1. + k / q + k * k;
+    c[5] = 2. * (k * k - 1.) / a0;
+    c[6] = (1. - k / q + k * k) / a0;
+
+    for (i = 0; i < 7; i++)
+        s->coeffs[i][0] = s->coeffs[i][1] = c[i];
+}
+
+static double bessel_i0(double x)
+{
+    double v = 1., t = 1.;
+    int i;
+
+    for (i = 1; i < 30; i++) {
+        t *= (x / (2 * i)) * (x / (2 * i));
+        v += t;
+    }
+    return v;
+}
+
+/* split a windowed sinc into tp_factor phases, each normalized to unity gain
+ * and stored oldest sample first */
+static av_cold void init_true_peak(FFEBUR128Context *s)
+{
+    const int factor = s->tp_factor;
+    const double center = (factor * TP_TAPS - 1) / 2.;
+    int p, j;
+
+    for (p = 0; p < factor; p++) {
+        double sum = 0;
+
+        for (j = 0; j < TP_TAPS; j++) {
+            const double t = j * factor + p - center;
+            const double w = bessel_i0(TP_BETA * sqrt(1. - (t / (center + 0.5)) * (t / (center + 0.5))));
+            const double h = sin(M_PI * t / factor) / (M_PI * t / factor) * w;
+
+            s->tp_coeffs[p][TP_TAPS - 1 - j] = h;
+            sum += h;
+        }
+        for (j = 0; j < TP_TAPS; j++)
+            s->tp_coeffs[p][j] /= sum;
+    }
+}
+
+av_cold int ff_ebur128_init(FFEBUR128Context *s, AVFilterContext *ctx,
+                            uint64_t channel_layout, int nb_channels,
+                            int sample_rate, int flags)
+{
+    int i;
+
+    ff_ebur128_uninit(s);
+    memset(s, 0, sizeof(*s));
+
+    s->ctx         = ctx;
+    s->nb_channels = nb_channels;
+    s->sample_rate = sample_rate;
+    s->flags       = flags;
+    s->block_size  = (sample_rate + 5) / 10;
+    s->momentary   =
+    s->shortterm   = LOUDNESS(1e-12);
+
+    s->weights          = av_calloc(nb_channels, sizeof(*s->weights));
+    s->energy           = av_calloc(nb_channels, sizeof(*s->energy));
+    s->state            = av_calloc(6 * nb_channels, sizeof(*s->state));
+    s->i400.histogram   = av_calloc(HIST_SIZE, sizeof(*s->i400.histogram));
+    s->i3000.histogram  = av_calloc(HIST_SIZE, sizeof(*s->i3000.histogram));
+    s->hist_energy      = av_calloc(HIST_SIZE, sizeof(*s->hist_energy));
+    s->sample_peaks     = av_calloc(nb_channels, sizeof(*s->sample_peaks));
+    s->true_peaks       = av_calloc(nb_channels, sizeof(*s->true_peaks));
+    s->block_true_peaks = av_calloc(nb_channels, sizeof(*s->block_true_peaks));
+    s->tp_hist          = av_calloc(nb_channels, 2 * TP_TAPS * sizeof(*s->tp_hist));
+    if (!s->weights || !s->energy || !s->state || !s->i400.histogram ||
+        !s->i3000.histogram || !s->hist_energy || !s->sample_peaks ||
+        !s->true_peaks || !s->block_true_peaks || !s->tp_hist)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < nb_channels; i++) {
+        const uint64_t chl = channel_layout ? av_channel_layout_extract_channel(channel_layout, i) : 0;
+
+        if (chl & (AV_CH_LOW_FREQUENCY|AV_CH_LOW_FREQUENCY_2))
+            s->weights[i] = 0;
+        else if (chl & BACK_MASK)
+            s->weights[i] = 1.41;
+        else
+            s->weights[i] = 1.0;
+    }
+    if (nb_channels == 1 && (flags & FF_EBUR128_DUAL_MONO))
+        s->weights[0] = 2.0;
+
+    for (i = 0; i < HIST_SIZE; i++)
+        s->hist_energy[i] = ENERGY(i / (double)HIST_GRAIN + ABS_THRES);
+
+    init_kweighting(s);
+
+    s->tp_factor = sample_rate < 96000 ? 4 : sample_rate < 192000 ? 2 : 1;
+    if (s->tp_factor > 1)
+        init_true_peak(s);
+
+    ff_ebur128_dsp_init(&s->dsp);
+
+    return 0;
+}
+
+static double true_peak(const FFEBUR128Context *s, double *hist, const double *src,
+                        ptrdiff_t stride, int nb_samples)
+{
+    double peak = 0;
+    int pos = s->tp_pos;
+    int i, p, j;
+
+    if (s->tp_factor == 1) {
+        for (i = 0; i < nb_samples; i++)
+            peak = FFMAX(peak, fabs(src[i * stride]));
+        return peak;
+    }
+
+    for (i = 0; i < nb_samples; i++) {
+        const double *h = hist + pos + 1;
+
+        /* each sample is stored twice, so the last TP_TAPS samples are
+         * always contiguous */
+        hist[pos] = hist[pos + TP_TAPS] = src[i * stride];
+        for (p = 0; p < s->tp_factor; p++) {
+            double v = 0;
+
+            for (j = 0; j < TP_TAPS; j++)
+                v += h[j] * s->tp_coeffs[p][j];
+            peak = FFMAX(peak, fabs(v));
+        }
+        if (++pos == TP_TAPS)
+            pos = 0;
+    }
+    return peak;
+}
+
+typedef struct ThreadData {
+    FFEBUR128Context *s;
+    const double *src;
+    int nb_samples;
+} ThreadData;
+
+static void filter_channels(FFEBUR128Context *s, const double *src, int nb_samples,
+                            int ch_start, int ch_end)
+{
+    const int nb_channels = s->nb_channels;
+    int ch, i;
+
+    for (ch = ch_start; ch + 1 < ch_end; ch += 2)
+        s->dsp.kweight(s->energy + ch, s->state + ch, nb_channels,
+                       s->coeffs[0], src + ch, nb_channels, nb_samples);
+    if (ch < ch_end)
+        kweight_channel(s->energy + ch, s->state + ch, nb_channels,
+                        s->coeffs[0], src + ch, nb_channels, nb_samples);
+
+    for (ch = ch_start; ch < ch_end; ch++) {
+        if (s->flags & FF_EBUR128_SAMPLE_PEAK) {
+            double peak = s->sample_peaks[ch];
+
+            for (i = 0; i < nb_samples; i++)
+                peak = FFMAX(peak, fabs(src[i * nb_channels + ch]));
+            s->sample_peaks[ch] = peak;
+        }
+        if (s->flags & FF_EBUR128_TRUE_PEAK) {
+            double peak = true_peak(s, s->tp_hist + ch * 2 * TP_TAPS,
+                                    src + ch, nb_channels, nb_samples);
+
+            s->block_true_peaks[ch] = FFMAX(s->block_true_peaks[ch], peak);
+            s->true_peaks[ch]       = FFMAX(s->true_peaks[ch],       peak);
+        }
+    }
+}
+
+static int filter_channels_job(AVFilterContext *ctx, void *arg, int jobnr,
+                               int ch_start, int ch_end)
+{
+    ThreadData *td = arg;
+
+    filter_channels(td->s, td->src, td->nb_samples, ch_start, ch_end);
+    return 0;
+}
+
+static void gate_add(FFEBUR128Gate *g, double power, double loudness)
+{
+    g->histogram[av_clip(HIST_POS(loudness), 0, HIST_SIZE - 1)]++;
+    g->sum_kept_powers += power;
+    g->nb_kept_powers++;
+}
+
+static void end_block(FFEBUR128Context *s)
+{
+    double energy = 0, power_400 = 1e-12, power_3000 = 1e-12;
+    int ch, i;
+
+    for (ch = 0; ch < s->nb_channels; ch++) {
+        energy += s->weights[ch] * s->energy[ch];
+        s->energy[ch] = 0;
+    }
+
+    s->blocks[s->block_idx] = energy;
+    s->block_idx = (s->block_idx + 1) % 30;
+    s->nb_blocks = FFMIN(s->nb_blocks + 1, 30);
+
+    /* gating blocks of 400 ms overlap by 75% (BS.1770-2), and the short-term
+     * loudness is updated at the same rate */
+    if (s->nb_blocks >= 4) {
+        for (i = 1; i <= 4; i++)
+            power_400 += s->blocks[(s->block_idx - i + 30) % 30];
+        power_400 /= 4 * s->block_size;
+    }
+    if (s->nb_blocks == 30) {
+        for (i = 0; i < 30; i++)
+            power_3000 += s->blocks[i];
+        power_3000 /= 30 * s->block_size;
+    }
+
+    s->momentary = LOUDNESS(power_400);
+    s->shortterm = LOUDNESS(power_3000);
+
+    if (s->momentary >= ABS_THRES)
+        gate_add(&s->i400, power_400, s->momentary);
+    /* XXX: example code in EBU 3342 is ">=" but formula in BS.1770
+     * specs is ">" */
+    if (s->shortterm >= ABS_THRES)
+        gate_add(&s->i3000, power_3000, s->shortterm);
+}
+
+int ff_ebur128_feed(FFEBUR128Context *s, const double *src, int nb_samples)
+{
+    const int n = FFMIN(nb_samples, s->block_size - s->block_pos);
+    ThreadData td = { s, src, n };
+
+    if (n <= 0)
+        return 0;
+
+    if (!s->block_pos)
+        memset(s->block_true_peaks, 0, s->nb_channels * sizeof(*s->block_true_peaks));
+
+    if (s->ctx)
+        ff_filter_execute_channels(s->ctx, filter_channels_job, &td, s->nb_channels);
+    else
+        filter_channels(s, src, n, 0, s->nb_channels);
+    s->tp_pos = (s->tp_pos + n) % TP_TAPS;
+
+    s->block_pos += n;
+    if (s->block_pos == s->block_size) {
+        s->block_pos = 0;
+        end_block(s);
+    }
+    return n;
+}
+
+void ff_ebur128_add_frames(FFEBUR128Context *s, const double *src, int nb_samples)
+{
+    while (nb_samples > 0) {
+        const int n = ff_ebur128_feed(s, src, nb_samples);
+
+        src        += n * s->nb_channels;
+        nb_samples -= n;
+    }
+}
+
+static double relative_gate(const FFEBUR128Gate *g, int gate_thres)
+{
+    double relative_threshold;
+
+    if (!g->nb_kept_powers)
+        return ABS_THRES;
+
+    relative_threshold = g->sum_kept_powers / g->nb_kept_powers;
+    if (!relative_threshold)
+        relative_threshold = 1e-12;
+    return LOUDNESS(relative_threshold) + gate_thres;
+}
+
+double ff_ebur128_loudness_global(FFEBUR128Context *s)
+{
+    const FFEBUR128Gate *g = &s->i400;
+    double integrated_sum = 0;
+    int nb_integrated = 0;
+    int i;
+
+    if (!g->nb_kept_powers)
+        return -HUGE_VAL;
+
+    /* sum the histogram values above the relative threshold */
+    for (i = av_clip(HIST_POS(relative_gate(g, I_GATE_THRES)), 0, HIST_SIZE - 1); i < HIST_SIZE; i++) {
+        nb_integrated  += g->histogram[i];
+        integrated_sum += g->histogram[i] * s->hist_energy[i];
+    }
+    if (!nb_integrated)
+        return -HUGE_VAL;
+    return LOUDNESS(integrated_sum / nb_integrated);
+}
+
+double ff_ebur128_relative_threshold(FFEBUR128Context *s)
+{
+    return relative_gate(&s->i400, I_GATE_THRES);
+}
+
+void ff_ebur128_loudness_range(FFEBUR128Context *s, double *lra,
+                               double *low, double *high)
+{
+    const FFEBUR128Gate *g = &s->i3000;
+    int gate_hist_pos, nb_powers = 0, n, nb_pow, i;
+    double lra_low = 0, lra_high = 0;
+
+    *lra = 0;
+    if (low)
+        *low = 0;
+    if (high)
+        *high = 0;
+    if (!g->nb_kept_powers)
+        return;
+
+    gate_hist_pos = av_clip(HIST_POS(relative_gate(g, LRA_GATE_THRES)), 0, HIST_SIZE - 1);
+    for (i = gate_hist_pos; i < HIST_SIZE; i++)
+        nb_powers += g->histogram[i];
+    if (!nb_powers)
+        return;
+
+    /* get lower loudness to consider */
+    n = 0;
+    nb_pow = LRA_LOWER_PRC  * nb_powers / 100. + 0.5;
+    for (i = gate_hist_pos; i < HIST_SIZE; i++) {
+        n += g->histogram[i];
+        if (n >= nb_pow) {
+            lra_low = i / (double)HIST_GRAIN + ABS_THRES;
+            break;
+        }
+    }
+
+    /* get higher loudness to consider */
+    n = nb_powers;
+    nb_pow = LRA_HIGHER_PRC * nb_powers / 100. + 0.5;
+    for (i = HIST_SIZE - 1; i >= 0; i--) {
+        n -= g->histogram[i];
+        if (n < nb_pow) {
+            lra_high = i / (double)HIST_GRAIN + ABS_THRES;
+            break;
+        }
+    }
+
+    *lra = lra_high - lra_low;
+    if (low)
+        *low = lra_low;
+    if (high)
+        *high = lra_high;
+}
+
+double ff_ebur128_range_threshold(FFEBUR128Context *s)
+{
+    return relative_gate(&s->i3000, LRA_GATE_THRES);
+}
+
+av_cold void ff_ebur128_uninit(FFEBUR128Context *s)
+{
+    av_freep(&s->weights);
+    av_freep(&s->energy);
+    av_freep(&s->state);
+    av_freep(&s->i400.histogram);
+    av_freep(&s->i3000.histogram);
+    av_freep(&s->hist_energy);
+    av_freep(&s->sample_peaks);
+    av_freep(&s->true_peaks);
+    av_freep(&s->block_true_peaks);
+    av_freep(&s->tp_hist);
+}
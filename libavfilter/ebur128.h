@@ -0,0 +1,181 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * EBU R128 / ITU-R BS.1770 loudness measurement
+ *
+ * The input is K-weighted at its own sample rate and its energy is summed
+ * in blocks of 100 ms. Momentary and short-term loudness are computed over
+ * the last 4 and 30 blocks after each block; the gating of the integrated
+ * loudness and the loudness range uses histograms with a resolution of
+ * 0.01 LU, so the memory use does not grow with the length of the input.
+ * True peaks are measured by 4x (2x at 96 kHz and more) polyphase
+ * oversampling.
+ */
+
+#ifndef AVFILTER_EBUR128_H
+#define AVFILTER_EBUR128_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/mem.h"
+#include "avfilter.h"
+
+#define FF_EBUR128_ABS_THRES   -70  ///< absolute gate, in LUFS
+#define FF_EBUR128_ABS_UP_THRES 10  ///< loudest value kept in the histograms
+#define FF_EBUR128_HIST_GRAIN  100  ///< histogram bins per LU
+#define FF_EBUR128_HIST_SIZE ((FF_EBUR128_ABS_UP_THRES - FF_EBUR128_ABS_THRES) * FF_EBUR128_HIST_GRAIN + 1)
+
+#define FF_EBUR128_TP_TAPS 12       ///< taps per phase of the true peak filter
+#define FF_EBUR128_TP_MAX_FACTOR 4
+
+enum FFEBUR128Flags {
+    FF_EBUR128_SAMPLE_PEAK = 1 << 0,    ///< measure sample peaks
+    FF_EBUR128_TRUE_PEAK   = 1 << 1,    ///< measure true peaks
+    FF_EBUR128_DUAL_MONO   = 1 << 2,    ///< count a mono input twice
+};
+
+typedef struct FFEBUR128DSPContext {
+    /**
+     * K-weight two adjacent channels of interleaved audio and add the
+     * energy of the filtered signal to sum.
+     *
+     * The filter is the cascade of the pre-filter, in direct form I, and
+     * of the RLB high-pass, whose numerator is 1, -2, 1.
+     *
+     * @param sum          energy of each channel
+     * @param state        filter state, x[n-1], x[n-2], y[n-1], y[n-2],
+     *                     z[n-1] and z[n-2] of both channels, each pair
+     *                     state_stride doubles after the previous one
+     * @param coeffs       b0, b1, b2, a1, a2 of the pre-filter and a1, a2
+     *                     of the RLB filter, each value stored twice,
+     *                     16-byte aligned
+     * @param src          first sample of the first channel
+     * @param src_stride   distance between frames, in doubles
+     * @param len          number of frames, greater than 0
+     */
+    void (*kweight)(double *sum, double *state, ptrdiff_t state_stride,
+                    const double *coeffs, const double *src,
+                    ptrdiff_t src_stride, int len);
+} FFEBUR128DSPContext;
+
+typedef struct FFEBUR128Gate {
+    int *histogram;                         ///< number of blocks per loudness
+    double sum_kept_powers;                 ///< sum of the powers above the absolute gate
+    int nb_kept_powers;                     ///< number of blocks above the absolute gate
+} FFEBUR128Gate;
+
+typedef struct FFEBUR128Context {
+    AVFilterContext *ctx;       ///< context used for threading, may be NULL
+    int nb_channels;
+    int sample_rate;
+    int flags;
+
+    int block_size;             ///< samples in 100 ms
+    int block_pos;              ///< samples of the current block already done
+    int nb_blocks;              ///< number of complete blocks, up to 30
+    int block_idx;              ///< slot of the next block in blocks
+    double blocks[30];          ///< weighted energy of the last blocks
+
+    double *weights;            ///< weight of each channel
+    double *energy;             ///< energy of the current block per channel
+    double *state;              ///< K-weighting filter state, [6][nb_channels]
+    DECLARE_ALIGNED(16, double, coeffs)[7][2];
+
+    double momentary;           ///< loudness of the last 400 ms, in LUFS
+    double shortterm;           ///< loudness of the last 3 s, in LUFS
+    FFEBUR128Gate i400;         ///< gate of the integrated loudness
+    FFEBUR128Gate i3000;        ///< gate of the loudness range
+    double *hist_energy;        ///< energy of each histogram bin
+
+    double *sample_peaks;       ///< sample peak per channel
+    double *true_peaks;         ///< true peak per channel
+    double *block_true_peaks;   ///< true peak of the last block per channel
+    int tp_factor;              ///< oversampling factor of the true peak
+    double tp_coeffs[FF_EBUR128_TP_MAX_FACTOR][FF_EBUR128_TP_TAPS];
+    double *tp_hist;            ///< past samples, [nb_channels][2 * FF_EBUR128_TP_TAPS]
+    int tp_pos;
+
+    FFEBUR128DSPContext dsp;
+} FFEBUR128Context;
+
+void ff_ebur128_dsp_init(FFEBUR128DSPContext *dsp);
+void ff_ebur128_dsp_init_x86(FFEBUR128DSPContext *dsp);
+
+/**
+ * Set up the measurement of interleaved double audio.
+ *
+ * The channels are weighted from channel_layout as BS.1770 asks for: low
+ * frequency channels are ignored and surround channels are weighted by
+ * 1.41. All channels are weighted by 1 if the layout is unknown.
+ *
+ * @param ctx   filter whose slice threads process the channels, or NULL
+ * @param flags a combination of FFEBUR128Flags
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int ff_ebur128_init(FFEBUR128Context *s, AVFilterContext *ctx,
+                    uint64_t channel_layout, int nb_channels,
+                    int sample_rate, int flags);
+
+/**
+ * Measure up to nb_samples frames, stopping at the end of a 100 ms block.
+ * The loudness values are updated when a block completes, which is the
+ * case when block_pos is 0 after the call.
+ *
+ * @return the number of frames consumed
+ */
+int ff_ebur128_feed(FFEBUR128Context *s, const double *src, int nb_samples);
+
+/**
+ * Measure nb_samples frames.
+ */
+void ff_ebur128_add_frames(FFEBUR128Context *s, const double *src, int nb_samples);
+
+/**
+ * Get the integrated loudness, or -HUGE_VAL if no block passed the
+ * absolute gate.
+ */
+double ff_ebur128_loudness_global(FFEBUR128Context *s);
+
+/**
+ * Get the relative gate of the integrated loudness, or the absolute gate if
+ * no block passed it.
+ */
+double ff_ebur128_relative_threshold(FFEBUR128Context *s);
+
+/**
+ * Get the loudness range and the lower and upper loudness it spans. All
+ * three are 0 while no short-term block passed the absolute gate.
+ *
+ * @param low  lower loudness, may be NULL
+ * @param high upper loudness, may be NULL
+ */
+void ff_ebur128_loudness_range(FFEBUR128Context *s, double *lra,
+                               double *low, double *high);
+
+/**
+ * Get the relative gate of the loudness range, or the absolute gate if no
+ * block passed it.
+ */
+double ff_ebur128_range_threshold(FFEBUR128Context *s);
+
+void ff_ebur128_uninit(FFEBUR128Context *s);
+
+#endif /* AVFILTER_EBUR128_H */
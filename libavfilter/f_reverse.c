@@ -18,7 +18,22 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_IO_H
+#include <io.h>
+#endif
+
+#include "libavutil/file.h"
+#include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
+#include "libavutil/samplefmt.h"
+#include "audio.h"
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
@@ -27,18 +42,38 @@
 #define DEFAULT_LENGTH 300
 
 typedef struct ReverseContext {
+    const AVClass *class;
     int nb_frames;
     AVFrame **frames;
     unsigned int frames_size;
     unsigned int pts_size;
     int64_t *pts;
     int flush_idx;
+
+    int64_t memory_limit;   ///< frame data kept in memory, 0 for no limit
+    int64_t memory_used;
+
+    /* Once memory_limit is exceeded, the data of the oldest frames is moved
+     * to a temporary file, only their properties are kept in frames[].
+     * Frames are output last first, so the spilled ones are read back from
+     * the end of the file towards its start. */
+    int nb_spilled;         ///< number of frames at the start of frames[] with spilled data
+    int64_t *spill_offsets; ///< file offset of each spilled frame, plus the end of file
+    unsigned int spill_offsets_size;
+    int spill_fd;
+    char *spill_filename;
+    uint8_t *spill_buf;
+    unsigned int spill_buf_size;
 } ReverseContext;
 
+#define OFFSET(x) offsetof(ReverseContext, x)
+
 static av_cold int init(AVFilterContext *ctx)
 {
     ReverseContext *s = ctx->priv;
 
+    s->spill_fd = -1;
+
     s->pts = av_fast_realloc(NULL, &s->pts_size,
                              DEFAULT_LENGTH * sizeof(*(s->pts)));
     if (!s->pts)
@@ -58,10 +93,215 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     ReverseContext *s = ctx->priv;
 
+    while (s->nb_frames > 0)
+        av_frame_free(&s->frames[--s->nb_frames]);
+
+    if (s->spill_fd >= 0) {
+        close(s->spill_fd);
+        if (s->spill_filename)
+            unlink(s->spill_filename);
+    }
+    av_freep(&s->spill_filename);
+    av_freep(&s->spill_offsets);
+    av_freep(&s->spill_buf);
     av_freep(&s->pts);
     av_freep(&s->frames);
 }
 
+static int64_t frame_data_size(const AVFrame *frame)
+{
+    int64_t size = 0;
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(frame->buf) && frame->buf[i]; i++)
+        size += frame->buf[i]->size;
+    for (i = 0; i < frame->nb_extended_buf; i++)
+        size += frame->extended_buf[i]->size;
+
+    return size;
+}
+
+static int spill_io(AVFilterContext *ctx, uint8_t *data, int size, int write_data)
+{
+    ReverseContext *s = ctx->priv;
+
+    while (size > 0) {
+        int ret = write_data ? write(s->spill_fd, data, size)
+                             : read(s->spill_fd, data, size);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0) {
+            ret = ret < 0 ? AVERROR(errno) : AVERROR(EIO);
+            av_log(ctx, AV_LOG_ERROR, "Error %s temporary file.\n",
+                   write_data ? "writing" : "reading");
+            return ret;
+        }
+        data += ret;
+        size -= ret;
+    }
+
+    return 0;
+}
+
+/**
+ * Get the size of the raw data of a frame, and for audio the size of
+ * each of its planes.
+ */
+static int frame_raw_size(const AVFrame *frame, enum AVMediaType type,
+                          int *nb_planes, int *plane_size)
+{
+    if (type == AVMEDIA_TYPE_VIDEO) {
+        *nb_planes  = 1;
+        *plane_size = av_image_get_buffer_size(frame->format, frame->width,
+                                               frame->height, 1);
+    } else {
+        int planar  = av_sample_fmt_is_planar(frame->format);
+        *nb_planes  = planar ? frame->channels : 1;
+        *plane_size = frame->nb_samples * (planar ? 1 : frame->channels) *
+                      av_get_bytes_per_sample(frame->format);
+    }
+    return *plane_size;
+}
+
+/**
+ * Move the data of the oldest frame still in memory to the temporary file,
+ * keeping only its properties.
+ */
+static int spill_frame(AVFilterContext *ctx, enum AVMediaType type)
+{
+    ReverseContext *s = ctx->priv;
+    AVFrame *frame = s->frames[s->nb_spilled], *props;
+    int nb_planes, plane_size, p, ret;
+    void *ptr;
+
+    if (s->spill_fd < 0) {
+        s->spill_fd = av_tempfile("ffreverse", &s->spill_filename, 0, ctx);
+        if (s->spill_fd < 0)
+            return s->spill_fd;
+        av_log(ctx, AV_LOG_VERBOSE, "Spilling frames to %s.\n", s->spill_filename);
+        /* Remove it right away where open files can be unlinked, so that
+         * it does not outlive the process. */
+        if (!unlink(s->spill_filename))
+            av_freep(&s->spill_filename);
+    }
+
+    ptr = av_fast_realloc(s->spill_offsets, &s->spill_offsets_size,
+                          (s->nb_spilled + 2) * sizeof(*s->spill_offsets));
+    if (!ptr)
+        return AVERROR(ENOMEM);
+    s->spill_offsets = ptr;
+    if (!s->nb_spilled)
+        s->spill_offsets[0] = 0;
+
+    if ((ret = frame_raw_size(frame, type, &nb_planes, &plane_size)) < 0)
+        return ret;
+
+    props = av_frame_alloc();
+    if (!props)
+        return AVERROR(ENOMEM);
+    if ((ret = av_frame_copy_props(props, frame)) < 0)
+        goto fail;
+    props->format         = frame->format;
+    props->width          = frame->width;
+    props->height         = frame->height;
+    props->nb_samples     = frame->nb_samples;
+    props->channels       = frame->channels;
+    props->channel_layout = frame->channel_layout;
+
+    if (type == AVMEDIA_TYPE_VIDEO) {
+        av_fast_malloc(&s->spill_buf, &s->spill_buf_size, plane_size);
+        if (!s->spill_buf) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        ret = av_image_copy_to_buffer(s->spill_buf, plane_size,
+                                      (const uint8_t * const *)frame->data,
+                                      frame->linesize, frame->format,
+                                      frame->width, frame->height, 1);
+        if (ret >= 0)
+            ret = spill_io(ctx, s->spill_buf, plane_size, 1);
+    } else {
+        for (p = 0, ret = 0; p < nb_planes && ret >= 0; p++)
+            ret = spill_io(ctx, frame->extended_data[p], plane_size, 1);
+    }
+    if (ret < 0)
+        goto fail;
+
+    s->spill_offsets[s->nb_spilled + 1] = s->spill_offsets[s->nb_spilled] +
+                                          (int64_t)nb_planes * plane_size;
+    s->memory_used -= frame_data_size(frame);
+    av_frame_free(&frame);
+    s->frames[s->nb_spilled++] = props;
+    return 0;
+
+fail:
+    av_frame_free(&props);
+    return ret;
+}
+
+/**
+ * Get the last buffered frame, reading its data back from the temporary
+ * file if it was spilled.
+ */
+static int get_last_frame(AVFilterLink *outlink, AVFrame **pout)
+{
+    AVFilterContext *ctx = outlink->src;
+    ReverseContext *s = ctx->priv;
+    int idx = s->nb_frames - 1;
+    AVFrame *props = s->frames[idx], *out;
+    int nb_planes, plane_size, p, ret;
+
+    if (idx >= s->nb_spilled) {
+        s->memory_used -= frame_data_size(props);
+        *pout = props;
+        return 0;
+    }
+
+    frame_raw_size(props, outlink->type, &nb_planes, &plane_size);
+    out = outlink->type == AVMEDIA_TYPE_VIDEO ?
+          ff_get_video_buffer(outlink, props->width, props->height) :
+          ff_get_audio_buffer(outlink, props->nb_samples);
+    if (!out)
+        return AVERROR(ENOMEM);
+    if ((ret = av_frame_copy_props(out, props)) < 0)
+        goto fail;
+
+    if (lseek(s->spill_fd, s->spill_offsets[idx], SEEK_SET) < 0) {
+        ret = AVERROR(errno);
+        goto fail;
+    }
+
+    if (outlink->type == AVMEDIA_TYPE_VIDEO) {
+        uint8_t *data[4];
+        int linesize[4];
+
+        av_fast_malloc(&s->spill_buf, &s->spill_buf_size, plane_size);
+        if (!s->spill_buf) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        if ((ret = spill_io(ctx, s->spill_buf, plane_size, 0)) < 0)
+            goto fail;
+        av_image_fill_arrays(data, linesize, s->spill_buf, props->format,
+                             props->width, props->height, 1);
+        av_image_copy(out->data, out->linesize, (const uint8_t **)data, linesize,
+                      props->format, props->width, props->height);
+    } else {
+        for (p = 0; p < nb_planes; p++)
+            if ((ret = spill_io(ctx, out->extended_data[p], plane_size, 0)) < 0)
+                goto fail;
+    }
+
+    av_frame_free(&s->frames[idx]);
+    s->nb_spilled--;
+    *pout = out;
+    return 0;
+
+fail:
+    av_frame_free(&out);
+    return ret;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -86,6 +326,14 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     s->pts[s->nb_frames]    = in->pts;
     s->nb_frames++;
 
+    s->memory_used += frame_data_size(in);
+    while (s->memory_limit && s->memory_used > s->memory_limit &&
+           s->nb_spilled < s->nb_frames) {
+        int ret = spill_frame(ctx, inlink->type);
+        if (ret < 0)
+            return ret;
+    }
+
     return 0;
 }
 
@@ -100,15 +348,25 @@ static int request_frame(AVFilterLink *outlink)
     ret = ff_request_frame(ctx->inputs[0]);
 
     if (ret == AVERROR_EOF && s->nb_frames > 0) {
-        AVFrame *out = s->frames[s->nb_frames - 1];
+        AVFrame *out;
+
+        if ((ret = get_last_frame(outlink, &out)) < 0)
+            return ret;
+        s->nb_frames--;
         out->pts     = s->pts[s->flush_idx++];
         ret          = ff_filter_frame(outlink, out);
-        s->nb_frames--;
     }
 
     return ret;
 }
 
+static const AVOption reverse_options[] = {
+    { "memory_limit", "set the amount of frame data kept in memory, 0 for no limit", OFFSET(memory_limit), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_FILTERING_PARAM },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(reverse);
+
 static const AVFilterPad reverse_inputs[] = {
     {
         .name         = "default",
@@ -131,6 +389,7 @@ AVFilter ff_vf_reverse = {
     .name        = "reverse",
     .description = NULL_IF_CONFIG_SMALL("Reverse a clip."),
     .priv_size   = sizeof(ReverseContext),
+    .priv_class  = &reverse_class,
     .init        = init,
     .uninit      = uninit,
     .inputs      = reverse_inputs,
@@ -173,7 +432,11 @@ static int areverse_request_frame(AVFilterLink *outlink)
     ret = ff_request_frame(ctx->inputs[0]);
 
     if (ret == AVERROR_EOF && s->nb_frames > 0) {
-        AVFrame *out = s->frames[s->nb_frames - 1];
+        AVFrame *out;
+
+        if ((ret = get_last_frame(outlink, &out)) < 0)
+            return ret;
+        s->nb_frames--;
         out->pts     = s->pts[s->flush_idx++];
 
         for (p = 0; p < outlink->channels; p++) {
@@ -212,12 +475,18 @@ static int areverse_request_frame(AVFilterLink *outlink)
         }
 
         ret = ff_filter_frame(outlink, out);
-        s->nb_frames--;
     }
 
     return ret;
 }
 
+static const AVOption areverse_options[] = {
+    { "memory_limit", "set the amount of frame data kept in memory, 0 for no limit", OFFSET(memory_limit), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, AV_OPT_FLAG_AUDIO_PARAM | AV_OPT_FLAG_FILTERING_PARAM },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(areverse);
+
 static const AVFilterPad areverse_inputs[] = {
     {
         .name           = "default",
@@ -242,6 +511,7 @@ AVFilter ff_af_areverse = {
     .description   = NULL_IF_CONFIG_SMALL("Reverse an audio clip."),
     .query_formats = query_formats,
     .priv_size     = sizeof(ReverseContext),
+    .priv_class    = &areverse_class,
     .init          = init,
     .uninit        = uninit,
     .inputs        = areverse_inputs,
@@ -0,0 +1,150 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Run the filters leading to the filter in their own thread, buffering
+ * their output.
+ *
+ * The work is done by the graph pipeline, which recognizes these filters by
+ * FF_PAD_PIPELINE_QUEUE and takes the limits of the buffer from
+ * AVFilterInternal. The filters themselves only pass frames through.
+ */
+
+#include <inttypes.h>
+
+#include "libavutil/opt.h"
+
+#include "avfilter.h"
+#include "internal.h"
+#include "pipeline.h"
+
+typedef struct ThreadQueueContext {
+    const AVClass *class;
+    int frames;
+    int64_t bytes;
+    int metadata;
+} ThreadQueueContext;
+
+static void set_meta(AVDictionary **metadata, const char *key, int64_t value)
+{
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%"PRId64, value);
+    av_dict_set(metadata, key, buf, 0);
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    ThreadQueueContext *s = ctx->priv;
+
+    ctx->internal->queue_frames = s->frames;
+    ctx->internal->queue_bytes  = s->bytes;
+    return 0;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx = inlink->dst;
+    ThreadQueueContext *s = ctx->priv;
+    FFPipelineStats stats;
+
+    if (s->metadata && ff_filter_pipeline_get_stats(ctx, &stats) >= 0) {
+        AVDictionary **metadata = avpriv_frame_get_metadatap(frame);
+
+        set_meta(metadata, "lavfi.threadqueue.frames", stats.nb_frames);
+        set_meta(metadata, "lavfi.threadqueue.bytes",  stats.nb_bytes);
+        set_meta(metadata, "lavfi.threadqueue.waits",  stats.nb_waits);
+    }
+    return ff_filter_frame(ctx->outputs[0], frame);
+}
+
+#define OFFSET(x) offsetof(ThreadQueueContext, x)
+#define FLAGS AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_AUDIO_PARAM | AV_OPT_FLAG_FILTERING_PARAM
+static const AVOption options[] = {
+    { "frames",   "maximum number of buffered output frames", OFFSET(frames), AV_OPT_TYPE_INT, { .i64 = 8 }, 1, 1024, FLAGS },
+    { "bytes",    "maximum size of the buffered output frames, 0 for no limit", OFFSET(bytes), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, FLAGS },
+    { "metadata", "export the state of the queue as frame metadata", OFFSET(metadata), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, FLAGS },
+    { NULL }
+};
+
+#if CONFIG_THREADQUEUE_FILTER
+#define threadqueue_options options
+AVFILTER_DEFINE_CLASS(threadqueue);
+
+static const AVFilterPad threadqueue_inputs[] = {
+    {
+        .name         = "default",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .filter_frame = filter_frame,
+        .pipeline     = FF_PAD_PIPELINE | FF_PAD_PIPELINE_QUEUE,
+    },
+    { NULL }
+};
+
+static const AVFilterPad threadqueue_outputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_VIDEO,
+    },
+    { NULL }
+};
+
+AVFilter ff_vf_threadqueue = {
+    .name        = "threadqueue",
+    .description = NULL_IF_CONFIG_SMALL("Run the preceding filters in their own thread."),
+    .priv_size   = sizeof(ThreadQueueContext),
+    .priv_class  = &threadqueue_class,
+    .init        = init,
+    .inputs      = threadqueue_inputs,
+    .outputs     = threadqueue_outputs,
+};
+#endif /* CONFIG_THREADQUEUE_FILTER */
+
+#if CONFIG_ATHREADQUEUE_FILTER
+#define athreadqueue_options options
+AVFILTER_DEFINE_CLASS(athreadqueue);
+
+static const AVFilterPad athreadqueue_inputs[] = {
+    {
+        .name         = "default",
+        .type         = AVMEDIA_TYPE_AUDIO,
+        .filter_frame = filter_frame,
+        .pipeline     = FF_PAD_PIPELINE | FF_PAD_PIPELINE_QUEUE,
+    },
+    { NULL }
+};
+
+static const AVFilterPad athreadqueue_outputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_AUDIO,
+    },
+    { NULL }
+};
+
+AVFilter ff_af_athreadqueue = {
+    .name        = "athreadqueue",
+    .description = NULL_IF_CONFIG_SMALL("Run the preceding filters in their own thread."),
+    .priv_size   = sizeof(ThreadQueueContext),
+    .priv_class  = &athreadqueue_class,
+    .init        = init,
+    .inputs      = athreadqueue_inputs,
+    .outputs     = athreadqueue_outputs,
+};
+#endif /* CONFIG_ATHREADQUEUE_FILTER */
@@ -54,77 +54,100 @@ do {                                                                       \
     av_freep(&a);                                                          \
 } while (0)
 
+/* large enough for a bitset of all pixel or sample formats */
+#define FORMAT_SET_WORDS ((FFMAX(AV_PIX_FMT_NB, AV_SAMPLE_FMT_NB) + 63) >> 6)
+
 /**
- * Add all formats common for a and b to ret, copy the refs and destroy
- * a and b.
+ * Return the upper bound of the values a formats list of the given kind
+ * may hold, or 0 if it is unbounded (sample rates).
  */
-#define MERGE_FORMATS(ret, a, b, fmts, nb, type, fail)                          \
-do {                                                                            \
-    int i, j, k = 0, count = FFMIN(a->nb, b->nb);                               \
-                                                                                \
-    if (!(ret = av_mallocz(sizeof(*ret))))                                      \
-        goto fail;                                                              \
-                                                                                \
-    if (count) {                                                                \
-        if (!(ret->fmts = av_malloc_array(count, sizeof(*ret->fmts))))          \
-            goto fail;                                                          \
-        for (i = 0; i < a->nb; i++)                                             \
-            for (j = 0; j < b->nb; j++)                                         \
-                if (a->fmts[i] == b->fmts[j]) {                                 \
-                    if(k >= FFMIN(a->nb, b->nb)){                               \
-                        av_log(NULL, AV_LOG_ERROR, "Duplicate formats in avfilter_merge_formats() detected\n"); \
-                        av_free(ret->fmts);                                     \
-                        av_free(ret);                                           \
-                        return NULL;                                            \
-                    }                                                           \
-                    ret->fmts[k++] = a->fmts[i];                                \
-                }                                                               \
-    }                                                                           \
-    ret->nb = k;                                                                \
-    /* check that there was at least one common format */                       \
-    if (!ret->nb)                                                               \
-        goto fail;                                                              \
-                                                                                \
-    MERGE_REF(ret, a, fmts, type, fail);                                        \
-    MERGE_REF(ret, b, fmts, type, fail);                                        \
-} while (0)
+static int format_limit(enum AVMediaType type, int is_sample_rate)
+{
+    if (is_sample_rate)
+        return 0;
+    return type == AVMEDIA_TYPE_VIDEO ? AV_PIX_FMT_NB :
+           type == AVMEDIA_TYPE_AUDIO ? AV_SAMPLE_FMT_NB : 0;
+}
 
-AVFilterFormats *ff_merge_formats(AVFilterFormats *a, AVFilterFormats *b,
-                                  enum AVMediaType type)
+/**
+ * Fill set with the formats of f.
+ * @return 0 if some format is not below limit and the set is unusable
+ */
+static int format_set_fill(uint64_t *set, const AVFilterFormats *f, int limit)
 {
-    AVFilterFormats *ret = NULL;
-    int i, j;
-    int alpha1=0, alpha2=0;
-    int chroma1=0, chroma2=0;
+    int i;
+
+    if (limit <= 0)
+        return 0;
+    memset(set, 0, FORMAT_SET_WORDS * sizeof(*set));
+    for (i = 0; i < f->nb_formats; i++) {
+        unsigned fmt = f->formats[i];
+        if (fmt >= limit)
+            return 0;
+        set[fmt >> 6] |= 1ULL << (fmt & 63);
+    }
+    return 1;
+}
 
-    if (a == b)
-        return a;
+static int format_set_has(const uint64_t *set, int limit, int fmt)
+{
+    return (unsigned)fmt < limit && (set[fmt >> 6] >> (fmt & 63) & 1);
+}
 
-    /* Do not lose chroma or alpha in merging.
-       It happens if both lists have formats with chroma (resp. alpha), but
-       the only formats in common do not have it (e.g. YUV+gray vs.
-       RGB+gray): in that case, the merging would select the gray format,
-       possibly causing a lossy conversion elsewhere in the graph.
-       To avoid that, pretend that there are no common formats to force the
-       insertion of a conversion filter. */
-    if (type == AVMEDIA_TYPE_VIDEO)
-        for (i = 0; i < a->nb_formats; i++)
-            for (j = 0; j < b->nb_formats; j++) {
-                const AVPixFmtDescriptor *adesc = av_pix_fmt_desc_get(a->formats[i]);
-                const AVPixFmtDescriptor *bdesc = av_pix_fmt_desc_get(b->formats[j]);
-                alpha2 |= adesc->flags & bdesc->flags & AV_PIX_FMT_FLAG_ALPHA;
-                chroma2|= adesc->nb_components > 1 && bdesc->nb_components > 1;
-                if (a->formats[i] == b->formats[j]) {
-                    alpha1 |= adesc->flags & AV_PIX_FMT_FLAG_ALPHA;
-                    chroma1|= adesc->nb_components > 1;
-                }
-            }
+/**
+ * Store the formats of a which are also in b into dst, in the order of a,
+ * and return their number; dst may be NULL to only count them.
+ * Pixel and sample formats are looked up in a bitset, which keeps merging
+ * linear in the size of the lists.
+ */
+static int intersect_formats(const AVFilterFormats *a, const AVFilterFormats *b,
+                             int limit, int *dst)
+{
+    uint64_t set[FORMAT_SET_WORDS];
+    int use_set = format_set_fill(set, b, limit);
+    int i, j, nb = 0;
 
-    // If chroma or alpha can be lost through merging then do not merge
-    if (alpha2 > alpha1 || chroma2 > chroma1)
-        return NULL;
+    for (i = 0; i < a->nb_formats; i++) {
+        int fmt = a->formats[i];
 
-    MERGE_FORMATS(ret, a, b, formats, nb_formats, AVFilterFormats, fail);
+        if (use_set) {
+            if (!format_set_has(set, limit, fmt))
+                continue;
+            /* ignore duplicates in a */
+            set[fmt >> 6] &= ~(1ULL << (fmt & 63));
+        } else {
+            for (j = 0; j < b->nb_formats && b->formats[j] != fmt; j++)
+                ;
+            if (j == b->nb_formats)
+                continue;
+        }
+        if (dst)
+            dst[nb] = fmt;
+        nb++;
+    }
+    return nb;
+}
+
+/**
+ * Return a list of the formats common to a and b, copy the refs and
+ * destroy a and b.
+ */
+static AVFilterFormats *merge_formats(AVFilterFormats *a, AVFilterFormats *b,
+                                      int limit)
+{
+    AVFilterFormats *ret = av_mallocz(sizeof(*ret));
+
+    if (!ret || !a->nb_formats)
+        goto fail;
+    if (!(ret->formats = av_malloc_array(a->nb_formats, sizeof(*ret->formats))))
+        goto fail;
+    ret->nb_formats = intersect_formats(a, b, limit, ret->formats);
+    /* check that there was at least one common format */
+    if (!ret->nb_formats)
+        goto fail;
+
+    MERGE_REF(ret, a, formats, AVFilterFormats, fail);
+    MERGE_REF(ret, b, formats, AVFilterFormats, fail);
 
     return ret;
 fail:
@@ -136,6 +159,69 @@ fail:
     return NULL;
 }
 
+#define FLAG_ALPHA  1
+#define FLAG_CHROMA 2
+
+static int pix_fmt_merge_flags(int fmt)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(fmt);
+
+    if (!desc)
+        return 0;
+    return (desc->flags & AV_PIX_FMT_FLAG_ALPHA ? FLAG_ALPHA  : 0) |
+           (desc->nb_components > 1             ? FLAG_CHROMA : 0);
+}
+
+/**
+ * Do not lose chroma or alpha in merging.
+ * It happens if both lists have formats with chroma (resp. alpha), but
+ * the only formats in common do not have it (e.g. YUV+gray vs.
+ * RGB+gray): in that case, the merging would select the gray format,
+ * possibly causing a lossy conversion elsewhere in the graph.
+ * To avoid that, pretend that there are no common formats to force the
+ * insertion of a conversion filter.
+ *
+ * @return 1 if the merge of the pixel formats lists a and b is allowed
+ */
+static int pix_fmts_mergeable(const AVFilterFormats *a, const AVFilterFormats *b)
+{
+    uint64_t set[FORMAT_SET_WORDS];
+    int use_set = format_set_fill(set, b, AV_PIX_FMT_NB);
+    int flags_a = 0, flags_b = 0, flags_common = 0;
+    int i, j;
+
+    for (j = 0; j < b->nb_formats; j++)
+        flags_b |= pix_fmt_merge_flags(b->formats[j]);
+    for (i = 0; i < a->nb_formats; i++) {
+        int fmt   = a->formats[i];
+        int flags = pix_fmt_merge_flags(fmt);
+
+        flags_a |= flags;
+        if (use_set) {
+            if (format_set_has(set, AV_PIX_FMT_NB, fmt))
+                flags_common |= flags;
+        } else {
+            for (j = 0; j < b->nb_formats; j++)
+                if (b->formats[j] == fmt)
+                    flags_common |= flags;
+        }
+    }
+
+    return !(flags_a & flags_b & ~flags_common);
+}
+
+AVFilterFormats *ff_merge_formats(AVFilterFormats *a, AVFilterFormats *b,
+                                  enum AVMediaType type)
+{
+    if (a == b)
+        return a;
+
+    if (type == AVMEDIA_TYPE_VIDEO && !pix_fmts_mergeable(a, b))
+        return NULL;
+
+    return merge_formats(a, b, format_limit(type, 0));
+}
+
 AVFilterFormats *ff_merge_samplerates(AVFilterFormats *a,
                                       AVFilterFormats *b)
 {
@@ -144,7 +230,7 @@ AVFilterFormats *ff_merge_samplerates(AVFilterFormats *a,
     if (a == b) return a;
 
     if (a->nb_formats && b->nb_formats) {
-        MERGE_FORMATS(ret, a, b, formats, nb_formats, AVFilterFormats, fail);
+        return merge_formats(a, b, format_limit(AVMEDIA_TYPE_AUDIO, 1));
     } else if (a->nb_formats) {
         MERGE_REF(a, b, formats, AVFilterFormats, fail);
         ret = a;
@@ -155,14 +241,26 @@ AVFilterFormats *ff_merge_samplerates(AVFilterFormats *a,
 
     return ret;
 fail:
-    if (ret) {
-        av_freep(&ret->refs);
-        av_freep(&ret->formats);
-    }
-    av_freep(&ret);
     return NULL;
 }
 
+int ff_can_merge_formats(const AVFilterFormats *a, const AVFilterFormats *b,
+                         enum AVMediaType type)
+{
+    if (a == b)
+        return 1;
+    if (type == AVMEDIA_TYPE_VIDEO && !pix_fmts_mergeable(a, b))
+        return 0;
+    return intersect_formats(a, b, format_limit(type, 0), NULL) > 0;
+}
+
+int ff_can_merge_samplerates(const AVFilterFormats *a, const AVFilterFormats *b)
+{
+    if (a == b || !a->nb_formats || !b->nb_formats)
+        return 1;
+    return intersect_formats(a, b, format_limit(AVMEDIA_TYPE_AUDIO, 1), NULL) > 0;
+}
+
 AVFilterChannelLayouts *ff_merge_channel_layouts(AVFilterChannelLayouts *a,
                                                  AVFilterChannelLayouts *b)
 {
@@ -349,22 +447,31 @@ int ff_add_channel_layout(AVFilterChannelLayouts **l, uint64_t channel_layout)
 
 AVFilterFormats *ff_all_formats(enum AVMediaType type)
 {
-    AVFilterFormats *ret = NULL;
+    AVFilterFormats *ret;
+    int nb = 0;
+
+    if (type != AVMEDIA_TYPE_VIDEO && type != AVMEDIA_TYPE_AUDIO)
+        return NULL;
+
+    /* allocate the list once instead of growing it format by format */
+    if (!(ret = av_mallocz(sizeof(*ret))))
+        return NULL;
+    ret->formats = av_malloc_array(format_limit(type, 0), sizeof(*ret->formats));
+    if (!ret->formats) {
+        av_freep(&ret);
+        return NULL;
+    }
 
     if (type == AVMEDIA_TYPE_VIDEO) {
         const AVPixFmtDescriptor *desc = NULL;
-        while ((desc = av_pix_fmt_desc_next(desc))) {
-            if (ff_add_format(&ret, av_pix_fmt_desc_get_id(desc)) < 0)
-                return NULL;
-        }
-    } else if (type == AVMEDIA_TYPE_AUDIO) {
+        while ((desc = av_pix_fmt_desc_next(desc)) && nb < AV_PIX_FMT_NB)
+            ret->formats[nb++] = av_pix_fmt_desc_get_id(desc);
+    } else {
         enum AVSampleFormat fmt = 0;
-        while (av_get_sample_fmt_name(fmt)) {
-            if (ff_add_format(&ret, fmt) < 0)
-                return NULL;
-            fmt++;
-        }
+        while (av_get_sample_fmt_name(fmt) && nb < AV_SAMPLE_FMT_NB)
+            ret->formats[nb++] = fmt++;
     }
+    ret->nb_formats = nb;
 
     return ret;
 }
@@ -41,11 +41,14 @@ FFVideoFramePool *ff_video_frame_pool_init(AVBufferRef* (*alloc)(int size),
                                            int width,
                                            int height,
                                            enum AVPixelFormat format,
-                                           int align)
+                                           int align,
+                                           int shared)
 {
     int i, ret;
     FFVideoFramePool *pool;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+    AVBufferPool *(*pool_init)(int size, AVBufferRef *(*alloc)(int size)) =
+        shared ? av_buffer_pool_init_shared : av_buffer_pool_init;
 
     if (!desc)
         return NULL;
@@ -84,15 +87,15 @@ FFVideoFramePool *ff_video_frame_pool_init(AVBufferRef* (*alloc)(int size),
         if (i == 1 || i == 2)
             h = AV_CEIL_RSHIFT(h, desc->log2_chroma_h);
 
-        pool->pools[i] = av_buffer_pool_init(pool->linesize[i] * h + 16 + 16 - 1,
-                                             alloc);
+        pool->pools[i] = pool_init(pool->linesize[i] * h + 16 + 16 - 1,
+                                   alloc);
         if (!pool->pools[i])
             goto fail;
     }
 
     if (desc->flags & AV_PIX_FMT_FLAG_PAL ||
         desc->flags & AV_PIX_FMT_FLAG_PSEUDOPAL) {
-        pool->pools[1] = av_buffer_pool_init(AVPALETTE_SIZE, alloc);
+        pool->pools[1] = pool_init(AVPALETTE_SIZE, alloc);
         if (!pool->pools[1])
             goto fail;
     }
@@ -41,13 +41,16 @@ typedef struct FFVideoFramePool FFVideoFramePool;
  * @param height height of each frame in this pool
  * @param format format of each frame in this pool
  * @param align buffers alignement of each frame in this pool
+ * @param shared allocate the buffers from the pools shared by the whole
+ * process (see av_buffer_pool_init_shared()) if not 0
  * @return newly created video frame pool on success, NULL on error.
  */
 FFVideoFramePool *ff_video_frame_pool_init(AVBufferRef* (*alloc)(int size),
                                            int width,
                                            int height,
                                            enum AVPixelFormat format,
-                                           int align);
+                                           int align,
+                                           int shared);
 
 /**
  * Deallocate the video frame pool. It is safe to call this function while
@@ -142,15 +142,45 @@ struct AVFilterPad {
      * input pads only.
      */
     int needs_writable;
+
+    /**
+     * A combination of FF_PAD_PIPELINE* flags, describing how the filter
+     * may be run by a pipeline worker.
+     *
+     * input pads only, of filters with one input and one output.
+     */
+    int pipeline;
 };
 
+/**
+ * The filter can be run by a pipeline worker (see pipeline.h): it does not
+ * end its input from filter_frame() and does not call back into the graph.
+ */
+#define FF_PAD_PIPELINE (1 << 0)
+
+/**
+ * The filter is a pipeline queue: the chain of filters leading to it is run
+ * by a stage of its own, and up to AVFilterInternal.queue_frames frames or
+ * queue_bytes bytes of its output are buffered for the filters after it.
+ */
+#define FF_PAD_PIPELINE_QUEUE (1 << 1)
+
 struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
+    struct FFFilterPipeline *pipeline;
 };
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+    /**
+     * Slice threads used by execute instead of those of the graph, so that
+     * the filters run by different threads do not share them.
+     */
+    void *thread;
+    struct FFPipelineStage *pipeline;
+    int queue_frames;           ///< output limits of a pipeline queue filter,
+    int64_t queue_bytes;        ///< set by its init callback
 };
 
 /**
@@ -366,6 +396,12 @@ int ff_request_frame_to_filter(AVFilterLink *link);
  */
 int ff_filter_frame(AVFilterLink *link, AVFrame *frame);
 
+/**
+ * Pass a frame to the destination filter of the link, skipping the checks
+ * of ff_filter_frame() and leaving frame_wanted_out untouched.
+ */
+int ff_filter_frame_to_filter(AVFilterLink *link, AVFrame *frame);
+
 /**
  * Allocate a new filter context and return it.
  *
@@ -0,0 +1,201 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/avassert.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "partconv.h"
+
+#define PART_BITS_MIN 3
+#define PART_BITS_MAX 15
+
+static void fcmul_add_c(float *sum, const float *t, const float *c, ptrdiff_t len)
+{
+    int k;
+
+    for (k = 0; k < len; k += 2) {
+        sum[k    ] += t[k] * c[k    ] - t[k + 1] * c[k + 1];
+        sum[k + 1] += t[k] * c[k + 1] + t[k + 1] * c[k    ];
+    }
+}
+
+av_cold void ff_partconv_dsp_init(PartConvDSPContext *dsp)
+{
+    dsp->fcmul_add = fcmul_add_c;
+
+    if (ARCH_X86)
+        ff_partconv_dsp_init_x86(dsp);
+}
+
+/* the first two values of a packed real spectrum are the real dc and
+ * nyquist bins, not a complex value */
+static void rdft_mul_add(PartConvContext *s, float *sum, const float *t, const float *c)
+{
+    float dc      = sum[0] + t[0] * c[0];
+    float nyquist = sum[1] + t[1] * c[1];
+
+    s->dsp.fcmul_add(sum, t, c, s->fft_len);
+    sum[0] = dc;
+    sum[1] = nyquist;
+}
+
+av_cold int ff_partconv_part_size(int ir_len)
+{
+    int len = 1 << av_ceil_log2(FFMAX(ir_len, 1));
+
+    /* one partition for short responses; long ones get up to 16 partitions
+     * of at least 1024 taps so the transforms stay short */
+    return av_clip(FFMAX(len >> 4, FFMIN(len, 1024)), 1 << PART_BITS_MIN, 1 << PART_BITS_MAX);
+}
+
+av_cold int ff_partconv_init(PartConvContext *s, int part_size, int ir_len, int nb_inputs)
+{
+    int bits = av_log2(part_size);
+    int n;
+
+    av_assert0(part_size == 1 << bits && bits >= PART_BITS_MIN && bits <= PART_BITS_MAX);
+
+    ff_partconv_uninit(s);
+
+    s->part_size = part_size;
+    s->fft_len   = 2 * part_size;
+    s->nb_parts  = FFMAX((ir_len + part_size - 1) / part_size, 1);
+    s->nb_inputs = nb_inputs;
+    s->pos       = 0;
+    s->fdl_idx   = 0;
+
+    n = nb_inputs * s->nb_parts * s->fft_len;
+    s->coeffs = av_calloc(n, sizeof(*s->coeffs));
+    s->fdl    = av_calloc(n, sizeof(*s->fdl));
+    s->block  = av_calloc(nb_inputs * s->fft_len, sizeof(*s->block));
+    s->sum    = av_calloc(s->fft_len, sizeof(*s->sum));
+    s->spec   = av_calloc(s->fft_len, sizeof(*s->spec));
+    s->out    = av_calloc(s->fft_len, sizeof(*s->out));
+    s->tail   = av_calloc(part_size, sizeof(*s->tail));
+    if (!s->coeffs || !s->fdl || !s->block || !s->sum || !s->spec || !s->out || !s->tail)
+        return AVERROR(ENOMEM);
+
+    if (!(s->rdft = av_rdft_init(bits + 1, DFT_R2C)) || !(s->irdft = av_rdft_init(bits + 1, IDFT_C2R)))
+        return AVERROR(ENOMEM);
+
+    ff_partconv_dsp_init(&s->dsp);
+
+    return 0;
+}
+
+void ff_partconv_set_ir(PartConvContext *s, int input, const float *ir, int len)
+{
+    /* the inverse transform scales by fft_len / 2 */
+    const float scale = 2.0f / s->fft_len;
+    float *coeffs = s->coeffs + input * s->nb_parts * s->fft_len;
+    int p, k;
+
+    av_assert1(len <= s->nb_parts * s->part_size);
+
+    for (p = 0; p < s->nb_parts; p++) {
+        float *c = coeffs + p * s->fft_len;
+        int n = av_clip(len - p * s->part_size, 0, s->part_size);
+
+        for (k = 0; k < n; k++)
+            c[k] = ir[p * s->part_size + k] * scale;
+        memset(c + n, 0, (s->fft_len - n) * sizeof(*c));
+        av_rdft_calc(s->rdft, c);
+    }
+}
+
+/* store the contribution of the delay line to the next block in sum */
+static void next_block(PartConvContext *s)
+{
+    const int nb_parts = s->nb_parts, fft_len = s->fft_len;
+    int i, p;
+
+    memset(s->sum, 0, fft_len * sizeof(*s->sum));
+    for (i = 0; i < s->nb_inputs; i++) {
+        const float *coeffs = s->coeffs + i * nb_parts * fft_len;
+        const float *fdl    = s->fdl    + i * nb_parts * fft_len;
+
+        /* partition p meets the block p - 1 blocks before the current one */
+        for (p = 1; p < nb_parts; p++) {
+            int slot = s->fdl_idx - (p - 1);
+
+            if (slot < 0)
+                slot += nb_parts;
+            rdft_mul_add(s, s->sum, fdl + slot * fft_len, coeffs + p * fft_len);
+        }
+        memset(s->block + i * fft_len, 0, s->part_size * sizeof(*s->block));
+    }
+
+    s->fdl_idx = s->fdl_idx + 1 < nb_parts ? s->fdl_idx + 1 : 0;
+    s->pos = 0;
+}
+
+void ff_partconv_process(PartConvContext *s, float *dst, ptrdiff_t dst_stride,
+                         const float *const *src, ptrdiff_t src_stride,
+                         int nb_samples)
+{
+    const int part_size = s->part_size, fft_len = s->fft_len;
+    int done = 0;
+
+    while (done < nb_samples) {
+        const int n = FFMIN(nb_samples - done, part_size - s->pos);
+        const int full = s->pos + n == part_size;
+        int i, k;
+
+        memcpy(s->out, s->sum, fft_len * sizeof(*s->out));
+        for (i = 0; i < s->nb_inputs; i++) {
+            const float *in = src[i] + done * src_stride;
+            float *block = s->block + i * fft_len;
+            /* complete blocks go straight to the delay line */
+            float *spec = full ? s->fdl + (i * s->nb_parts + s->fdl_idx) * fft_len : s->spec;
+
+            for (k = 0; k < n; k++)
+                block[s->pos + k] = in[k * src_stride];
+            memcpy(spec, block, fft_len * sizeof(*spec));
+            av_rdft_calc(s->rdft, spec);
+            rdft_mul_add(s, s->out, spec, s->coeffs + i * s->nb_parts * fft_len);
+        }
+        av_rdft_calc(s->irdft, s->out);
+
+        for (k = 0; k < n; k++)
+            dst[(done + k) * dst_stride] = s->out[s->pos + k] + s->tail[s->pos + k];
+
+        s->pos += n;
+        done   += n;
+        if (full) {
+            memcpy(s->tail, s->out + part_size, part_size * sizeof(*s->tail));
+            next_block(s);
+        }
+    }
+}
+
+av_cold void ff_partconv_uninit(PartConvContext *s)
+{
+    av_rdft_end(s->rdft);
+    av_rdft_end(s->irdft);
+    s->rdft = s->irdft = NULL;
+    av_freep(&s->coeffs);
+    av_freep(&s->fdl);
+    av_freep(&s->block);
+    av_freep(&s->sum);
+    av_freep(&s->spec);
+    av_freep(&s->out);
+    av_freep(&s->tail);
+}
@@ -0,0 +1,111 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Uniformly partitioned FFT convolution
+ *
+ * The impulse response is split into partitions of part_size taps, each
+ * transformed once with a real FFT of 2 * part_size points. The spectra of
+ * past input blocks are kept in a frequency-domain delay line, so a block
+ * costs one forward transform per input, one complex multiply-accumulate per
+ * partition and a single inverse transform. Blocks may be fed partially: the
+ * output always has the same timing as the input and no latency is added.
+ */
+
+#ifndef AVFILTER_PARTCONV_H
+#define AVFILTER_PARTCONV_H
+
+#include <stddef.h>
+
+#include "libavcodec/avfft.h"
+
+typedef struct PartConvDSPContext {
+    /**
+     * Multiply two arrays of interleaved complex floats and add the products
+     * to sum, i.e. sum[k] += t[k] * c[k] for each of the len / 2 complex
+     * values.
+     *
+     * @param sum accumulator, 32-byte aligned
+     * @param t   first factor, 32-byte aligned
+     * @param c   second factor, 32-byte aligned
+     * @param len number of floats, multiple of 16
+     */
+    void (*fcmul_add)(float *sum, const float *t, const float *c, ptrdiff_t len);
+} PartConvDSPContext;
+
+typedef struct PartConvContext {
+    int part_size;              ///< partition and block length
+    int fft_len;                ///< transform length, 2 * part_size
+    int nb_parts;               ///< number of partitions of the impulse response
+    int nb_inputs;              ///< number of inputs summed into the output
+    int pos;                    ///< samples of the current block already done
+    int fdl_idx;                ///< delay line slot of the current block
+
+    float *coeffs;              ///< partition spectra, [nb_inputs][nb_parts][fft_len]
+    float *fdl;                 ///< input block spectra, [nb_inputs][nb_parts][fft_len]
+    float *block;               ///< current input blocks, [nb_inputs][fft_len]
+    float *sum;                 ///< past blocks' contribution to the current one
+    float *spec;                ///< spectrum of a partial input block
+    float *out;                 ///< output of the current block
+    float *tail;                ///< overlap of the previous block
+
+    RDFTContext *rdft, *irdft;
+    PartConvDSPContext dsp;
+} PartConvContext;
+
+void ff_partconv_dsp_init(PartConvDSPContext *dsp);
+void ff_partconv_dsp_init_x86(PartConvDSPContext *dsp);
+
+/**
+ * Return a partition size suited to an impulse response of ir_len taps.
+ */
+int ff_partconv_part_size(int ir_len);
+
+/**
+ * Set up the convolution of nb_inputs signals with impulse responses of up
+ * to ir_len taps. The impulse responses start zeroed.
+ *
+ * @param part_size partition size, a power of 2 from 8 to 32768
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int ff_partconv_init(PartConvContext *s, int part_size, int ir_len, int nb_inputs);
+
+/**
+ * Set the impulse response of an input. This can be called while
+ * processing; the history of the input signals is kept.
+ *
+ * @param ir  taps, len must not exceed the ir_len given at init
+ */
+void ff_partconv_set_ir(PartConvContext *s, int input, const float *ir, int len);
+
+/**
+ * Convolve nb_samples samples of each input and store the sum to dst.
+ * dst may be the same as src[0] if the strides are equal.
+ *
+ * @param dst_stride distance between output samples, in floats
+ * @param src        nb_inputs input pointers
+ * @param src_stride distance between input samples, in floats
+ */
+void ff_partconv_process(PartConvContext *s, float *dst, ptrdiff_t dst_stride,
+                         const float *const *src, ptrdiff_t src_stride,
+                         int nb_samples);
+
+void ff_partconv_uninit(PartConvContext *s);
+
+#endif /* AVFILTER_PARTCONV_H */
@@ -0,0 +1,761 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Frame-level pipelining of filter chains
+ */
+
+#include "config.h"
+
+#include "libavutil/avassert.h"
+#include "libavutil/fifo.h"
+#include "libavutil/frame.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+
+#include "avfilter.h"
+#include "internal.h"
+#include "pipeline.h"
+#include "thread.h"
+
+typedef struct PipelineItem {
+    AVFilterLink *link;
+    AVFrame *frame;
+    struct FFPipelineStage *src;    ///< stage that output the frame, if any
+} PipelineItem;
+
+typedef struct FFFilterPipeline FFFilterPipeline;
+
+typedef struct FFPipelineStage {
+    FFFilterPipeline *pipe;
+    AVFilterContext *head;      ///< first filter of the chain run by the stage
+    AVFilterContext *filter;    ///< last filter of the chain
+    AVFifoBuffer *queue;        ///< PipelineItem waiting for the filter
+    pthread_t thread;
+    void *slice_thread;         ///< slice threads of the filters of the stage
+    pthread_cond_t cond;
+    /**
+     * Protects frame_wanted_in and frame_wanted_out of the links to the
+     * filters of the stage, which are written by the worker and read by the
+     * graph thread. Taken after FFFilterPipeline.lock, never before.
+     */
+    pthread_mutex_t request_lock;
+    int running;                ///< the worker is filtering a frame
+    int stop;                   ///< 1 if the worker must exit, 2 once it did
+    int held;                   ///< the graph thread is using the filter
+    int error;                  ///< last error returned by the filter
+    int max_frames;             ///< maximum number of queued frames
+    int64_t max_bytes;          ///< maximum size of the queued frames, 0 for no limit
+    int64_t queued_bytes;
+    int64_t nb_waits;           ///< times the producer waited for room in the queue
+    int nb_ready;               ///< frames output by the stage waiting for a sink
+    int64_t ready_bytes;
+    int max_ready;              ///< maximum number of frames waiting for a sink
+    int64_t max_ready_bytes;    ///< maximum size of these frames, 0 for no limit
+    int64_t ready_waits;        ///< times the stage waited for room for its output
+} FFPipelineStage;
+
+struct FFFilterPipeline {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;        ///< signalled whenever a queue changed
+    FFPipelineStage *stages;
+    int nb_stages;
+    AVFifoBuffer *ready;        ///< PipelineItem waiting for a sink
+    int in_flight;              ///< frames queued for or filtered by a stage
+    int nb_held;
+    int error;
+    int done;
+};
+
+static int64_t frame_size(const AVFrame *frame)
+{
+    int64_t size = 0;
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(frame->buf) && frame->buf[i]; i++)
+        size += frame->buf[i]->size;
+    for (i = 0; i < frame->nb_extended_buf; i++)
+        size += frame->extended_buf[i]->size;
+    return size;
+}
+
+static int queue_full(int nb_frames, int64_t nb_bytes, int max_frames,
+                      int64_t max_bytes, int64_t size)
+{
+    return nb_frames >= max_frames ||
+           (nb_frames && max_bytes && nb_bytes + size > max_bytes);
+}
+
+/**
+ * Tell if a frame of the given size can not be queued yet, for the queue of
+ * dst if it is not NULL, for the frames src output to the sinks otherwise.
+ */
+static int pipeline_full(FFPipelineStage *src, FFPipelineStage *dst, int64_t size)
+{
+    if (dst)
+        return queue_full(av_fifo_size(dst->queue) / sizeof(PipelineItem),
+                          dst->queued_bytes, dst->max_frames, dst->max_bytes, size);
+    return queue_full(src->nb_ready, src->ready_bytes,
+                      src->max_ready, src->max_ready_bytes, size);
+}
+
+static int stage_busy(FFPipelineStage *stage)
+{
+    return stage->running || (!stage->stop && av_fifo_size(stage->queue));
+}
+
+static void *attribute_align_arg pipeline_worker(void *arg)
+{
+    FFPipelineStage *stage = arg;
+    FFFilterPipeline *pipe = stage->pipe;
+    PipelineItem item;
+    int ret;
+
+    pthread_mutex_lock(&pipe->lock);
+    for (;;) {
+        while (!pipe->done && !stage->stop &&
+               (stage->held || !av_fifo_size(stage->queue)))
+            pthread_cond_wait(&stage->cond, &pipe->lock);
+        if (pipe->done || stage->stop)
+            break;
+
+        av_fifo_generic_read(stage->queue, &item, sizeof(item), NULL);
+        stage->queued_bytes -= frame_size(item.frame);
+        pthread_mutex_lock(&stage->request_lock);
+        item.link->frame_wanted_out = 0;
+        pthread_mutex_unlock(&stage->request_lock);
+        stage->running = 1;
+        /* wake up the producer waiting for room */
+        pthread_cond_broadcast(&pipe->cond);
+        pthread_mutex_unlock(&pipe->lock);
+
+        ret = ff_filter_frame_to_filter(item.link, item.frame);
+
+        pthread_mutex_lock(&pipe->lock);
+        stage->running = 0;
+        pipe->in_flight--;
+        if (ret < 0) {
+            stage->error = ret;
+            if (ret != AVERROR_EOF && !pipe->error)
+                pipe->error = ret;
+        }
+        pthread_cond_broadcast(&pipe->cond);
+    }
+    pthread_mutex_unlock(&pipe->lock);
+
+    return NULL;
+}
+
+static void pipeline_push(AVFifoBuffer *fifo, AVFilterLink *link, AVFrame *frame,
+                          FFPipelineStage *src)
+{
+    PipelineItem item = { link, frame, src };
+
+    av_assert0(av_fifo_space(fifo) >= sizeof(item));
+    av_fifo_generic_write(fifo, &item, sizeof(item), NULL);
+}
+
+static void pipeline_flush(AVFifoBuffer *fifo)
+{
+    PipelineItem item;
+
+    while (av_fifo_size(fifo) >= sizeof(item)) {
+        av_fifo_generic_read(fifo, &item, sizeof(item), NULL);
+        av_frame_free(&item.frame);
+    }
+}
+
+/**
+ * Pass the oldest frame output by the workers on to its sink. Called by the
+ * graph thread with the lock held, which is released meanwhile.
+ */
+static int pipeline_deliver_one(FFFilterPipeline *pipe)
+{
+    FFPipelineStage *src;
+    PipelineItem item;
+    int ret;
+
+    av_fifo_generic_read(pipe->ready, &item, sizeof(item), NULL);
+    src = item.src;
+    src->nb_ready--;
+    src->ready_bytes -= frame_size(item.frame);
+    pthread_cond_broadcast(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+
+    /* sinks are never pipelined, the link is only used by this thread */
+    item.link->frame_wanted_out = 0;
+    ret = ff_filter_frame_to_filter(item.link, item.frame);
+
+    pthread_mutex_lock(&pipe->lock);
+    return ret;
+}
+
+/**
+ * Wait for a change of the queues. The graph thread keeps passing frames on
+ * to the sinks meanwhile, as workers may be waiting for room there.
+ */
+static void pipeline_wait(FFFilterPipeline *pipe, int from_worker)
+{
+    int ret;
+
+    if (from_worker || !av_fifo_size(pipe->ready)) {
+        pthread_cond_wait(&pipe->cond, &pipe->lock);
+        return;
+    }
+    ret = pipeline_deliver_one(pipe);
+    if (ret < 0 && ret != AVERROR_EOF && !pipe->error)
+        pipe->error = ret;
+}
+
+static int filter_can_pipeline(AVFilterContext *f)
+{
+    for (; f->nb_inputs == 1 && f->nb_outputs == 1; f = f->outputs[0]->dst)
+        if (!(f->input_pads[0].pipeline & FF_PAD_PIPELINE))
+            return 0;
+    return !f->nb_outputs;
+}
+
+static int filter_is_queue(AVFilterContext *f)
+{
+    return f->nb_inputs == 1 &&
+           f->input_pads[0].pipeline & FF_PAD_PIPELINE_QUEUE;
+}
+
+static FFPipelineStage *stage_add(FFFilterPipeline *pipe, AVFilterContext *head,
+                                  AVFilterContext *tail, int max_frames, int64_t max_bytes)
+{
+    FFPipelineStage *stage = &pipe->stages[pipe->nb_stages++];
+    AVFilterContext *f;
+
+    stage->pipe            = pipe;
+    stage->head            = head;
+    stage->filter          = tail;
+    stage->max_frames      = FFMAX(max_frames, 1);
+    stage->max_bytes       = max_bytes;
+    stage->max_ready       = stage->max_frames;
+    stage->max_ready_bytes = max_bytes;
+    for (f = head; ; f = f->outputs[0]->dst) {
+        f->internal->pipeline = stage;
+        if (f == tail)
+            break;
+    }
+    return stage;
+}
+
+static void stage_set_slice_thread(FFPipelineStage *stage, void *thread)
+{
+    AVFilterContext *f;
+
+    for (f = stage->head; ; f = f->outputs[0]->dst) {
+        if (f->thread_type & AVFILTER_THREAD_SLICE)
+            f->internal->thread = thread;
+        if (f == stage->filter)
+            break;
+    }
+}
+
+static int stage_start(FFPipelineStage *stage)
+{
+    AVFilterGraph *graph = stage->head->graph;
+    AVFilterContext *f;
+    int ret;
+
+    /* give the slice threaded filters threads of their own, the workers of
+     * the graph can only run the slices of one filter at a time */
+    for (f = stage->head; ; f = f->outputs[0]->dst) {
+        if (f->thread_type & AVFILTER_THREAD_SLICE) {
+            ret = ff_filter_slice_thread_alloc(&stage->slice_thread,
+                                               graph->nb_threads);
+            if (ret < 0)
+                return ret;
+            if (!stage->slice_thread)
+                return AVERROR(EINVAL);
+            stage_set_slice_thread(stage, stage->slice_thread);
+            break;
+        }
+        if (f == stage->filter)
+            break;
+    }
+
+    stage->queue = av_fifo_alloc(stage->max_frames * sizeof(PipelineItem));
+    if (!stage->queue) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    pthread_cond_init(&stage->cond, NULL);
+    pthread_mutex_init(&stage->request_lock, NULL);
+    ret = pthread_create(&stage->thread, NULL, pipeline_worker, stage);
+    if (ret) {
+        pthread_mutex_destroy(&stage->request_lock);
+        pthread_cond_destroy(&stage->cond);
+        av_fifo_freep(&stage->queue);
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    return 0;
+
+fail:
+    if (stage->slice_thread) {
+        stage_set_slice_thread(stage, NULL);
+        ff_filter_slice_thread_free(&stage->slice_thread);
+    }
+    return ret;
+}
+
+/* free what stage_start() allocated, once the worker has exited */
+static void stage_free(FFPipelineStage *stage)
+{
+    if (!stage->queue)
+        return;
+    pthread_mutex_destroy(&stage->request_lock);
+    pthread_cond_destroy(&stage->cond);
+    pipeline_flush(stage->queue);
+    av_fifo_freep(&stage->queue);
+    ff_filter_slice_thread_free(&stage->slice_thread);
+}
+
+int ff_filter_graph_pipeline_init(AVFilterGraph *graph)
+{
+    FFFilterPipeline *pipe;
+    int i, ret, nb_queues, max_ready = 0;
+
+    ff_filter_graph_pipeline_uninit(graph);
+
+    pipe = av_mallocz(sizeof(*pipe));
+    if (!pipe)
+        return AVERROR(ENOMEM);
+    pipe->stages = av_mallocz_array(graph->nb_filters, sizeof(*pipe->stages));
+    if (!pipe->stages) {
+        av_freep(&pipe);
+        return AVERROR(ENOMEM);
+    }
+    pthread_mutex_init(&pipe->lock, NULL);
+    pthread_cond_init(&pipe->cond, NULL);
+    graph->internal->pipeline = pipe;
+
+    /* queue filters take the chain leading to them first */
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *head, *f = graph->filters[i];
+
+        if (!filter_is_queue(f))
+            continue;
+        if (f->nb_inputs != 1 || f->nb_outputs != 1 || !filter_can_pipeline(f)) {
+            av_log(f, AV_LOG_WARNING, "Not followed by a simple chain of "
+                   "filters ending in a sink, running in the graph thread.\n");
+            continue;
+        }
+
+        for (head = f; ; head = head->inputs[0]->src) {
+            AVFilterContext *prev = head->inputs[0]->src;
+            if (prev->nb_inputs != 1 || prev->nb_outputs != 1 ||
+                prev->internal->pipeline || filter_is_queue(prev) ||
+                !filter_can_pipeline(prev))
+                break;
+        }
+        /* frames are handed over one at a time, the queue is at the output */
+        stage_add(pipe, head, f, 1, 0);
+    }
+
+    /* the frames output by a queue filter wait in the queue of the stage
+     * following it, or for the sink, so that what comes after the filter
+     * is decoupled from what precedes it */
+    nb_queues = pipe->nb_stages;
+    for (i = 0; i < nb_queues; i++) {
+        FFPipelineStage *next, *stage = &pipe->stages[i];
+        AVFilterInternal *queue = stage->filter->internal;
+        AVFilterContext *head = stage->filter->outputs[0]->dst, *tail;
+
+        if (!head->nb_outputs) {
+            stage->max_ready       = FFMAX(queue->queue_frames, 1);
+            stage->max_ready_bytes = queue->queue_bytes;
+            continue;
+        }
+        if ((next = head->internal->pipeline)) {
+            next->max_frames = FFMAX(queue->queue_frames, 1);
+            next->max_bytes  = queue->queue_bytes;
+            continue;
+        }
+        /* the frames leaving the pipeline must go straight to a sink, so
+         * that the graph thread can pass them on while waiting for room */
+        for (tail = head; !graph->pipeline && tail->outputs[0]->dst->nb_outputs &&
+                          !tail->outputs[0]->dst->internal->pipeline;
+             tail = tail->outputs[0]->dst)
+            ;
+        stage_add(pipe, head, tail, queue->queue_frames, queue->queue_bytes);
+    }
+
+    for (i = 0; graph->pipeline && i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        if (f->nb_inputs != 1 || f->nb_outputs != 1 || f->internal->pipeline ||
+            !filter_can_pipeline(f))
+            continue;
+        stage_add(pipe, f, f, graph->pipeline, 0);
+    }
+
+    if (!pipe->nb_stages) {
+        ff_filter_graph_pipeline_uninit(graph);
+        return 0;
+    }
+
+    for (i = 0; i < pipe->nb_stages; i++) {
+        FFPipelineStage *stage = &pipe->stages[i];
+        AVFilterContext *next = stage->filter->outputs[0]->dst;
+
+        av_assert0(!next->nb_outputs || next->internal->pipeline);
+        if (!next->internal->pipeline)
+            max_ready += stage->max_ready;
+        if ((ret = stage_start(stage)) < 0)
+            goto fail;
+    }
+    pipe->ready = av_fifo_alloc(max_ready * sizeof(PipelineItem));
+    if (!pipe->ready) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    av_log(graph, AV_LOG_VERBOSE, "Pipelining %d filter chains.\n", pipe->nb_stages);
+    return 0;
+
+fail:
+    ff_filter_graph_pipeline_uninit(graph);
+    return ret;
+}
+
+void ff_filter_graph_pipeline_uninit(AVFilterGraph *graph)
+{
+    FFFilterPipeline *pipe = graph->internal->pipeline;
+    int i;
+
+    if (!pipe)
+        return;
+
+    pthread_mutex_lock(&pipe->lock);
+    pipe->done = 1;
+    for (i = 0; i < pipe->nb_stages; i++)
+        if (pipe->stages[i].queue)
+            pthread_cond_signal(&pipe->stages[i].cond);
+    pthread_cond_broadcast(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+
+    for (i = 0; i < pipe->nb_stages; i++) {
+        FFPipelineStage *stage = &pipe->stages[i];
+
+        /* the worker is running if the queue was allocated, unless the
+         * stage was detached */
+        if (stage->queue && !stage->stop)
+            pthread_join(stage->thread, NULL);
+        stage_free(stage);
+    }
+    /* detached stages may have lost filters, go through those of the graph */
+    for (i = 0; i < graph->nb_filters; i++) {
+        graph->filters[i]->internal->pipeline = NULL;
+        graph->filters[i]->internal->thread   = NULL;
+    }
+    if (pipe->ready) {
+        pipeline_flush(pipe->ready);
+        av_fifo_freep(&pipe->ready);
+    }
+
+    pthread_mutex_destroy(&pipe->lock);
+    pthread_cond_destroy(&pipe->cond);
+    av_freep(&pipe->stages);
+    av_freep(&graph->internal->pipeline);
+}
+
+static int stage_touches(FFPipelineStage *stage, AVFilterContext *ctx)
+{
+    AVFilterContext *f;
+
+    for (f = stage->head; ; f = f->outputs[0]->dst) {
+        if (f == ctx || f->inputs[0]->src == ctx || f->outputs[0]->dst == ctx)
+            return 1;
+        if (f == stage->filter)
+            return 0;
+    }
+}
+
+void ff_filter_pipeline_detach(AVFilterContext *ctx)
+{
+    FFFilterPipeline *pipe = ctx->graph->internal->pipeline;
+    PipelineItem item;
+    int i, nb_items;
+
+    if (!pipe)
+        return;
+
+    /* stop the workers of the stages using the filter or its links; their
+     * structures stay around until the pipeline is uninitialized, frames
+     * sent to them are dropped from now on */
+    pthread_mutex_lock(&pipe->lock);
+    for (i = 0; i < pipe->nb_stages; i++) {
+        FFPipelineStage *stage = &pipe->stages[i];
+
+        if (stage->queue && !stage->stop && stage_touches(stage, ctx)) {
+            stage->stop = 1;
+            pthread_cond_signal(&stage->cond);
+        }
+    }
+    pthread_cond_broadcast(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+
+    for (i = 0; i < pipe->nb_stages; i++) {
+        FFPipelineStage *stage = &pipe->stages[i];
+
+        if (stage->stop == 1) {
+            pthread_join(stage->thread, NULL);
+            stage->stop = 2;
+        }
+    }
+
+    pthread_mutex_lock(&pipe->lock);
+    for (i = 0; i < pipe->nb_stages; i++) {
+        FFPipelineStage *stage = &pipe->stages[i];
+
+        if (stage->queue && stage->stop) {
+            pipe->in_flight -= av_fifo_size(stage->queue) / sizeof(item);
+            stage->queued_bytes = 0;
+            pipeline_flush(stage->queue);
+        }
+    }
+    /* drop the frames output on the links of the filter */
+    nb_items = av_fifo_size(pipe->ready) / sizeof(item);
+    for (i = 0; i < nb_items; i++) {
+        av_fifo_generic_read(pipe->ready, &item, sizeof(item), NULL);
+        if (item.link->src != ctx && item.link->dst != ctx) {
+            av_fifo_generic_write(pipe->ready, &item, sizeof(item), NULL);
+            continue;
+        }
+        item.src->nb_ready--;
+        item.src->ready_bytes -= frame_size(item.frame);
+        av_frame_free(&item.frame);
+    }
+    pthread_cond_broadcast(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+}
+
+int ff_filter_pipeline_frame(AVFilterLink *link, AVFrame *frame)
+{
+    FFPipelineStage *src = link->src->internal->pipeline;
+    FFPipelineStage *dst = link->dst->internal->pipeline;
+    FFFilterPipeline *pipe = src ? src->pipe : dst->pipe;
+    int64_t size = frame_size(frame);
+    int from_worker, ret;
+
+    /* links inside a stage are followed by whoever runs the stage */
+    if (src == dst)
+        return 0;
+
+    pthread_mutex_lock(&pipe->lock);
+    /* a stage that is not held can only be run by its own worker */
+    from_worker = src && !src->held;
+    if (!from_worker && (!dst || dst->held)) {
+        av_assert1(!dst || !av_fifo_size(dst->queue));
+        pthread_mutex_unlock(&pipe->lock);
+        return 0;
+    }
+
+    /* the destination chain lost a filter, see ff_filter_pipeline_detach() */
+    if (dst && dst->stop) {
+        ret = 1;
+        goto fail;
+    }
+    if (dst && dst->error < 0) {
+        ret = dst->error;
+        goto fail;
+    }
+    if (pipeline_full(src, dst, size)) {
+        if (dst)
+            dst->nb_waits++;
+        else
+            src->ready_waits++;
+        do {
+            if (pipe->error || pipe->done || (from_worker && src->stop)) {
+                ret = pipe->error ? pipe->error : AVERROR_EXIT;
+                goto fail;
+            }
+            if (dst && dst->stop) {
+                ret = 1;
+                goto fail;
+            }
+            pipeline_wait(pipe, from_worker);
+        } while (pipeline_full(src, dst, size));
+    }
+
+    if (dst) {
+        pipeline_push(dst->queue, link, frame, src);
+        dst->queued_bytes += size;
+        pipe->in_flight++;
+        pthread_cond_signal(&dst->cond);
+    } else {
+        pipeline_push(pipe->ready, link, frame, src);
+        src->nb_ready++;
+        src->ready_bytes += size;
+        pthread_cond_broadcast(&pipe->cond);
+    }
+    pthread_mutex_unlock(&pipe->lock);
+    return 1;
+
+fail:
+    pthread_mutex_unlock(&pipe->lock);
+    av_frame_free(&frame);
+    return ret;
+}
+
+static void stage_hold(FFPipelineStage *stage)
+{
+    FFFilterPipeline *pipe = stage->pipe;
+
+    while (!stage->held && stage_busy(stage))
+        pipeline_wait(pipe, 0);
+    stage->held++;
+    pipe->nb_held++;
+}
+
+int ff_filter_pipeline_request(AVFilterLink *link)
+{
+    AVFilterContext *ctx   = link->src;
+    FFPipelineStage *stage = ctx->internal->pipeline;
+    FFFilterPipeline *pipe = stage->pipe;
+    AVFilterLink *inlink   = stage->head->inputs[0];
+    int ret;
+
+    pthread_mutex_lock(&pipe->lock);
+    if (!stage->held && stage_busy(stage) && !inlink->status) {
+        /* the frames being filtered will answer the request, keep the
+         * stage fed in the meantime, without the lock since the request
+         * may take the request lock of another stage */
+        pthread_mutex_unlock(&pipe->lock);
+        ff_request_frame(inlink);
+        return 1;
+    }
+    stage_hold(stage);
+    pthread_mutex_unlock(&pipe->lock);
+
+    /* frames output so far must reach the sinks before any status change */
+    ret = ff_filter_graph_pipeline_deliver(ctx->graph);
+    if (ret < 0) {
+        ff_filter_pipeline_release(ctx);
+        return ret;
+    }
+    return 0;
+}
+
+void ff_filter_pipeline_hold(AVFilterContext *ctx)
+{
+    FFPipelineStage *stage = ctx->internal->pipeline;
+
+    pthread_mutex_lock(&stage->pipe->lock);
+    stage_hold(stage);
+    pthread_mutex_unlock(&stage->pipe->lock);
+}
+
+void ff_filter_pipeline_release(AVFilterContext *ctx)
+{
+    FFPipelineStage *stage = ctx->internal->pipeline;
+    FFFilterPipeline *pipe = stage->pipe;
+
+    pthread_mutex_lock(&pipe->lock);
+    av_assert0(stage->held > 0);
+    stage->held--;
+    pipe->nb_held--;
+    if (!stage->held)
+        pthread_cond_signal(&stage->cond);
+    pthread_mutex_unlock(&pipe->lock);
+}
+
+void ff_filter_pipeline_lock_link(AVFilterLink *link)
+{
+    FFPipelineStage *stage = link->dst->internal->pipeline;
+
+    if (stage)
+        pthread_mutex_lock(&stage->request_lock);
+}
+
+void ff_filter_pipeline_unlock_link(AVFilterLink *link)
+{
+    FFPipelineStage *stage = link->dst->internal->pipeline;
+
+    if (stage)
+        pthread_mutex_unlock(&stage->request_lock);
+}
+
+int ff_filter_pipeline_get_stats(AVFilterContext *ctx, FFPipelineStats *stats)
+{
+    FFPipelineStage *next, *stage = ctx->internal->pipeline;
+
+    if (!stage)
+        return AVERROR(ENOSYS);
+
+    pthread_mutex_lock(&stage->pipe->lock);
+    next = stage->filter->outputs[0]->dst->internal->pipeline;
+    if (next) {
+        stats->nb_frames = av_fifo_size(next->queue) / sizeof(PipelineItem);
+        stats->nb_bytes  = next->queued_bytes;
+        stats->nb_waits  = next->nb_waits;
+    } else {
+        stats->nb_frames = stage->nb_ready;
+        stats->nb_bytes  = stage->ready_bytes;
+        stats->nb_waits  = stage->ready_waits;
+    }
+    pthread_mutex_unlock(&stage->pipe->lock);
+    return 0;
+}
+
+int ff_filter_graph_pipeline_deliver(AVFilterGraph *graph)
+{
+    FFFilterPipeline *pipe = graph->internal->pipeline;
+    int ret = 0, nb_frames = 0;
+
+    if (!pipe)
+        return 0;
+
+    pthread_mutex_lock(&pipe->lock);
+    while (ret >= 0 && av_fifo_size(pipe->ready)) {
+        ret = pipeline_deliver_one(pipe);
+        nb_frames++;
+    }
+    if (ret >= 0 && pipe->error)
+        ret = pipe->error;
+    pthread_mutex_unlock(&pipe->lock);
+
+    return ret < 0 ? ret : nb_frames;
+}
+
+int ff_filter_graph_pipeline_wait(AVFilterGraph *graph)
+{
+    FFFilterPipeline *pipe = graph->internal->pipeline;
+    int ret = 0;
+
+    if (!pipe)
+        return 0;
+
+    pthread_mutex_lock(&pipe->lock);
+    if (pipe->error) {
+        ret = pipe->error;
+    } else if (av_fifo_size(pipe->ready)) {
+        ret = 1;
+    } else if (pipe->in_flight) {
+        pthread_cond_wait(&pipe->cond, &pipe->lock);
+        ret = 1;
+    }
+    pthread_mutex_unlock(&pipe->lock);
+
+    return ret;
+}
@@ -0,0 +1,124 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_PIPELINE_H
+#define AVFILTER_PIPELINE_H
+
+/**
+ * @file
+ * Frame-level pipelining of filter chains.
+ *
+ * When AVFilterGraph.pipeline is set, every filter with one input and one
+ * output whose chain of single input/output filters ends in a sink gets its
+ * own worker thread and a bounded queue of incoming frames, provided the
+ * input pads of all the filters of the chain have FF_PAD_PIPELINE set. Each
+ * queue has a single producer and a single consumer, so frames reach every
+ * filter in the same order as without pipelining. A producer finding the
+ * queue full waits for room. Frames for the sinks, status changes and
+ * request_frame() calls are handled by the thread running the graph. The
+ * slice threaded filters of a stage get slice threads of their own, so that
+ * stages do not wait for each other to run their slices.
+ *
+ * Filters whose input pad has FF_PAD_PIPELINE_QUEUE, like threadqueue, make
+ * the chain of single input/output filters leading to them a single stage,
+ * even when AVFilterGraph.pipeline is not set. Their limits apply to the
+ * frames output by that stage, which wait in the queue of the following stage
+ * or for the sink. The filters between them and the sink make another stage,
+ * so that the frames leaving the pipeline always go straight to a sink.
+ */
+
+#include "avfilter.h"
+
+/**
+ * Start the workers of the graph, called at the end of graph configuration.
+ */
+int ff_filter_graph_pipeline_init(AVFilterGraph *graph);
+
+void ff_filter_graph_pipeline_uninit(AVFilterGraph *graph);
+
+/**
+ * Stop the workers of the stages a filter about to be freed belongs or is
+ * linked to, and drop the frames queued on its links. The other stages of
+ * the graph keep running.
+ */
+void ff_filter_pipeline_detach(AVFilterContext *ctx);
+
+/**
+ * Hand a frame to the pipeline.
+ *
+ * @return 1 if the frame was queued, 0 if the caller must filter it
+ *         itself, a negative error code on failure (the frame is freed)
+ */
+int ff_filter_pipeline_frame(AVFilterLink *link, AVFrame *frame);
+
+/**
+ * Prepare a request on a link whose source filter is pipelined.
+ *
+ * If the source is busy with queued frames, the request is forwarded to its
+ * input and 1 is returned. Otherwise the source is held like with
+ * ff_filter_pipeline_hold() and 0 is returned.
+ */
+int ff_filter_pipeline_request(AVFilterLink *link);
+
+/**
+ * Wait for a pipelined filter to consume its queue and keep its worker away
+ * from it until ff_filter_pipeline_release(), so that the calling thread
+ * can use the filter directly.
+ */
+void ff_filter_pipeline_hold(AVFilterContext *ctx);
+
+void ff_filter_pipeline_release(AVFilterContext *ctx);
+
+/**
+ * Lock the frame_wanted_in and frame_wanted_out fields of a link, which the
+ * worker of a pipelined destination filter can access concurrently. Nothing
+ * is done if the destination is not pipelined.
+ */
+void ff_filter_pipeline_lock_link(AVFilterLink *link);
+
+void ff_filter_pipeline_unlock_link(AVFilterLink *link);
+
+typedef struct FFPipelineStats {
+    int nb_frames;              ///< frames output by the stage still waiting
+    int64_t nb_bytes;           ///< size of the buffers of these frames
+    int64_t nb_waits;           ///< times the stage waited for room for its output
+} FFPipelineStats;
+
+/**
+ * Get the state of the frames output by the stage a filter belongs to.
+ *
+ * @return 0 on success, AVERROR(ENOSYS) if the filter is not pipelined
+ */
+int ff_filter_pipeline_get_stats(AVFilterContext *ctx, FFPipelineStats *stats);
+
+/**
+ * Pass the frames output by the workers on to the sinks.
+ *
+ * @return the number of frames delivered or a negative error code
+ */
+int ff_filter_graph_pipeline_deliver(AVFilterGraph *graph);
+
+/**
+ * Wait for the workers to make progress.
+ *
+ * @return 0 if there was nothing in flight, 1 after waiting,
+ *         a negative error code if a worker failed
+ */
+int ff_filter_graph_pipeline_wait(AVFilterGraph *graph);
+
+#endif /* AVFILTER_PIPELINE_H */
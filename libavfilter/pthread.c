@@ -116,7 +116,8 @@ static void slice_thread_park_workers(ThreadContext *c)
 static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
                           void *arg, int *ret, int nb_jobs)
 {
-    ThreadContext *c = ctx->graph->internal->thread;
+    ThreadContext *c = ctx->internal->thread ? ctx->internal->thread :
+                                               ctx->graph->internal->thread;
     int dummy_ret;
 
     if (nb_jobs <= 0)
@@ -227,3 +228,28 @@ void ff_graph_thread_free(AVFilterGraph *graph)
         slice_thread_uninit(graph->internal->thread);
     av_freep(&graph->internal->thread);
 }
+
+int ff_filter_slice_thread_alloc(void **thread, int nb_threads)
+{
+    ThreadContext *c;
+    int ret;
+
+    c = av_mallocz(sizeof(*c));
+    if (!c)
+        return AVERROR(ENOMEM);
+
+    ret = thread_init_internal(c, nb_threads);
+    if (ret <= 1) {
+        av_free(c);
+        return ret;
+    }
+    *thread = c;
+    return ret;
+}
+
+void ff_filter_slice_thread_free(void **thread)
+{
+    if (*thread)
+        slice_thread_uninit(*thread);
+    av_freep(thread);
+}
@@ -237,6 +237,7 @@ static const AVFilterPad avfilter_vf_setpts_inputs[] = {
         .type         = AVMEDIA_TYPE_VIDEO,
         .config_props = config_input,
         .filter_frame = filter_frame,
+        .pipeline     = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -274,6 +275,7 @@ static const AVFilterPad asetpts_inputs[] = {
         .type         = AVMEDIA_TYPE_AUDIO,
         .config_props = config_input,
         .filter_frame = filter_frame,
+        .pipeline     = FF_PAD_PIPELINE,
     },
     { NULL }
 };
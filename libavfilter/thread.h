@@ -25,4 +25,15 @@ int ff_graph_thread_init(AVFilterGraph *graph);
 
 void ff_graph_thread_free(AVFilterGraph *graph);
 
+/**
+ * Start a set of slice threads of its own for the filters whose
+ * AVFilterInternal.thread points to it, instead of those of the graph.
+ *
+ * @return the number of threads, *thread being set if it is more than 1,
+ *         or a negative error code
+ */
+int ff_filter_slice_thread_alloc(void **thread, int nb_threads);
+
+void ff_filter_slice_thread_free(void **thread);
+
 #endif /* AVFILTER_THREAD_H */
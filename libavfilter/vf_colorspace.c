@@ -23,7 +23,10 @@
  * Convert between colorspaces.
  */
 
+#include <float.h>
+
 #include "libavutil/avassert.h"
+#include "libavutil/mastering_display_metadata.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/pixfmt.h"
@@ -40,6 +43,17 @@ enum DitherMode {
     DITHER_NB,
 };
 
+enum ToneMapping {
+    TONEMAP_NONE,
+    TONEMAP_REINHARD,
+    TONEMAP_HABLE,
+    TONEMAP_MOBIUS,
+    TONEMAP_NB,
+};
+
+/* luminance in cd/m² of the 1.0 level of SDR content */
+#define REFERENCE_WHITE 100.0
+
 enum Colorspace {
     CS_UNSPECIFIED,
     CS_BT470M,
@@ -134,9 +148,16 @@ typedef struct ColorSpaceContext {
     enum AVColorTransferCharacteristic in_trc, out_trc, user_trc;
     enum AVColorPrimaries in_prm, out_prm, user_prm;
     enum AVPixelFormat in_format, user_format;
+    enum AVColorSpace user_icsp;
+    enum AVColorRange user_irng;
+    enum AVColorTransferCharacteristic user_itrc;
+    enum AVColorPrimaries user_iprm;
     int fast_mode;
     enum DitherMode dither;
     enum WhitepointAdaptation wp_adapt;
+    enum ToneMapping tonemap;
+    double tonemap_param;
+    double user_peak;
 
     int16_t *rgb[3];
     ptrdiff_t rgb_stride;
@@ -150,6 +171,9 @@ typedef struct ColorSpaceContext {
     const struct TransferCharacteristics *in_txchr, *out_txchr;
     int rgb2rgb_passthrough;
     int16_t *lin_lut, *delin_lut;
+    int in_hdr;                 ///< input is PQ or HLG, linearized with tone mapping
+    double peak;                ///< peak luminance of the input in cd/m²
+    DECLARE_ALIGNED(16, int16_t, gamut_coeffs)[3][8];
 
     const struct LumaCoefficients *in_lumacoef, *out_lumacoef;
     int yuv2yuv_passthrough, yuv2yuv_fastmode;
@@ -233,6 +257,17 @@ static const struct TransferCharacteristics transfer_characteristics[AVCOL_TRC_N
     [AVCOL_TRC_BT2020_12] = { 1.0993, 0.0181, 0.45, 4.5 },
 };
 
+/* PQ and HLG do not fit the model above, they are linearized by dedicated
+ * code and these values only mark them as supported input */
+static const struct TransferCharacteristics hdr_transfer_characteristics = {
+    1.0, 0.0, 1.0, 0.0
+};
+
+static int is_hdr_transfer(enum AVColorTransferCharacteristic trc)
+{
+    return trc == AVCOL_TRC_SMPTEST2084 || trc == AVCOL_TRC_ARIB_STD_B67;
+}
+
 static const struct TransferCharacteristics *
     get_transfer_characteristics(enum AVColorTransferCharacteristic trc)
 {
@@ -301,6 +336,71 @@ static void invert_matrix3x3(const double in[3][3], double out[3][3])
     }
 }
 
+/* returns the displayed luminance in cd/m² */
+static double hdr_eotf(enum AVColorTransferCharacteristic trc, double v)
+{
+    v = FFMAX(v, 0.0);
+    if (trc == AVCOL_TRC_SMPTEST2084) {
+        const double m1 = 2610.0 / 16384, m2 = 2523.0 / 4096 * 128;
+        const double c1 = 3424.0 / 4096, c2 = 2413.0 / 4096 * 32, c3 = 2392.0 / 4096 * 32;
+        double p = pow(v, 1.0 / m2);
+
+        return 10000.0 * pow(FFMAX(p - c1, 0.0) / (c2 - c3 * p), 1.0 / m1);
+    } else {
+        const double a = 0.17883277, b = 0.28466892, c = 0.55991073;
+        double e = v <= 0.5 ? v * v / 3.0 : (exp((v - c) / a) + b) / 12.0;
+
+        // OOTF of a nominal 1000 cd/m² display, applied per component
+        return 1000.0 * pow(e, 1.2);
+    }
+}
+
+static double hable(double in)
+{
+    double a = 0.15, b = 0.50, c = 0.10, d = 0.20, e = 0.02, f = 0.30;
+    return (in * (in * a + b * c) + d * e) / (in * (in * a + b) + d * f) - e / f;
+}
+
+static double mobius(double in, double j, double peak)
+{
+    double a, b;
+
+    if (in <= j)
+        return in;
+
+    a = -j * j * (peak - 1.0) / (j * j - 2.0 * j + peak);
+    b = (j * j - 2.0 * j * peak + peak) / FFMAX(peak - 1.0, 1e-6);
+
+    return (b * b + 2.0 * b * j + j * j) / (b - a) * (in + a) / (in + b);
+}
+
+/*
+ * Map a luminance relative to the reference white into [0,1]. peak is the
+ * relative luminance of the brightest pixel of the input.
+ */
+static double tone_map(ColorSpaceContext *s, double sig, double peak)
+{
+    double param = s->tonemap_param, offset;
+
+    if (peak <= 1.0)
+        return av_clipd(sig, 0.0, 1.0);
+
+    switch (s->tonemap) {
+    case TONEMAP_REINHARD:
+        offset = (1.0 - (isnan(param) ? 0.5 : param)) / (isnan(param) ? 0.5 : param);
+        sig = sig / (sig + offset) * (peak + offset) / peak;
+        break;
+    case TONEMAP_HABLE:
+        sig = hable(sig) / hable(peak);
+        break;
+    case TONEMAP_MOBIUS:
+        sig = mobius(sig, isnan(param) ? 0.3 : param, peak);
+        break;
+    }
+
+    return av_clipd(sig, 0.0, 1.0);
+}
+
 static int fill_gamma_table(ColorSpaceContext *s)
 {
     int n;
@@ -328,7 +428,10 @@ static int fill_gamma_table(ColorSpaceContext *s)
         s->delin_lut[n] = av_clip_int16(lrint(d * 28672.0));
 
         // linearize
-        if (v <= -in_beta) {
+        if (s->in_hdr) {
+            l = tone_map(s, hdr_eotf(s->in_trc, v) / REFERENCE_WHITE,
+                         s->peak / REFERENCE_WHITE);
+        } else if (v <= -in_beta) {
             l = -pow((1.0 - in_alpha - v) * in_ialpha, in_igamma);
         } else if (v < in_beta) {
             l = v * in_idelta;
@@ -502,8 +605,11 @@ static int convert(AVFilterContext *ctx, void *data, int job_nr, int n_jobs)
                    s->yuv2rgb_coeffs, s->yuv_offset[0]);
         if (!s->rgb2rgb_passthrough) {
             apply_lut(rgb, s->rgb_stride, w, h, s->lin_lut);
-            if (!s->lrgb2lrgb_passthrough)
+            if (!s->lrgb2lrgb_passthrough) {
                 s->dsp.multiply3x3(rgb, s->rgb_stride, w, h, s->lrgb2lrgb_coeffs);
+                if (s->in_hdr)
+                    s->dsp.gamut_map(rgb, s->rgb_stride, w, h, s->gamut_coeffs);
+            }
             apply_lut(rgb, s->rgb_stride, w, h, s->delin_lut);
         }
         if (s->dither == DITHER_FSB) {
@@ -631,6 +737,12 @@ static int create_filtergraph(AVFilterContext *ctx,
                         s->lrgb2lrgb_coeffs[m][n][o] = s->lrgb2lrgb_coeffs[m][n][0];
                 }
 
+            // luminance of the output primaries, used for gamut mapping
+            fill_rgb2xyz_table(s->out_primaries, rgb2xyz);
+            for (m = 0; m < 3; m++)
+                for (o = 0; o < 8; o++)
+                    s->gamut_coeffs[m][o] = lrint(16384.0 * rgb2xyz[1][m]);
+
             emms = 1;
         }
     }
@@ -638,7 +750,9 @@ static int create_filtergraph(AVFilterContext *ctx,
     if (!s->in_txchr) {
         av_freep(&s->lin_lut);
         s->in_trc = in->color_trc;
-        s->in_txchr = get_transfer_characteristics(s->in_trc);
+        s->in_hdr = is_hdr_transfer(s->in_trc);
+        s->in_txchr = s->in_hdr ? &hdr_transfer_characteristics :
+                                  get_transfer_characteristics(s->in_trc);
         if (!s->in_txchr) {
             av_log(ctx, AV_LOG_ERROR,
                    "Unsupported input transfer characteristics %d (%s)\n",
@@ -820,6 +934,13 @@ static int init(AVFilterContext *ctx)
 {
     ColorSpaceContext *s = ctx->priv;
 
+    if (is_hdr_transfer(s->user_trc)) {
+        av_log(ctx, AV_LOG_ERROR,
+               "Output transfer characteristics %s are only supported as input\n",
+               av_color_transfer_name(s->user_trc));
+        return AVERROR(EINVAL);
+    }
+
     ff_colorspacedsp_init(&s->dsp);
 
     return 0;
@@ -843,6 +964,24 @@ static void uninit(AVFilterContext *ctx)
     av_freep(&s->lin_lut);
 }
 
+static double get_peak(ColorSpaceContext *s, const AVFrame *in)
+{
+    AVFrameSideData *sd;
+
+    if (s->user_peak > 0)
+        return s->user_peak;
+
+    sd = av_frame_get_side_data(in, AV_FRAME_DATA_MASTERING_DISPLAY_METADATA);
+    if (sd) {
+        const AVMasteringDisplayMetadata *md = (const AVMasteringDisplayMetadata *)sd->data;
+
+        if (md->has_luminance && md->max_luminance.num > 0 && md->max_luminance.den > 0)
+            return av_q2d(md->max_luminance);
+    }
+
+    return 1000.0;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
     AVFilterContext *ctx = link->dst;
@@ -861,6 +1000,14 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         av_frame_free(&in);
         return AVERROR(ENOMEM);
     }
+    if (s->user_icsp != AVCOL_SPC_UNSPECIFIED)
+        in->colorspace = s->user_icsp;
+    if (s->user_irng != AVCOL_RANGE_UNSPECIFIED)
+        in->color_range = s->user_irng;
+    if (s->user_itrc != AVCOL_TRC_UNSPECIFIED)
+        in->color_trc = s->user_itrc;
+    if (s->user_iprm != AVCOL_PRI_UNSPECIFIED)
+        in->color_primaries = s->user_iprm;
     av_frame_copy_props(out, in);
 
     out->color_primaries = s->user_prm == AVCOL_PRI_UNSPECIFIED ?
@@ -923,6 +1070,16 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         }
         s->rgb_sz = rgb_sz;
     }
+    if (is_hdr_transfer(in->color_trc)) {
+        double peak = get_peak(s, in);
+
+        if (peak != s->peak) {
+            s->peak = peak;
+            av_freep(&s->lin_lut);
+        }
+        // the output is no longer mastered on the HDR display
+        av_frame_remove_side_data(out, AV_FRAME_DATA_MASTERING_DISPLAY_METADATA);
+    }
     res = create_filtergraph(ctx, in, out);
     if (res < 0)
         return res;
@@ -1073,6 +1230,42 @@ static const AVOption colorspace_options[] = {
     ENUM("vonkries", WP_ADAPT_VON_KRIES, "wpadapt"),
     ENUM("identity", WP_ADAPT_IDENTITY, "wpadapt"),
 
+    { "ispace",     "Input colorspace",
+      OFFSET(user_icsp),  AV_OPT_TYPE_INT, { .i64 = AVCOL_SPC_UNSPECIFIED },
+      AVCOL_SPC_RGB, AVCOL_SPC_NB - 1, FLAGS, "csp" },
+    { "irange",     "Input color range",
+      OFFSET(user_irng),  AV_OPT_TYPE_INT, { .i64 = AVCOL_RANGE_UNSPECIFIED },
+      AVCOL_RANGE_UNSPECIFIED, AVCOL_RANGE_NB - 1, FLAGS, "rng" },
+    { "iprimaries", "Input color primaries",
+      OFFSET(user_iprm),  AV_OPT_TYPE_INT, { .i64 = AVCOL_PRI_UNSPECIFIED },
+      AVCOL_PRI_RESERVED0, AVCOL_PRI_NB - 1, FLAGS, "prm" },
+    { "itrc",       "Input transfer characteristics",
+      OFFSET(user_itrc),  AV_OPT_TYPE_INT, { .i64 = AVCOL_TRC_UNSPECIFIED },
+      AVCOL_TRC_RESERVED0, AVCOL_TRC_NB - 1, FLAGS, "itrc" },
+    ENUM("bt709",        AVCOL_TRC_BT709,        "itrc"),
+    ENUM("gamma22",      AVCOL_TRC_GAMMA22,      "itrc"),
+    ENUM("gamma28",      AVCOL_TRC_GAMMA28,      "itrc"),
+    ENUM("smpte170m",    AVCOL_TRC_SMPTE170M,    "itrc"),
+    ENUM("smpte240m",    AVCOL_TRC_SMPTE240M,    "itrc"),
+    ENUM("bt2020-10",    AVCOL_TRC_BT2020_10,    "itrc"),
+    ENUM("bt2020-12",    AVCOL_TRC_BT2020_12,    "itrc"),
+    ENUM("smpte2084",    AVCOL_TRC_SMPTEST2084,  "itrc"),
+    ENUM("arib-std-b67", AVCOL_TRC_ARIB_STD_B67, "itrc"),
+
+    { "tonemap",  "Tone mapping of PQ and HLG input",
+      OFFSET(tonemap), AV_OPT_TYPE_INT, { .i64 = TONEMAP_HABLE },
+      TONEMAP_NONE, TONEMAP_NB - 1, FLAGS, "tonemap" },
+    ENUM("none",     TONEMAP_NONE,     "tonemap"),
+    ENUM("reinhard", TONEMAP_REINHARD, "tonemap"),
+    ENUM("hable",    TONEMAP_HABLE,    "tonemap"),
+    ENUM("mobius",   TONEMAP_MOBIUS,   "tonemap"),
+    { "param",    "Tone mapping parameter",
+      OFFSET(tonemap_param), AV_OPT_TYPE_DOUBLE, { .dbl = NAN },
+      DBL_MIN, DBL_MAX, FLAGS },
+    { "peak",     "Peak luminance of the input in cd/m², 0 to use the frame metadata",
+      OFFSET(user_peak), AV_OPT_TYPE_DOUBLE, { .dbl = 0 },
+      0, 10000, FLAGS },
+
     { NULL }
 };
 
@@ -38,15 +38,21 @@ typedef struct ConvolutionContext {
     int bstride;
     uint8_t *buffer;
     int nb_planes;
+    int nb_threads;
     int planewidth[4];
     int planeheight[4];
     int matrix[4][25];
     int matrix_length[4];
     int copy[4];
 
-    void (*filter[4])(struct ConvolutionContext *s, AVFrame *in, AVFrame *out, int plane);
+    int (*filter[4])(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
 } ConvolutionContext;
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int plane;
+} ThreadData;
+
 #define OFFSET(x) offsetof(ConvolutionContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
 
@@ -96,7 +102,8 @@ static int query_formats(AVFilterContext *ctx)
 
 static int config_input(AVFilterLink *inlink)
 {
-    ConvolutionContext *s = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    ConvolutionContext *s = ctx->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
     int ret;
 
@@ -108,8 +115,9 @@ static int config_input(AVFilterLink *inlink)
 
     s->nb_planes = av_pix_fmt_count_planes(inlink->format);
 
+    s->nb_threads = FFMAX(1, ctx->graph->nb_threads);
     s->bstride = s->planewidth[0] + 32;
-    s->buffer = av_malloc(5 * s->bstride);
+    s->buffer = av_malloc_array(5 * s->bstride, s->nb_threads);
     if (!s->buffer)
         return AVERROR(ENOMEM);
 
@@ -128,15 +136,30 @@ static inline void line_copy8(uint8_t *line, const uint8_t *srcp, int width, int
     }
 }
 
-static void filter_3x3(ConvolutionContext *s, AVFrame *in, AVFrame *out, int plane)
+/* rows outside of the plane are mirrored */
+static inline const uint8_t *src_row(const uint8_t *src, int stride, int y, int height)
+{
+    if (y < 0)
+        y = -y;
+    else if (y >= height)
+        y = 2 * (height - 1) - y;
+    return src + av_clip(y, 0, height - 1) * stride;
+}
+
+static int filter_3x3(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    const uint8_t *src = in->data[plane];
-    uint8_t *dst = out->data[plane];
-    const int stride = in->linesize[plane];
+    ConvolutionContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int plane = td->plane;
+    const uint8_t *src = td->in->data[plane];
+    const int stride = td->in->linesize[plane];
     const int bstride = s->bstride;
     const int height = s->planeheight[plane];
     const int width  = s->planewidth[plane];
-    uint8_t *p0 = s->buffer + 16;
+    const int slice_start = (height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+    uint8_t *dst = td->out->data[plane] + slice_start * td->out->linesize[plane];
+    uint8_t *p0 = s->buffer + jobnr * 5 * bstride + 16;
     uint8_t *p1 = p0 + bstride;
     uint8_t *p2 = p1 + bstride;
     uint8_t *orig = p0, *end = p2;
@@ -145,12 +168,11 @@ static void filter_3x3(ConvolutionContext *s, AVFrame *in, AVFrame *out, int pla
     const float bias = s->bias[plane];
     int y, x;
 
-    line_copy8(p0, src + stride, width, 1);
-    line_copy8(p1, src, width, 1);
+    line_copy8(p0, src_row(src, stride, slice_start - 1, height), width, 1);
+    line_copy8(p1, src_row(src, stride, slice_start,     height), width, 1);
 
-    for (y = 0; y < height; y++) {
-        src += stride * (y < height - 1 ? 1 : -1);
-        line_copy8(p2, src, width, 1);
+    for (y = slice_start; y < slice_end; y++) {
+        line_copy8(p2, src_row(src, stride, y + 1, height), width, 1);
 
         for (x = 0; x < width; x++) {
             int sum = p0[x - 1] * matrix[0] +
@@ -169,19 +191,26 @@ static void filter_3x3(ConvolutionContext *s, AVFrame *in, AVFrame *out, int pla
         p0 = p1;
         p1 = p2;
         p2 = (p2 == end) ? orig: p2 + bstride;
-        dst += out->linesize[plane];
+        dst += td->out->linesize[plane];
     }
+
+    return 0;
 }
 
-static void filter_5x5(ConvolutionContext *s, AVFrame *in, AVFrame *out, int plane)
+static int filter_5x5(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    const uint8_t *src = in->data[plane];
-    uint8_t *dst = out->data[plane];
-    const int stride = in->linesize[plane];
+    ConvolutionContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int plane = td->plane;
+    const uint8_t *src = td->in->data[plane];
+    const int stride = td->in->linesize[plane];
     const int bstride = s->bstride;
     const int height = s->planeheight[plane];
     const int width  = s->planewidth[plane];
-    uint8_t *p0 = s->buffer + 16;
+    const int slice_start = (height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+    uint8_t *dst = td->out->data[plane] + slice_start * td->out->linesize[plane];
+    uint8_t *p0 = s->buffer + jobnr * 5 * bstride + 16;
     uint8_t *p1 = p0 + bstride;
     uint8_t *p2 = p1 + bstride;
     uint8_t *p3 = p2 + bstride;
@@ -192,14 +221,12 @@ static void filter_5x5(ConvolutionContext *s, AVFrame *in, AVFrame *out, int pla
     float bias = s->bias[plane];
     int y, x, i;
 
-    line_copy8(p0, src + 2 * stride, width, 2);
-    line_copy8(p1, src + stride, width, 2);
-    line_copy8(p2, src, width, 2);
-    src += stride;
-    line_copy8(p3, src, width, 2);
+    line_copy8(p0, src_row(src, stride, slice_start - 2, height), width, 2);
+    line_copy8(p1, src_row(src, stride, slice_start - 1, height), width, 2);
+    line_copy8(p2, src_row(src, stride, slice_start,     height), width, 2);
+    line_copy8(p3, src_row(src, stride, slice_start + 1, height), width, 2);
 
-
-    for (y = 0; y < height; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         uint8_t *array[] = {
             p0 - 2, p0 - 1, p0, p0 + 1, p0 + 2,
             p1 - 2, p1 - 1, p1, p1 + 1, p1 + 2,
@@ -208,8 +235,7 @@ static void filter_5x5(ConvolutionContext *s, AVFrame *in, AVFrame *out, int pla
             p4 - 2, p4 - 1, p4, p4 + 1, p4 + 2
         };
 
-        src += stride * (y < height - 2 ? 1 : -1);
-        line_copy8(p4, src, width, 2);
+        line_copy8(p4, src_row(src, stride, y + 2, height), width, 2);
 
         for (x = 0; x < width; x++) {
             int sum = 0;
@@ -226,14 +252,17 @@ static void filter_5x5(ConvolutionContext *s, AVFrame *in, AVFrame *out, int pla
         p2 = p3;
         p3 = p4;
         p4 = (p4 == end) ? orig: p4 + bstride;
-        dst += out->linesize[plane];
+        dst += td->out->linesize[plane];
     }
+
+    return 0;
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
-    ConvolutionContext *s = inlink->dst->priv;
-    AVFilterLink *outlink = inlink->dst->outputs[0];
+    AVFilterContext *ctx = inlink->dst;
+    ConvolutionContext *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
     AVFrame *out;
     int plane;
 
@@ -245,6 +274,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     av_frame_copy_props(out, in);
 
     for (plane = 0; plane < s->nb_planes; plane++) {
+        ThreadData td;
+
         if (s->copy[plane]) {
             av_image_copy_plane(out->data[plane], out->linesize[plane],
                                 in->data[plane], in->linesize[plane],
@@ -253,7 +284,11 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             continue;
         }
 
-        s->filter[plane](s, in, out, plane);
+        td.in    = in;
+        td.out   = out;
+        td.plane = plane;
+        ctx->internal->execute(ctx, s->filter[plane], &td, NULL,
+                               FFMIN(s->planeheight[plane], s->nb_threads));
     }
 
     av_frame_free(&in);
@@ -332,5 +367,5 @@ AVFilter ff_vf_convolution = {
     .query_formats = query_formats,
     .inputs        = convolution_inputs,
     .outputs       = convolution_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
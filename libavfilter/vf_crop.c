@@ -355,6 +355,7 @@ static const AVFilterPad avfilter_vf_crop_inputs[] = {
         .type         = AVMEDIA_TYPE_VIDEO,
         .filter_frame = filter_frame,
         .config_props = config_input,
+        .pipeline     = FF_PAD_PIPELINE,
     },
     { NULL }
 };
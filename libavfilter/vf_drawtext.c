@@ -147,8 +147,9 @@ typedef struct DrawTextContext {
     uint8_t *fontcolor_expr;        ///< fontcolor expression to evaluate
     AVBPrint expanded_fontcolor;    ///< used to contain the expanded fontcolor spec
     int ft_load_flags;              ///< flags used for loading fonts, see FT_LOAD_*
-    FT_Vector *positions;           ///< positions for each element in the text
-    size_t nb_positions;            ///< number of elements of positions array
+    struct GlyphPos *layout;        ///< position of each glyph of the text
+    unsigned int layout_size;       ///< allocated size of layout, in bytes
+    int nb_layout;                  ///< number of glyphs in layout
     char *textfile;                 ///< file with text to be drawn
     int x;                          ///< x position to start drawing text
     int y;                          ///< y position to start drawing text
@@ -174,6 +175,15 @@ typedef struct DrawTextContext {
     FT_Face face;                   ///< freetype font face handle
     FT_Stroker stroker;             ///< freetype stroker handle
     struct AVTreeNode *glyphs;      ///< rendered glyphs, stored using the UTF-32 char code
+    struct Glyph *latin1_glyphs[256]; ///< rendered glyphs with a char code below 256
+    struct GlyphPos *strip_layout;  ///< glyphs the text strip was rendered from
+    unsigned int strip_layout_size; ///< allocated size of strip_layout, in bytes
+    int nb_strip_layout;            ///< number of glyphs in strip_layout
+    uint8_t *strip[2];              ///< cached coverage of the text and of its border
+    unsigned int strip_size[2];     ///< allocated size of the strips
+    int strip_x, strip_y;           ///< position of the strips relative to the text
+    int strip_w, strip_h;           ///< dimensions of the strips
+    int nb_threads;
     char *x_expr;                   ///< expression for x position
     char *y_expr;                   ///< expression for y position
     AVExpr *x_pexpr, *y_pexpr;      ///< parsed expressions for x and y
@@ -282,12 +292,19 @@ typedef struct Glyph {
     uint32_t code;
     FT_Bitmap bitmap; ///< array holding bitmaps of font
     FT_Bitmap border_bitmap; ///< array holding bitmaps of font border
+    uint8_t *mask;           ///< bitmap as 8-bit coverage, bitmap.width x bitmap.rows
+    uint8_t *border_mask;    ///< border_bitmap as 8-bit coverage
     FT_BBox bbox;
     int advance;
     int bitmap_left;
     int bitmap_top;
 } Glyph;
 
+typedef struct GlyphPos {
+    Glyph *glyph;
+    int x, y;                ///< position of the glyph bitmap relative to the text
+} GlyphPos;
+
 static int glyph_cmp(const void *key, const void *b)
 {
     const Glyph *a = key, *bb = b;
@@ -295,6 +312,48 @@ static int glyph_cmp(const void *key, const void *b)
     return diff > 0 ? 1 : diff < 0 ? -1 : 0;
 }
 
+/**
+ * Convert a FreeType bitmap to 8-bit coverage values, so that it can be
+ * composited without looking at its pixel mode again.
+ * Unsupported pixel modes leave *mask NULL.
+ */
+static int bitmap_to_mask(uint8_t **mask, const FT_Bitmap *bitmap)
+{
+    int x, y;
+
+    *mask = NULL;
+    if (bitmap->pixel_mode != FT_PIXEL_MODE_MONO &&
+        bitmap->pixel_mode != FT_PIXEL_MODE_GRAY)
+        return 0;
+
+    *mask = av_malloc(FFMAX(bitmap->width * bitmap->rows, 1));
+    if (!*mask)
+        return AVERROR(ENOMEM);
+
+    for (y = 0; y < bitmap->rows; y++) {
+        const uint8_t *src = bitmap->buffer + y * bitmap->pitch;
+        uint8_t *dst = *mask + y * bitmap->width;
+
+        if (bitmap->pixel_mode == FT_PIXEL_MODE_MONO) {
+            for (x = 0; x < bitmap->width; x++)
+                dst[x] = (src[x >> 3] >> (7 - (x & 7)) & 1) * 255;
+        } else {
+            memcpy(dst, src, bitmap->width);
+        }
+    }
+    return 0;
+}
+
+static Glyph *find_glyph(DrawTextContext *s, uint32_t code)
+{
+    Glyph dummy = { 0 };
+
+    if (code < FF_ARRAY_ELEMS(s->latin1_glyphs))
+        return s->latin1_glyphs[code];
+    dummy.code = code;
+    return av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+}
+
 /**
  * Load glyphs corresponding to the UTF-32 codepoint code.
  */
@@ -342,6 +401,11 @@ static int load_glyph(AVFilterContext *ctx, Glyph **glyph_ptr, uint32_t code)
     glyph->bitmap_top  = bitmapglyph->top;
     glyph->advance     = s->face->glyph->advance.x >> 6;
 
+    if ((ret = bitmap_to_mask(&glyph->mask, &glyph->bitmap)) < 0 ||
+        (s->borderw &&
+         (ret = bitmap_to_mask(&glyph->border_mask, &glyph->border_bitmap)) < 0))
+        goto error;
+
     /* measure text height to calculate text_height (or the maximum text height) */
     FT_Glyph_Get_CBox(glyph->glyph, ft_glyph_bbox_pixels, &glyph->bbox);
 
@@ -351,14 +415,19 @@ static int load_glyph(AVFilterContext *ctx, Glyph **glyph_ptr, uint32_t code)
         goto error;
     }
     av_tree_insert(&s->glyphs, glyph, glyph_cmp, &node);
+    if (code < FF_ARRAY_ELEMS(s->latin1_glyphs))
+        s->latin1_glyphs[code] = glyph;
 
     if (glyph_ptr)
         *glyph_ptr = glyph;
     return 0;
 
 error:
-    if (glyph)
+    if (glyph) {
         av_freep(&glyph->glyph);
+        av_freep(&glyph->mask);
+        av_freep(&glyph->border_mask);
+    }
 
     av_freep(&glyph);
     av_freep(&node);
@@ -697,6 +766,8 @@ static int glyph_enu_free(void *opaque, void *elem)
 
     FT_Done_Glyph(glyph->glyph);
     FT_Done_Glyph(glyph->border_glyph);
+    av_free(glyph->mask);
+    av_free(glyph->border_mask);
     av_free(elem);
     return 0;
 }
@@ -708,9 +779,14 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_expr_free(s->x_pexpr);
     av_expr_free(s->y_pexpr);
     s->x_pexpr = s->y_pexpr = NULL;
-    av_freep(&s->positions);
-    s->nb_positions = 0;
-
+    av_freep(&s->layout);
+    s->layout_size = s->nb_layout = 0;
+    av_freep(&s->strip_layout);
+    s->strip_layout_size = s->nb_strip_layout = 0;
+    av_freep(&s->strip[0]);
+    av_freep(&s->strip[1]);
+    s->strip_size[0] = s->strip_size[1] = 0;
+    memset(s->latin1_glyphs, 0, sizeof(s->latin1_glyphs));
 
     av_tree_enumerate(s->glyphs, NULL, NULL, glyph_enu_free);
     av_tree_destroy(s->glyphs);
@@ -746,6 +822,8 @@ static int config_input(AVFilterLink *inlink)
     s->var_values[VAR_Y]     = NAN;
     s->var_values[VAR_T]     = NAN;
 
+    s->nb_threads = FFMAX(1, ctx->graph->nb_threads);
+
     av_lfg_init(&s->prng, av_get_random_seed());
 
     av_expr_free(s->x_pexpr);
@@ -1070,49 +1148,230 @@ static int expand_text(AVFilterContext *ctx, char *text, AVBPrint *bp)
     return 0;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       int width, int height,
-                       FFDrawColor *color,
-                       int x, int y, int borderw)
+#define FAST_DIV255(x) ((((x) + 128) * 257) >> 16)
+#define MAX_DIRTY_RECTS 8
+
+typedef struct TextRect {
+    int x0, y0, x1, y1;
+} TextRect;
+
+/**
+ * Get the area covered by a glyph and its border, relative to the text.
+ */
+static TextRect glyph_rect(DrawTextContext *s, const GlyphPos *pos)
 {
-    char *text = s->expanded_text.str;
-    uint32_t code = 0;
-    int i, x1, y1;
-    uint8_t *p;
-    Glyph *glyph = NULL;
+    const Glyph *glyph = pos->glyph;
+    TextRect r = { pos->x, pos->y,
+                   pos->x + glyph->bitmap.width, pos->y + glyph->bitmap.rows };
 
-    for (i = 0, p = text; *p; i++) {
-        FT_Bitmap bitmap;
-        Glyph dummy = { 0 };
-        GET_UTF8(code, *p++, continue;);
+    if (s->borderw) {
+        r.x0 = FFMIN(r.x0, pos->x - s->borderw);
+        r.y0 = FFMIN(r.y0, pos->y - s->borderw);
+        r.x1 = FFMAX(r.x1, pos->x - s->borderw + (int)glyph->border_bitmap.width);
+        r.y1 = FFMAX(r.y1, pos->y - s->borderw + (int)glyph->border_bitmap.rows);
+    }
+    return r;
+}
 
-        /* skip new line chars, just go to new line */
-        if (code == '\n' || code == '\r' || code == '\t')
-            continue;
+static void rect_union(TextRect *r, const TextRect *r2)
+{
+    r->x0 = FFMIN(r->x0, r2->x0);
+    r->y0 = FFMIN(r->y0, r2->y0);
+    r->x1 = FFMAX(r->x1, r2->x1);
+    r->y1 = FFMAX(r->y1, r2->y1);
+}
+
+/**
+ * Composite the part of a glyph mask of size w x h at x, y that lies in
+ * the area r of a strip. Coverages combine like successive blends would.
+ */
+static void strip_add_mask(DrawTextContext *s, uint8_t *strip,
+                           const uint8_t *mask, int w, int h,
+                           int x, int y, const TextRect *r)
+{
+    int x0 = FFMAX(x, r->x0), x1 = FFMIN(x + w, r->x1);
+    int y0 = FFMAX(y, r->y0), y1 = FFMIN(y + h, r->y1);
+    int i, j;
 
-        dummy.code = code;
-        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+    if (!mask)
+        return;
+    for (j = y0; j < y1; j++) {
+        uint8_t *dst       = strip + (j - s->strip_y) * s->strip_w - s->strip_x;
+        const uint8_t *src = mask + (j - y) * w - x;
 
-        bitmap = borderw ? glyph->border_bitmap : glyph->bitmap;
+        for (i = x0; i < x1; i++)
+            dst[i] = dst[i] + src[i] - FAST_DIV255(dst[i] * src[i]);
+    }
+}
 
-        if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
-            glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
-            return AVERROR(EINVAL);
+/**
+ * Render the area r of the strips from scratch.
+ */
+static void render_strip_rect(DrawTextContext *s, const TextRect *r)
+{
+    int i, y;
+
+    for (y = r->y0; y < r->y1; y++) {
+        int offset = (y - s->strip_y) * s->strip_w + r->x0 - s->strip_x;
+
+        memset(s->strip[0] + offset, 0, r->x1 - r->x0);
+        if (s->borderw)
+            memset(s->strip[1] + offset, 0, r->x1 - r->x0);
+    }
+
+    for (i = 0; i < s->nb_layout; i++) {
+        const GlyphPos *pos = &s->layout[i];
+        const Glyph *glyph  = pos->glyph;
+        TextRect gr = glyph_rect(s, pos);
+
+        if (gr.x1 <= r->x0 || gr.x0 >= r->x1 || gr.y1 <= r->y0 || gr.y0 >= r->y1)
+            continue;
+        strip_add_mask(s, s->strip[0], glyph->mask,
+                       glyph->bitmap.width, glyph->bitmap.rows,
+                       pos->x, pos->y, r);
+        if (s->borderw)
+            strip_add_mask(s, s->strip[1], glyph->border_mask,
+                           glyph->border_bitmap.width, glyph->border_bitmap.rows,
+                           pos->x - s->borderw, pos->y - s->borderw, r);
+    }
+}
+
+/**
+ * Bring the cached text strips up to date with the current layout.
+ * Only the areas of the glyphs which changed since the last frame are
+ * rendered again, so that e.g. a running timecode costs a few digits.
+ */
+static int update_strip(DrawTextContext *s)
+{
+    TextRect bounds, dirty[MAX_DIRTY_RECTS];
+    int i, nb_dirty = 0;
+    void *tmp;
 
-        x1 = s->positions[i].x+s->x+x - borderw;
-        y1 = s->positions[i].y+s->y+y - borderw;
+    if (!s->nb_layout) {
+        s->strip_w = s->strip_h = s->nb_strip_layout = 0;
+        return 0;
+    }
 
-        ff_blend_mask(&s->dc, color,
-                      frame->data, frame->linesize, width, height,
-                      bitmap.buffer, bitmap.pitch,
-                      bitmap.width, bitmap.rows,
-                      bitmap.pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
-                      0, x1, y1);
+    bounds = glyph_rect(s, &s->layout[0]);
+    for (i = 1; i < s->nb_layout; i++) {
+        TextRect r = glyph_rect(s, &s->layout[i]);
+        rect_union(&bounds, &r);
+    }
+
+    if (s->nb_layout != s->nb_strip_layout ||
+        bounds.x0 != s->strip_x || bounds.x1 - bounds.x0 != s->strip_w ||
+        bounds.y0 != s->strip_y || bounds.y1 - bounds.y0 != s->strip_h) {
+        int size;
+
+        s->strip_x = bounds.x0;
+        s->strip_y = bounds.y0;
+        s->strip_w = bounds.x1 - bounds.x0;
+        s->strip_h = bounds.y1 - bounds.y0;
+        size = FFMAX(s->strip_w * s->strip_h, 1);
+        for (i = 0; i < 1 + !!s->borderw; i++) {
+            av_fast_malloc(&s->strip[i], &s->strip_size[i], size);
+            if (!s->strip[i]) {
+                s->strip_w = s->strip_h = s->nb_strip_layout = 0;
+                return AVERROR(ENOMEM);
+            }
+        }
+        dirty[nb_dirty++] = bounds;
+    } else {
+        for (i = 0; i < s->nb_layout; i++) {
+            const GlyphPos *pos = &s->layout[i], *prev = &s->strip_layout[i];
+            TextRect r, r2;
+
+            if (pos->glyph == prev->glyph && pos->x == prev->x && pos->y == prev->y)
+                continue;
+            r  = glyph_rect(s, pos);
+            r2 = glyph_rect(s, prev);
+            rect_union(&r, &r2);
+            if (nb_dirty == MAX_DIRTY_RECTS) {
+                rect_union(&dirty[0], &r);
+                while (--nb_dirty > 0)
+                    rect_union(&dirty[0], &dirty[nb_dirty]);
+                nb_dirty = 1;
+            } else {
+                dirty[nb_dirty++] = r;
+            }
+        }
     }
 
+    if (!nb_dirty)
+        return 0;
+
+    for (i = 0; i < nb_dirty; i++)
+        render_strip_rect(s, &dirty[i]);
+
+    tmp = av_fast_realloc(s->strip_layout, &s->strip_layout_size,
+                          s->nb_layout * sizeof(*s->layout));
+    if (!tmp) {
+        s->nb_strip_layout = 0;
+        return AVERROR(ENOMEM);
+    }
+    s->strip_layout = tmp;
+    memcpy(s->strip_layout, s->layout, s->nb_layout * sizeof(*s->layout));
+    s->nb_strip_layout = s->nb_layout;
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *frame;
+    int width, height;
+    int y0, y1;                     ///< rows covered by the text and its box
+    int box_w, box_h;
+    FFDrawColor fontcolor;
+    FFDrawColor shadowcolor;
+    FFDrawColor bordercolor;
+    FFDrawColor boxcolor;
+} ThreadData;
+
+static int draw_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td     = arg;
+    const int align    = (1 << s->dc.vsub_max) - 1;
+    const int start    = !jobnr ? 0 :
+                         (td->y0 + (td->y1 - td->y0) *  jobnr      / nb_jobs) & ~align;
+    const int end      = jobnr == nb_jobs - 1 ? td->height :
+                         (td->y0 + (td->y1 - td->y0) * (jobnr + 1) / nb_jobs) & ~align;
+    const int x        = s->x + s->strip_x;
+    const int y        = s->y + s->strip_y - start;
+    uint8_t *data[4];
+    int plane;
+
+    if (end <= start)
+        return 0;
+    for (plane = 0; plane < s->dc.nb_planes; plane++)
+        data[plane] = td->frame->data[plane] +
+                      (start >> s->dc.vsub[plane]) * td->frame->linesize[plane];
+
+    if (s->draw_box)
+        ff_blend_rectangle(&s->dc, &td->boxcolor,
+                           data, td->frame->linesize, td->width, end - start,
+                           s->x - s->boxborderw, s->y - s->boxborderw - start,
+                           td->box_w + s->boxborderw * 2, td->box_h + s->boxborderw * 2);
+
+    if (!s->strip_w)
+        return 0;
+
+    if (s->shadowx || s->shadowy)
+        ff_blend_mask(&s->dc, &td->shadowcolor,
+                      data, td->frame->linesize, td->width, end - start,
+                      s->strip[0], s->strip_w, s->strip_w, s->strip_h,
+                      3, 0, x + s->shadowx, y + s->shadowy);
+    if (s->borderw)
+        ff_blend_mask(&s->dc, &td->bordercolor,
+                      data, td->frame->linesize, td->width, end - start,
+                      s->strip[1], s->strip_w, s->strip_w, s->strip_h,
+                      3, 0, x, y);
+    ff_blend_mask(&s->dc, &td->fontcolor,
+                  data, td->frame->linesize, td->width, end - start,
+                  s->strip[0], s->strip_w, s->strip_w, s->strip_h,
+                  3, 0, x, y);
+
+    return 0;
+}
 
 static void update_color_with_alpha(DrawTextContext *s, FFDrawColor *color, const FFDrawColor incolor)
 {
@@ -1152,17 +1411,13 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     int x_min = 32000, x_max = -32000;
     FT_Vector delta;
     Glyph *glyph = NULL, *prev_glyph = NULL;
-    Glyph dummy = { 0 };
+    ThreadData td;
+    void *tmp;
 
     time_t now = time(0);
     struct tm ltime;
     AVBPrint *bp = &s->expanded_text;
 
-    FFDrawColor fontcolor;
-    FFDrawColor shadowcolor;
-    FFDrawColor bordercolor;
-    FFDrawColor boxcolor;
-
     av_bprint_clear(bp);
 
     if(s->basetime != AV_NOPTS_VALUE)
@@ -1192,12 +1447,12 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     if (!av_bprint_is_complete(bp))
         return AVERROR(ENOMEM);
     text = s->expanded_text.str;
-    if ((len = s->expanded_text.len) > s->nb_positions) {
-        if (!(s->positions =
-              av_realloc(s->positions, len*sizeof(*s->positions))))
-            return AVERROR(ENOMEM);
-        s->nb_positions = len;
-    }
+    len  = s->expanded_text.len;
+    tmp  = av_fast_realloc(s->layout, &s->layout_size, len * sizeof(*s->layout));
+    if (!tmp)
+        return AVERROR(ENOMEM);
+    s->layout    = tmp;
+    s->nb_layout = 0;
 
     if (s->fontcolor_expr[0]) {
         /* If expression is set, evaluate and replace the static value */
@@ -1221,8 +1476,7 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
         GET_UTF8(code, *p++, continue;);
 
         /* get glyph */
-        dummy.code = code;
-        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+        glyph = find_glyph(s, code);
         if (!glyph) {
             ret = load_glyph(ctx, &glyph, code);
             if (ret < 0)
@@ -1257,8 +1511,7 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
 
         /* get glyph */
         prev_glyph = glyph;
-        dummy.code = code;
-        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+        glyph = find_glyph(s, code);
 
         /* kerning */
         if (s->use_kerning && prev_glyph && glyph->code) {
@@ -1268,8 +1521,12 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
         }
 
         /* save position */
-        s->positions[i].x = x + glyph->bitmap_left;
-        s->positions[i].y = y - glyph->bitmap_top + y_max;
+        if (code != '\t') {
+            GlyphPos *pos = &s->layout[s->nb_layout++];
+            pos->glyph = glyph;
+            pos->x     = x + glyph->bitmap_left;
+            pos->y     = y - glyph->bitmap_top + y_max;
+        }
         if (code == '\t') x  = (x / s->tabsize + 1)*s->tabsize;
         else              x += glyph->advance;
     }
@@ -1291,35 +1548,42 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     s->x = s->var_values[VAR_X] = av_expr_eval(s->x_pexpr, s->var_values, &s->prng);
 
     update_alpha(s);
-    update_color_with_alpha(s, &fontcolor  , s->fontcolor  );
-    update_color_with_alpha(s, &shadowcolor, s->shadowcolor);
-    update_color_with_alpha(s, &bordercolor, s->bordercolor);
-    update_color_with_alpha(s, &boxcolor   , s->boxcolor   );
+    update_color_with_alpha(s, &td.fontcolor  , s->fontcolor  );
+    update_color_with_alpha(s, &td.shadowcolor, s->shadowcolor);
+    update_color_with_alpha(s, &td.bordercolor, s->bordercolor);
+    update_color_with_alpha(s, &td.boxcolor   , s->boxcolor   );
 
     box_w = FFMIN(width - 1 , max_text_line_w);
     box_h = FFMIN(height - 1, y + s->max_glyph_h);
 
-    /* draw box */
-    if (s->draw_box)
-        ff_blend_rectangle(&s->dc, &boxcolor,
-                           frame->data, frame->linesize, width, height,
-                           s->x - s->boxborderw, s->y - s->boxborderw,
-                           box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
-
-    if (s->shadowx || s->shadowy) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &shadowcolor, s->shadowx, s->shadowy, 0)) < 0)
-            return ret;
-    }
+    if ((ret = update_strip(s)) < 0)
+        return ret;
 
-    if (s->borderw) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &bordercolor, 0, 0, s->borderw)) < 0)
-            return ret;
+    /* rows touched by the box, the shadow, the border and the text */
+    td.y0 = INT_MAX;
+    td.y1 = INT_MIN;
+    if (s->draw_box) {
+        td.y0 = s->y - s->boxborderw;
+        td.y1 = s->y + box_h + s->boxborderw;
     }
-    if ((ret = draw_glyphs(s, frame, width, height,
-                           &fontcolor, 0, 0, 0)) < 0)
-        return ret;
+    if (s->strip_h) {
+        int shadowy = FFMIN(s->shadowy, 0), shadowh = FFABS(s->shadowy);
+        td.y0 = FFMIN(td.y0, s->y + s->strip_y + shadowy);
+        td.y1 = FFMAX(td.y1, s->y + s->strip_y + shadowy + s->strip_h + shadowh);
+    }
+    td.y0 = av_clip(td.y0, 0, height);
+    td.y1 = av_clip(td.y1, 0, height);
+    if (td.y0 >= td.y1)
+        return 0;
+
+    td.frame  = frame;
+    td.width  = width;
+    td.height = height;
+    td.box_w  = box_w;
+    td.box_h  = box_h;
+    /* only split text which is tall enough to be worth it */
+    ctx->internal->execute(ctx, draw_slice, &td, NULL,
+                           FFMIN(s->nb_threads, FFMAX(1, (td.y1 - td.y0) >> 5)));
 
     return 0;
 }
@@ -1369,6 +1633,7 @@ static const AVFilterPad avfilter_vf_drawtext_inputs[] = {
         .filter_frame   = filter_frame,
         .config_props   = config_input,
         .needs_writable = 1,
+        .pipeline       = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -1392,5 +1657,5 @@ AVFilter ff_vf_drawtext = {
     .inputs        = avfilter_vf_drawtext_inputs,
     .outputs       = avfilter_vf_drawtext_outputs,
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
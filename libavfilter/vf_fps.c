@@ -269,6 +269,7 @@ static const AVFilterPad avfilter_vf_fps_inputs[] = {
         .name         = "default",
         .type         = AVMEDIA_TYPE_VIDEO,
         .filter_frame = filter_frame,
+        .pipeline     = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -178,6 +178,7 @@ static const AVFilterPad avfilter_vf_hflip_inputs[] = {
         .type         = AVMEDIA_TYPE_VIDEO,
         .filter_frame = filter_frame,
         .config_props = config_props,
+        .pipeline     = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -475,6 +475,7 @@ static const AVFilterPad inputs[] = {
       .type         = AVMEDIA_TYPE_VIDEO,
       .filter_frame = filter_frame,
       .config_props = config_props,
+      .pipeline     = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -22,13 +22,14 @@
 #include <float.h>
 
 #include "libavutil/common.h"
-#include "libavutil/float_dsp.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/thread.h"
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "nnedi.h"
 #include "video.h"
 
 typedef struct FrameData {
@@ -43,10 +44,35 @@ typedef struct FrameData {
     int field[3];
 
     int32_t *lcount[3];
-    float *input;
-    float *temp;
+    float *input;       ///< 512 floats per thread
+    float *temp;        ///< temp_size bytes per thread
+    size_t temp_size;
 } FrameData;
 
+/**
+ * Prescreener and predictor weights prepared for a given set of options.
+ * They only depend on the weights file and on the network parameters, so
+ * they are shared by all the filter instances using the same ones.
+ */
+typedef struct NNEDIWeights {
+    char *file;
+    int nsize;
+    int nnsparam;
+    int etype;
+    int pscrn;
+    int fapprox;
+
+    float *weights0;
+    float *weights1[2];
+
+    int refcount;
+    struct NNEDIWeights *next;
+} NNEDIWeights;
+
+static NNEDIWeights *weights_cache;
+static AVMutex weights_cache_lock;
+static AVOnce weights_cache_once = AV_ONCE_INIT;
+
 typedef struct NNEDIContext {
     const AVClass *class;
 
@@ -58,13 +84,13 @@ typedef struct NNEDIContext {
     int eof;
     int64_t cur_pts;
 
-    AVFloatDSPContext *fdsp;
+    NNEDIDSPContext dsp;
     int nb_planes;
+    int nb_threads;
     int linesize[4];
     int planeheight[4];
 
-    float *weights0;
-    float *weights1[2];
+    NNEDIWeights *weights;
     int asize;
     int nns;
     int xdia;
@@ -84,8 +110,8 @@ typedef struct NNEDIContext {
     int max_value;
 
     void (*copy_pad)(const AVFrame *, FrameData *, struct NNEDIContext *, int);
-    void (*evalfunc_0)(struct NNEDIContext *, FrameData *);
-    void (*evalfunc_1)(struct NNEDIContext *, FrameData *);
+    void (*evalfunc_0)(struct NNEDIContext *, FrameData *, int jobnr, int nb_jobs);
+    void (*evalfunc_1)(struct NNEDIContext *, FrameData *, int jobnr, int nb_jobs);
 
     // Functions used in evalfunc_0
     void (*readpixels)(const uint8_t *, const int, float *);
@@ -161,6 +187,8 @@ static int config_input(AVFilterLink *inlink)
     s->planeheight[1] = s->planeheight[2] = AV_CEIL_RSHIFT(inlink->h, desc->log2_chroma_h);
     s->planeheight[0] = s->planeheight[3] = inlink->h;
 
+    s->nb_threads = FFMAX(1, ctx->graph->nb_threads);
+
     return 0;
 }
 
@@ -257,6 +285,36 @@ static void copy_pad(const AVFrame *src, FrameData *frame_data, NNEDIContext *s,
     }
 }
 
+static float scalarproduct_float_c(const float *v1, const float *v2, int len)
+{
+    float p = 0.0f;
+    int i;
+
+    for (i = 0; i < len; i++)
+        p += v1[i] * v2[i];
+
+    return p;
+}
+
+static int scalarproduct_int16_c(const int16_t *v1, const int16_t *v2, int len)
+{
+    int i, p = 0;
+
+    for (i = 0; i < len; i++)
+        p += v1[i] * v2[i];
+
+    return p;
+}
+
+av_cold void ff_nnedi_init(NNEDIDSPContext *dsp)
+{
+    dsp->scalarproduct_float = scalarproduct_float_c;
+    dsp->scalarproduct_int16 = scalarproduct_int16_c;
+
+    if (ARCH_X86)
+        ff_nnedi_init_x86(dsp);
+}
+
 static void elliott(float *data, const int n)
 {
     int i;
@@ -272,7 +330,7 @@ static void dot_prod(NNEDIContext *s, const float *data, const float *weights, f
     for (i = 0; i < n; i++) {
         float sum;
 
-        sum = s->fdsp->scalarproduct_float(data, &weights[i * len], len);
+        sum = s->dsp.scalarproduct_float(data, &weights[i * len], len);
 
         vals[i] = sum * scale[0] + weights[n * len + i];
     }
@@ -283,12 +341,11 @@ static void dot_prods(NNEDIContext *s, const float *dataf, const float *weightsf
     const int16_t *data = (int16_t *)dataf;
     const int16_t *weights = (int16_t *)weightsf;
     const float *wf = (float *)&weights[n * len];
-    int i, j;
+    int i;
 
     for (i = 0; i < n; i++) {
-        int sum = 0, off = ((i >> 2) << 3) + (i & 3);
-        for (j = 0; j < len; j++)
-            sum += data[j] * weights[i * len + j];
+        int sum = s->dsp.scalarproduct_int16(data, &weights[i * len], len);
+        int off = ((i >> 2) << 3) + (i & 3);
 
         vals[i] = sum * wf[off] * scale[0] + wf[off + 4];
     }
@@ -389,11 +446,9 @@ static void compute_network0new(NNEDIContext *s, const float *datai, const float
     int mask, i, j;
 
     for (i = 0; i < 4; i++) {
-        int sum = 0;
+        int sum = s->dsp.scalarproduct_int16(data, ws + i * 64, 64);
         float t;
 
-        for (j = 0; j < 64; j++)
-            sum += data[j] * ws[(i << 3) + ((j >> 3) << 5) + (j & 7)];
         t = sum * wf[i] + wf[4 + i];
         vals[i] = t / (1.0f + FFABS(t));
     }
@@ -415,12 +470,11 @@ static void compute_network0new(NNEDIContext *s, const float *datai, const float
     ((int *)d)[0] = mask;
 }
 
-static void evalfunc_0(NNEDIContext *s, FrameData *frame_data)
+static void evalfunc_0(NNEDIContext *s, FrameData *frame_data, int jobnr, int nb_jobs)
 {
-    float *input = frame_data->input;
-    const float *weights0 = s->weights0;
-    float *temp = frame_data->temp;
-    uint8_t *tempu = (uint8_t *)temp;
+    float *input = frame_data->input + jobnr * 512;
+    const float *weights0 = s->weights->weights0;
+    uint8_t *tempu = (uint8_t *)frame_data->temp + jobnr * frame_data->temp_size;
     int plane, x, y;
 
     // And now the actual work.
@@ -433,6 +487,9 @@ static void evalfunc_0(NNEDIContext *s, FrameData *frame_data)
 
         uint8_t *dstp = (uint8_t *)frame_data->dstp[plane];
         const int dst_stride = frame_data->dst_stride[plane] / sizeof(uint8_t);
+        const int field = frame_data->field[plane];
+        const int slice_start = ((height - 12) *  jobnr     ) / nb_jobs;
+        const int slice_end   = ((height - 12) * (jobnr + 1)) / nb_jobs;
         const uint8_t *src3p;
         int ystart, ystop;
         int32_t *lcount;
@@ -440,15 +497,16 @@ static void evalfunc_0(NNEDIContext *s, FrameData *frame_data)
         if (!(s->process_plane & (1 << plane)))
             continue;
 
-        for (y = 1 - frame_data->field[plane]; y < height - 12; y += 2) {
+        // Lines of the kept field in this slice.
+        for (y = slice_start + ((slice_start + field + 1) & 1); y < slice_end; y += 2) {
             memcpy(dstp + y * dst_stride,
                    srcp + 32 + (6 + y) * src_stride,
                    (width - 64) * sizeof(uint8_t));
 
         }
 
-        ystart = 6 + frame_data->field[plane];
-        ystop = height - 6;
+        ystart = 6 + slice_start + ((slice_start + field) & 1);
+        ystop = 6 + slice_end;
         srcp += ystart * src_stride;
         dstp += (ystart - 6) * dst_stride - 32;
         src3p = srcp - src_stride * 3;
@@ -575,11 +633,11 @@ static void weighted_avg_elliott_mul5_m16(const float *w, const int n, float *ms
 }
 
 
-static void evalfunc_1(NNEDIContext *s, FrameData *frame_data)
+static void evalfunc_1(NNEDIContext *s, FrameData *frame_data, int jobnr, int nb_jobs)
 {
-    float *input = frame_data->input;
-    float *temp = frame_data->temp;
-    float **weights1 = s->weights1;
+    float *input = frame_data->input + jobnr * 512;
+    float *temp = (float *)((uint8_t *)frame_data->temp + jobnr * frame_data->temp_size);
+    float **weights1 = s->weights->weights1;
     const int qual = s->qual;
     const int asize = s->asize;
     const int nns = s->nns;
@@ -599,8 +657,10 @@ static void evalfunc_1(NNEDIContext *s, FrameData *frame_data)
         uint8_t *dstp = (uint8_t *)frame_data->dstp[plane];
         const int dst_stride = frame_data->dst_stride[plane] / sizeof(uint8_t);
 
-        const int ystart = frame_data->field[plane];
-        const int ystop = height - 12;
+        const int slice_start = ((height - 12) *  jobnr     ) / nb_jobs;
+        const int slice_end   = ((height - 12) * (jobnr + 1)) / nb_jobs;
+        const int ystart = slice_start + ((slice_start + frame_data->field[plane]) & 1);
+        const int ystop = slice_end;
         const uint8_t *srcpp;
 
         if (!(s->process_plane & (1 << plane)))
@@ -635,6 +695,10 @@ static void evalfunc_1(NNEDIContext *s, FrameData *frame_data)
 #define NUM_NSIZE 7
 #define NUM_NNS 5
 
+static const int xdia_table[NUM_NSIZE] = { 8, 16, 32, 48, 8, 16, 32 };
+static const int ydia_table[NUM_NSIZE] = { 6, 6, 6, 6, 4, 4, 4 };
+static const int nns_table[NUM_NNS] = { 16, 32, 64, 128, 256 };
+
 static int roundds(const double f)
 {
     if (f - floor(f) >= 0.5)
@@ -686,6 +750,20 @@ static int modnpf(const int m, const int n)
     return m + n - (m % n);
 }
 
+static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    NNEDIContext *s = ctx->priv;
+    FrameData *frame_data = arg;
+
+    // Handles prescreening and the cubic interpolation.
+    s->evalfunc_0(s, frame_data, jobnr, nb_jobs);
+
+    // The rest.
+    s->evalfunc_1(s, frame_data, jobnr, nb_jobs);
+
+    return 0;
+}
+
 static int get_frame(AVFilterContext *ctx, int is_second)
 {
     NNEDIContext *s = ctx->priv;
@@ -693,7 +771,6 @@ static int get_frame(AVFilterContext *ctx, int is_second)
     AVFrame *src = s->src;
     FrameData *frame_data;
     int effective_field = s->field;
-    size_t temp_size;
     int field_n;
     int plane;
 
@@ -766,15 +843,15 @@ static int get_frame(AVFilterContext *ctx, int is_second)
     }
 
     if (!frame_data->input) {
-        frame_data->input = av_malloc(512 * sizeof(float));
+        frame_data->input = av_malloc_array(s->nb_threads, 512 * sizeof(float));
         if (!frame_data->input)
             return AVERROR(ENOMEM);
     }
     // evalfunc_0 requires at least padded_width[0] bytes.
     // evalfunc_1 requires at least 512 floats.
     if (!frame_data->temp) {
-        temp_size = FFMAX(frame_data->padded_width[0], 512 * sizeof(float));
-        frame_data->temp = av_malloc(temp_size);
+        frame_data->temp_size = FFALIGN(FFMAX(frame_data->padded_width[0], 512 * sizeof(float)), 64);
+        frame_data->temp = av_malloc_array(s->nb_threads, frame_data->temp_size);
         if (!frame_data->temp)
             return AVERROR(ENOMEM);
     }
@@ -782,11 +859,8 @@ static int get_frame(AVFilterContext *ctx, int is_second)
     // Copy src to a padded "frame" in frame_data and mirror the edges.
     s->copy_pad(src, frame_data, s, field_n);
 
-    // Handles prescreening and the cubic interpolation.
-    s->evalfunc_0(s, frame_data);
-
-    // The rest.
-    s->evalfunc_1(s, frame_data);
+    ctx->internal->execute(ctx, filter_slice, frame_data, NULL,
+                           FFMIN(s->planeheight[1], s->nb_threads));
 
     return 0;
 }
@@ -904,7 +978,21 @@ static int request_frame(AVFilterLink *link)
     return 0;
 }
 
-static av_cold int init(AVFilterContext *ctx)
+static void weights_cache_init(void)
+{
+    ff_mutex_init(&weights_cache_lock, NULL);
+}
+
+static void free_weights(NNEDIWeights *w)
+{
+    av_freep(&w->file);
+    av_freep(&w->weights0);
+    av_freep(&w->weights1[0]);
+    av_freep(&w->weights1[1]);
+    av_free(w);
+}
+
+static av_cold int read_weights(AVFilterContext *ctx, NNEDIWeights *w)
 {
     NNEDIContext *s = ctx->priv;
     FILE *weights_file = NULL;
@@ -912,9 +1000,6 @@ static av_cold int init(AVFilterContext *ctx)
     int64_t weights_size;
     float *bdata;
     size_t bytes_read;
-    const int xdia_table[NUM_NSIZE] = { 8, 16, 32, 48, 8, 16, 32 };
-    const int ydia_table[NUM_NSIZE] = { 6, 6, 6, 6, 4, 4, 4 };
-    const int nns_table[NUM_NNS] = { 16, 32, 64, 128, 256 };
     const int dims0 = 49 * 4 + 5 * 4 + 9 * 4;
     const int dims0new = 4 * 65 + 4 * 5;
     const int dims1 = nns_table[s->nnsparam] * 2 * (xdia_table[s->nsize] * ydia_table[s->nsize] + 1);
@@ -977,15 +1062,15 @@ static av_cold int init(AVFilterContext *ctx)
         }
     }
 
-    s->weights0 = av_malloc_array(FFMAX(dims0, dims0new), sizeof(float));
-    if (!s->weights0) {
+    w->weights0 = av_malloc_array(FFMAX(dims0, dims0new), sizeof(float));
+    if (!w->weights0) {
         ret = AVERROR(ENOMEM);
         goto fail;
     }
 
     for (i = 0; i < 2; i++) {
-        s->weights1[i] = av_malloc_array(dims1, sizeof(float));
-        if (!s->weights1[i]) {
+        w->weights1[i] = av_malloc_array(dims1, sizeof(float));
+        if (!w->weights1[i]) {
             ret = AVERROR(ENOMEM);
             goto fail;
         }
@@ -1009,7 +1094,7 @@ static av_cold int init(AVFilterContext *ctx)
                 offt[j * 64 + k] = ((k >> 3) << 5) + ((j & 3) << 3) + (k & 7);
 
         bdw = bdata + dims0 + dims0new * (s->pscrn - 2);
-        ws = (int16_t *)s->weights0;
+        ws = (int16_t *)w->weights0;
         wf = (float *)&ws[4 * 64];
         // Calculate mean weight of each first layer neuron
         for (j = 0; j < 4; j++) {
@@ -1027,7 +1112,7 @@ static av_cold int init(AVFilterContext *ctx)
                 mval = FFMAX(mval, FFABS((bdw[offt[j * 64 + k]] - mean[j]) / 127.5));
             scale = 32767.0 / mval;
             for (k = 0; k < 64; k++)
-                ws[offt[j * 64 + k]] = roundds(((bdw[offt[j * 64 + k]] - mean[j]) / 127.5) * scale);
+                ws[j * 64 + k] = roundds(((bdw[offt[j * 64 + k]] - mean[j]) / 127.5) * scale);
             wf[j] = (float)(mval / 32767.0);
         }
         memcpy(wf + 4, bdw + 4 * 64, (dims0new - 4 * 64) * sizeof(float));
@@ -1042,7 +1127,7 @@ static av_cold int init(AVFilterContext *ctx)
             mean[j] = cmean / 48.0;
         }
         if (s->fapprox & 1) {// use int16 dot products in first layer
-            int16_t *ws = (int16_t *)s->weights0;
+            int16_t *ws = (int16_t *)w->weights0;
             float *wf = (float *)&ws[4 * 48];
             // Factor mean removal and 1.0/127.5 scaling
             // into first layer weights. scale to int16 range
@@ -1065,8 +1150,8 @@ static av_cold int init(AVFilterContext *ctx)
             // into first layer weights.
             for (j = 0; j < 4; j++)
                 for (k = 0; k < 48; k++)
-                    s->weights0[j * 48 + k] = (float)((bdata[j * 48 + k] - mean[j]) / half);
-            memcpy(s->weights0 + 4 * 48, bdata + 4 * 48, (dims0 - 4 * 48) * sizeof(float));
+                    w->weights0[j * 48 + k] = (float)((bdata[j * 48 + k] - mean[j]) / half);
+            memcpy(w->weights0 + 4 * 48, bdata + 4 * 48, (dims0 - 4 * 48) * sizeof(float));
         }
     }
 
@@ -1100,7 +1185,7 @@ static av_cold int init(AVFilterContext *ctx)
             mean[j] /= (double)(nnst);
 
         if (s->fapprox & 2) { // use int16 dot products
-            int16_t *ws = (int16_t *)s->weights1[i];
+            int16_t *ws = (int16_t *)w->weights1[i];
             float *wf = (float *)&ws[nnst * 2 * asize];
             // Factor mean removal into weights, remove global offset from
             // softmax neurons, and scale weights to int16 range.
@@ -1130,14 +1215,104 @@ static av_cold int init(AVFilterContext *ctx)
             for (j = 0; j < nnst * 2; j++) {
                 for (k = 0; k < asize; k++) {
                     const double q = j < nnst ? mean[k] : 0.0;
-                    s->weights1[i][j * asize + k] = (float)(bdataT[j * asize + k] - mean[asize + 1 + j] - q);
+                    w->weights1[i][j * asize + k] = (float)(bdataT[j * asize + k] - mean[asize + 1 + j] - q);
                 }
-                s->weights1[i][boff + j] = (float)(bdataT[boff + j] - (j < nnst ? mean[asize] : 0.0));
+                w->weights1[i][boff + j] = (float)(bdataT[boff + j] - (j < nnst ? mean[asize] : 0.0));
             }
         }
         av_free(mean);
     }
 
+fail:
+    av_free(bdata);
+    return ret;
+}
+
+/**
+ * Get the weights matching the filter options from the cache, reading and
+ * preparing them if no other instance uses them yet.
+ */
+static av_cold int get_weights(AVFilterContext *ctx)
+{
+    NNEDIContext *s = ctx->priv;
+    NNEDIWeights *w;
+    int ret = 0;
+
+    ff_thread_once(&weights_cache_once, weights_cache_init);
+    ff_mutex_lock(&weights_cache_lock);
+
+    for (w = weights_cache; w; w = w->next) {
+        if (!strcmp(w->file, s->weights_file) &&
+            w->nsize    == s->nsize    &&
+            w->nnsparam == s->nnsparam &&
+            w->etype    == s->etype    &&
+            w->pscrn    == s->pscrn    &&
+            w->fapprox  == s->fapprox)
+            break;
+    }
+
+    if (!w) {
+        w = av_mallocz(sizeof(*w));
+        if (!w) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        w->file     = av_strdup(s->weights_file);
+        w->nsize    = s->nsize;
+        w->nnsparam = s->nnsparam;
+        w->etype    = s->etype;
+        w->pscrn    = s->pscrn;
+        w->fapprox  = s->fapprox;
+        ret = w->file ? read_weights(ctx, w) : AVERROR(ENOMEM);
+        if (ret < 0) {
+            free_weights(w);
+            goto end;
+        }
+        w->next = weights_cache;
+        weights_cache = w;
+    }
+
+    w->refcount++;
+    s->weights = w;
+
+end:
+    ff_mutex_unlock(&weights_cache_lock);
+    return ret;
+}
+
+static void release_weights(NNEDIContext *s)
+{
+    NNEDIWeights *w = s->weights, **p;
+
+    if (!w)
+        return;
+
+    ff_mutex_lock(&weights_cache_lock);
+    if (!--w->refcount) {
+        for (p = &weights_cache; *p != w; p = &(*p)->next)
+            ;
+        *p = w->next;
+        free_weights(w);
+    }
+    ff_mutex_unlock(&weights_cache_lock);
+
+    s->weights = NULL;
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    NNEDIContext *s = ctx->priv;
+    int ret;
+
+    if (!s->weights_file) {
+        av_log(ctx, AV_LOG_ERROR, "No weights file provided, aborting!\n");
+        return AVERROR(EINVAL);
+    }
+
+    ret = get_weights(ctx);
+    if (ret < 0)
+        return ret;
+
     s->nns = nns_table[s->nnsparam];
     s->xdia = xdia_table[s->nsize];
     s->ydia = ydia_table[s->nsize];
@@ -1147,13 +1322,9 @@ static av_cold int init(AVFilterContext *ctx)
 
     select_functions(s);
 
-    s->fdsp = avpriv_float_dsp_alloc(0);
-    if (!s->fdsp)
-        ret = AVERROR(ENOMEM);
+    ff_nnedi_init(&s->dsp);
 
-fail:
-    av_free(bdata);
-    return ret;
+    return 0;
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -1161,10 +1332,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     NNEDIContext *s = ctx->priv;
     int i;
 
-    av_freep(&s->weights0);
-
-    for (i = 0; i < 2; i++)
-        av_freep(&s->weights1[i]);
+    release_weights(s);
 
     for (i = 0; i < s->nb_planes; i++) {
         av_freep(&s->frame_data.paddedp[i]);
@@ -1173,7 +1341,6 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     av_freep(&s->frame_data.input);
     av_freep(&s->frame_data.temp);
-    av_freep(&s->fdsp);
     av_frame_free(&s->second);
 }
 
@@ -1207,5 +1374,5 @@ AVFilter ff_vf_nnedi = {
     .query_formats = query_formats,
     .inputs        = inputs,
     .outputs       = outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
 };
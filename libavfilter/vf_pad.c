@@ -377,6 +377,7 @@ static const AVFilterPad avfilter_vf_pad_inputs[] = {
         .config_props     = config_input,
         .get_video_buffer = get_video_buffer,
         .filter_frame     = filter_frame,
+        .pipeline         = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -0,0 +1,267 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * video scene change detection filter
+ */
+
+#include "libavutil/imgutils.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/timestamp.h"
+
+#include "avfilter.h"
+#include "formats.h"
+#include "internal.h"
+#include "scene_sad.h"
+#include "video.h"
+
+typedef struct SCDetJob {
+    uint64_t sad;
+    uint32_t hist[256];
+} SCDetJob;
+
+typedef struct SCDetContext {
+    const AVClass *class;
+
+    double threshold;
+    int sc_pass;
+    int step;
+
+    int depth;
+    int width;                  ///< luma samples per line
+    int nb_rows;                ///< number of sampled lines
+    int nb_threads;
+    ff_scene_sad_fn sad;
+
+    SCDetJob *jobs;
+    uint32_t prev_hist[256];
+    AVFrame *prev_picref;
+    double prev_mafd;
+} SCDetContext;
+
+#define OFFSET(x) offsetof(SCDetContext, x)
+#define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
+
+static const AVOption scdet_options[] = {
+    { "threshold", "set the scene change threshold", OFFSET(threshold), AV_OPT_TYPE_DOUBLE, {.dbl = 10.}, 0,  100., FLAGS },
+    { "t",         "set the scene change threshold", OFFSET(threshold), AV_OPT_TYPE_DOUBLE, {.dbl = 10.}, 0,  100., FLAGS },
+    { "sc_pass",   "only output the scene change frames", OFFSET(sc_pass), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, FLAGS },
+    { "s",         "only output the scene change frames", OFFSET(sc_pass), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, FLAGS },
+    { "step",      "only analyze one line out of step", OFFSET(step), AV_OPT_TYPE_INT, {.i64 = 1}, 1, 64, FLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(scdet);
+
+static int query_formats(AVFilterContext *ctx)
+{
+    static const enum AVPixelFormat pix_fmts[] = {
+        AV_PIX_FMT_RGB24, AV_PIX_FMT_BGR24,
+        AV_PIX_FMT_GRAY8, AV_PIX_FMT_GRAY16,
+        AV_PIX_FMT_YUV410P, AV_PIX_FMT_YUV411P, AV_PIX_FMT_YUV420P,
+        AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV440P, AV_PIX_FMT_YUV444P,
+        AV_PIX_FMT_YUVJ411P, AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_YUVJ422P,
+        AV_PIX_FMT_YUVJ440P, AV_PIX_FMT_YUVJ444P,
+        AV_PIX_FMT_YUVA420P, AV_PIX_FMT_YUVA422P, AV_PIX_FMT_YUVA444P,
+        AV_PIX_FMT_YUV420P9, AV_PIX_FMT_YUV422P9, AV_PIX_FMT_YUV444P9,
+        AV_PIX_FMT_YUV420P10, AV_PIX_FMT_YUV422P10, AV_PIX_FMT_YUV440P10,
+        AV_PIX_FMT_YUV444P10,
+        AV_PIX_FMT_YUV420P12, AV_PIX_FMT_YUV422P12, AV_PIX_FMT_YUV440P12,
+        AV_PIX_FMT_YUV444P12,
+        AV_PIX_FMT_YUV420P16, AV_PIX_FMT_YUV422P16, AV_PIX_FMT_YUV444P16,
+        AV_PIX_FMT_NONE
+    };
+
+    AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
+    if (!fmts_list)
+        return AVERROR(ENOMEM);
+    return ff_set_common_formats(ctx, fmts_list);
+}
+
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    SCDetContext *s = ctx->priv;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    int linesize = av_image_get_linesize(inlink->format, inlink->w, 0);
+
+    if (linesize < 0)
+        return linesize;
+
+    /* packed RGB is analyzed as a single plane of bytes */
+    s->depth   = desc->comp[0].depth;
+    s->width   = linesize / ((s->depth + 7) >> 3);
+    s->nb_rows = (inlink->h + s->step - 1) / s->step;
+    s->sad     = ff_scene_sad_get_fn(s->depth);
+    if (!s->sad)
+        return AVERROR(EINVAL);
+
+    s->nb_threads = FFMAX(1, FFMIN(s->nb_rows, ctx->graph->nb_threads));
+    av_freep(&s->jobs);
+    s->jobs = av_calloc(s->nb_threads, sizeof(*s->jobs));
+    if (!s->jobs)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+typedef struct ThreadData {
+    const AVFrame *cur, *prev;
+} ThreadData;
+
+static int scdet_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SCDetContext *s = ctx->priv;
+    ThreadData *td  = arg;
+    SCDetJob *job   = &s->jobs[jobnr];
+    const int start = (s->nb_rows *  jobnr     ) / nb_jobs;
+    const int end   = (s->nb_rows * (jobnr + 1)) / nb_jobs;
+    const ptrdiff_t linesize = td->cur->linesize[0] * (ptrdiff_t)s->step;
+    const uint8_t *src = td->cur->data[0] + start * linesize;
+    const int shift = s->depth - 8;
+    int x, y;
+
+    memset(job->hist, 0, sizeof(job->hist));
+    job->sad = 0;
+    if (td->prev)
+        s->sad(src, linesize,
+               td->prev->data[0] + start * td->prev->linesize[0] * (ptrdiff_t)s->step,
+               td->prev->linesize[0] * (ptrdiff_t)s->step,
+               s->width, end - start, &job->sad);
+
+    if (s->depth == 8) {
+        for (y = start; y < end; y++) {
+            for (x = 0; x < s->width; x++)
+                job->hist[src[x]]++;
+            src += linesize;
+        }
+    } else {
+        for (y = start; y < end; y++) {
+            const uint16_t *src16 = (const uint16_t *)src;
+            for (x = 0; x < s->width; x++)
+                job->hist[src16[x] >> shift]++;
+            src += linesize;
+        }
+    }
+
+    return 0;
+}
+
+static void set_meta(AVDictionary **metadata, const char *key, double d)
+{
+    char value[128];
+
+    snprintf(value, sizeof(value), "%0.3f", d);
+    av_dict_set(metadata, key, value, 0);
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx = inlink->dst;
+    SCDetContext *s = ctx->priv;
+    const double count = (double)s->width * s->nb_rows;
+    const int nb_jobs  = s->nb_threads;
+    ThreadData td;
+    uint64_t sad = 0;
+    uint32_t hist[256] = { 0 };
+    uint64_t hist_diff = 0;
+    double mafd = 0, score = 0;
+    int i, j, scene = 0;
+
+    td.cur  = frame;
+    td.prev = s->prev_picref;
+    ctx->internal->execute(ctx, scdet_slice, &td, NULL, nb_jobs);
+
+    for (i = 0; i < nb_jobs; i++) {
+        sad += s->jobs[i].sad;
+        for (j = 0; j < 256; j++)
+            hist[j] += s->jobs[i].hist[j];
+    }
+
+    if (td.prev) {
+        for (j = 0; j < 256; j++)
+            hist_diff += FFABS((int64_t)hist[j] - s->prev_hist[j]);
+        mafd  = sad * 100. / count / (1ULL << s->depth);
+        score = av_clipf(FFMIN(mafd, fabs(mafd - s->prev_mafd)), 0, 100.);
+        s->prev_mafd = mafd;
+        scene = score >= s->threshold;
+    }
+    memcpy(s->prev_hist, hist, sizeof(hist));
+    av_frame_free(&s->prev_picref);
+    s->prev_picref = av_frame_clone(frame);
+    if (!s->prev_picref) {
+        av_frame_free(&frame);
+        return AVERROR(ENOMEM);
+    }
+
+    set_meta(avpriv_frame_get_metadatap(frame), "lavfi.scd.mafd",  mafd);
+    set_meta(avpriv_frame_get_metadatap(frame), "lavfi.scd.score", score);
+    set_meta(avpriv_frame_get_metadatap(frame), "lavfi.scd.hist",  hist_diff * 50. / count);
+
+    if (scene) {
+        av_dict_set(avpriv_frame_get_metadatap(frame), "lavfi.scd.time",
+                    av_ts2timestr(frame->pts, &inlink->time_base), 0);
+        av_log(ctx, AV_LOG_VERBOSE, "lavfi.scd.score: %.3f, lavfi.scd.time: %s\n",
+               score, av_ts2timestr(frame->pts, &inlink->time_base));
+    } else if (s->sc_pass) {
+        av_frame_free(&frame);
+        return 0;
+    }
+
+    return ff_filter_frame(ctx->outputs[0], frame);
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    SCDetContext *s = ctx->priv;
+
+    av_frame_free(&s->prev_picref);
+    av_freep(&s->jobs);
+}
+
+static const AVFilterPad scdet_inputs[] = {
+    {
+        .name         = "default",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .filter_frame = filter_frame,
+        .config_props = config_input,
+    },
+    { NULL }
+};
+
+static const AVFilterPad scdet_outputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_VIDEO,
+    },
+    { NULL }
+};
+
+AVFilter ff_vf_scdet = {
+    .name          = "scdet",
+    .description   = NULL_IF_CONFIG_SMALL("Detect video scene change."),
+    .priv_size     = sizeof(SCDetContext),
+    .priv_class    = &scdet_class,
+    .uninit        = uninit,
+    .query_formats = query_formats,
+    .inputs        = scdet_inputs,
+    .outputs       = scdet_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
+};
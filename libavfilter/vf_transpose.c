@@ -282,6 +282,7 @@ static const AVFilterPad avfilter_vf_transpose_inputs[] = {
         .type         = AVMEDIA_TYPE_VIDEO,
         .get_video_buffer = get_video_buffer,
         .filter_frame = filter_frame,
+        .pipeline     = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -90,6 +90,7 @@ static const AVFilterPad avfilter_vf_vflip_inputs[] = {
         .get_video_buffer = get_video_buffer,
         .filter_frame     = filter_frame,
         .config_props     = config_input,
+        .pipeline         = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -532,6 +532,7 @@ static const AVFilterPad avfilter_vf_yadif_inputs[] = {
         .name          = "default",
         .type          = AVMEDIA_TYPE_VIDEO,
         .filter_frame  = filter_frame,
+        .pipeline      = FF_PAD_PIPELINE,
     },
     { NULL }
 };
@@ -49,7 +49,8 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
 
     if (!link->video_frame_pool) {
         link->video_frame_pool = ff_video_frame_pool_init(av_buffer_allocz, w, h,
-                                                          link->format, BUFFER_ALIGN);
+                                                          link->format, BUFFER_ALIGN,
+                                                          link->graph && link->graph->shared_pools);
         if (!link->video_frame_pool)
             return NULL;
     } else {
@@ -64,7 +65,8 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
 
             ff_video_frame_pool_uninit((FFVideoFramePool **)&link->video_frame_pool);
             link->video_frame_pool = ff_video_frame_pool_init(av_buffer_allocz, w, h,
-                                                              link->format, BUFFER_ALIGN);
+                                                              link->format, BUFFER_ALIGN,
+                                                              link->graph && link->graph->shared_pools);
             if (!link->video_frame_pool)
                 return NULL;
         }
@@ -0,0 +1,82 @@
+;*****************************************************************************
+;* x86-optimized functions for the amix filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+%if ARCH_X86_64
+
+;-----------------------------------------------------------------------------
+; void ff_amix_mix(float *dst, const float *const *src, const float *scale,
+;                  int nb_src, int len)
+;-----------------------------------------------------------------------------
+%macro MIX 0
+cglobal amix_mix, 5,8,6, dst, src, scale, nb_src, len, off, i, ptr
+    movsxdifnidn nb_srcq, nb_srcd
+    movsxdifnidn    lenq, lend
+    shl             lenq, 2
+    lea             srcq, [srcq+nb_srcq*gprsize]
+    lea           scaleq, [scaleq+nb_srcq*4]
+    neg          nb_srcq
+    xor             offq, offq
+.loop:
+    ; the output stays in registers while all inputs are added to it
+    mova              m0, [dstq+offq]
+    mova              m1, [dstq+offq+mmsize]
+    mova              m2, [dstq+offq+mmsize*2]
+    mova              m3, [dstq+offq+mmsize*3]
+    mov               iq, nb_srcq
+.input:
+    mov             ptrq, [srcq+iq*gprsize]
+    VBROADCASTSS      m4, [scaleq+iq*4]
+    movu              m5, [ptrq+offq]
+    mulps             m5, m4
+    addps             m0, m5
+    movu              m5, [ptrq+offq+mmsize]
+    mulps             m5, m4
+    addps             m1, m5
+    movu              m5, [ptrq+offq+mmsize*2]
+    mulps             m5, m4
+    addps             m2, m5
+    movu              m5, [ptrq+offq+mmsize*3]
+    mulps             m5, m4
+    addps             m3, m5
+    inc               iq
+    jl .input
+    mova  [dstq+offq         ], m0
+    mova  [dstq+offq+mmsize  ], m1
+    mova  [dstq+offq+mmsize*2], m2
+    mova  [dstq+offq+mmsize*3], m3
+    add             offq, mmsize*4
+    cmp             offq, lenq
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse
+MIX
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+MIX
+%endif
+
+%endif ; ARCH_X86_64
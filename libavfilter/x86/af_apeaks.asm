@@ -0,0 +1,98 @@
+;*****************************************************************************
+;* x86-optimized functions for the apeaks filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;-----------------------------------------------------------------------------
+; void ff_apeaks_peaks(float *stats, const float *src, int len)
+;-----------------------------------------------------------------------------
+%macro PEAKS 0
+cglobal apeaks_peaks, 3,3,8, stats, src, len
+    movsxdifnidn lenq, lend
+    shl          lenq, 2
+    add          srcq, lenq
+    neg          lenq
+    VBROADCASTSS   m4, [statsq]
+    VBROADCASTSS   m5, [statsq+4]
+    ; partial sum j in lane j of the registers, 4 or 8 per register
+    movu           m0, [statsq+8]
+    movu           m1, [statsq+8+mmsize]
+%if mmsize == 16
+    movu           m2, [statsq+8+32]
+    movu           m3, [statsq+8+48]
+%endif
+.loop:
+    movu           m6, [srcq+lenq]
+    movu           m7, [srcq+lenq+mmsize]
+    minps          m4, m6
+    maxps          m5, m6
+    mulps          m6, m6
+    addps          m0, m6
+    minps          m4, m7
+    maxps          m5, m7
+    mulps          m7, m7
+    addps          m1, m7
+%if mmsize == 16
+    movu           m6, [srcq+lenq+32]
+    movu           m7, [srcq+lenq+48]
+    minps          m4, m6
+    maxps          m5, m6
+    mulps          m6, m6
+    addps          m2, m6
+    minps          m4, m7
+    maxps          m5, m7
+    mulps          m7, m7
+    addps          m3, m7
+%endif
+    add          lenq, 64
+    jl .loop
+
+    movu [statsq+8],        m0
+    movu [statsq+8+mmsize], m1
+%if mmsize == 16
+    movu [statsq+8+32],     m2
+    movu [statsq+8+48],     m3
+%else
+    vextractf128  xm6, m4, 1
+    vextractf128  xm7, m5, 1
+    minps         xm4, xm6
+    maxps         xm5, xm7
+%endif
+    movhlps       xm6, xm4
+    movhlps       xm7, xm5
+    minps         xm4, xm6
+    maxps         xm5, xm7
+    shufps        xm6, xm4, xm4, q0001
+    shufps        xm7, xm5, xm5, q0001
+    minss         xm4, xm6
+    maxss         xm5, xm7
+    movss [statsq],   xm4
+    movss [statsq+4], xm5
+    RET
+%endmacro
+
+INIT_XMM sse
+PEAKS
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+PEAKS
+%endif
@@ -0,0 +1,92 @@
+;*****************************************************************************
+;* x86-optimized functions for the atempo filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;-----------------------------------------------------------------------------
+; float ff_atempo_dot(const float *a, const float *b, int len)
+;-----------------------------------------------------------------------------
+%macro DOT 0
+cglobal atempo_dot, 3,3,6, a, b, len
+    movsxdifnidn lenq, lend
+    shl          lenq, 2
+    add            aq, lenq
+    add            bq, lenq
+    neg          lenq
+    xorps          m0, m0
+    xorps          m1, m1
+%if mmsize == 16
+    xorps          m2, m2
+    xorps          m3, m3
+%endif
+.loop:
+    ; 16 partial sums, lane j of register r taking the products of index
+    ; r * mmsize / 4 + j modulo 16
+    movu           m4, [aq+lenq]
+    movu           m5, [bq+lenq]
+    mulps          m4, m5
+    addps          m0, m4
+    movu           m4, [aq+lenq+mmsize]
+    movu           m5, [bq+lenq+mmsize]
+    mulps          m4, m5
+    addps          m1, m4
+%if mmsize == 16
+    movu           m4, [aq+lenq+32]
+    movu           m5, [bq+lenq+32]
+    mulps          m4, m5
+    addps          m2, m4
+    movu           m4, [aq+lenq+48]
+    movu           m5, [bq+lenq+48]
+    mulps          m4, m5
+    addps          m3, m4
+%endif
+    add          lenq, 64
+    jl .loop
+
+    ; sum[j] += sum[j + 8], sum[j] += sum[j + 4]
+%if mmsize == 16
+    addps          m0, m2
+    addps          m1, m3
+%else
+    addps          m0, m1
+    vextractf128  xm1, m0, 1
+%endif
+    addps         xm0, xm1
+    ; (sum[0] + sum[2]) + (sum[1] + sum[3])
+    movhlps       xm1, xm0
+    addps         xm0, xm1
+    movss         xm1, xm0
+    shufps        xm0, xm0, q0001
+    addss         xm0, xm1
+%if ARCH_X86_64 == 0
+    movss         r0m, xm0
+    fld   dword   r0m
+%endif
+    RET
+%endmacro
+
+INIT_XMM sse
+DOT
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+DOT
+%endif
@@ -25,8 +25,8 @@ SECTION_RODATA 32
 
 pd_1_256:     times 4 dq 0x3F70000000000000
 pd_int32_max: times 4 dq 0x41DFFFFFFFC00000
-pw_1:         times 8 dw 1
-pw_128:       times 8 dw 128
+pw_1:         times 16 dw 1
+pw_128:       times 16 dw 128
 pq_128:       times 2 dq 128
 
 SECTION .text
@@ -36,16 +36,20 @@ SECTION .text
 ;                           int volume)
 ;------------------------------------------------------------------------------
 
-INIT_XMM sse2
+%macro SCALE_SAMPLES_S16 0
 cglobal scale_samples_s16, 4,4,4, dst, src, len, volume
-    movd        m0, volumem
-    pshuflw     m0, m0, 0
-    punpcklwd   m0, [pw_1]
+    movd       xm0, volumem
+    pshuflw    xm0, xm0, 0
+    punpcklwd  xm0, [pw_1]
+%if mmsize == 32
+    vpbroadcastd m0, xm0
+%endif
     mova        m1, [pw_128]
     lea       lenq, [lend*2-mmsize]
 .loop:
     ; dst[i] = av_clip_int16((src[i] * volume + 128) >> 8);
-    mova        m2, [srcq+lenq]
+    ; the unpacks and the pack work within lanes, so the order is kept
+    movu        m2, [srcq+lenq]
     punpcklwd   m3, m2, m1
     punpckhwd   m2, m1
     pmaddwd     m3, m0
@@ -53,10 +57,18 @@ cglobal scale_samples_s16, 4,4,4, dst, src, len, volume
     psrad       m3, 8
     psrad       m2, 8
     packssdw    m3, m2
-    mova  [dstq+lenq], m3
+    movu  [dstq+lenq], m3
     sub       lenq, mmsize
     jge .loop
     REP_RET
+%endmacro
+
+INIT_XMM sse2
+SCALE_SAMPLES_S16
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SCALE_SAMPLES_S16
+%endif
 
 ;------------------------------------------------------------------------------
 ; void ff_scale_samples_s32(uint8_t *dst, const uint8_t *src, int len,
@@ -25,6 +25,8 @@
 
 void ff_scale_samples_s16_sse2(uint8_t *dst, const uint8_t *src, int len,
                                int volume);
+void ff_scale_samples_s16_avx2(uint8_t *dst, const uint8_t *src, int len,
+                               int volume);
 
 void ff_scale_samples_s32_sse2(uint8_t *dst, const uint8_t *src, int len,
                                int volume);
@@ -43,6 +45,10 @@ av_cold void ff_volume_init_x86(VolumeContext *vol)
             vol->scale_samples = ff_scale_samples_s16_sse2;
             vol->samples_align = 8;
         }
+        if (EXTERNAL_AVX2_FAST(cpu_flags) && vol->volume_i < 32768) {
+            vol->scale_samples = ff_scale_samples_s16_avx2;
+            vol->samples_align = 16;
+        }
     } else if (sample_fmt == AV_SAMPLE_FMT_S32) {
         if (EXTERNAL_SSE2(cpu_flags)) {
             vol->scale_samples = ff_scale_samples_s32_sse2;
@@ -24,7 +24,7 @@
 
 SECTION_RODATA
 
-pw_1: times 8 dw 1
+pw_1: times 16 dw 1
 pw_2: times 8 dw 2
 pw_4: times 8 dw 4
 pw_8: times 8 dw 8
@@ -37,7 +37,7 @@ pw_1023: times 8 dw 1023
 pw_1024: times 8 dw 1024
 pw_2048: times 8 dw 2048
 pw_4095: times 8 dw 4095
-pw_8192: times 8 dw 8192
+pw_8192: times 16 dw 8192
 pw_16384: times 8 dw 16384
 
 pd_1: times 4 dd 1
@@ -1014,22 +1014,30 @@ RGB2YUV_FNS 0, 0
 RGB2YUV_FNS 1, 0
 RGB2YUV_FNS 1, 1
 
-; void ff_multiply3x3_sse2(int16_t *data[3], ptrdiff_t stride,
-;                          int w, int h, const int16_t coeff[3][3][8])
-INIT_XMM sse2
+; void ff_multiply3x3_<opt>(int16_t *data[3], ptrdiff_t stride,
+;                           int w, int h, const int16_t coeff[3][3][8])
+%macro MULTIPLY3X3_FN 0
 cglobal multiply3x3, 5, 7, 16, data, stride, ww, h, c
-    movh            m0, [cq+  0]
-    movh            m1, [cq+ 32]
-    movh            m2, [cq+ 48]
-    movh            m3, [cq+ 80]
-    movh            m4, [cq+ 96]
-    movh            m5, [cq+128]
-    punpcklwd       m0, [cq+ 16]
-    punpcklwd       m1, [pw_8192]
-    punpcklwd       m2, [cq+ 64]
-    punpcklwd       m3, [pw_8192]
-    punpcklwd       m4, [cq+112]
-    punpcklwd       m5, [pw_8192]
+    movh           xm0, [cq+  0]
+    movh           xm1, [cq+ 32]
+    movh           xm2, [cq+ 48]
+    movh           xm3, [cq+ 80]
+    movh           xm4, [cq+ 96]
+    movh           xm5, [cq+128]
+    punpcklwd      xm0, [cq+ 16]
+    punpcklwd      xm1, [pw_8192]
+    punpcklwd      xm2, [cq+ 64]
+    punpcklwd      xm3, [pw_8192]
+    punpcklwd      xm4, [cq+112]
+    punpcklwd      xm5, [pw_8192]
+%if mmsize == 32
+    vinserti128     m0, m0, xm0, 1
+    vinserti128     m1, m1, xm1, 1
+    vinserti128     m2, m2, xm2, 1
+    vinserti128     m3, m3, xm3, 1
+    vinserti128     m4, m4, xm4, 1
+    vinserti128     m5, m5, xm5, 1
+%endif
 
     DEFINE_ARGS data0, stride, ww, h, data1, data2, x
     shl        strideq, 1
@@ -1094,4 +1102,13 @@ cglobal multiply3x3, 5, 7, 16, data, stride, ww, h, c
     jg .loop_v
 
     RET
+%endmacro
+
+INIT_XMM sse2
+MULTIPLY3X3_FN
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+MULTIPLY3X3_FN
+%endif
 %endif
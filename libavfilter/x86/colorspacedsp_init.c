@@ -75,6 +75,8 @@ decl_rgb2yuv_fns(444);
 
 void ff_multiply3x3_sse2(int16_t *data[3], ptrdiff_t stride, int w, int h,
                          const int16_t coeff[3][3][8]);
+void ff_multiply3x3_avx2(int16_t *data[3], ptrdiff_t stride, int w, int h,
+                         const int16_t coeff[3][3][8]);
 
 void ff_colorspacedsp_x86_init(ColorSpaceDSPContext *dsp)
 {
@@ -116,4 +118,8 @@ void ff_colorspacedsp_x86_init(ColorSpaceDSPContext *dsp)
 
         dsp->multiply3x3 = ff_multiply3x3_sse2;
     }
+
+    if (ARCH_X86_64 && EXTERNAL_AVX2(cpu_flags)) {
+        dsp->multiply3x3 = ff_multiply3x3_avx2;
+    }
 }
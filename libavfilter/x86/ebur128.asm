@@ -0,0 +1,99 @@
+;*****************************************************************************
+;* x86-optimized functions for EBU R128 loudness measurement
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+%if ARCH_X86_64
+;-----------------------------------------------------------------------------
+; void ff_ebur128_kweight(double *sum, double *state, ptrdiff_t state_stride,
+;                         const double *coeffs, const double *src,
+;                         ptrdiff_t src_stride, int len)
+;-----------------------------------------------------------------------------
+%macro KWEIGHT 0
+cglobal ebur128_kweight, 7,8,10, sum, state, sstride, coeffs, src, stride, len, tmp
+    shl   sstrideq, 3
+    shl    strideq, 3
+    mov       tmpq, stateq
+    movu        m0, [tmpq]              ; x[n-1]
+    add       tmpq, sstrideq
+    movu        m1, [tmpq]              ; x[n-2]
+    add       tmpq, sstrideq
+    movu        m2, [tmpq]              ; y[n-1]
+    add       tmpq, sstrideq
+    movu        m3, [tmpq]              ; y[n-2]
+    add       tmpq, sstrideq
+    movu        m4, [tmpq]              ; z[n-1]
+    add       tmpq, sstrideq
+    movu        m5, [tmpq]              ; z[n-2]
+    movu        m6, [sumq]
+.loop:
+    movu        m7, [srcq]              ; x[n]
+    mulpd       m8, m7, [coeffsq+0*16]
+    mulpd       m9, m0, [coeffsq+1*16]
+    addpd       m8, m9
+    mulpd       m9, m1, [coeffsq+2*16]
+    addpd       m8, m9
+    mulpd       m9, m2, [coeffsq+3*16]
+    subpd       m8, m9
+    mulpd       m9, m3, [coeffsq+4*16]
+    subpd       m8, m9                  ; y[n]
+    mova        m1, m0
+    mova        m0, m7
+    addpd       m9, m2, m2
+    subpd       m7, m8, m9
+    addpd       m7, m3
+    mulpd       m9, m4, [coeffsq+5*16]
+    subpd       m7, m9
+    mulpd       m9, m5, [coeffsq+6*16]
+    subpd       m7, m9                  ; z[n]
+    mova        m3, m2
+    mova        m2, m8
+    mova        m5, m4
+    mova        m4, m7
+    mulpd       m7, m7
+    addpd       m6, m7
+    add       srcq, strideq
+    dec       lend
+    jg .loop
+
+    movu    [sumq], m6
+    movu  [stateq], m0
+    add     stateq, sstrideq
+    movu  [stateq], m1
+    add     stateq, sstrideq
+    movu  [stateq], m2
+    add     stateq, sstrideq
+    movu  [stateq], m3
+    add     stateq, sstrideq
+    movu  [stateq], m4
+    add     stateq, sstrideq
+    movu  [stateq], m5
+    RET
+%endmacro
+
+INIT_XMM sse2
+KWEIGHT
+%if HAVE_AVX_EXTERNAL
+INIT_XMM avx
+KWEIGHT
+%endif
+%endif ; ARCH_X86_64
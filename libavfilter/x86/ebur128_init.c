@@ -0,0 +1,41 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/ebur128.h"
+
+void ff_ebur128_kweight_sse2(double *sum, double *state, ptrdiff_t state_stride,
+                             const double *coeffs, const double *src,
+                             ptrdiff_t src_stride, int len);
+void ff_ebur128_kweight_avx(double *sum, double *state, ptrdiff_t state_stride,
+                            const double *coeffs, const double *src,
+                            ptrdiff_t src_stride, int len);
+
+av_cold void ff_ebur128_dsp_init_x86(FFEBUR128DSPContext *dsp)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags))
+        dsp->kweight = ff_ebur128_kweight_sse2;
+    if (EXTERNAL_AVX(cpu_flags))
+        dsp->kweight = ff_ebur128_kweight_avx;
+#endif
+}
@@ -0,0 +1,77 @@
+;*****************************************************************************
+;* x86-optimized functions for partitioned convolution
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;-----------------------------------------------------------------------------
+; void ff_partconv_fcmul_add(float *sum, const float *t, const float *c,
+;                            ptrdiff_t len)
+;-----------------------------------------------------------------------------
+%macro FCMUL_ADD 0
+cglobal partconv_fcmul_add, 4,4,6, sum, t, c, len
+    shl       lenq, 2
+    add       sumq, lenq
+    add         tq, lenq
+    add         cq, lenq
+    neg       lenq
+.loop:
+    movsldup    m0, [tq+lenq]          ; tr tr
+    movshdup    m1, [tq+lenq]          ; ti ti
+    mova        m2, [cq+lenq]          ; cr ci
+    shufps      m3, m2, m2, q2301      ; ci cr
+    mulps       m1, m3                 ; ti*ci ti*cr
+%if cpuflag(fma3)
+    fmaddsubps  m0, m0, m2, m1         ; tr*cr-ti*ci tr*ci+ti*cr
+%else
+    mulps       m0, m2                 ; tr*cr tr*ci
+    addsubps    m0, m1
+%endif
+    addps       m0, [sumq+lenq]
+    mova [sumq+lenq], m0
+    movsldup    m4, [tq+lenq+mmsize]
+    movshdup    m1, [tq+lenq+mmsize]
+    mova        m2, [cq+lenq+mmsize]
+    shufps      m3, m2, m2, q2301
+    mulps       m1, m3
+%if cpuflag(fma3)
+    fmaddsubps  m4, m4, m2, m1
+%else
+    mulps       m4, m2
+    addsubps    m4, m1
+%endif
+    addps       m4, [sumq+lenq+mmsize]
+    mova [sumq+lenq+mmsize], m4
+    add       lenq, 2*mmsize
+    jl .loop
+    REP_RET
+%endmacro
+
+INIT_XMM sse3
+FCMUL_ADD
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+FCMUL_ADD
+%endif
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+FCMUL_ADD
+%endif
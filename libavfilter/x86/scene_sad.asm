@@ -0,0 +1,129 @@
+;*****************************************************************************
+;* x86-optimized functions for scene SAD
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; add the qwords of m%1 and store the result to the pointer in the 7th
+; argument, clobbers m%2 and r0
+%macro STORE_SUM 2
+%if mmsize == 32
+    vextracti128 xm%2, m%1, 1
+    paddq        xm%1, xm%2
+%endif
+    movhlps      xm%2, xm%1
+    paddq        xm%1, xm%2
+    mov           r0q, r6mp
+    movq         [r0q], xm%1
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_scene_sad(const uint8_t *src1, ptrdiff_t stride1,
+;                   const uint8_t *src2, ptrdiff_t stride2,
+;                   ptrdiff_t width, ptrdiff_t height, uint64_t *sum)
+; width is a multiple of mmsize
+;-----------------------------------------------------------------------------
+%macro SCENE_SAD 0
+cglobal scene_sad, 6, 7, 3, src1, stride1, src2, stride2, width, height, x
+    add      src1q, widthq
+    add      src2q, widthq
+    neg     widthq
+    pxor        m2, m2
+    test   heightq, heightq
+    jz .end
+.nextrow:
+    mov         xq, widthq
+.loop:
+    movu        m0, [src1q + xq]
+    movu        m1, [src2q + xq]
+    psadbw      m0, m1
+    paddq       m2, m0
+    add         xq, mmsize
+    jl .loop
+    add      src1q, stride1q
+    add      src2q, stride2q
+    sub    heightq, 1
+    jg .nextrow
+
+.end:
+    STORE_SUM 2, 0
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_scene_sad16(const uint8_t *src1, ptrdiff_t stride1,
+;                     const uint8_t *src2, ptrdiff_t stride2,
+;                     ptrdiff_t width, ptrdiff_t height, uint64_t *sum)
+; width is a multiple of mmsize / 2
+;-----------------------------------------------------------------------------
+%macro SCENE_SAD16 0
+cglobal scene_sad16, 6, 7, 6, src1, stride1, src2, stride2, width, height, x
+    add     widthq, widthq
+    add      src1q, widthq
+    add      src2q, widthq
+    neg     widthq
+    pxor        m3, m3
+    pxor        m4, m4
+    test   heightq, heightq
+    jz .end
+.nextrow:
+    ; the dword sums of one row cannot overflow for any sensible width
+    pxor        m1, m1
+    mov         xq, widthq
+.loop:
+    movu        m0, [src1q + xq]
+    movu        m2, [src2q + xq]
+    mova        m5, m0
+    psubusw     m0, m2
+    psubusw     m2, m5
+    por         m0, m2
+    ; zero-extend the differences, they do not fit in signed words
+    mova        m5, m0
+    punpcklwd   m0, m4
+    punpckhwd   m5, m4
+    paddd       m1, m0
+    paddd       m1, m5
+    add         xq, mmsize
+    jl .loop
+    mova        m5, m1
+    punpckldq   m1, m4
+    punpckhdq   m5, m4
+    paddq       m3, m1
+    paddq       m3, m5
+    add      src1q, stride1q
+    add      src2q, stride2q
+    sub    heightq, 1
+    jg .nextrow
+
+.end:
+    STORE_SUM 3, 0
+    RET
+%endmacro
+
+INIT_XMM sse2
+SCENE_SAD
+SCENE_SAD16
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SCENE_SAD
+SCENE_SAD16
+%endif
@@ -0,0 +1,67 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/scene_sad.h"
+
+/* the asm functions only handle a multiple of a register of samples per
+ * line, the remaining columns are done in C */
+#define SCENE_SAD_FUNC(name, asm_name, c_name, bps, nb)                        \
+void asm_name(SCENE_SAD_PARAMS);                                              \
+                                                                              \
+static void name(SCENE_SAD_PARAMS)                                            \
+{                                                                             \
+    const ptrdiff_t awidth = width & ~(ptrdiff_t)((nb) - 1);                  \
+    uint64_t sad[2] = { 0 };                                                  \
+                                                                              \
+    if (awidth)                                                               \
+        asm_name(src1, stride1, src2, stride2, awidth, height, &sad[0]);      \
+    if (width > awidth)                                                       \
+        c_name(src1 + awidth * bps, stride1, src2 + awidth * bps, stride2,    \
+               width - awidth, height, &sad[1]);                              \
+    *sum = sad[0] + sad[1];                                                   \
+}
+
+#if HAVE_YASM
+SCENE_SAD_FUNC(scene_sad_sse2,   ff_scene_sad_sse2,   ff_scene_sad_c,   1, 16)
+SCENE_SAD_FUNC(scene_sad_avx2,   ff_scene_sad_avx2,   ff_scene_sad_c,   1, 32)
+SCENE_SAD_FUNC(scene_sad16_sse2, ff_scene_sad16_sse2, ff_scene_sad16_c, 2,  8)
+SCENE_SAD_FUNC(scene_sad16_avx2, ff_scene_sad16_avx2, ff_scene_sad16_c, 2, 16)
+#endif
+
+av_cold ff_scene_sad_fn ff_scene_sad_get_fn_x86(int depth)
+{
+#if HAVE_YASM
+    int cpu_flags = av_get_cpu_flags();
+
+    if (depth == 8) {
+        if (EXTERNAL_AVX2_FAST(cpu_flags))
+            return scene_sad_avx2;
+        if (EXTERNAL_SSE2(cpu_flags))
+            return scene_sad_sse2;
+    } else if (depth > 8 && depth <= 16) {
+        if (EXTERNAL_AVX2_FAST(cpu_flags))
+            return scene_sad16_avx2;
+        if (EXTERNAL_SSE2(cpu_flags))
+            return scene_sad16_sse2;
+    }
+#endif
+    return NULL;
+}
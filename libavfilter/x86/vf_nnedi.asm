@@ -0,0 +1,113 @@
+;*****************************************************************************
+;* x86-optimized functions for nnedi filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;-----------------------------------------------------------------------------
+; float ff_nnedi_scalarproduct_float(const float *v1, const float *v2, int len)
+;-----------------------------------------------------------------------------
+%macro SCALARPRODUCT_FLOAT 0
+cglobal nnedi_scalarproduct_float, 3,3,3, v1, v2, len
+    shl       lend, 2
+    add        v1q, lenq
+    add        v2q, lenq
+    neg       lenq
+    xorps       m0, m0
+%if mmsize == 32
+    ; len is a multiple of 4, do the odd group of 4 with xmm first
+    test      lenq, 16
+    jz .loop
+    movu       xm0, [v1q+lenq]
+    mulps      xm0, [v2q+lenq]
+    add       lenq, 16
+    jz .end
+%endif
+.loop:
+    movu        m1, [v1q+lenq]
+%if cpuflag(fma3)
+    fmaddps     m0, m1, [v2q+lenq], m0
+%else
+    movu        m2, [v2q+lenq]
+    mulps       m1, m2
+    addps       m0, m1
+%endif
+    add       lenq, mmsize
+    jl .loop
+.end:
+%if mmsize == 32
+    vextractf128 xm1, m0, 1
+    addps      xm0, xm1
+%endif
+    movhlps    xm1, xm0
+    addps      xm0, xm1
+    movss      xm1, xm0
+    shufps     xm0, xm0, 1
+    addss      xm0, xm1
+%if ARCH_X86_64 == 0
+    movss       r0m, xm0
+    fld dword   r0m
+%endif
+    RET
+%endmacro
+
+INIT_XMM sse
+SCALARPRODUCT_FLOAT
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+SCALARPRODUCT_FLOAT
+%endif
+
+;-----------------------------------------------------------------------------
+; int ff_nnedi_scalarproduct_int16(const int16_t *v1, const int16_t *v2, int len)
+;-----------------------------------------------------------------------------
+%macro SCALARPRODUCT_INT16 0
+cglobal nnedi_scalarproduct_int16, 3,3,3, v1, v2, len
+    shl       lend, 1
+    add        v1q, lenq
+    add        v2q, lenq
+    neg       lenq
+    pxor        m2, m2
+.loop:
+    movu        m0, [v1q+lenq]
+    movu        m1, [v2q+lenq]
+    pmaddwd     m0, m1
+    paddd       m2, m0
+    add       lenq, mmsize
+    jl .loop
+%if mmsize == 32
+    vextracti128 xm0, m2, 1
+    paddd      xm2, xm0
+%endif
+    pshufd     xm0, xm2, q0032
+    paddd      xm2, xm0
+    pshufd     xm0, xm2, q0001
+    paddd      xm2, xm0
+    movd       eax, xm2
+    RET
+%endmacro
+
+INIT_XMM sse2
+SCALARPRODUCT_INT16
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SCALARPRODUCT_INT16
+%endif
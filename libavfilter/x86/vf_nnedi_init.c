@@ -0,0 +1,41 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/nnedi.h"
+
+float ff_nnedi_scalarproduct_float_sse(const float *v1, const float *v2, int len);
+float ff_nnedi_scalarproduct_float_fma3(const float *v1, const float *v2, int len);
+int ff_nnedi_scalarproduct_int16_sse2(const int16_t *v1, const int16_t *v2, int len);
+int ff_nnedi_scalarproduct_int16_avx2(const int16_t *v1, const int16_t *v2, int len);
+
+av_cold void ff_nnedi_init_x86(NNEDIDSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE(cpu_flags))
+        dsp->scalarproduct_float = ff_nnedi_scalarproduct_float_sse;
+    if (EXTERNAL_SSE2(cpu_flags))
+        dsp->scalarproduct_int16 = ff_nnedi_scalarproduct_int16_sse2;
+    if (EXTERNAL_FMA3_FAST(cpu_flags))
+        dsp->scalarproduct_float = ff_nnedi_scalarproduct_float_fma3;
+    if (EXTERNAL_AVX2_FAST(cpu_flags))
+        dsp->scalarproduct_int16 = ff_nnedi_scalarproduct_int16_avx2;
+}
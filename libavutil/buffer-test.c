@@ -0,0 +1,84 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+
+#include "avassert.h"
+#include "buffer.h"
+#include "buffer_internal.h"
+
+static void print_stats(const char *step)
+{
+    BufferPoolStats stats;
+
+    ff_buffer_pool_get_shared_stats(&stats);
+    printf("%-8s pools %d hits %d misses %d held %d free %d\n", step,
+           stats.nb_pools, (int)stats.hits, (int)stats.misses,
+           (int)stats.bytes_held, (int)stats.bytes_free);
+}
+
+int main(void)
+{
+    AVBufferPool *a, *b, *c;
+    AVBufferRef *buf[4];
+    uint8_t *data;
+    int i;
+
+    /* the same size and allocator give the same pool */
+    a = av_buffer_pool_init_shared(1000, NULL);
+    b = av_buffer_pool_init_shared(1000, av_buffer_alloc);
+    c = av_buffer_pool_init_shared(2000, NULL);
+    av_assert0(a && b && c);
+    av_assert0(a == b && a != c);
+    print_stats("init");
+
+    buf[0] = av_buffer_pool_get(a);
+    data   = buf[0]->data;
+    av_buffer_unref(&buf[0]);
+    buf[0] = av_buffer_pool_get(b);
+    av_assert0(buf[0]->data == data);
+    buf[1] = av_buffer_pool_get(b);
+    buf[2] = av_buffer_pool_get(c);
+    print_stats("get");
+
+    /* released buffers are kept for reuse */
+    for (i = 0; i < 3; i++)
+        av_buffer_unref(&buf[i]);
+    print_stats("release");
+
+    /* a pool stays available as long as one of its users holds it */
+    av_buffer_pool_uninit(&a);
+    buf[0] = av_buffer_pool_get(b);
+    print_stats("uninit");
+
+    /* above the limit, unused buffers of other pools are freed first,
+     * then released buffers are not kept anymore */
+    av_buffer_pool_set_shared_limit(3500);
+    for (i = 1; i < 4; i++)
+        buf[i] = av_buffer_pool_get(b);
+    print_stats("limit");
+    for (i = 0; i < 4; i++)
+        av_buffer_unref(&buf[i]);
+    print_stats("release");
+
+    av_buffer_pool_uninit(&b);
+    av_buffer_pool_uninit(&c);
+    print_stats("uninit");
+
+    return 0;
+}
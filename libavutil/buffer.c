@@ -25,6 +25,16 @@
 #include "mem.h"
 #include "thread.h"
 
+/* registry of the pools shared by the whole process */
+static AVMutex shared_pools_lock;
+static AVOnce  shared_pools_once = AV_ONCE_INIT;
+static AVBufferPool *shared_pools;
+static int64_t shared_max_memory;
+static uint64_t shared_hits, shared_misses;
+
+/* shared_max_memory is not 0, read without the registry lock */
+static volatile int shared_limited;
+
 AVBufferRef *av_buffer_create(uint8_t *data, int size,
                               void (*free)(void *opaque, uint8_t *data),
                               void *opaque, int flags)
@@ -250,12 +260,214 @@ AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size))
     return pool;
 }
 
+static void shared_pools_init(void)
+{
+    ff_mutex_init(&shared_pools_lock, NULL);
+}
+
+AVBufferPool *av_buffer_pool_init_shared(int size, AVBufferRef* (*alloc)(int size))
+{
+    AVBufferPool *pool;
+
+    if (!alloc)
+        alloc = av_buffer_alloc;
+
+    ff_thread_once(&shared_pools_once, shared_pools_init);
+    ff_mutex_lock(&shared_pools_lock);
+
+    for (pool = shared_pools; pool; pool = pool->next_shared)
+        if (pool->users && pool->size == size && pool->alloc == alloc)
+            break;
+
+    if (pool) {
+        pool->users++;
+        avpriv_atomic_int_add_and_fetch(&pool->refcount, 1);
+    } else if ((pool = av_buffer_pool_init(size, alloc))) {
+        pool->shared      = 1;
+        pool->users       = 1;
+        pool->next_shared = shared_pools;
+        shared_pools      = pool;
+    }
+
+    ff_mutex_unlock(&shared_pools_lock);
+
+    return pool;
+}
+
+void av_buffer_pool_set_shared_limit(int64_t max_memory)
+{
+    ff_thread_once(&shared_pools_once, shared_pools_init);
+    ff_mutex_lock(&shared_pools_lock);
+    shared_max_memory = FFMAX(max_memory, 0);
+    avpriv_atomic_int_set(&shared_limited, !!shared_max_memory);
+    ff_mutex_unlock(&shared_pools_lock);
+}
+
+/* add the counts of a pool to the totals, with the registry lock held */
+static void shared_pool_flush_stats(AVBufferPool *pool)
+{
+    int hits   = avpriv_atomic_int_get(&pool->hits);
+    int misses = avpriv_atomic_int_get(&pool->misses);
+
+    avpriv_atomic_int_add_and_fetch(&pool->hits,   -hits);
+    avpriv_atomic_int_add_and_fetch(&pool->misses, -misses);
+    shared_hits   += hits;
+    shared_misses += misses;
+}
+
+/* count a hit or a miss, moving the counts to the totals long before
+ * they can overflow */
+static void shared_pool_count(AVBufferPool *pool, volatile int *count)
+{
+    if (avpriv_atomic_int_add_and_fetch(count, 1) >= 1 << 30) {
+        ff_mutex_lock(&shared_pools_lock);
+        shared_pool_flush_stats(pool);
+        ff_mutex_unlock(&shared_pools_lock);
+    }
+}
+
+void ff_buffer_pool_get_shared_stats(BufferPoolStats *stats)
+{
+    AVBufferPool *pool;
+
+    memset(stats, 0, sizeof(*stats));
+
+    ff_thread_once(&shared_pools_once, shared_pools_init);
+    ff_mutex_lock(&shared_pools_lock);
+    for (pool = shared_pools; pool; pool = pool->next_shared) {
+        shared_pool_flush_stats(pool);
+        stats->bytes_held += (int64_t)avpriv_atomic_int_get(&pool->nb_held) * pool->size;
+        stats->bytes_free += (int64_t)avpriv_atomic_int_get(&pool->nb_free) * pool->size;
+        stats->nb_pools   += !!pool->users;
+    }
+    stats->hits   = shared_hits;
+    stats->misses = shared_misses;
+    ff_mutex_unlock(&shared_pools_lock);
+}
+
+static void shared_pool_release(AVBufferPool *pool)
+{
+    ff_mutex_lock(&shared_pools_lock);
+    pool->users--;
+    ff_mutex_unlock(&shared_pools_lock);
+}
+
+/* remove a pool being freed from the registry */
+static void shared_pool_unlink(AVBufferPool *pool)
+{
+    AVBufferPool **p;
+
+    ff_mutex_lock(&shared_pools_lock);
+    for (p = &shared_pools; *p; p = &(*p)->next_shared)
+        if (*p == pool) {
+            *p = pool->next_shared;
+            break;
+        }
+    shared_pool_flush_stats(pool);
+    ff_mutex_unlock(&shared_pools_lock);
+}
+
+/* memory allocated by the shared pools, with the registry lock held */
+static int64_t shared_pools_held(void)
+{
+    AVBufferPool *pool;
+    int64_t held = 0;
+
+    for (pool = shared_pools; pool; pool = pool->next_shared)
+        held += (int64_t)avpriv_atomic_int_get(&pool->nb_held) * pool->size;
+    return held;
+}
+
+/*
+ * Free unused buffers of the shared pools until size more bytes fit in the
+ * memory limit. Must be called with the registry lock held.
+ */
+static void shared_pools_trim(int size)
+{
+    AVBufferPool *pool;
+    int64_t held = shared_pools_held();
+
+    for (pool = shared_pools; pool; pool = pool->next_shared) {
+        while (held + size > shared_max_memory) {
+            BufferPoolEntry *buf;
+
+            ff_mutex_lock(&pool->mutex);
+            buf = pool->pool;
+            if (buf)
+                pool->pool = buf->next;
+            ff_mutex_unlock(&pool->mutex);
+            if (!buf)
+                break;
+
+#if USE_ATOMICS
+            avpriv_atomic_int_add_and_fetch(&pool->nb_allocated, -1);
+#endif
+            avpriv_atomic_int_add_and_fetch(&pool->nb_held, -1);
+            avpriv_atomic_int_add_and_fetch(&pool->nb_free, -1);
+            buf->free(buf->opaque, buf->data);
+            av_free(buf);
+            held -= pool->size;
+        }
+    }
+}
+
+/* make room in the memory limit before a shared pool allocates a buffer;
+ * must not be called with the mutex of a pool held */
+static void shared_pool_reserve(AVBufferPool *pool)
+{
+    if (avpriv_atomic_int_get(&shared_limited)) {
+        ff_mutex_lock(&shared_pools_lock);
+        if (shared_max_memory &&
+            shared_pools_held() + pool->size > shared_max_memory)
+            shared_pools_trim(pool->size);
+        ff_mutex_unlock(&shared_pools_lock);
+    }
+}
+
+/* account a buffer handed out by a shared pool */
+static void shared_pool_get(AVBufferPool *pool, int reused)
+{
+    if (reused) {
+        avpriv_atomic_int_add_and_fetch(&pool->nb_free, -1);
+        shared_pool_count(pool, &pool->hits);
+        return;
+    }
+
+    avpriv_atomic_int_add_and_fetch(&pool->nb_held, 1);
+    shared_pool_count(pool, &pool->misses);
+}
+
+/**
+ * Account a buffer returned to a shared pool.
+ * @return 1 if the buffer should be kept for reuse, 0 if it should be freed
+ */
+static int shared_pool_put(AVBufferPool *pool)
+{
+    int keep = 1;
+
+    if (avpriv_atomic_int_get(&shared_limited)) {
+        ff_mutex_lock(&shared_pools_lock);
+        keep = !shared_max_memory || shared_pools_held() <= shared_max_memory;
+        ff_mutex_unlock(&shared_pools_lock);
+    }
+    if (keep)
+        avpriv_atomic_int_add_and_fetch(&pool->nb_free, 1);
+    else
+        avpriv_atomic_int_add_and_fetch(&pool->nb_held, -1);
+
+    return keep;
+}
+
 /*
  * This function gets called when the pool has been uninited and
  * all the buffers returned to it.
  */
 static void buffer_pool_free(AVBufferPool *pool)
 {
+    /* the registry must not trim the pool anymore */
+    if (pool->shared)
+        shared_pool_unlink(pool);
+
     while (pool->pool) {
         BufferPoolEntry *buf = pool->pool;
         pool->pool = buf->next;
@@ -280,6 +492,9 @@ void av_buffer_pool_uninit(AVBufferPool **ppool)
     pool   = *ppool;
     *ppool = NULL;
 
+    if (pool->shared)
+        shared_pool_release(pool);
+
     if (!avpriv_atomic_int_add_and_fetch(&pool->refcount, -1))
         buffer_pool_free(pool);
 }
@@ -327,17 +542,26 @@ static void pool_release_buffer(void *opaque, uint8_t *data)
     BufferPoolEntry *buf = opaque;
     AVBufferPool *pool = buf->pool;
 
-    if(CONFIG_MEMORY_POISONING)
-        memset(buf->data, FF_MEMORY_POISON, pool->size);
+    if (pool->shared && !shared_pool_put(pool)) {
+        /* over the memory limit, do not keep the buffer */
+#if USE_ATOMICS
+        avpriv_atomic_int_add_and_fetch(&pool->nb_allocated, -1);
+#endif
+        buf->free(buf->opaque, buf->data);
+        av_free(buf);
+    } else {
+        if(CONFIG_MEMORY_POISONING)
+            memset(buf->data, FF_MEMORY_POISON, pool->size);
 
 #if USE_ATOMICS
-    add_to_pool(buf);
+        add_to_pool(buf);
 #else
-    ff_mutex_lock(&pool->mutex);
-    buf->next = pool->pool;
-    pool->pool = buf;
-    ff_mutex_unlock(&pool->mutex);
+        ff_mutex_lock(&pool->mutex);
+        buf->next = pool->pool;
+        pool->pool = buf;
+        ff_mutex_unlock(&pool->mutex);
 #endif
+    }
 
     if (!avpriv_atomic_int_add_and_fetch(&pool->refcount, -1))
         buffer_pool_free(pool);
@@ -381,6 +605,7 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
 {
     AVBufferRef *ret;
     BufferPoolEntry *buf;
+    int reused;
 
 #if USE_ATOMICS
     /* check whether the pool is empty */
@@ -391,8 +616,15 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
             buf = get_pool(pool);
     }
 
-    if (!buf)
-        return pool_alloc_buffer(pool);
+    if (!buf) {
+        if (pool->shared)
+            shared_pool_reserve(pool);
+        ret = pool_alloc_buffer(pool);
+        if (ret && pool->shared)
+            shared_pool_get(pool, 0);
+        return ret;
+    }
+    reused = 1;
 
     /* keep the first entry, return the rest of the list to the pool */
     add_to_pool(buf->next);
@@ -406,7 +638,8 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
     }
 #else
     ff_mutex_lock(&pool->mutex);
-    buf = pool->pool;
+    buf    = pool->pool;
+    reused = !!buf;
     if (buf) {
         ret = av_buffer_create(buf->data, pool->size, pool_release_buffer,
                                buf, 0);
@@ -414,14 +647,22 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
             pool->pool = buf->next;
             buf->next = NULL;
         }
-    } else {
-        ret = pool_alloc_buffer(pool);
     }
     ff_mutex_unlock(&pool->mutex);
+
+    /* trimming the shared pools takes their mutexes, this one included */
+    if (!buf) {
+        if (pool->shared)
+            shared_pool_reserve(pool);
+        ret = pool_alloc_buffer(pool);
+    }
 #endif
 
     if (ret)
         avpriv_atomic_int_add_and_fetch(&pool->refcount, 1);
 
+    if (ret && pool->shared)
+        shared_pool_get(pool, reused);
+
     return ret;
 }
@@ -283,6 +283,33 @@ void av_buffer_pool_uninit(AVBufferPool **pool);
  */
 AVBufferRef *av_buffer_pool_get(AVBufferPool *pool);
 
+/**
+ * Get a pool from the registry of pools shared by the whole process,
+ * creating it if needed. Callers asking for the same size and allocator get
+ * the same pool, so that for example all the decoders and filters handling
+ * frames of the same dimensions draw from a single set of buffers.
+ *
+ * The returned pool is used like one from av_buffer_pool_init(); each call
+ * must be matched by a call to av_buffer_pool_uninit().
+ *
+ * @param size size of each buffer in this pool
+ * @param alloc a function that will be used to allocate new buffers when the
+ * pool is empty. May be NULL, then the default allocator will be used
+ * (av_buffer_alloc()).
+ * @return the shared pool on success, NULL on error.
+ */
+AVBufferPool *av_buffer_pool_init_shared(int size, AVBufferRef* (*alloc)(int size));
+
+/**
+ * Set the maximum amount of memory, in bytes, held by the shared pools.
+ * Above it, buffers returned to a shared pool are freed instead of being
+ * kept, and unused buffers of the shared pools are freed before a new one
+ * is allocated. Allocations never fail because of this limit.
+ *
+ * @param max_memory the limit, 0 (the default) for no limit
+ */
+void av_buffer_pool_set_shared_limit(int64_t max_memory);
+
 /**
  * @}
  */
@@ -94,6 +94,46 @@ struct AVBufferPool {
     AVBufferRef* (*alloc)(int size);
     AVBufferRef* (*alloc2)(void *opaque, int size);
     void         (*pool_free)(void *opaque);
+
+    /*
+     * Set for the pools created by av_buffer_pool_init_shared().
+     * users is the number of callers holding the pool, each of them also
+     * owns one refcount; av_buffer_pool_init_shared() only returns the pool
+     * as long as users is not 0. The pool stays linked in the registry
+     * through next_shared until it is freed, so that its buffers are
+     * accounted for.
+     * All three are protected by the registry lock.
+     */
+    int shared;
+    int users;
+    struct AVBufferPool *next_shared;
+
+    /*
+     * Statistics of a shared pool, updated atomically without taking the
+     * registry lock: buffers reused and allocated since these counts were
+     * last added to the totals of the registry, buffers allocated by the
+     * pool and not freed yet, and those of them waiting in the pool.
+     */
+    volatile int hits;
+    volatile int misses;
+    volatile int nb_held;
+    volatile int nb_free;
 };
 
+/**
+ * Statistics of the shared pools, see ff_buffer_pool_get_shared_stats().
+ */
+typedef struct BufferPoolStats {
+    uint64_t hits;       ///< buffers served by reusing an unused one
+    uint64_t misses;     ///< buffers that had to be allocated
+    int64_t  bytes_held; ///< memory allocated by the shared pools
+    int64_t  bytes_free; ///< part of bytes_held not in use
+    int      nb_pools;   ///< number of shared pools
+} BufferPoolStats;
+
+/**
+ * Get the current statistics of the shared pools.
+ */
+void ff_buffer_pool_get_shared_stats(BufferPoolStats *stats);
+
 #endif /* AVUTIL_BUFFER_INTERNAL_H */
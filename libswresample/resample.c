@@ -27,8 +27,33 @@
  */
 
 #include "libavutil/avassert.h"
+#include "libavutil/thread.h"
 #include "resample.h"
 
+/**
+ * A filter bank only depends on the parameters below, so resamplers with
+ * the same ones share a single read-only copy, which stays cached for a
+ * while after its last user is gone.
+ */
+typedef struct FilterBank {
+    struct FilterBank *next;
+    int refcount;
+    enum AVSampleFormat format;
+    int phase_shift;
+    double factor;
+    int filter_length;
+    enum SwrFilterType filter_type;
+    double kaiser_beta;
+    uint8_t *data;
+} FilterBank;
+
+/* maximum number of cached filter banks no resampler uses */
+#define MAX_IDLE_FILTER_BANKS 4
+
+static AVMutex filter_banks_lock;
+static AVOnce filter_banks_once = AV_ONCE_INIT;
+static FilterBank *filter_banks; ///< most recently used first
+
 static inline double eval_poly(const double *coeff, int size, double x) {
     double sum = coeff[size-1];
     int i;
@@ -295,6 +320,126 @@ fail:
     return 0;
 }
 
+static void filter_banks_init(void)
+{
+    ff_mutex_init(&filter_banks_lock, NULL);
+}
+
+static int filter_bank_match(const FilterBank *bank, const ResampleContext *c)
+{
+    return bank->format        == c->format        &&
+           bank->phase_shift   == c->phase_shift   &&
+           bank->factor        == c->factor        &&
+           bank->filter_length == c->filter_length &&
+           bank->filter_type   == c->filter_type   &&
+           bank->kaiser_beta   == c->kaiser_beta;
+}
+
+static void filter_bank_free(FilterBank *bank)
+{
+    av_freep(&bank->data);
+    av_free(bank);
+}
+
+/* must be called with filter_banks_lock held */
+static FilterBank *filter_bank_find(const ResampleContext *c)
+{
+    FilterBank **prev, *bank;
+
+    for (prev = &filter_banks; (bank = *prev); prev = &bank->next) {
+        if (filter_bank_match(bank, c)) {
+            *prev        = bank->next;
+            bank->next   = filter_banks;
+            filter_banks = bank;
+            bank->refcount++;
+            return bank;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Get the filter bank for the parameters set in c, building it if it is not
+ * cached. The bank is built without holding the lock, if another thread
+ * built the same one in the meantime, the first one wins.
+ */
+static FilterBank *filter_bank_get(ResampleContext *c)
+{
+    int phase_count = 1 << c->phase_shift;
+    FilterBank *bank, *cached;
+
+    ff_thread_once(&filter_banks_once, filter_banks_init);
+    ff_mutex_lock(&filter_banks_lock);
+    bank = filter_bank_find(c);
+    ff_mutex_unlock(&filter_banks_lock);
+    if (bank)
+        return bank;
+
+    bank = av_mallocz(sizeof(*bank));
+    if (!bank)
+        return NULL;
+    bank->format        = c->format;
+    bank->phase_shift   = c->phase_shift;
+    bank->factor        = c->factor;
+    bank->filter_length = c->filter_length;
+    bank->filter_type   = c->filter_type;
+    bank->kaiser_beta   = c->kaiser_beta;
+    bank->refcount      = 1;
+    bank->data          = av_calloc(c->filter_alloc, (phase_count+1)*c->felem_size);
+    if (!bank->data ||
+        build_filter(c, (void*)bank->data, c->factor, c->filter_length, c->filter_alloc, phase_count, 1<<c->filter_shift, c->filter_type, c->kaiser_beta)) {
+        filter_bank_free(bank);
+        return NULL;
+    }
+    memcpy(bank->data + (c->filter_alloc*phase_count+1)*c->felem_size, bank->data, (c->filter_alloc-1)*c->felem_size);
+    memcpy(bank->data + (c->filter_alloc*phase_count  )*c->felem_size, bank->data + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
+
+    ff_mutex_lock(&filter_banks_lock);
+    cached = filter_bank_find(c);
+    if (!cached) {
+        bank->next   = filter_banks;
+        filter_banks = bank;
+    }
+    ff_mutex_unlock(&filter_banks_lock);
+
+    if (cached) {
+        filter_bank_free(bank);
+        return cached;
+    }
+    return bank;
+}
+
+static void filter_bank_release(FilterBank **pbank)
+{
+    FilterBank **prev, *bank = *pbank;
+    int nb_idle = 0;
+
+    if (!bank)
+        return;
+    *pbank = NULL;
+
+    ff_mutex_lock(&filter_banks_lock);
+    av_assert0(bank->refcount > 0);
+    bank->refcount--;
+    /* drop the least recently used idle banks over the limit */
+    for (prev = &filter_banks; (bank = *prev);) {
+        if (!bank->refcount && ++nb_idle > MAX_IDLE_FILTER_BANKS) {
+            *prev = bank->next;
+            filter_bank_free(bank);
+        } else {
+            prev = &bank->next;
+        }
+    }
+    ff_mutex_unlock(&filter_banks_lock);
+}
+
+static void resample_free(ResampleContext **c){
+    if(!*c)
+        return;
+    filter_bank_release(&(*c)->bank);
+    av_freep(c);
+}
+
 static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_rate, int filter_size, int phase_shift, int linear,
                                     double cutoff0, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta,
                                     double precision, int cheby)
@@ -306,6 +451,7 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
     if (!c || c->phase_shift != phase_shift || c->linear!=linear || c->factor != factor
            || c->filter_length != FFMAX((int)ceil(filter_size/factor), 1) || c->format != format
            || c->filter_type != filter_type || c->kaiser_beta != kaiser_beta) {
+        resample_free(&c);
         c = av_mallocz(sizeof(*c));
         if (!c)
             return NULL;
@@ -341,15 +487,12 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
         c->factor        = factor;
         c->filter_length = FFMAX((int)ceil(filter_size/factor), 1);
         c->filter_alloc  = FFALIGN(c->filter_length, 8);
-        c->filter_bank   = av_calloc(c->filter_alloc, (phase_count+1)*c->felem_size);
         c->filter_type   = filter_type;
         c->kaiser_beta   = kaiser_beta;
-        if (!c->filter_bank)
+        c->bank          = filter_bank_get(c);
+        if (!c->bank)
             goto error;
-        if (build_filter(c, (void*)c->filter_bank, factor, c->filter_length, c->filter_alloc, phase_count, 1<<c->filter_shift, filter_type, kaiser_beta))
-            goto error;
-        memcpy(c->filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, c->filter_bank, (c->filter_alloc-1)*c->felem_size);
-        memcpy(c->filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, c->filter_bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
+        c->filter_bank   = c->bank->data;
     }
 
     c->compensation_distance= 0;
@@ -370,18 +513,11 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
 
     return c;
 error:
-    av_freep(&c->filter_bank);
+    filter_bank_release(&c->bank);
     av_free(c);
     return NULL;
 }
 
-static void resample_free(ResampleContext **c){
-    if(!*c)
-        return;
-    av_freep(&(*c)->filter_bank);
-    av_freep(c);
-}
-
 static int set_compensation(ResampleContext *c, int sample_delta, int compensation_distance){
     c->compensation_distance= compensation_distance;
     if (compensation_distance)
@@ -433,6 +569,26 @@ static int swri_resample(ResampleContext *c,
     return dst_size;
 }
 
+static int swri_resample_interleaved(ResampleContext *c,
+                                     uint8_t *dst, const uint8_t *src, int nb_channels,
+                                     int *consumed, int src_size, int dst_size)
+{
+    int64_t end_index = (1LL + src_size - c->filter_length) << c->phase_shift;
+    int64_t delta_frac = (end_index - c->index) * c->src_incr - c->frac;
+    int delta_n = (delta_frac + c->dst_incr - 1) / c->dst_incr;
+
+    av_assert1(c->filter_length > 1 || c->phase_shift);
+
+    dst_size = FFMIN(dst_size, delta_n);
+    if (dst_size > 0) {
+        *consumed = c->dsp.resample_interleaved(c, dst, src, nb_channels, dst_size, 1);
+    } else {
+        *consumed = 0;
+    }
+
+    return dst_size;
+}
+
 static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, AudioData *src, int src_size, int *consumed){
     int i, ret= -1;
     int av_unused mm_flags = av_get_cpu_flags();
@@ -444,6 +600,10 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
         dst_size = FFMIN(dst_size, c->compensation_distance);
     src_size = FFMIN(src_size, max_src_size);
 
+    if(!dst->planar){
+        ret= swri_resample_interleaved(c, dst->ch[0], src->ch[0], dst->ch_count,
+                                       consumed, src_size, dst_size);
+    }else
     for(i=0; i<dst->ch_count; i++){
         ret= swri_resample(c, dst->ch[i], src->ch[i],
                            consumed, src_size, dst_size, i+1==dst->ch_count);
@@ -494,14 +654,14 @@ static int64_t get_out_samples(struct SwrContext *s, int in_samples) {
 
 static int resample_flush(struct SwrContext *s) {
     AudioData *a= &s->in_buffer;
-    int i, j, ret;
+    int i, j, ret, stride;
     if((ret = swri_realloc_audio(a, s->in_buffer_index + 2*s->in_buffer_count)) < 0)
         return ret;
-    av_assert0(a->planar);
+    stride = a->planar ? a->bps : a->bps * a->ch_count;
     for(i=0; i<a->ch_count; i++){
         for(j=0; j<s->in_buffer_count; j++){
-            memcpy(a->ch[i] + (s->in_buffer_index+s->in_buffer_count+j  )*a->bps,
-                a->ch[i] + (s->in_buffer_index+s->in_buffer_count-j-1)*a->bps, a->bps);
+            memcpy(a->ch[i] + (s->in_buffer_index+s->in_buffer_count+j  )*stride,
+                a->ch[i] + (s->in_buffer_index+s->in_buffer_count-j-1)*stride, a->bps);
         }
     }
     s->in_buffer_count += (s->in_buffer_count+1)/2;
@@ -513,18 +673,22 @@ static int invert_initial_buffer(ResampleContext *c, AudioData *dst, const Audio
                                  int in_count, int *out_idx, int *out_sz)
 {
     int n, ch, num = FFMIN(in_count + *out_sz, c->filter_length + 1), res;
+    int dst_stride, src_stride;
 
     if (c->index >= 0)
         return 0;
 
+    dst_stride = c->felem_size * (dst->planar ? 1 : dst->ch_count);
+    src_stride = c->felem_size * (src->planar ? 1 : src->ch_count);
+
     if ((res = swri_realloc_audio(dst, c->filter_length * 2 + 1)) < 0)
         return res;
 
     // copy
     for (n = *out_sz; n < num; n++) {
         for (ch = 0; ch < src->ch_count; ch++) {
-            memcpy(dst->ch[ch] + ((c->filter_length + n) * c->felem_size),
-                   src->ch[ch] + ((n - *out_sz) * c->felem_size), c->felem_size);
+            memcpy(dst->ch[ch] + ((c->filter_length + n) * dst_stride),
+                   src->ch[ch] + ((n - *out_sz) * src_stride), c->felem_size);
         }
     }
 
@@ -538,8 +702,8 @@ static int invert_initial_buffer(ResampleContext *c, AudioData *dst, const Audio
     // else invert
     for (n = 1; n <= c->filter_length; n++) {
         for (ch = 0; ch < src->ch_count; ch++) {
-            memcpy(dst->ch[ch] + ((c->filter_length - n) * c->felem_size),
-                   dst->ch[ch] + ((c->filter_length + n) * c->felem_size),
+            memcpy(dst->ch[ch] + ((c->filter_length - n) * dst_stride),
+                   dst->ch[ch] + ((c->filter_length + n) * dst_stride),
                    c->felem_size);
         }
     }
@@ -55,7 +55,22 @@ typedef struct ResampleContext {
                              int n, int64_t index, int64_t incr);
         int (*resample)(struct ResampleContext *c, void *dst,
                         const void *src, int n, int update_ctx);
+        /**
+         * Resample nb_channels interleaved channels, see resample().
+         * Only set for float and double.
+         */
+        int (*resample_interleaved)(struct ResampleContext *c, void *dst,
+                                    const void *src, int nb_channels,
+                                    int n, int update_ctx);
+        /**
+         * Compute one output sample of each of nb_channels interleaved
+         * channels: dst[ch] = sum(src[i * nb_channels + ch] * filter[i]).
+         */
+        void (*resample_frame)(void *dst, const void *src, const void *filter,
+                               int filter_length, int nb_channels);
     } dsp;
+
+    struct FilterBank *bank;    ///< shared filter bank filter_bank points to
 } ResampleContext;
 
 void swri_resample_dsp_init(ResampleContext *c);
@@ -57,10 +57,16 @@ void swri_resample_dsp_init(ResampleContext *c)
     case AV_SAMPLE_FMT_FLTP:
         c->dsp.resample_one = resample_one_float;
         c->dsp.resample     = c->linear ? resample_linear_float : resample_common_float;
+        c->dsp.resample_interleaved = c->linear ? resample_linear_interleaved_float
+                                                : resample_common_interleaved_float;
+        c->dsp.resample_frame       = resample_frame_float;
         break;
     case AV_SAMPLE_FMT_DBLP:
         c->dsp.resample_one = resample_one_double;
         c->dsp.resample     = c->linear ? resample_linear_double : resample_common_double;
+        c->dsp.resample_interleaved = c->linear ? resample_linear_interleaved_double
+                                                : resample_common_interleaved_double;
+        c->dsp.resample_frame       = resample_frame_double;
         break;
     }
 
@@ -176,6 +176,121 @@ static int RENAME(resample_linear)(ResampleContext *c,
     return sample_index;
 }
 
+#if FILTER_SHIFT == 0
+/* packed input is only resampled directly as float or double */
+
+static void RENAME(resample_frame)(void *dest, const void *source,
+                                   const void *filter_, int filter_length,
+                                   int nb_channels)
+{
+    DELEM *dst = dest;
+    const DELEM *src = source;
+    const FELEM *filter = filter_;
+    int ch, i, k;
+
+    /* a block of channels shares every filter tap load, each channel is
+     * summed in the same order as in resample_common() */
+    for (ch = 0; ch < nb_channels; ch += 8) {
+        const int block = FFMIN(nb_channels - ch, 8);
+        FELEM2 val[8] = { 0 };
+
+        for (i = 0; i < filter_length; i++) {
+            const DELEM *s = src + i * nb_channels + ch;
+            for (k = 0; k < block; k++)
+                val[k] += s[k] * (FELEM2)filter[i];
+        }
+        for (k = 0; k < block; k++) {
+            OUT(dst[ch + k], val[k]);
+        }
+    }
+}
+
+static int RENAME(resample_common_interleaved)(ResampleContext *c,
+                                               void *dest, const void *source,
+                                               int nb_channels, int n, int update_ctx)
+{
+    DELEM *dst = dest;
+    const DELEM *src = source;
+    int dst_index;
+    int index= c->index;
+    int frac= c->frac;
+    int sample_index = index >> c->phase_shift;
+
+    index &= c->phase_mask;
+    for (dst_index = 0; dst_index < n; dst_index++) {
+        FELEM *filter = ((FELEM *) c->filter_bank) + c->filter_alloc * index;
+
+        c->dsp.resample_frame(dst + dst_index * nb_channels,
+                              src + sample_index * nb_channels,
+                              filter, c->filter_length, nb_channels);
+
+        frac  += c->dst_incr_mod;
+        index += c->dst_incr_div;
+        if (frac >= c->src_incr) {
+            frac -= c->src_incr;
+            index++;
+        }
+        sample_index += index >> c->phase_shift;
+        index &= c->phase_mask;
+    }
+
+    if(update_ctx){
+        c->frac= frac;
+        c->index= index;
+    }
+
+    return sample_index;
+}
+
+static int RENAME(resample_linear_interleaved)(ResampleContext *c,
+                                               void *dest, const void *source,
+                                               int nb_channels, int n, int update_ctx)
+{
+    DELEM *dst = dest;
+    const DELEM *src = source;
+    int dst_index;
+    int index= c->index;
+    int frac= c->frac;
+    int sample_index = index >> c->phase_shift;
+    double inv_src_incr = 1.0 / c->src_incr;
+
+    index &= c->phase_mask;
+    for (dst_index = 0; dst_index < n; dst_index++) {
+        FELEM *filter = ((FELEM *) c->filter_bank) + c->filter_alloc * index;
+        const DELEM *s = src + sample_index * nb_channels;
+        int ch;
+
+        for (ch = 0; ch < nb_channels; ch++) {
+            FELEM2 val=0, v2 = 0;
+            int i;
+
+            for (i = 0; i < c->filter_length; i++) {
+                val += s[i * nb_channels + ch] * (FELEM2)filter[i];
+                v2  += s[i * nb_channels + ch] * (FELEM2)filter[i + c->filter_alloc];
+            }
+            val += (v2 - val) * inv_src_incr * frac;
+            OUT(dst[dst_index * nb_channels + ch], val);
+        }
+
+        frac += c->dst_incr_mod;
+        index += c->dst_incr_div;
+        if (frac >= c->src_incr) {
+            frac -= c->src_incr;
+            index++;
+        }
+        sample_index += index >> c->phase_shift;
+        index &= c->phase_mask;
+    }
+
+    if(update_ctx){
+        c->frac= frac;
+        c->index= index;
+    }
+
+    return sample_index;
+}
+#endif /* FILTER_SHIFT == 0 */
+
 #undef RENAME
 #undef FILTER_SHIFT
 #undef DELEM
@@ -318,6 +318,16 @@ av_assert0(s->used_ch_count);
 av_assert0(s->out.ch_count);
     s->resample_first= RSC*s->out.ch_count/s->in.ch_count - RSC < s->out_sample_rate/(float)s-> in_sample_rate - 1.0;
 
+    /* resample packed float data in place of converting it to planar and
+     * back when nothing else has to be done to it */
+    s->packed_resample =  s->resample && s->engine == SWR_ENGINE_SWR
+                       && !s->in.planar && s->in_sample_fmt == s->out_sample_fmt
+                       && av_get_planar_sample_fmt(s->in_sample_fmt) == s->int_sample_fmt
+                       && (s->int_sample_fmt == AV_SAMPLE_FMT_FLTP || s->int_sample_fmt == AV_SAMPLE_FMT_DBLP)
+                       && !s->rematrix && !s->channel_map && !s->dither.method
+                       && s->in.ch_count == s->used_ch_count && s->in.ch_count == s->out.ch_count
+                       && !(s->filter_size == 1 && s->phase_shift == 0);
+
     s->in_buffer= s->in;
     s->silence  = s->in;
     s->drop_temp= s->out;
@@ -358,7 +368,7 @@ av_assert0(s->out.ch_count);
     set_audiodata_fmt(&s->midbuf, s->int_sample_fmt);
     set_audiodata_fmt(&s->preout, s->int_sample_fmt);
 
-    if(s->resample){
+    if(s->resample && !s->packed_resample){
         set_audiodata_fmt(&s->in_buffer, s->int_sample_fmt);
     }
 
@@ -572,6 +582,9 @@ static int swr_convert_internal(struct SwrContext *s, AudioData *out, int out_co
         return out_count;
     }
 
+    if(s->packed_resample)
+        return resample(s, out, out_count, in, in_count);
+
 //     in_max= out_count*(int64_t)s->in_sample_rate / s->out_sample_rate + resample_filter_taps;
 //     in_count= FFMIN(in_count, in_in + 2 - s->hist_buffer_count);
 
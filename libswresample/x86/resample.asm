@@ -603,3 +603,99 @@ RESAMPLE_FNS int16, 2, 1
 
 INIT_XMM sse2
 RESAMPLE_FNS double, 8, 3, d, pdbl_1
+
+%macro RESAMPLE_FRAME_FN 3 ; format [float or double], log2_bps, float op suffix [s or d]
+; void resample_frame_$format($format *dst, const $format *src,
+;                             const $format *filter, int filter_length,
+;                             int nb_channels)
+; every filter tap is broadcast once and applied to a whole register of
+; interleaved channels, leftover channels are done one at a time; without
+; fma the sums are rounded exactly like the C version
+cglobal resample_frame_%1, 5, 8, 3, dst, src, filter, filter_end, channels, \
+                                    stride, srcp, filterp
+    movsxdifnidn        filter_endq, filter_endd
+    movsxdifnidn          channelsq, channelsd
+    lea                     strideq, [channelsq*(1 << %2)]
+    lea                 filter_endq, [filterq+filter_endq*(1 << %2)]
+    sub                   channelsq, mmsize >> %2
+    jl .tail
+
+.block_loop:
+    xorps                        m0, m0
+    mov                       srcpq, srcq
+    mov                    filterpq, filterq
+.block_tap_loop:
+%if cpuflag(avx)
+    vbroadcasts%3                m1, [filterpq]
+%elifidn %3, s
+    movss                        m1, [filterpq]
+    shufps                       m1, m1, 0
+%else
+    movsd                        m1, [filterpq]
+    unpcklpd                     m1, m1
+%endif
+%if cpuflag(fma3)
+    fmaddp%3                     m0, m1, [srcpq], m0
+%elif cpuflag(avx)
+    mulp%3                       m1, m1, [srcpq]
+    addp%3                       m0, m1
+%else
+    ; the rows are not aligned, legacy SSE memory operands must be
+    movu                         m2, [srcpq]
+    mulp%3                       m1, m2
+    addp%3                       m0, m1
+%endif
+    add                       srcpq, strideq
+    add                    filterpq, 1 << %2
+    cmp                    filterpq, filter_endq
+    jb .block_tap_loop
+    movu                     [dstq], m0
+    add                        dstq, mmsize
+    add                        srcq, mmsize
+    sub                   channelsq, mmsize >> %2
+    jge .block_loop
+
+.tail:
+    add                   channelsq, mmsize >> %2
+    jz .end
+.tail_loop:
+    xorps                       xm0, xm0
+    mov                       srcpq, srcq
+    mov                    filterpq, filterq
+.tail_tap_loop:
+    movs%3                      xm1, [filterpq]
+%if cpuflag(fma3)
+    fmadds%3                    xm0, xm1, [srcpq], xm0
+%else
+    muls%3                      xm1, [srcpq]
+    adds%3                      xm0, xm1
+%endif
+    add                       srcpq, strideq
+    add                    filterpq, 1 << %2
+    cmp                    filterpq, filter_endq
+    jb .tail_tap_loop
+    movs%3                   [dstq], xm0
+    add                        dstq, 1 << %2
+    add                        srcq, 1 << %2
+    dec                   channelsq
+    jnz .tail_loop
+.end:
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse
+RESAMPLE_FRAME_FN float,  2, s
+INIT_XMM sse2
+RESAMPLE_FRAME_FN double, 3, d
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+RESAMPLE_FRAME_FN float,  2, s
+RESAMPLE_FRAME_FN double, 3, d
+%endif
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+RESAMPLE_FRAME_FN float,  2, s
+RESAMPLE_FRAME_FN double, 3, d
+%endif
+%endif
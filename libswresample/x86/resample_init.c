@@ -43,6 +43,18 @@ RESAMPLE_FUNCS(float,  fma3);
 RESAMPLE_FUNCS(float,  fma4);
 RESAMPLE_FUNCS(double, sse2);
 
+#define RESAMPLE_FRAME_FUNC(type, opt) \
+void ff_resample_frame_##type##_##opt(void *dst, const void *src, \
+                                     const void *filter, int filter_length, \
+                                     int nb_channels)
+
+RESAMPLE_FRAME_FUNC(float,  sse);
+RESAMPLE_FRAME_FUNC(float,  avx);
+RESAMPLE_FRAME_FUNC(float,  fma3);
+RESAMPLE_FRAME_FUNC(double, sse2);
+RESAMPLE_FRAME_FUNC(double, avx);
+RESAMPLE_FRAME_FUNC(double, fma3);
+
 av_cold void swri_resample_dsp_x86_init(ResampleContext *c)
 {
     int av_unused mm_flags = av_get_cpu_flags();
@@ -66,14 +78,20 @@ av_cold void swri_resample_dsp_x86_init(ResampleContext *c)
         if (EXTERNAL_SSE(mm_flags)) {
             c->dsp.resample = c->linear ? ff_resample_linear_float_sse
                                         : ff_resample_common_float_sse;
+            if (ARCH_X86_64)
+                c->dsp.resample_frame = ff_resample_frame_float_sse;
         }
         if (EXTERNAL_AVX_FAST(mm_flags)) {
             c->dsp.resample = c->linear ? ff_resample_linear_float_avx
                                         : ff_resample_common_float_avx;
+            if (ARCH_X86_64)
+                c->dsp.resample_frame = ff_resample_frame_float_avx;
         }
         if (EXTERNAL_FMA3_FAST(mm_flags)) {
             c->dsp.resample = c->linear ? ff_resample_linear_float_fma3
                                         : ff_resample_common_float_fma3;
+            if (ARCH_X86_64)
+                c->dsp.resample_frame = ff_resample_frame_float_fma3;
         }
         if (EXTERNAL_FMA4(mm_flags)) {
             c->dsp.resample = c->linear ? ff_resample_linear_float_fma4
@@ -84,6 +102,14 @@ av_cold void swri_resample_dsp_x86_init(ResampleContext *c)
         if (EXTERNAL_SSE2(mm_flags)) {
             c->dsp.resample = c->linear ? ff_resample_linear_double_sse2
                                         : ff_resample_common_double_sse2;
+            if (ARCH_X86_64)
+                c->dsp.resample_frame = ff_resample_frame_double_sse2;
+        }
+        if (ARCH_X86_64 && EXTERNAL_AVX_FAST(mm_flags)) {
+            c->dsp.resample_frame = ff_resample_frame_double_avx;
+        }
+        if (ARCH_X86_64 && EXTERNAL_FMA3_FAST(mm_flags)) {
+            c->dsp.resample_frame = ff_resample_frame_double_fma3;
         }
         break;
     }
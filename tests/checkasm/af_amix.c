@@ -0,0 +1,83 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/af_amix.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define MAX_INPUTS 128
+#define LEN        1024
+
+static const int nb_inputs[] = { 1, 2, 3, 4, 8, 16, 32, 64, MAX_INPUTS };
+
+static void check_mix(AMixDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, dst0, [LEN]);
+    LOCAL_ALIGNED_32(float, dst1, [LEN]);
+    /* one spare sample per input, so that half of them are misaligned */
+    float *buf = av_malloc_array(MAX_INPUTS * (LEN + 1), sizeof(*buf));
+    const float *src[MAX_INPUTS];
+    float scale[MAX_INPUTS];
+    declare_func(void, float *dst, const float *const *src, const float *scale,
+                 int nb_src, int len);
+    int i, k;
+
+    if (!buf)
+        return;
+
+    for (k = 0; k < MAX_INPUTS * (LEN + 1); k++)
+        buf[k] = (int)(rnd() & 0xffff) / 32768.0f - 1.0f;
+    for (i = 0; i < MAX_INPUTS; i++) {
+        src[i]   = buf + i * (LEN + 1) + (i & 1);
+        scale[i] = (int)(rnd() & 0xffff) / 65536.0f;
+    }
+
+    for (i = 0; i < FF_ARRAY_ELEMS(nb_inputs); i++) {
+        const int n = nb_inputs[i];
+
+        if (check_func(dsp->mix, "amix_mix_%d", n)) {
+            for (k = 0; k < LEN; k++)
+                dst0[k] = dst1[k] = (int)(rnd() & 0xffff) / 32768.0f - 1.0f;
+            call_ref(dst0, src, scale, n, LEN);
+            call_new(dst1, src, scale, n, LEN);
+            /* the sums are done in the same order */
+            if (memcmp(dst0, dst1, LEN * sizeof(*dst0)))
+                fail();
+            call_ref(dst0, src, scale, n, 32);
+            call_new(dst1, src, scale, n, 32);
+            if (memcmp(dst0, dst1, LEN * sizeof(*dst0)))
+                fail();
+            bench_new(dst1, src, scale, n, LEN);
+        }
+    }
+    report("mix");
+
+    av_free(buf);
+}
+
+void checkasm_check_amix(void)
+{
+    AMixDSPContext dsp;
+
+    ff_amix_init(&dsp);
+    check_mix(&dsp);
+}
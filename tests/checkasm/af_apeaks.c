@@ -0,0 +1,67 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/af_apeaks.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define LEN 2048
+
+static const int lens[] = { APEAKS_ALIGN, 272, LEN };
+
+static void check_peaks(APeaksDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, src, [LEN + 1]);
+    float stats_ref[APEAKS_STATS], stats_new[APEAKS_STATS], init[APEAKS_STATS];
+    declare_func(void, float *stats, const float *src, int len);
+    int i, j;
+
+    for (i = 0; i < LEN + 1; i++)
+        src[i] = (int)(rnd() & 0xffff) / 32768.0f - 1.0f;
+    init[0] = 0.25f;
+    init[1] = 0.5f;
+    for (j = 2; j < APEAKS_STATS; j++)
+        init[j] = (rnd() & 0xff) / 16.0f;
+
+    if (check_func(dsp->peaks, "apeaks_peaks")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(lens); i++) {
+            memcpy(stats_ref, init, sizeof(init));
+            memcpy(stats_new, init, sizeof(init));
+            call_ref(stats_ref, src + 1, lens[i]);
+            call_new(stats_new, src + 1, lens[i]);
+            /* the sums are done in the same order */
+            for (j = 0; j < APEAKS_STATS; j++)
+                if (stats_ref[j] != stats_new[j])
+                    fail();
+        }
+        bench_new(stats_new, src + 1, LEN);
+    }
+    report("peaks");
+}
+
+void checkasm_check_apeaks(void)
+{
+    APeaksDSPContext dsp;
+
+    ff_apeaks_init(&dsp);
+    check_peaks(&dsp);
+}
@@ -0,0 +1,59 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavfilter/af_atempo.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define LEN 2048
+
+static const int lens[] = { ATEMPO_DOT_ALIGN, 272, LEN };
+
+static void check_dot(ATempoDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, a, [LEN + 1]);
+    LOCAL_ALIGNED_32(float, b, [LEN + 3]);
+    declare_func_float(float, const float *a, const float *b, int len);
+    int i;
+
+    for (i = 0; i < LEN + 1; i++)
+        a[i] = (int)(rnd() & 0xffff) / 32768.0f - 1.0f;
+    for (i = 0; i < LEN + 3; i++)
+        b[i] = (int)(rnd() & 0xffff) / 32768.0f - 1.0f;
+
+    if (check_func(dsp->dot, "atempo_dot")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(lens); i++) {
+            /* the sums are done in the same order */
+            if (call_ref(a + 1, b + 3, lens[i]) != call_new(a + 1, b + 3, lens[i]) ||
+                call_ref(a,     b,     lens[i]) != call_new(a,     b,     lens[i]))
+                fail();
+        }
+        bench_new(a + 1, b + 3, LEN);
+    }
+    report("dot");
+}
+
+void checkasm_check_atempo(void)
+{
+    ATempoDSPContext dsp;
+
+    ff_atempo_init(&dsp);
+    check_dot(&dsp);
+}
@@ -0,0 +1,73 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/ebur128.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+
+/* 100 ms at 48 kHz, interleaved with an odd number of channels so that
+ * the pairs are not aligned */
+#define CHANNELS 3
+#define MAX_LEN  4800
+
+static const int lens[] = { 1, 7, 480, MAX_LEN };
+
+static void check_kweight(FFEBUR128DSPContext *dsp, const double *coeffs)
+{
+    LOCAL_ALIGNED_16(double, src,    [MAX_LEN * CHANNELS]);
+    LOCAL_ALIGNED_16(double, state0, [6 * CHANNELS]);
+    LOCAL_ALIGNED_16(double, state1, [6 * CHANNELS]);
+    double sum0[2], sum1[2];
+    declare_func(void, double *sum, double *state, ptrdiff_t state_stride,
+                 const double *coeffs, const double *src,
+                 ptrdiff_t src_stride, int len);
+    int i, k;
+
+    if (check_func(dsp->kweight, "ebur128_kweight")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(lens); i++) {
+            for (k = 0; k < MAX_LEN * CHANNELS; k++)
+                src[k] = (int)(rnd() & 0xffff) / 32768.0 - 1.0;
+            for (k = 0; k < 6 * CHANNELS; k++)
+                state0[k] = state1[k] = (int)(rnd() & 0xffff) / 32768.0 - 1.0;
+            sum0[0] = sum1[0] = rnd() & 0xff;
+            sum0[1] = sum1[1] = rnd() & 0xff;
+
+            call_ref(sum0, state0 + 1, CHANNELS, coeffs, src + 1, CHANNELS, lens[i]);
+            call_new(sum1, state1 + 1, CHANNELS, coeffs, src + 1, CHANNELS, lens[i]);
+            /* both versions do the same operations in the same order */
+            if (memcmp(sum0, sum1, sizeof(sum0)) ||
+                memcmp(state0, state1, 6 * CHANNELS * sizeof(*state0)))
+                fail();
+        }
+        bench_new(sum1, state1 + 1, CHANNELS, coeffs, src + 1, CHANNELS, MAX_LEN);
+    }
+    report("kweight");
+}
+
+void checkasm_check_ebur128(void)
+{
+    FFEBUR128Context s = { 0 };
+
+    /* K-weighting coefficients for 48 kHz */
+    if (ff_ebur128_init(&s, NULL, 0, CHANNELS, 48000, 0) >= 0)
+        check_kweight(&s.dsp, s.coeffs[0]);
+    ff_ebur128_uninit(&s);
+}
@@ -0,0 +1,70 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/partconv.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+
+/* transform lengths of the smallest and of a typical partition */
+#define MAX_LEN 2048
+
+static const int lens[] = { 16, 32, 48, 256, MAX_LEN };
+
+#define randomize_buffer(buf)                                    \
+    do {                                                         \
+        int k;                                                   \
+        for (k = 0; k < MAX_LEN; k++)                            \
+            buf[k] = (int)(rnd() & 0xffff) / 32768.0f - 1.0f;    \
+    } while (0)
+
+static void check_fcmul_add(PartConvDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, x,    [MAX_LEN]);
+    LOCAL_ALIGNED_32(float, h,    [MAX_LEN]);
+    LOCAL_ALIGNED_32(float, sum0, [MAX_LEN]);
+    LOCAL_ALIGNED_32(float, sum1, [MAX_LEN]);
+    declare_func(void, float *sum, const float *t, const float *c, ptrdiff_t len);
+    int i;
+
+    if (check_func(dsp->fcmul_add, "partconv_fcmul_add")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(lens); i++) {
+            randomize_buffer(x);
+            randomize_buffer(h);
+            randomize_buffer(sum0);
+            memcpy(sum1, sum0, MAX_LEN * sizeof(*sum1));
+            call_ref(sum0, x, h, lens[i]);
+            call_new(sum1, x, h, lens[i]);
+            /* fma does not round the products, allow for that */
+            if (!float_near_abs_eps_array(sum0, sum1, 1e-6, MAX_LEN))
+                fail();
+        }
+        bench_new(sum1, x, h, MAX_LEN);
+    }
+    report("fcmul_add");
+}
+
+void checkasm_check_partconv(void)
+{
+    PartConvDSPContext dsp;
+
+    ff_partconv_dsp_init(&dsp);
+    check_fcmul_add(&dsp);
+}
@@ -0,0 +1,73 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/af_volume.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+
+#define LEN 1024
+
+static void check_scale_samples(enum AVSampleFormat sample_fmt, int volume)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,  [LEN * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [LEN * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [LEN * 4]);
+    VolumeContext vol = { 0 };
+    declare_func(void, uint8_t *dst, const uint8_t *src, int nb_samples,
+                 int volume);
+    int k;
+
+    vol.sample_fmt = sample_fmt;
+    vol.volume_i   = volume;
+    ff_volume_init(&vol);
+
+    if (check_func(vol.scale_samples, "scale_samples_%s_%d",
+                   av_get_sample_fmt_name(sample_fmt), volume)) {
+        for (k = 0; k < LEN * 4; k++)
+            src[k] = rnd();
+        call_ref(dst0, src, LEN, volume);
+        call_new(dst1, src, LEN, volume);
+        if (sample_fmt == AV_SAMPLE_FMT_S16) {
+            if (memcmp(dst0, dst1, LEN * 2))
+                fail();
+        } else {
+            /* the s32 versions round the halves differently */
+            const int32_t *ref = (const int32_t *)dst0;
+            const int32_t *new = (const int32_t *)dst1;
+            for (k = 0; k < LEN; k++)
+                if (FFABS((int64_t)ref[k] - new[k]) > 1)
+                    break;
+            if (k < LEN)
+                fail();
+        }
+        bench_new(dst1, src, LEN, volume);
+    }
+}
+
+void checkasm_check_volume(void)
+{
+    check_scale_samples(AV_SAMPLE_FMT_S16, 128);
+    check_scale_samples(AV_SAMPLE_FMT_S16, 1000);
+    report("scale_samples_s16");
+
+    check_scale_samples(AV_SAMPLE_FMT_S32, 200);
+    report("scale_samples_s32");
+}
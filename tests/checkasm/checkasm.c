@@ -86,6 +86,10 @@ static const struct {
     #if CONFIG_H264QPEL
         { "h264qpel", checkasm_check_h264qpel },
     #endif
+    #if CONFIG_HEVC_DECODER
+        { "hevc_sao", checkasm_check_hevc_sao },
+        { "hevc_transform", checkasm_check_hevc_transform },
+    #endif
     #if CONFIG_JPEG2000_DECODER
         { "jpeg2000dsp", checkasm_check_jpeg2000dsp },
     #endif
@@ -103,12 +107,39 @@ static const struct {
     #endif
 #endif
 #if CONFIG_AVFILTER
+    #if CONFIG_AMIX_FILTER
+        { "af_amix", checkasm_check_amix },
+    #endif
+    #if CONFIG_APEAKS_FILTER
+        { "af_apeaks", checkasm_check_apeaks },
+    #endif
+    #if CONFIG_ATEMPO_FILTER
+        { "af_atempo", checkasm_check_atempo },
+    #endif
+    #if CONFIG_EBUR128_FILTER || CONFIG_LOUDNORM_FILTER
+        { "af_ebur128", checkasm_check_ebur128 },
+    #endif
+    #if CONFIG_FIREQUALIZER_FILTER || CONFIG_SOFALIZER_FILTER
+        { "af_partconv", checkasm_check_partconv },
+    #endif
+    #if CONFIG_VOLUME_FILTER
+        { "af_volume", checkasm_check_volume },
+    #endif
     #if CONFIG_BLEND_FILTER
         { "vf_blend", checkasm_check_blend },
     #endif
     #if CONFIG_COLORSPACE_FILTER
         { "vf_colorspace", checkasm_check_colorspace },
     #endif
+    #if CONFIG_NNEDI_FILTER
+        { "vf_nnedi", checkasm_check_nnedi },
+    #endif
+    #if CONFIG_ASELECT_FILTER || CONFIG_SCDET_FILTER || CONFIG_SELECT_FILTER
+        { "scene_sad", checkasm_check_scene_sad },
+    #endif
+#endif
+#if CONFIG_SWRESAMPLE
+    { "sw_resample", checkasm_check_sw_resample },
 #endif
     { NULL }
 };
@@ -0,0 +1,162 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavcodec/avcodec.h"
+#include "libavcodec/hevcdsp.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/intreadwrite.h"
+
+static const uint32_t pixel_mask[3] = { 0xffffffff, 0x03ff03ff, 0x0fff0fff };
+static const int sao_size[5] = { 8, 16, 32, 48, 64 };
+
+#define SIZEOF_PIXEL ((bit_depth + 7) / 8)
+/* stride of the padded source buffer the edge filter works on, in bytes */
+#define SRC_STRIDE   (2 * MAX_PB_SIZE + AV_INPUT_BUFFER_PADDING_SIZE)
+#define DST_STRIDE   (MAX_PB_SIZE * 2 + 64)
+#define BUF_SIZE     (SRC_STRIDE * (MAX_PB_SIZE + 2) + DST_STRIDE * MAX_PB_SIZE)
+
+#define randomize_buffers(buf0, buf1, size)                 \
+    do {                                                    \
+        uint32_t mask = pixel_mask[(bit_depth - 8) >> 1];   \
+        int k;                                              \
+        for (k = 0; k < size; k += 4) {                     \
+            uint32_t r = rnd() & mask;                      \
+            AV_WN32A(buf0 + k, r);                          \
+            AV_WN32A(buf1 + k, r);                          \
+        }                                                   \
+    } while (0)
+
+static void randomize_offsets(int16_t *offset_val, int bit_depth)
+{
+    /* sao_offset_abs is at most (1 << (FFMIN(bit_depth, 10) - 5)) - 1 */
+    int max = (1 << (FFMIN(bit_depth, 10) - 5)) - 1;
+    int k;
+
+    offset_val[0] = 0;
+    for (k = 1; k < 5; k++)
+        offset_val[k] = (int)(rnd() % (2 * max + 1)) - max;
+}
+
+static void check_sao_band(HEVCDSPContext *h, uint8_t *src0, uint8_t *src1,
+                           uint8_t *dst0, uint8_t *dst1, int bit_depth)
+{
+    int i, w, y;
+
+    for (i = 0; i < 5; i++) {
+        int block_size = sao_size[i];
+        int prev_size  = i > 0 ? sao_size[i - 1] : 0;
+        declare_func(void, uint8_t *dst, uint8_t *src, ptrdiff_t dst_stride,
+                     ptrdiff_t src_stride, int16_t *sao_offset_val,
+                     int sao_left_class, int width, int height);
+
+        if (check_func(h->sao_band_filter[i], "hevc_sao_band_%d_%d",
+                       block_size, bit_depth)) {
+            LOCAL_ALIGNED_16(int16_t, offset_val, [5]);
+
+            for (w = prev_size + 4; w <= block_size; w += 4) {
+                int left_class = rnd() & 31;
+
+                randomize_buffers(src0, src1, BUF_SIZE);
+                randomize_offsets(offset_val, bit_depth);
+                memset(dst0, 0, BUF_SIZE);
+                memset(dst1, 0, BUF_SIZE);
+
+                call_ref(dst0, src0, DST_STRIDE, SRC_STRIDE, offset_val,
+                         left_class, w, block_size);
+                call_new(dst1, src1, DST_STRIDE, SRC_STRIDE, offset_val,
+                         left_class, w, block_size);
+                for (y = 0; y < block_size; y++)
+                    if (memcmp(dst0 + y * DST_STRIDE, dst1 + y * DST_STRIDE,
+                               w * SIZEOF_PIXEL))
+                        fail();
+            }
+            bench_new(dst1, src1, DST_STRIDE, SRC_STRIDE, offset_val,
+                      rnd() & 31, block_size, block_size);
+        }
+    }
+}
+
+static void check_sao_edge(HEVCDSPContext *h, uint8_t *src0, uint8_t *src1,
+                           uint8_t *dst0, uint8_t *dst1, int bit_depth)
+{
+    /* the edge filter reads one row and one column of margin around the
+     * block, the source starts one row and one padding block into it */
+    const int src_offset = SRC_STRIDE + AV_INPUT_BUFFER_PADDING_SIZE;
+    int i, w, y;
+
+    for (i = 0; i < 5; i++) {
+        int block_size = sao_size[i];
+        int prev_size  = i > 0 ? sao_size[i - 1] : 0;
+        declare_func(void, uint8_t *dst, uint8_t *src, ptrdiff_t stride_dst,
+                     int16_t *sao_offset_val, int eo, int width, int height);
+
+        if (check_func(h->sao_edge_filter[i], "hevc_sao_edge_%d_%d",
+                       block_size, bit_depth)) {
+            LOCAL_ALIGNED_16(int16_t, offset_val, [5]);
+
+            for (w = prev_size + 4; w <= block_size; w += 4) {
+                int eo = rnd() & 3;
+
+                randomize_buffers(src0, src1, BUF_SIZE);
+                randomize_offsets(offset_val, bit_depth);
+                memset(dst0, 0, BUF_SIZE);
+                memset(dst1, 0, BUF_SIZE);
+
+                call_ref(dst0, src0 + src_offset, DST_STRIDE, offset_val,
+                         eo, w, block_size);
+                call_new(dst1, src1 + src_offset, DST_STRIDE, offset_val,
+                         eo, w, block_size);
+                for (y = 0; y < block_size; y++)
+                    if (memcmp(dst0 + y * DST_STRIDE, dst1 + y * DST_STRIDE,
+                               w * SIZEOF_PIXEL))
+                        fail();
+            }
+            bench_new(dst1, src1 + src_offset, DST_STRIDE, offset_val,
+                      rnd() & 3, block_size, block_size);
+        }
+    }
+}
+
+void checkasm_check_hevc_sao(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src0, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, src1, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [BUF_SIZE]);
+    int bit_depth;
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth += 2) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_sao_band(&h, src0, src1, dst0, dst1, bit_depth);
+    }
+    report("sao_band");
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth += 2) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_sao_edge(&h, src0, src1, dst0, dst1, bit_depth);
+    }
+    report("sao_edge");
+}
@@ -0,0 +1,102 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavcodec/hevcdsp.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+
+#define randomize_buffers(buf0, buf1, size)         \
+    do {                                            \
+        int k;                                      \
+        for (k = 0; k < size; k++) {                \
+            int16_t r = rnd();                      \
+            buf0[k] = r;                            \
+            buf1[k] = r;                            \
+        }                                           \
+    } while (0)
+
+static void check_transform_skip(HEVCDSPContext *h, int bit_depth)
+{
+    LOCAL_ALIGNED_32(int16_t, coeffs0, [32 * 32]);
+    LOCAL_ALIGNED_32(int16_t, coeffs1, [32 * 32]);
+    int log2_size;
+
+    for (log2_size = 2; log2_size <= 5; log2_size++) {
+        int size = 1 << (2 * log2_size);
+        declare_func(void, int16_t *coeffs, int16_t log2_size);
+
+        if (check_func(h->transform_skip, "hevc_transform_skip_%dx%d_%d",
+                       1 << log2_size, 1 << log2_size, bit_depth)) {
+            randomize_buffers(coeffs0, coeffs1, size);
+            call_ref(coeffs0, log2_size);
+            call_new(coeffs1, log2_size);
+            if (memcmp(coeffs0, coeffs1, size * sizeof(*coeffs0)))
+                fail();
+            bench_new(coeffs1, log2_size);
+        }
+    }
+}
+
+static void check_transform_rdpcm(HEVCDSPContext *h, int bit_depth)
+{
+    LOCAL_ALIGNED_32(int16_t, coeffs0, [32 * 32]);
+    LOCAL_ALIGNED_32(int16_t, coeffs1, [32 * 32]);
+    int log2_size, mode;
+
+    for (log2_size = 2; log2_size <= 5; log2_size++) {
+        for (mode = 0; mode < 2; mode++) {
+            int size = 1 << (2 * log2_size);
+            declare_func(void, int16_t *coeffs, int16_t log2_size, int mode);
+
+            if (check_func(h->transform_rdpcm, "hevc_transform_rdpcm_%s_%dx%d_%d",
+                           mode ? "ver" : "hor", 1 << log2_size,
+                           1 << log2_size, bit_depth)) {
+                randomize_buffers(coeffs0, coeffs1, size);
+                call_ref(coeffs0, log2_size, mode);
+                call_new(coeffs1, log2_size, mode);
+                if (memcmp(coeffs0, coeffs1, size * sizeof(*coeffs0)))
+                    fail();
+                bench_new(coeffs1, log2_size, mode);
+            }
+        }
+    }
+}
+
+void checkasm_check_hevc_transform(void)
+{
+    int bit_depth;
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth += 2) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_transform_skip(&h, bit_depth);
+    }
+    report("transform_skip");
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth += 2) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_transform_rdpcm(&h, bit_depth);
+    }
+    report("transform_rdpcm");
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/scene_sad.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+
+#define WIDTH  256
+#define HEIGHT 16
+#define STRIDE (WIDTH * 2 + 32)
+
+/* widths in samples, with and without columns left for the C code */
+static const int widths[]  = { 1, 8, 40, 67, WIDTH };
+static const int heights[] = { 0, 1, 3, HEIGHT };
+
+static void randomize(uint8_t *buf, int depth)
+{
+    int i;
+
+    if (depth == 8) {
+        for (i = 0; i < STRIDE * HEIGHT; i++)
+            buf[i] = rnd();
+    } else {
+        for (i = 0; i < STRIDE * HEIGHT; i += 2)
+            AV_WN16A(buf + i, rnd() & ((1 << depth) - 1));
+    }
+}
+
+static void check_sad(int depth)
+{
+    LOCAL_ALIGNED_32(uint8_t, src1, [STRIDE * HEIGHT]);
+    LOCAL_ALIGNED_32(uint8_t, src2, [STRIDE * HEIGHT]);
+    declare_func(void, const uint8_t *src1, ptrdiff_t stride1,
+                 const uint8_t *src2, ptrdiff_t stride2,
+                 ptrdiff_t width, ptrdiff_t height, uint64_t *sum);
+    ff_scene_sad_fn sad = ff_scene_sad_get_fn(depth);
+    uint64_t sum_ref, sum_new;
+    int i, j, k;
+
+    if (!check_func(sad, "scene_sad%d", depth))
+        return;
+
+    for (k = 0; k < 2; k++) {
+        if (!k) {
+            randomize(src1, depth);
+            randomize(src2, depth);
+        } else {
+            /* the largest differences of the depth, both ways */
+            memset(src1, 0x00, STRIDE * HEIGHT);
+            memset(src2, 0xff, STRIDE * HEIGHT);
+            if (depth > 8)
+                for (i = 0; i < STRIDE * HEIGHT; i += 2)
+                    AV_WN16A(src2 + i, (1 << depth) - 1);
+            memcpy(src1 + STRIDE * HEIGHT / 2, src2, STRIDE * HEIGHT / 2);
+            memset(src2 + STRIDE * HEIGHT / 2, 0x00, STRIDE * HEIGHT / 2);
+        }
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+            for (j = 0; j < FF_ARRAY_ELEMS(heights); j++) {
+                sum_ref = sum_new = ~0ULL;
+                call_ref(src1, STRIDE, src2, STRIDE, widths[i], heights[j], &sum_ref);
+                call_new(src1, STRIDE, src2, STRIDE, widths[i], heights[j], &sum_new);
+                if (sum_ref != sum_new)
+                    fail();
+            }
+        }
+    }
+    bench_new(src1, STRIDE, src2, STRIDE, WIDTH, HEIGHT, &sum_new);
+}
+
+void checkasm_check_scene_sad(void)
+{
+    check_sad(8);
+    report("scene_sad8");
+
+    check_sad(10);
+    check_sad(16);
+    report("scene_sad16");
+}
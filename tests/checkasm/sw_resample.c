@@ -0,0 +1,100 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libswresample/resample.h"
+
+#define FILTER_LENGTH 32
+#define MAX_CHANNELS  SWR_CH_MAX
+
+#define randomize_buffers(type)                                  \
+    do {                                                         \
+        type *s = (type *)src, *f = (type *)filter;              \
+        int k;                                                   \
+        for (k = 0; k < FILTER_LENGTH * MAX_CHANNELS; k++)       \
+            s[k] = (type)rnd() / UINT_MAX * 2 - 1;               \
+        for (k = 0; k < FILTER_LENGTH; k++)                      \
+            f[k] = ((type)rnd() / UINT_MAX * 2 - 1) / FILTER_LENGTH; \
+    } while (0)
+
+static int double_near_abs_eps_array(const double *a, const double *b,
+                                     double eps, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+        if (fabs(a[i] - b[i]) > eps)
+            return 0;
+    return 1;
+}
+
+static void check_resample_frame(enum AVSampleFormat format)
+{
+    static const int channels[] = { 2, 6, 8, 16, 19, 32, 64 };
+    LOCAL_ALIGNED_32(double, src,    [FILTER_LENGTH * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, filter, [FILTER_LENGTH]);
+    LOCAL_ALIGNED_32(double, dst0,   [MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, dst1,   [MAX_CHANNELS]);
+    const int is_float = format == AV_SAMPLE_FMT_FLTP;
+    ResampleContext c = { .format = format };
+    int i;
+
+    declare_func(void, void *dst, const void *src, const void *filter,
+                 int filter_length, int nb_channels);
+
+    swri_resample_dsp_init(&c);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(channels); i++) {
+        if (check_func(c.dsp.resample_frame, "resample_frame_%s_%dch",
+                       is_float ? "float" : "double", channels[i])) {
+            int ok;
+
+            if (is_float)
+                randomize_buffers(float);
+            else
+                randomize_buffers(double);
+            memset(dst0, 0, sizeof(*dst0) * MAX_CHANNELS);
+            memset(dst1, 0, sizeof(*dst1) * MAX_CHANNELS);
+            call_ref(dst0, src, filter, FILTER_LENGTH, channels[i]);
+            call_new(dst1, src, filter, FILTER_LENGTH, channels[i]);
+            /* fma does not round the products, allow for that */
+            if (is_float)
+                ok = float_near_abs_eps_array((float *)dst0, (float *)dst1,
+                                              1e-5, channels[i]);
+            else
+                ok = double_near_abs_eps_array(dst0, dst1, 1e-13, channels[i]);
+            if (!ok)
+                fail();
+            bench_new(dst1, src, filter, FILTER_LENGTH, channels[i]);
+        }
+    }
+}
+
+void checkasm_check_sw_resample(void)
+{
+    check_resample_frame(AV_SAMPLE_FMT_FLTP);
+    report("resample_frame_float");
+
+    check_resample_frame(AV_SAMPLE_FMT_DBLP);
+    report("resample_frame_double");
+}
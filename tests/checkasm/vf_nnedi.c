@@ -0,0 +1,93 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavfilter/nnedi.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+
+/* largest predictor input, 48x6 pixels */
+#define MAX_LEN 288
+
+/* vector lengths used by the prescreener and predictor networks */
+static const int float_len[] = { 4, 8, 36, 48, 96, 192, 288 };
+static const int int16_len[] = { 16, 32, 48, 64, 96, 288 };
+
+static void check_scalarproduct_float(NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, v1, [MAX_LEN + 1]);
+    LOCAL_ALIGNED_32(float, v2, [MAX_LEN + 1]);
+    /* checked_call() cannot return a float on x86-32, so no declare_func()
+     * here and the new function is called directly */
+    typedef float func_type(const float *v1, const float *v2, int len);
+    int i, j;
+
+    if (check_func(dsp->scalarproduct_float, "nnedi_scalarproduct_float")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(float_len); i++) {
+            int len = float_len[i];
+            /* the inputs are not required to be aligned */
+            int off = i & 1;
+            float ref, new;
+
+            for (j = 0; j < MAX_LEN + 1; j++) {
+                v1[j] = (int)(rnd() & 0xffff) / 32768.0f - 1.0f;
+                v2[j] = (int)(rnd() & 0xffff) / 32768.0f - 1.0f;
+            }
+            ref = call_ref(v1 + off, v2, len);
+            new = ((func_type *)func_new)(v1 + off, v2, len);
+            if (!float_near_abs_eps(ref, new, 1e-4))
+                fail();
+        }
+        bench_new(v1, v2, MAX_LEN);
+    }
+    report("scalarproduct_float");
+}
+
+static void check_scalarproduct_int16(NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(int16_t, v1, [MAX_LEN + 1]);
+    LOCAL_ALIGNED_32(int16_t, v2, [MAX_LEN + 1]);
+    declare_func(int, const int16_t *v1, const int16_t *v2, int len);
+    int i, j;
+
+    if (check_func(dsp->scalarproduct_int16, "nnedi_scalarproduct_int16")) {
+        for (i = 0; i < FF_ARRAY_ELEMS(int16_len); i++) {
+            int len = int16_len[i];
+            int off = i & 1;
+
+            /* pixels against weights scaled to the full int16 range */
+            for (j = 0; j < MAX_LEN + 1; j++) {
+                v1[j] = rnd() & 0xff;
+                v2[j] = rnd();
+            }
+            if (call_ref(v1 + off, v2, len) != call_new(v1 + off, v2, len))
+                fail();
+        }
+        bench_new(v1, v2, MAX_LEN);
+    }
+    report("scalarproduct_int16");
+}
+
+void checkasm_check_nnedi(void)
+{
+    NNEDIDSPContext dsp;
+
+    ff_nnedi_init(&dsp);
+    check_scalarproduct_float(&dsp);
+    check_scalarproduct_int16(&dsp);
+}
@@ -223,7 +223,14 @@ cglobal checked_call%1, 1,7
     jz .clobber_ok
     report_fail error_message
 .clobber_ok:
-%ifnid %1, _emms
+%ifidn %1, _float
+    ; the return value is left in st0, the only x87 register in use
+    fstenv [esp]
+    cmp  word [esp + 8], 0x3fff
+    je   .emms_ok
+    report_fail error_message_emms
+.emms_ok:
+%elifnid %1, _emms
     fstenv [esp]
     cmp  word [esp + 8], 0xffff
     je   .emms_ok
@@ -241,3 +248,6 @@ cglobal checked_call%1, 1,7
 
 CHECKED_CALL
 CHECKED_CALL _emms
+%if ARCH_X86_32
+CHECKED_CALL _float
+%endif
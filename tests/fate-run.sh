@@ -192,6 +192,16 @@ enc_dec(){
     tests/tiny_psnr $srcfile $decfile $cmp_unit $cmp_shift
 }
 
+peaks(){
+    src_file=$(target_path $1)
+    peaks_opts=$2
+    peaksfile="${outdir}/${test}.dat"
+    cleanfiles=$peaksfile
+    ffmpeg -i $src_file -af apeaks=file=$(target_path $peaksfile):$peaks_opts -f null - || return
+    do_md5sum $peaksfile
+    echo $(wc -c $peaksfile)
+}
+
 lavffatetest(){
     t="${test#lavf-fate-}"
     ref=${base}/ref/lavf-fate/$t
@@ -48,9 +48,22 @@ FATE_AFILTER_SAMPLES-$(call FILTERDEMDECENCMUX, AMIX, WAV, PCM_S16LE, PCM_F32LE,
 $(FATE_AMIX): tests/data/asynth-44100-2.wav tests/data/asynth-44100-2-2.wav
 $(FATE_AMIX): SRC  = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
 $(FATE_AMIX): SRC1 = $(TARGET_PATH)/tests/data/asynth-44100-2-2.wav
+
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, AMIX, WAV, PCM_S16LE, PCM_S16LE, PCM_S16LE) += fate-filter-amix-weights
+fate-filter-amix-weights: tests/data/asynth-44100-2.wav tests/data/asynth-44100-2-2.wav tests/data/asynth-44100-2-3.wav
+fate-filter-amix-weights: SRC  = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-amix-weights: SRC1 = $(TARGET_PATH)/tests/data/asynth-44100-2-2.wav
+fate-filter-amix-weights: SRC2 = $(TARGET_PATH)/tests/data/asynth-44100-2-3.wav
+fate-filter-amix-weights: CMD = md5 -i $(SRC) -ss 2 -i $(SRC1) -ss 4 -i $(SRC2) -filter_complex "amix=inputs=3:weights=2|1|0.5" -f s16le
+fate-filter-amix-weights: CMP = oneline
+fate-filter-amix-weights: REF = e8454531be9bc7bd0d1c92077f38063c
 $(FATE_AMIX): CMP  = oneoff
 $(FATE_AMIX): CMP_UNIT = f32
 
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, APEAKS, WAV, PCM_S16LE, PCM_S16LE, NULL) += fate-filter-apeaks
+fate-filter-apeaks: tests/data/asynth-44100-2.wav
+fate-filter-apeaks: CMD = peaks tests/data/asynth-44100-2.wav spp=300:levels=3:rms=1
+
 FATE_AFILTER_SAMPLES-$(call FILTERDEMDECMUX, ASYNCTS, FLV, NELLYMOSER, PCM_S16LE) += fate-filter-asyncts
 fate-filter-asyncts: SRC = $(TARGET_SAMPLES)/nellymoser/nellymoser-discont.flv
 fate-filter-asyncts: CMD = pcm -analyzeduration 10000000 -i $(SRC) -af asyncts
@@ -63,6 +76,24 @@ fate-filter-aresample: CMD = pcm -analyzeduration 10000000 -i $(SRC) -af aresamp
 fate-filter-aresample: CMP = oneoff
 fate-filter-aresample: REF = $(SAMPLES)/nellymoser/nellymoser-discont.pcm
 
+FATE_ATEMPO += fate-filter-atempo-slow
+fate-filter-atempo-slow: CMD = md5 -i $(SRC) -af atempo=0.3 -f s16le
+fate-filter-atempo-slow: REF = f073697ed5c05f3e57ce70e6e4fd4ec4
+
+FATE_ATEMPO += fate-filter-atempo-nominal
+fate-filter-atempo-nominal: CMD = md5 -i $(SRC) -af atempo=1 -f s16le
+fate-filter-atempo-nominal: REF = 7394fe34fe65449eb326c56e39d5ce45
+
+FATE_ATEMPO += fate-filter-atempo-fast
+fate-filter-atempo-fast: CMD = md5 -i $(SRC) -af atempo=4 -f s16le
+fate-filter-atempo-fast: REF = a1e10ee7b82a7b36c6d72e73841839c0
+
+$(FATE_ATEMPO): tests/data/asynth-44100-2.wav
+$(FATE_ATEMPO): SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+$(FATE_ATEMPO): CMP = oneline
+
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, ATEMPO, WAV, PCM_S16LE, PCM_S16LE, PCM_S16LE) += $(FATE_ATEMPO)
+
 FATE_ATRIM += fate-filter-atrim-duration
 fate-filter-atrim-duration: CMD = framecrc -i $(SRC) -af atrim=start=0.1:duration=0.01
 FATE_ATRIM += fate-filter-atrim-mixed
@@ -112,6 +143,19 @@ fate-filter-join: CMD = md5 -i $(SRC1) -i $(SRC2) -filter_complex join=channel_l
 fate-filter-join: CMP = oneline
 fate-filter-join: REF = 88b0d24a64717ba8635b29e8dac6ecd8
 
+FATE_AFILTER-$(call ALLYES, SINE_FILTER AREVERSE_FILTER) += fate-filter-areverse-spill
+fate-filter-areverse-spill: CMD = framecrc -lavfi sine=f=440:d=2,areverse=memory_limit=64k
+
+FATE_AFILTER-$(call ALLYES, WAV_DEMUXER PCM_S16LE_DECODER PCM_S16LE_ENCODER NULL_MUXER ASETNSAMPLES_FILTER EBUR128_FILTER AMETADATA_FILTER) += fate-filter-ebur128
+fate-filter-ebur128: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-ebur128: tests/data/asynth-44100-2.wav
+fate-filter-ebur128: CMD = ffmpeg -i $(SRC) -af asetnsamples=4410,ebur128=metadata=1,ametadata=mode=print:file=- -f null -
+
+FATE_AFILTER-$(call ALLYES, WAV_DEMUXER PCM_S16LE_DECODER PCM_S16LE_ENCODER NULL_MUXER LOUDNORM_FILTER) += fate-filter-loudnorm-json
+fate-filter-loudnorm-json: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-loudnorm-json: tests/data/asynth-44100-2.wav
+fate-filter-loudnorm-json: CMD = ffmpeg -i $(SRC) -af loudnorm=measure=1:print_format=json -f null - 2>&1 | sed -n "/^{/,/^}/p"
+
 FATE_AFILTER-$(call ALLYES, WAV_DEMUXER PCM_S16LE_DECODER PCM_S16LE_ENCODER PCM_S16LE_MUXER APERMS_FILTER VOLUME_FILTER) += fate-filter-volume
 fate-filter-volume: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
 fate-filter-volume: tests/data/asynth-44100-2.wav
@@ -64,6 +64,9 @@ fate-filter-lavd-life: CMD = framecrc -f lavfi -i life=s=40x40:r=5:seed=42:mold=
 FATE_FILTER-$(call ALLYES, AVDEVICE TESTSRC_FILTER) += fate-filter-lavd-testsrc
 fate-filter-lavd-testsrc: CMD = framecrc -f lavfi -i testsrc=r=7:n=2:d=10
 
+# The testsrc2 tests also cover the 8-bit mask lines of ff_blend_mask() that
+# drawtext uses. drawtext itself has no test: neither the tree nor the FATE
+# samples ship a font, and the FreeType rasterization varies across versions.
 FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER) += fate-filter-testsrc2-yuv420p
 fate-filter-testsrc2-yuv420p: CMD = framecrc -lavfi testsrc2=r=7:d=10 -pix_fmt yuv420p
 
@@ -334,6 +337,24 @@ fate-filter-concat: CMD = framecrc -filter_complex_script $(TARGET_PATH)/tests/d
 FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FPS_FILTER MPDECIMATE_FILTER) += fate-filter-mpdecimate
 fate-filter-mpdecimate: CMD = framecrc -lavfi testsrc2=r=2:d=10,fps=3,mpdecimate -r 3 -pix_fmt yuv420p
 
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER HFLIP_FILTER BOXBLUR_FILTER NEGATE_FILTER) += fate-filter-pipeline
+fate-filter-pipeline: CMD = framecrc -filter_pipeline 2 -lavfi testsrc2=r=7:d=10,hflip,boxblur=2,negate -pix_fmt yuv420p
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER HFLIP_FILTER BOXBLUR_FILTER THREADQUEUE_FILTER NEGATE_FILTER) += fate-filter-threadqueue
+fate-filter-threadqueue: CMD = framecrc -lavfi testsrc2=r=7:d=10,hflip,boxblur=2,threadqueue=frames=3,negate -pix_fmt yuv420p
+
+FATE_FILTER-$(call ALLYES, SINE_FILTER VOLUME_FILTER ATHREADQUEUE_FILTER ASETPTS_FILTER) += fate-filter-athreadqueue
+fate-filter-athreadqueue: CMD = framecrc -lavfi sine=f=440:d=5,volume=0.5,athreadqueue=frames=3,asetpts=PTS+0.5/TB
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER REVERSE_FILTER) += fate-filter-reverse-spill
+fate-filter-reverse-spill: CMD = framecrc -lavfi testsrc2=r=7:d=3,reverse=memory_limit=300k -pix_fmt yuv420p
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER COLORSPACE_FILTER) += fate-filter-colorspace-tonemap-pq
+fate-filter-colorspace-tonemap-pq: CMD = framecrc -lavfi testsrc2=s=176x144:r=7:d=1,format=yuv420p10,colorspace=ispace=bt2020ncl:iprimaries=bt2020:irange=mpeg:itrc=smpte2084:peak=1000:tonemap=hable:all=bt709:format=yuv420p
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER COLORSPACE_FILTER) += fate-filter-colorspace-tonemap-hlg
+fate-filter-colorspace-tonemap-hlg: CMD = framecrc -lavfi testsrc2=s=176x144:r=7:d=1,format=yuv420p10,colorspace=ispace=bt2020ncl:iprimaries=bt2020:irange=mpeg:itrc=arib-std-b67:tonemap=mobius:all=bt709:format=yuv420p
+
 FATE_FILTER_SAMPLES-$(call ALLYES, MOV_DEMUXER FPS_FILTER QTRLE_DECODER) += fate-filter-fps-cfr fate-filter-fps fate-filter-fps-r
 fate-filter-fps-cfr: CMD = framecrc -i $(TARGET_SAMPLES)/qtrle/apple-animation-variable-fps-bug.mov -r 30 -vsync cfr -pix_fmt yuv420p
 fate-filter-fps-r:   CMD = framecrc -i $(TARGET_SAMPLES)/qtrle/apple-animation-variable-fps-bug.mov -r 30 -vf fps -pix_fmt yuv420p
@@ -632,6 +653,11 @@ FATE_METADATA_FILTER-$(call ALLYES, $(READVITC_METADATA_DEPS)) += fate-filter-me
 fate-filter-metadata-readvitc-thr: SRC = $(TARGET_SAMPLES)/filter/sample-vitc.avi
 fate-filter-metadata-readvitc-thr: CMD = run $(FILTER_METADATA_COMMAND) "movie='$(SRC)',readvitc=thr_b=0.3:thr_w=0.5"
 
+SCDET_DEPS = FFPROBE AVDEVICE LAVFI_INDEV TESTSRC2_FILTER DRAWBOX_FILTER FORMAT_FILTER SCDET_FILTER
+FATE_METADATA_FILTER_LAVFI-$(call ALLYES, $(SCDET_DEPS)) += fate-filter-metadata-scdet fate-filter-metadata-scdet-10bit
+fate-filter-metadata-scdet: CMD = run $(FILTER_METADATA_COMMAND) "testsrc2=s=176x144:d=2,format=yuv420p,drawbox=c=red@0.8:t=max:enable=gte(t\,1),scdet=t=10"
+fate-filter-metadata-scdet-10bit: CMD = run $(FILTER_METADATA_COMMAND) "testsrc2=s=176x144:d=2,format=yuv420p10,drawbox=c=red@0.8:t=max:enable=gte(t\,1),scdet=t=10:step=2"
+
 tests/data/file4560-override2rotate0.mov: TAG = GEN
 tests/data/file4560-override2rotate0.mov: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
 	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< \
@@ -642,9 +668,10 @@ fate-filter-meta-4560-rotate0: tests/data/file4560-override2rotate0.mov
 fate-filter-meta-4560-rotate0: CMD = framecrc -flags +bitexact -c:a aac_fixed -i $(TARGET_PATH)/tests/data/file4560-override2rotate0.mov
 
 FATE_SAMPLES_FFPROBE += $(FATE_METADATA_FILTER-yes)
+FATE_FFPROBE += $(FATE_METADATA_FILTER_LAVFI-yes)
 FATE_SAMPLES_FFMPEG += $(FATE_FILTER_SAMPLES-yes)
 FATE_FFMPEG += $(FATE_FILTER-yes)
 
 fate-vfilter: $(FATE_FILTER-yes) $(FATE_FILTER_SAMPLES-yes) $(FATE_FILTER_VSYNTH-yes)
 
-fate-filter: fate-afilter fate-vfilter $(FATE_METADATA_FILTER-yes)
+fate-filter: fate-afilter fate-vfilter $(FATE_METADATA_FILTER-yes) $(FATE_METADATA_FILTER_LAVFI-yes)
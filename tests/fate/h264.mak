@@ -188,8 +188,15 @@ FATE_H264_REINIT_TESTS := large_420_8-to-small_420_8                    \
                           small_420_9-to-small_420_8                    \
                           small_422_9-to-small_420_9                    \
 
+# single slice pictures decoded while a second slice thread deblocks the
+# decoded rows, the output must match that of the plain decoder
+FATE_H264_SLICE_THREADS_TESTS := ba1_sony_d                             \
+                                 caba1_sony_d                           \
+                                 sva_ba1_b                              \
+
 FATE_H264  := $(FATE_H264:%=fate-h264-conformance-%)                    \
               $(FATE_H264_REINIT_TESTS:%=fate-h264-reinit-%)            \
+              $(FATE_H264_SLICE_THREADS_TESTS:%=fate-h264-slice-threads-%) \
               fate-h264-extreme-plane-pred                              \
               fate-h264-lossless                                        \
 
@@ -415,4 +422,9 @@ fate-h264-unescaped-extradata:                    CMD = framecrc -i $(TARGET_SAM
 
 fate-h264-reinit-%:                               CMD = framecrc -i $(TARGET_SAMPLES)/h264/$(@:fate-h264-%=%).h264 -vf format=yuv444p10le,scale=w=352:h=288
 
+fate-h264-slice-threads-ba1_sony_d:               CMD = framecrc -threads 2 -thread_type slice -i $(TARGET_SAMPLES)/h264-conformance/BA1_Sony_D.jsv
+fate-h264-slice-threads-caba1_sony_d:             CMD = framecrc -threads 2 -thread_type slice -i $(TARGET_SAMPLES)/h264-conformance/CABA1_Sony_D.jsv
+fate-h264-slice-threads-sva_ba1_b:                CMD = framecrc -threads 2 -thread_type slice -vsync drop -i $(TARGET_SAMPLES)/h264-conformance/SVA_BA1_B.264
+fate-h264-slice-threads-%: REF = $(SRC_PATH)/tests/ref/fate/h264-conformance-$(@:fate-h264-slice-threads-%=%)
+
 fate-h264-dts_5frames:                            CMD = probeframes $(TARGET_SAMPLES)/h264/dts_5frames.mkv
@@ -13,6 +13,10 @@ fate-camellia: libavutil/camellia-test$(EXESUF)
 fate-camellia: CMD = run libavutil/camellia-test
 fate-camellia: REF = /dev/null
 
+FATE_LIBAVUTIL += fate-buffer
+fate-buffer: libavutil/buffer-test$(EXESUF)
+fate-buffer: CMD = run libavutil/buffer-test
+
 FATE_LIBAVUTIL += fate-cast5
 fate-cast5: libavutil/cast5-test$(EXESUF)
 fate-cast5: CMD = run libavutil/cast5-test